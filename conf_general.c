@@ -84,6 +84,10 @@ __attribute__((section(".text2"))) void conf_general_init(void) {
 		VirtAddVarTab[ind++] = EEPROM_BASE_CUSTOM + i;
 	}
 
+	for (unsigned int i = 0;i < (sizeof(mc_configuration) / 2);i++) {
+		VirtAddVarTab[ind++] = EEPROM_BASE_MCCONF_2 + i;
+	}
+
 	for (unsigned int i = 0;i < (sizeof(backup_data) / 2);i++) {
 		VirtAddVarTab[ind++] = EEPROM_BASE_BACKUP + i;
 	}
@@ -163,16 +167,21 @@ __attribute__((section(".text2"))) bool conf_general_store_backup_data(void) {
 	FLASH_ClearFlag(FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR | FLASH_FLAG_PGAERR |
 			FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
 
+	EE_TransactionBegin();
 	for (unsigned int i = 0;i < (sizeof(backup_data) / 2);i++) {
 		var = (data_addr[2 * i] << 8) & 0xFF00;
 		var |= data_addr[2 * i + 1] & 0xFF;
 
-		if (EE_WriteVariable(EEPROM_BASE_BACKUP + i, var) != FLASH_COMPLETE) {
+		if (EE_TransactionWrite(EEPROM_BASE_BACKUP + i, var) != FLASH_COMPLETE) {
 			is_ok = false;
 			break;
 		}
 	}
 
+	if (is_ok && EE_TransactionCommit() != FLASH_COMPLETE) {
+		is_ok = false;
+	}
+
 	FLASH_Lock();
 	timeout_configure_IWDT();
 	mc_interface_ignore_input_both(100);
@@ -293,16 +302,21 @@ __attribute__((section(".text2"))) static bool store_eeprom_var(eeprom_var *v, i
 	FLASH_ClearFlag(FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR | FLASH_FLAG_PGAERR |
 			FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
 
-	if (EE_WriteVariable(base + address * 2, var0) != FLASH_COMPLETE) {
+	EE_TransactionBegin();
+	if (EE_TransactionWrite(base + address * 2, var0) != FLASH_COMPLETE) {
 		is_ok = false;
 	}
 
 	if (is_ok) {
-		if (EE_WriteVariable(base + address * 2 + 1, var1) != FLASH_COMPLETE) {
+		if (EE_TransactionWrite(base + address * 2 + 1, var1) != FLASH_COMPLETE) {
 			is_ok = false;
 		}
 	}
 
+	if (is_ok && EE_TransactionCommit() != FLASH_COMPLETE) {
+		is_ok = false;
+	}
+
 	FLASH_Lock();
 	timeout_configure_IWDT();
 	mc_interface_ignore_input_both(100);
@@ -377,16 +391,21 @@ __attribute__((section(".text2"))) bool conf_general_store_app_configuration(app
 	FLASH_ClearFlag(FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR | FLASH_FLAG_PGAERR |
 			FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
 
+	EE_TransactionBegin();
 	for (unsigned int i = 0;i < (sizeof(app_configuration) / 2);i++) {
 		var = (conf_addr[2 * i] << 8) & 0xFF00;
 		var |= conf_addr[2 * i + 1] & 0xFF;
 
-		if (EE_WriteVariable(EEPROM_BASE_APPCONF + i, var) != FLASH_COMPLETE) {
+		if (EE_TransactionWrite(EEPROM_BASE_APPCONF + i, var) != FLASH_COMPLETE) {
 			is_ok = false;
 			break;
 		}
 	}
 
+	if (is_ok && EE_TransactionCommit() != FLASH_COMPLETE) {
+		is_ok = false;
+	}
+
 	FLASH_Lock();
 	timeout_configure_IWDT();
 	mc_interface_ignore_input_both(100);
@@ -461,16 +480,21 @@ __attribute__((section(".text2"))) bool conf_general_store_mc_configuration(mc_c
 	FLASH_ClearFlag(FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR | FLASH_FLAG_PGAERR |
 			FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
 
+	EE_TransactionBegin();
 	for (unsigned int i = 0;i < (sizeof(mc_configuration) / 2);i++) {
 		uint16_t var = (conf_addr[2 * i] << 8) & 0xFF00;
 		var |= conf_addr[2 * i + 1] & 0xFF;
 
-		if (EE_WriteVariable(base + i, var) != FLASH_COMPLETE) {
+		if (EE_TransactionWrite(base + i, var) != FLASH_COMPLETE) {
 			is_ok = false;
 			break;
 		}
 	}
 
+	if (is_ok && EE_TransactionCommit() != FLASH_COMPLETE) {
+		is_ok = false;
+	}
+
 	FLASH_Lock();
 	timeout_configure_IWDT();
 	mc_interface_ignore_input_both(100);
@@ -37,9 +37,23 @@
 /* Global variable used to store variable value in read sequence */
 uint16_t DataVar = 0;
 
-/* Virtual address defined by the user: 0xFFFF value is prohibited */
+/* Virtual address defined by the user: must be below 0x7FFF, see EE_TXN_PENDING */
 extern uint16_t VirtAddVarTab[NB_OF_VAR];
 
+/* RAM index of the latest slot of each variable in the valid page. Entry n
+   holds the slot number + 1 of VirtAddVarTab[n], 0 if the variable is not
+   stored. The index is only used when the used part of VirtAddVarTab is sorted
+   so that it can be binary searched and IndexPage matches the valid page. */
+static uint16_t VarSlotIndex[NB_OF_VAR];
+static uint16_t IndexPage = NO_VALID_PAGE;
+static int IndexVarNum = 0;
+static uint32_t IndexFreeSlot = 0;
+static bool IndexTxnIncomplete = false;
+
+/* Variables staged by EE_TransactionWrite, indexed like VirtAddVarTab */
+static uint16_t TxnData[NB_OF_VAR];
+static uint32_t TxnStaged[(NB_OF_VAR + 31) / 32];
+
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 static FLASH_Status EE_Format(void);
@@ -47,6 +61,13 @@ static uint16_t EE_FindValidPage(uint8_t Operation);
 static uint16_t EE_VerifyPageFullWriteVariable(uint16_t VirtAddress, uint16_t Data);
 static uint16_t EE_PageTransfer(uint16_t VirtAddress, uint16_t Data);
 static uint16_t EE_EraseSectorIfNotEmpty(uint32_t FLASH_Sector, uint8_t VoltageRange);
+static int EE_FindVarIdx(uint16_t VirtAddress);
+static void EE_IndexRebuild(void);
+static bool EE_ScanPage(uint32_t PageStartAddress, bool UpdateIndex, uint32_t *FreeSlot);
+static void EE_MarkStored(uint32_t PageStartAddress);
+static uint16_t EE_AppendVariable(uint32_t *Address, uint32_t PageEndAddress, uint16_t VirtAddress, uint16_t Data);
+static uint16_t EE_TransferWithStaged(uint16_t StagedNum);
+static bool EE_IsStaged(int VarIdx);
 
 /**
  * @brief  Restore the pages to a known good state in case of page's status
@@ -68,6 +89,61 @@ uint16_t EE_Init(void)
 	/* Get Page1 status */
 	PageStatus1 = (*(__IO uint16_t*)PAGE1_BASE_ADDRESS);
 
+	/* Index the valid page so that the repairs below skip uncommitted transactions */
+	EE_IndexRebuild();
+
+	/* A page that was receiving data is dropped if it holds an uncommitted
+	   transaction. Otherwise only the variables it does not have yet are copied
+	   to it, as it can hold a committed transaction after the other variables. */
+	if (IndexPage != NO_VALID_PAGE &&
+			((PageStatus0 == RECEIVE_DATA && PageStatus1 == VALID_PAGE) ||
+			(PageStatus0 == VALID_PAGE && PageStatus1 == RECEIVE_DATA)))
+	{
+		uint32_t ReceiveAddress = PageStatus0 == RECEIVE_DATA ? PAGE0_BASE_ADDRESS : PAGE1_BASE_ADDRESS;
+		uint32_t ReceiveId = PageStatus0 == RECEIVE_DATA ? PAGE0_ID : PAGE1_ID;
+		uint32_t ValidId = PageStatus0 == RECEIVE_DATA ? PAGE1_ID : PAGE0_ID;
+
+		if (EE_ScanPage(ReceiveAddress, false, 0))
+		{
+			FlashStatus = EE_EraseSectorIfNotEmpty(ReceiveId, VOLTAGE_RANGE);
+			if (FlashStatus != FLASH_COMPLETE)
+			{
+				return FlashStatus;
+			}
+		}
+		else
+		{
+			EE_MarkStored(ReceiveAddress);
+			for (int i = 0;i < IndexVarNum;i++)
+			{
+				if (!EE_IsStaged(i) && EE_ReadVariable(VirtAddVarTab[i], &DataVar) == 0)
+				{
+					EepromStatus = EE_VerifyPageFullWriteVariable(VirtAddVarTab[i], DataVar);
+					if (EepromStatus != FLASH_COMPLETE)
+					{
+						return EepromStatus;
+					}
+				}
+			}
+			EE_TransactionBegin();
+
+			FlashStatus = EE_EraseSectorIfNotEmpty(ValidId, VOLTAGE_RANGE);
+			if (FlashStatus != FLASH_COMPLETE)
+			{
+				return FlashStatus;
+			}
+			FlashStatus = FLASH_ProgramHalfWord(ReceiveAddress, VALID_PAGE);
+			if (FlashStatus != FLASH_COMPLETE)
+			{
+				return FlashStatus;
+			}
+		}
+
+		PageStatus0 = (*(__IO uint16_t*)PAGE0_BASE_ADDRESS);
+		PageStatus1 = (*(__IO uint16_t*)PAGE1_BASE_ADDRESS);
+		EE_IndexRebuild();
+	}
+
 	/* Check for invalid header states and repair if necessary */
 	switch (PageStatus0)
 	{
@@ -257,6 +333,16 @@ uint16_t EE_Init(void)
 		break;
 	}
 
+	EE_IndexRebuild();
+
+	/* Roll back a transaction that was interrupted in the valid page by moving
+	   the variables as they were before it to the other page */
+	if (IndexPage != NO_VALID_PAGE && IndexTxnIncomplete)
+	{
+		EE_TransactionBegin();
+		return EE_TransferWithStaged(0);
+	}
+
 	return FLASH_COMPLETE;
 }
 
@@ -288,6 +374,29 @@ uint16_t EE_ReadVariable(uint16_t VirtAddress, uint16_t* Data)
 	/* Get the valid Page start Address */
 	PageStartAddress = (uint32_t)(EEPROM_START_ADDRESS + (uint32_t)(ValidPage * PAGE_SIZE));
 
+	/* Look up the slot in the index if it is up to date */
+	if (IndexPage == ValidPage)
+	{
+		int VarIdx = EE_FindVarIdx(VirtAddress);
+
+		if (VarIdx >= 0)
+		{
+			if (VarSlotIndex[VarIdx] == 0)
+			{
+				return 1;
+			}
+
+			Address = PageStartAddress + (uint32_t)(VarSlotIndex[VarIdx] - 1) * 4;
+
+			/* Fall back to scanning if the slot does not hold the variable */
+			if ((*(__IO uint16_t*)(Address + 2)) == VirtAddress)
+			{
+				*Data = (*(__IO uint16_t*)Address);
+				return 0;
+			}
+		}
+	}
+
 	/* Get the valid Page end Address */
 	Address = (uint32_t)((EEPROM_START_ADDRESS - 2) + (uint32_t)((1 + ValidPage) * PAGE_SIZE));
 
@@ -354,6 +463,92 @@ uint16_t EE_WriteVariable(uint16_t VirtAddress, uint16_t Data)
 	return Status;
 }
 
+/**
+ * Start a transaction. Variables written with EE_TransactionWrite are staged in
+ * RAM and written together by EE_TransactionCommit, so that either all or none
+ * of them are visible after a power loss.
+ */
+void EE_TransactionBegin(void)
+{
+	for (unsigned int i = 0;i < (sizeof(TxnStaged) / sizeof(TxnStaged[0]));i++)
+	{
+		TxnStaged[i] = 0;
+	}
+}
+
+/**
+ * Stage a variable in the current transaction. Variables that already have the
+ * value are not staged. Variables that are not in the index, which only happens
+ * if VirtAddVarTab is not sorted or does not contain the address, are written
+ * directly with EE_WriteVariable.
+ *
+ * @return FLASH_COMPLETE or the status from EE_WriteVariable
+ */
+uint16_t EE_TransactionWrite(uint16_t VirtAddress, uint16_t Data)
+{
+	int VarIdx = EE_FindVarIdx(VirtAddress);
+
+	if (VarIdx < 0 || IndexPage == NO_VALID_PAGE)
+	{
+		return EE_WriteVariable(VirtAddress, Data);
+	}
+
+	uint16_t DataOld = 0;
+	if (EE_ReadVariable(VirtAddress, &DataOld) == 0 && DataOld == Data)
+	{
+		TxnStaged[VarIdx / 32] &= ~(1u << (VarIdx % 32));
+	}
+	else
+	{
+		TxnData[VarIdx] = Data;
+		TxnStaged[VarIdx / 32] |= 1u << (VarIdx % 32);
+	}
+
+	return FLASH_COMPLETE;
+}
+
+/**
+ * Write all staged variables and commit them. Committing takes no extra slots,
+ * so a transaction uses as many slots as writing the changed variables one by
+ * one. At most one page transfer is done, and only if the changed variables do
+ * not fit in the valid page.
+ *
+ * @return
+ *   - FLASH_COMPLETE: on success
+ *   - PAGE_FULL: if the variables do not fit in an empty page
+ *   - NO_VALID_PAGE: if no valid page was found
+ *   - Flash error code: on write Flash error
+ */
+uint16_t EE_TransactionCommit(void)
+{
+	uint16_t StagedNum = 0;
+
+	for (int i = 0;i < IndexVarNum;i++)
+	{
+		if (EE_IsStaged(i))
+		{
+			StagedNum++;
+		}
+	}
+
+	if (StagedNum == 0)
+	{
+		return FLASH_COMPLETE;
+	}
+
+	uint16_t Status = EE_TransferWithStaged(StagedNum);
+	EE_TransactionBegin();
+
+	/* Do not leave a partly written transaction behind, as later writes after it
+	   would not be indexed */
+	if (Status != FLASH_COMPLETE && IndexPage != NO_VALID_PAGE && IndexTxnIncomplete)
+	{
+		EE_TransferWithStaged(0);
+	}
+
+	return Status;
+}
+
 /**
  * @brief  Erases PAGE and PAGE1 and writes VALID_PAGE header to PAGE
  * @param  None
@@ -506,6 +701,23 @@ static uint16_t EE_VerifyPageFullWriteVariable(uint16_t VirtAddress, uint16_t Da
 			}
 			/* Set variable virtual address */
 			FlashStatus = FLASH_ProgramHalfWord(Address + 2, VirtAddress);
+
+			/* Keep the index current when writing to the page that is read from. Writes
+			   to a page that is receiving data are indexed when the transfer is done. */
+			if (FlashStatus == FLASH_COMPLETE && IndexPage == ValidPage)
+			{
+				int VarIdx = EE_FindVarIdx(VirtAddress);
+				uint32_t Slot = (Address - (EEPROM_START_ADDRESS + (uint32_t)(ValidPage * PAGE_SIZE))) / 4;
+				if (VarIdx >= 0)
+				{
+					VarSlotIndex[VarIdx] = (uint16_t)(Slot + 1);
+				}
+				if (Slot >= IndexFreeSlot)
+				{
+					IndexFreeSlot = Slot + 1;
+				}
+			}
+
 			/* Return program operation status */
 			return FlashStatus;
 		}
@@ -616,6 +828,9 @@ static uint16_t EE_PageTransfer(uint16_t VirtAddress, uint16_t Data)
 		return FlashStatus;
 	}
 
+	/* Index the variables in the new page */
+	EE_IndexRebuild();
+
 	/* Return last operation flash status */
 	return FlashStatus;
 }
@@ -627,6 +842,9 @@ static uint16_t EE_PageTransfer(uint16_t VirtAddress, uint16_t Data)
 static uint16_t EE_EraseSectorIfNotEmpty(uint32_t FLASH_Sector, uint8_t VoltageRange) {
 	uint8_t *addr = flash_helper_get_sector_address(FLASH_Sector);
 
+	// The index might point into this page
+	IndexPage = NO_VALID_PAGE;
+
 	for (unsigned int i = 0;i < PAGE_SIZE;i++) {
 		if (addr[i] != 0xFF) {
 			return FLASH_EraseSector(FLASH_Sector, VoltageRange);
@@ -636,6 +854,247 @@ static uint16_t EE_EraseSectorIfNotEmpty(uint32_t FLASH_Sector, uint8_t VoltageR
 	return FLASH_COMPLETE;
 }
 
+/*
+ * Find the index of a virtual address in VirtAddVarTab using binary search.
+ * Returns -1 if it is not found.
+ */
+static int EE_FindVarIdx(uint16_t VirtAddress) {
+	int low = 0;
+	int high = IndexVarNum - 1;
+
+	while (low <= high) {
+		int mid = (low + high) / 2;
+
+		if (VirtAddVarTab[mid] == VirtAddress) {
+			return mid;
+		} else if (VirtAddVarTab[mid] < VirtAddress) {
+			low = mid + 1;
+		} else {
+			high = mid - 1;
+		}
+	}
+
+	return -1;
+}
+
+/*
+ * Build the slot index for the valid page. The index is disabled if VirtAddVarTab
+ * is not sorted, as it then cannot be searched.
+ */
+static void EE_IndexRebuild(void) {
+	IndexPage = NO_VALID_PAGE;
+
+	// Unused entries at the end of VirtAddVarTab are left as 0
+	IndexVarNum = 0;
+	while (IndexVarNum < (int)NB_OF_VAR && VirtAddVarTab[IndexVarNum] != 0) {
+		if (IndexVarNum > 0 && VirtAddVarTab[IndexVarNum] <= VirtAddVarTab[IndexVarNum - 1]) {
+			IndexVarNum = 0;
+			return;
+		}
+		IndexVarNum++;
+	}
+
+	uint16_t ValidPage = EE_FindValidPage(READ_FROM_VALID_PAGE);
+	if (ValidPage == NO_VALID_PAGE) {
+		return;
+	}
+
+	uint32_t PageStartAddress = (uint32_t)(EEPROM_START_ADDRESS + (uint32_t)(ValidPage * PAGE_SIZE));
+	IndexTxnIncomplete = EE_ScanPage(PageStartAddress, true, &IndexFreeSlot);
+	IndexPage = ValidPage;
+}
+
+/*
+ * Scan a page from the start, so that later copies of a variable replace earlier
+ * ones, and optionally fill the index from it. The first variable of a transaction
+ * is written with EE_TXN_PENDING set in its virtual address, which is cleared when
+ * all variables of the transaction are written. Nothing from such a pending slot
+ * on is indexed.
+ *
+ * Returns true if the page ends with an uncommitted transaction, and the first
+ * free slot.
+ */
+static bool EE_ScanPage(uint32_t PageStartAddress, bool UpdateIndex, uint32_t *FreeSlot) {
+	bool Pending = false;
+	uint32_t slot;
+
+	if (UpdateIndex) {
+		for (int i = 0;i < (int)NB_OF_VAR;i++) {
+			VarSlotIndex[i] = 0;
+		}
+	}
+
+	// The first slot holds the page status
+	for (slot = 1;slot < (PAGE_SIZE / 4);slot++) {
+		uint32_t Address = PageStartAddress + slot * 4;
+
+		if ((*(__IO uint32_t*)Address) == 0xFFFFFFFF) {
+			break;
+		}
+
+		uint16_t VirtAddress = *(__IO uint16_t*)(Address + 2);
+
+		if (VirtAddress != 0xFFFF && (VirtAddress & EE_TXN_PENDING) &&
+				EE_FindVarIdx(VirtAddress & ~EE_TXN_PENDING) >= 0) {
+			Pending = true;
+			break;
+		}
+
+		if (UpdateIndex) {
+			int VarIdx = EE_FindVarIdx(VirtAddress);
+			if (VarIdx >= 0) {
+				VarSlotIndex[VarIdx] = (uint16_t)(slot + 1);
+			}
+		}
+	}
+
+	// Nothing should be written after an uncommitted transaction, so treat the rest as used
+	if (Pending) {
+		slot = PAGE_SIZE / 4;
+	}
+
+	if (FreeSlot) {
+		*FreeSlot = slot;
+	}
+
+	return Pending;
+}
+
+/*
+ * Mark the variables that are stored in a page in TxnStaged.
+ */
+static void EE_MarkStored(uint32_t PageStartAddress) {
+	EE_TransactionBegin();
+
+	for (uint32_t slot = 1;slot < (PAGE_SIZE / 4);slot++) {
+		uint32_t Address = PageStartAddress + slot * 4;
+
+		if ((*(__IO uint32_t*)Address) == 0xFFFFFFFF) {
+			break;
+		}
+
+		int VarIdx = EE_FindVarIdx(*(__IO uint16_t*)(Address + 2));
+		if (VarIdx >= 0) {
+			TxnStaged[VarIdx / 32] |= 1u << (VarIdx % 32);
+		}
+	}
+}
+
+/*
+ * Program a variable in the slot at Address and advance Address to the next slot.
+ * The slots of a transaction have to be consecutive, so a slot that is not
+ * erased is an error rather than being skipped.
+ */
+static uint16_t EE_AppendVariable(uint32_t *Address, uint32_t PageEndAddress, uint16_t VirtAddress, uint16_t Data) {
+	uint32_t a = *Address;
+
+	if (a >= PageEndAddress || (*(__IO uint32_t*)a) != 0xFFFFFFFF) {
+		return PAGE_FULL;
+	}
+
+	*Address += 4;
+
+	uint16_t FlashStatus = FLASH_ProgramHalfWord(a, Data);
+	if (FlashStatus != FLASH_COMPLETE) {
+		return FlashStatus;
+	}
+
+	return FLASH_ProgramHalfWord(a + 2, VirtAddress);
+}
+
+static bool EE_IsStaged(int VarIdx) {
+	return (TxnStaged[VarIdx / 32] >> (VarIdx % 32)) & 1;
+}
+
+/*
+ * Write the staged variables as a transaction. If they do not fit in the valid
+ * page, all other variables are first copied to the other page and the
+ * transaction is written after them, so that at most one page transfer is done.
+ */
+static uint16_t EE_TransferWithStaged(uint16_t StagedNum) {
+	uint16_t FlashStatus = FLASH_COMPLETE;
+	uint16_t ValidPage = EE_FindValidPage(READ_FROM_VALID_PAGE);
+	uint16_t OldPageId = 0, NewPageId = 0;
+	uint32_t PageStartAddress = 0, PageEndAddress = 0, Address = 0;
+	uint16_t Data = 0;
+
+	if (ValidPage == NO_VALID_PAGE || IndexPage != ValidPage) {
+		return NO_VALID_PAGE;
+	}
+
+	bool Transfer = IndexTxnIncomplete || (IndexFreeSlot + StagedNum) > (PAGE_SIZE / 4);
+
+	if (Transfer) {
+		PageStartAddress = ValidPage == PAGE0 ? PAGE1_BASE_ADDRESS : PAGE0_BASE_ADDRESS;
+		OldPageId = ValidPage == PAGE0 ? PAGE0_ID : PAGE1_ID;
+		NewPageId = ValidPage == PAGE0 ? PAGE1_ID : PAGE0_ID;
+		Address = PageStartAddress + 4;
+		PageEndAddress = PageStartAddress + PAGE_SIZE;
+
+		FlashStatus = FLASH_ProgramHalfWord(PageStartAddress, RECEIVE_DATA);
+
+		// Copy the variables that are not part of the transaction
+		for (int i = 0;i < IndexVarNum && FlashStatus == FLASH_COMPLETE;i++) {
+			if (!EE_IsStaged(i) && EE_ReadVariable(VirtAddVarTab[i], &Data) == 0) {
+				FlashStatus = EE_AppendVariable(&Address, PageEndAddress, VirtAddVarTab[i], Data);
+			}
+		}
+	} else {
+		PageStartAddress = (uint32_t)(EEPROM_START_ADDRESS + (uint32_t)(ValidPage * PAGE_SIZE));
+		Address = PageStartAddress + IndexFreeSlot * 4;
+		PageEndAddress = PageStartAddress + PAGE_SIZE;
+	}
+
+	// A single variable is written like EE_WriteVariable does. With more than one,
+	// the first is written as pending and the transaction is committed by clearing
+	// that bit after the others are written.
+	uint32_t PendingAddress = 0;
+	int PendingIdx = -1;
+
+	for (int i = 0;i < IndexVarNum && StagedNum > 0 && FlashStatus == FLASH_COMPLETE;i++) {
+		if (EE_IsStaged(i)) {
+			uint16_t VirtAddress = VirtAddVarTab[i];
+
+			if (StagedNum > 1 && PendingIdx < 0) {
+				PendingAddress = Address;
+				PendingIdx = i;
+				VirtAddress |= EE_TXN_PENDING;
+			}
+
+			FlashStatus = EE_AppendVariable(&Address, PageEndAddress, VirtAddress, TxnData[i]);
+		}
+	}
+
+	if (PendingIdx >= 0 && FlashStatus == FLASH_COMPLETE) {
+		FlashStatus = FLASH_ProgramHalfWord(PendingAddress + 2, VirtAddVarTab[PendingIdx]);
+	}
+
+	if (FlashStatus != FLASH_COMPLETE) {
+		// Drop the partly written page so that later writes go to the valid page
+		if (Transfer) {
+			EE_EraseSectorIfNotEmpty(NewPageId, VOLTAGE_RANGE);
+		}
+		EE_IndexRebuild();
+		return FlashStatus;
+	}
+
+	if (Transfer) {
+		FlashStatus = EE_EraseSectorIfNotEmpty(OldPageId, VOLTAGE_RANGE);
+		if (FlashStatus != FLASH_COMPLETE) {
+			return FlashStatus;
+		}
+
+		FlashStatus = FLASH_ProgramHalfWord(PageStartAddress, VALID_PAGE);
+		if (FlashStatus != FLASH_COMPLETE) {
+			return FlashStatus;
+		}
+	}
+
+	EE_IndexRebuild();
+
+	return FlashStatus;
+}
+
 /**
  * @}
  */
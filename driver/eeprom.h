@@ -69,6 +69,10 @@
 /* Page full define */
 #define PAGE_FULL             ((uint8_t)0x80)
 
+/* Set in the virtual address of the first variable of a transaction until all
+   variables of it are written. Virtual addresses must be below 0x7FFF. */
+#define EE_TXN_PENDING        ((uint16_t)0x8000)
+
 /* Variables' number */
 #define NB_OF_VAR             ((uint16_t)((2 * sizeof(mc_configuration) + sizeof(app_configuration) + 1) / 2) + \
                               EEPROM_VARS_HW * 2 + EEPROM_VARS_CUSTOM * 2 + (sizeof(backup_data) + 1) / 2)
@@ -79,6 +83,9 @@
 uint16_t EE_Init(void);
 uint16_t EE_ReadVariable(uint16_t VirtAddress, uint16_t* Data);
 uint16_t EE_WriteVariable(uint16_t VirtAddress, uint16_t Data);
+void EE_TransactionBegin(void);
+uint16_t EE_TransactionWrite(uint16_t VirtAddress, uint16_t Data);
+uint16_t EE_TransactionCommit(void);
 
 #endif /* __EEPROM_H */
 
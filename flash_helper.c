@@ -89,6 +89,7 @@ const crc_info_t __attribute__((section (".crcinfo"))) crc_info = {0xFFFFFFFF, 0
 static uint16_t erase_sector(uint32_t sector);
 static uint16_t write_data(uint32_t base, uint8_t *data, uint32_t len);
 static void qmlui_check(int ind);
+static void code_invalidate(int ind);
 
 // Private variables
 typedef struct {
@@ -99,6 +100,12 @@ typedef struct {
 static _code_checks code_checks[3] = {0};
 static int code_sectors[3] = {QMLUI_BASE, LISP_BASE, LISP_CONST_BASE};
 
+// Background scan of the code regions. The generation counter is bumped on every
+// erase and write so that a scan that overlaps a modification is discarded.
+static volatile uint32_t code_gen[3] = {0};
+static volatile flash_region_status code_status[3] = {FLASH_REGION_UNCHECKED};
+static volatile uint32_t code_scan_cnt[3] = {0};
+
 // Private constants
 static const uint32_t flash_addr[FLASH_SECTORS] = {
 		ADDR_FLASH_SECTOR_0,
@@ -202,15 +209,17 @@ uint16_t flash_helper_erase_code(int ind) {
 		return FLASH_COMPLETE;
 	}
 
-	code_checks[ind].check_done = false;
-	code_checks[ind].ok = false;
-	return erase_sector(flash_sector[code_sectors[ind]]);
+	code_invalidate(ind);
+	uint16_t res = erase_sector(flash_sector[code_sectors[ind]]);
+	code_invalidate(ind);
+	return res;
 }
 
 uint16_t flash_helper_write_code(int ind, uint32_t offset, uint8_t *data, uint32_t len) {
-	code_checks[ind].check_done = false;
-	code_checks[ind].ok = false;
-	return write_data(flash_addr[code_sectors[ind]] + offset, data, len);
+	code_invalidate(ind);
+	uint16_t res = write_data(flash_addr[code_sectors[ind]] + offset, data, len);
+	code_invalidate(ind);
+	return res;
 }
 
 uint8_t* flash_helper_code_data(int ind) {
@@ -407,10 +416,125 @@ uint32_t flash_helper_verify_flash_memory_chunk(void) {
 	return res;
 }
 
+/**
+ * Verify the next chunk of the QML, Lisp and Lisp const regions. The regions
+ * are scanned round-robin in small chunks so that this can be called periodically
+ * from a low priority thread. When the scan of a region completes the result
+ * is cached, so that flash_helper_code_data and friends do not have to run the
+ * full CRC again.
+ *
+ * @return
+ * FAULT_CODE_FLASH_CORRUPTION when a region that previously passed its check
+ * fails it now, FAULT_CODE_NONE otherwise.
+ */
+uint32_t flash_helper_verify_code_chunk(void) {
+	static int ind = 0;
+	static uint32_t pos = 0;
+	static uint32_t len = 0;
+	static uint16_t crc = 0;
+	static uint16_t crc_stored = 0;
+	static uint32_t gen = 0;
+
+	uint8_t *base = (uint8_t*)(flash_addr[code_sectors[ind]]);
+	flash_region_status status = FLASH_REGION_UNCHECKED;
+
+	if (pos == 0) {
+		int32_t index = 0;
+		len = buffer_get_uint32(base, &index);
+		crc_stored = buffer_get_uint16(base, &index);
+		crc = 0;
+		gen = code_gen[ind];
+
+		if (len == 0xFFFFFFFF) {
+			status = FLASH_REGION_EMPTY;
+		} else if (len > QMLUI_MAX_SIZE) {
+			status = FLASH_REGION_CORRUPT;
+		} else {
+			len += 2; // CRC includes the 2 byte flags
+		}
+	}
+
+	if (status == FLASH_REGION_UNCHECKED) {
+		uint32_t chunk_size = 1024;
+
+		if ((pos + chunk_size) > len) {
+			chunk_size = len - pos;
+		}
+
+		crc = crc16_rolling(crc, base + 6 + pos, chunk_size);
+		pos += chunk_size;
+
+		if (pos < len) {
+			return FAULT_CODE_NONE;
+		}
+
+		status = (crc == crc_stored) ? FLASH_REGION_OK : FLASH_REGION_CORRUPT;
+	}
+
+	uint32_t res = FAULT_CODE_NONE;
+
+	utils_sys_lock_cnt();
+	if (gen == code_gen[ind]) {
+		if (status == FLASH_REGION_CORRUPT && code_status[ind] == FLASH_REGION_OK) {
+			res = FAULT_CODE_FLASH_CORRUPTION;
+		}
+
+		code_status[ind] = status;
+		code_scan_cnt[ind]++;
+		code_checks[ind].ok = status == FLASH_REGION_OK;
+		code_checks[ind].check_done = true;
+	}
+	utils_sys_unlock_cnt();
+
+	pos = 0;
+	ind++;
+	if (ind >= 3) {
+		ind = 0;
+	}
+
+	return res;
+}
+
+/**
+ * Get the result of the latest completed background scan of a code region.
+ *
+ * @param ind
+ * CODE_IND_QML, CODE_IND_LISP or CODE_IND_LISP_CONST
+ *
+ * @return
+ * The region status. FLASH_REGION_UNCHECKED until the first scan of the region
+ * since it was last erased or written has completed.
+ */
+flash_region_status flash_helper_code_region_status(int ind) {
+	return code_status[ind];
+}
+
+/**
+ * Get the number of completed background scans of a code region.
+ */
+uint32_t flash_helper_code_region_scan_cnt(int ind) {
+	return code_scan_cnt[ind];
+}
+
 uint32_t flash_helper_app_crc(void) {
 	return *APP_CRC_ADDRESS;
 }
 
+/*
+ * Forget the cached check and scan result of a code region after it has been
+ * modified. The result of a scan that overlapped the modification is discarded,
+ * and as the status is reset a reflashed region is not compared against the
+ * status of the old contents.
+ */
+static void code_invalidate(int ind) {
+	utils_sys_lock_cnt();
+	code_gen[ind]++;
+	code_status[ind] = FLASH_REGION_UNCHECKED;
+	code_checks[ind].check_done = false;
+	code_checks[ind].ok = false;
+	utils_sys_unlock_cnt();
+}
+
 static uint16_t erase_sector(uint32_t sector) {
 	FLASH_Unlock();
 	FLASH_ClearFlag(FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR | FLASH_FLAG_PGAERR |
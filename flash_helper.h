@@ -26,6 +26,13 @@
 #define CODE_IND_LISP		1
 #define CODE_IND_LISP_CONST 2
 
+typedef enum {
+	FLASH_REGION_UNCHECKED = 0,
+	FLASH_REGION_OK,
+	FLASH_REGION_EMPTY,
+	FLASH_REGION_CORRUPT
+} flash_region_status;
+
 // Functions
 uint16_t flash_helper_erase_new_app(uint32_t new_app_size);
 uint16_t flash_helper_erase_bootloader(void);
@@ -42,6 +49,9 @@ void flash_helper_jump_to_bootloader(void);
 uint8_t* flash_helper_get_sector_address(uint32_t fsector);
 uint32_t flash_helper_verify_flash_memory(void);
 uint32_t flash_helper_verify_flash_memory_chunk(void);
+uint32_t flash_helper_verify_code_chunk(void);
+flash_region_status flash_helper_code_region_status(int ind);
+uint32_t flash_helper_code_region_scan_cnt(int ind);
 uint32_t flash_helper_app_crc(void);
 
 // functions used in vesc_c_if.h and therefore accessible to packages
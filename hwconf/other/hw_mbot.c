@@ -299,10 +299,14 @@ static THD_FUNCTION(mux_thread, arg) {
 	(void)arg;
 
 #define TEMP_FILTER_LEN				9
-	uint16_t mot1_temp_samples[TEMP_FILTER_LEN] = {0};
-	uint16_t mot2_temp_samples[TEMP_FILTER_LEN] = {0};
-	unsigned int mot1_temp_samp_ptr = 0;
-	unsigned int mot2_temp_samp_ptr = 0;
+	uint16_t mot1_temp_samples[TEMP_FILTER_LEN];
+	uint16_t mot2_temp_samples[TEMP_FILTER_LEN];
+	uint16_t mot1_temp_sorted[TEMP_FILTER_LEN];
+	uint16_t mot2_temp_sorted[TEMP_FILTER_LEN];
+	utils_window_uint16 mot1_temp_filter;
+	utils_window_uint16 mot2_temp_filter;
+	utils_window_uint16_init(&mot1_temp_filter, mot1_temp_samples, mot1_temp_sorted, TEMP_FILTER_LEN, 0);
+	utils_window_uint16_init(&mot2_temp_filter, mot2_temp_samples, mot2_temp_sorted, TEMP_FILTER_LEN, 0);
 
 	for (;;) {
 		ENABLE_MOS_TEMP1();
@@ -315,13 +319,13 @@ static THD_FUNCTION(mux_thread, arg) {
 
 		ENABLE_MOT_TEMP1();
 		chThdSleepMicroseconds(400);
-		ADC_Value[ADC_IND_TEMP_MOTOR] = utils_median_filter_uint16_run(
-				mot1_temp_samples, &mot1_temp_samp_ptr, TEMP_FILTER_LEN, ADC_Value[ADC_IND_ADC_MUX]);
+		utils_window_uint16_add(&mot1_temp_filter, ADC_Value[ADC_IND_ADC_MUX]);
+		ADC_Value[ADC_IND_TEMP_MOTOR] = utils_window_uint16_median(&mot1_temp_filter);
 
 		ENABLE_MOT_TEMP2();
 		chThdSleepMicroseconds(400);
-		ADC_Value[ADC_IND_TEMP_MOTOR_2] = utils_median_filter_uint16_run(
-				mot2_temp_samples, &mot2_temp_samp_ptr, TEMP_FILTER_LEN, ADC_Value[ADC_IND_ADC_MUX]);
+		utils_window_uint16_add(&mot2_temp_filter, ADC_Value[ADC_IND_ADC_MUX]);
+		ADC_Value[ADC_IND_TEMP_MOTOR_2] = utils_window_uint16_median(&mot2_temp_filter);
 
     ENABLE_MOS_TEMP1B();
     chThdSleepMicroseconds(400);
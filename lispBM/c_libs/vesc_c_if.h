@@ -201,6 +201,38 @@ typedef struct {
 	float ki;
 	float beta;
 } ATTITUDE_INFO;
+
+typedef struct{
+	float a0, a1, a2, b1, b2;
+	float z1, z2;
+} Biquad;
+
+typedef enum {
+	BQ_LOWPASS,
+	BQ_HIGHPASS
+} BiquadType;
+
+typedef struct {
+	const float *coeffs;
+	float *state; // 2 * taps floats
+	int taps;
+	int index;
+} FirFilter;
+
+typedef struct {
+	Biquad *sections;
+	int num;
+} BiquadCascade;
+
+// Buffer sizes for a real FFT of 1 << bits points
+#define FILTER_RFFT_TWIDDLE_LEN(bits)	(1 << (bits))
+#define FILTER_RFFT_BITREV_LEN(bits)	(1 << ((bits) - 1))
+
+typedef struct {
+	int bits;
+	float *twiddle; // cos and sin interleaved, FILTER_RFFT_TWIDDLE_LEN floats
+	uint16_t *bitrev; // FILTER_RFFT_BITREV_LEN entries
+} FilterRfft;
 #endif
 
 typedef bool (*load_extension_fptr)(char*,extension_fptr);
@@ -661,6 +693,21 @@ typedef struct {
 	void (*sem_signal)(lib_semaphore);
 	bool (*sem_wait_to)(lib_semaphore, systime_t); // Returns false on timeout
 	void (*sem_reset)(lib_semaphore);
+
+	// Block filters. The state and the sections are owned by the library.
+	void (*filter_fir_init)(FirFilter *fir, const float *coeffs, float *state, int taps);
+	void (*filter_fir_reset)(FirFilter *fir);
+	void (*filter_fir_process_block)(FirFilter *fir, const float *in, float *out, int len);
+	void (*biquad_config)(Biquad *biquad, BiquadType type, float Fc);
+	void (*biquad_cascade_init)(BiquadCascade *cascade, Biquad *sections, int num);
+	void (*biquad_cascade_reset)(BiquadCascade *cascade);
+	void (*biquad_cascade_process_block)(BiquadCascade *cascade, const float *in, float *out, int len);
+
+	// Real FFT. The tables are owned by the library and can be shared by
+	// transforms of the same size.
+	bool (*filter_rfft_init)(FilterRfft *fft, int bits, float *twiddle, uint16_t *bitrev);
+	void (*filter_rfft)(FilterRfft *fft, float *data);
+	void (*filter_rfft_magnitude)(FilterRfft *fft, float *data, float *mag);
 } vesc_c_if;
 
 typedef struct {
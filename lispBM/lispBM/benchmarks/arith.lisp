@@ -0,0 +1,9 @@
+; Integer arithmetic, comparisons and bitwise operations on values that
+; fit in immediate integers.
+
+(define arith (lambda (i acc)
+  (if (= i 0) acc
+    (arith (- i 1)
+           (mod (+ (* acc 31) (bitwise-xor i (shr acc 3)) (/ i 7)) 1000003)))))
+
+(arith 100000 1)
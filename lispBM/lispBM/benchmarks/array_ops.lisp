@@ -0,0 +1,23 @@
+; Byte buffer reads and writes and indexing into lisp arrays.
+
+(define buf (bufcreate 256))
+(define arr (list-to-array (range 64)))
+
+(define fill-buf (lambda (i)
+  (if (= i 64) t
+    (progn
+      (bufset-u32 buf (* i 4) (* i 12345))
+      (fill-buf (+ i 1))))))
+
+(define sum-buf (lambda (i acc)
+  (if (= i 64) acc
+    (sum-buf (+ i 1) (+ acc (bufget-u32 buf (* i 4)) (ix arr i))))))
+
+(define rounds (lambda (n acc)
+  (if (= n 0) acc
+    (progn
+      (fill-buf 0)
+      (setix arr (mod n 64) n)
+      (rounds (- n 1) (+ acc (sum-buf 0 0)))))))
+
+(rounds 500 0)
@@ -0,0 +1,190 @@
+/*
+    Copyright 2026 Joel Svensson  svenssonjoel@yahoo.se
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Measures the image buffer operations a UI redraw is made of, for
+// every color format: clearing, filled rectangles, copying a sprite
+// with and without a transparent color and drawing an indexed4 sprite
+// into the buffer. The extensions are applied directly, without the
+// evaluator, and the time is reported per pixel written.
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lispbm.h"
+#include "lbm_image.h"
+#include "extensions/display_extensions.h"
+
+#define HEAP_SIZE               8192
+#define GC_STACK_SIZE           96
+#define PRINT_STACK_SIZE        256
+#define EXTENSION_STORAGE_SIZE  64
+#define IMAGE_STORAGE_SIZE      (128 * 1024)
+#define WIDTH                   320
+#define HEIGHT                  240
+#define SPRITE_SIZE             64
+#define ROUNDS                  50
+
+static lbm_cons_t heap[HEAP_SIZE];
+static lbm_uint memory[LBM_MEMORY_SIZE_1M];
+static lbm_uint bitmap[LBM_MEMORY_BITMAP_SIZE_1M];
+static lbm_extension_t extensions[EXTENSION_STORAGE_SIZE];
+static uint32_t image_storage[IMAGE_STORAGE_SIZE / sizeof(uint32_t)];
+
+static bool image_write(uint32_t w, int32_t ix, bool const_heap) {
+  (void) const_heap;
+  if (image_storage[ix] == 0xffffffff) {
+    image_storage[ix] = w;
+  }
+  return image_storage[ix] == w;
+}
+
+static bool init(void) {
+  if (!lbm_init(heap, HEAP_SIZE,
+                memory, LBM_MEMORY_SIZE_1M,
+                bitmap, LBM_MEMORY_BITMAP_SIZE_1M,
+                GC_STACK_SIZE,
+                PRINT_STACK_SIZE,
+                extensions,
+                EXTENSION_STORAGE_SIZE)) {
+    return false;
+  }
+  // The display extensions add constant symbols, which go in the image.
+  lbm_image_init(image_storage, IMAGE_STORAGE_SIZE / sizeof(lbm_uint), image_write);
+  memset(image_storage, 0xff, IMAGE_STORAGE_SIZE);
+  lbm_image_create("bench");
+  if (!lbm_image_boot()) {
+    return false;
+  }
+  lbm_display_extensions_init();
+  return true;
+}
+
+static lbm_value sym(char *name) {
+  lbm_uint id;
+  if (!lbm_get_symbol_by_name(name, &id)) {
+    printf("symbol %s not found\n", name);
+    exit(1);
+  }
+  return lbm_enc_sym(id);
+}
+
+static lbm_value apply(char *name, lbm_value *args, lbm_uint argn) {
+  extension_fptr f = lbm_get_extension(lbm_dec_sym(sym(name)));
+  lbm_value r = f ? f(args, argn) : ENC_SYM_EERROR;
+  if (r == ENC_SYM_TERROR || r == ENC_SYM_EERROR || r == ENC_SYM_MERROR) {
+    printf("%s failed\n", name);
+    exit(1);
+  }
+  return r;
+}
+
+static lbm_value img_buffer(char *fmt, int w, int h) {
+  lbm_value args[3] = {sym(fmt), lbm_enc_i(w), lbm_enc_i(h)};
+  return apply("img-buffer", args, 3);
+}
+
+static double now_us(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double)t.tv_sec * 1e6 + (double)t.tv_nsec / 1e3;
+}
+
+static void bench_format(char *fmt) {
+  lbm_value img = img_buffer(fmt, WIDTH, HEIGHT);
+  lbm_value sprite = img_buffer(fmt, SPRITE_SIZE, SPRITE_SIZE);
+  lbm_value sprite4 = img_buffer("indexed4", SPRITE_SIZE, SPRITE_SIZE);
+  lbm_value filled = lbm_heap_allocate_list_init(1, sym("filled"));
+
+  for (int i = 0; i < SPRITE_SIZE; i ++) {
+    lbm_value args[6] = {sprite, lbm_enc_i(i), lbm_enc_i(0), lbm_enc_i(i), lbm_enc_i(SPRITE_SIZE - 1),
+                         lbm_enc_u32((uint32_t)i * 0x030201)};
+    apply("img-line", args, 6);
+    args[0] = sprite4;
+    args[5] = lbm_enc_u32((uint32_t)i & 0x3);
+    apply("img-line", args, 6);
+  }
+
+  double t_clear = 0.0;
+  double t_fill = 0.0;
+  double t_blit = 0.0;
+  double t_blit_tc = 0.0;
+  double t_blit_ix = 0.0;
+  for (int r = 0; r < ROUNDS; r ++) {
+    lbm_value clear[2] = {img, lbm_enc_u32(0x102030)};
+    double start = now_us();
+    apply("img-clear", clear, 2);
+    t_clear += now_us() - start;
+
+    start = now_us();
+    for (int i = 0; i < 10; i ++) {
+      lbm_value args[7] = {img, lbm_enc_i(i * 7), lbm_enc_i(i * 5), lbm_enc_i(200), lbm_enc_i(100),
+                           lbm_enc_u32((uint32_t)i & 0x3), filled};
+      apply("img-rectangle", args, 7);
+    }
+    t_fill += now_us() - start;
+
+    start = now_us();
+    for (int i = 0; i < 10; i ++) {
+      lbm_value args[5] = {img, sprite, lbm_enc_i(i * 25), lbm_enc_i(i * 15), lbm_enc_i(-1)};
+      apply("img-blit", args, 5);
+    }
+    t_blit += now_us() - start;
+
+    start = now_us();
+    for (int i = 0; i < 10; i ++) {
+      lbm_value args[5] = {img, sprite, lbm_enc_i(i * 25), lbm_enc_i(i * 15), lbm_enc_i(0)};
+      apply("img-blit", args, 5);
+    }
+    t_blit_tc += now_us() - start;
+
+    start = now_us();
+    for (int i = 0; i < 10; i ++) {
+      lbm_value args[5] = {img, sprite4, lbm_enc_i(i * 25), lbm_enc_i(i * 15), lbm_enc_i(0)};
+      apply("img-blit", args, 5);
+    }
+    t_blit_ix += now_us() - start;
+  }
+
+  double clear_pix = (double)ROUNDS * WIDTH * HEIGHT;
+  double fill_pix = (double)ROUNDS * 10 * 200 * 100;
+  double blit_pix = (double)ROUNDS * 10 * SPRITE_SIZE * SPRITE_SIZE;
+  printf("%-10s %8.2f %8.2f %8.2f %8.2f %8.2f\n",
+         fmt,
+         t_clear * 1000.0 / clear_pix,
+         t_fill * 1000.0 / fill_pix,
+         t_blit * 1000.0 / blit_pix,
+         t_blit_tc * 1000.0 / blit_pix,
+         t_blit_ix * 1000.0 / blit_pix);
+}
+
+int main(void) {
+  char *formats[] = {"indexed2", "indexed4", "indexed16", "rgb332", "rgb565", "rgb888"};
+
+  printf("ns/pixel      clear     fill     blit  blit-tc  blit-i4\n");
+  for (unsigned int i = 0; i < sizeof(formats) / sizeof(formats[0]); i ++) {
+    if (!init()) {
+      printf("init failed\n");
+      return 1;
+    }
+    bench_format(formats[i]);
+  }
+  return 0;
+}
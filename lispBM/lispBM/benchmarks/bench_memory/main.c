@@ -0,0 +1,215 @@
+/*
+    Copyright 2026 Joel Svensson  svenssonjoel@yahoo.se
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Exercises lbm_memory with fragmenting allocation patterns. The
+// allocator is first checked against a shadow model of which words
+// are in use and then timed on a few workloads.
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "lbm_memory.h"
+
+#define MEMORY_SIZE   LBM_MEMORY_SIZE_32K
+#define BITMAP_SIZE   LBM_MEMORY_BITMAP_SIZE_32K
+#define MAX_LIVE      1024
+#define CHECK_OPS     200000
+#define BENCH_OPS     2000000
+
+static lbm_uint memory[MEMORY_SIZE];
+static lbm_uint bitmap[BITMAP_SIZE];
+
+static lbm_uint *live[MAX_LIVE];
+static lbm_uint live_size[MAX_LIVE];
+static int shadow[MEMORY_SIZE]; // owning slot + 1 or 0 for free words
+
+static unsigned int rand_state = 1;
+
+// lbm_memory requests a GC when it runs low, there is no GC here.
+void lbm_request_gc(void) {
+}
+
+static unsigned int next_rand(void) {
+  rand_state = rand_state * 1103515245u + 12345u;
+  return (rand_state >> 16) & 0x7fff;
+}
+
+// Mostly small sizes, like conses of arrays and closures, with an
+// occasional large array.
+static lbm_uint rand_size(void) {
+  unsigned int r = next_rand();
+  if (r % 16 == 0) return 32 + next_rand() % 200;
+  return 1 + next_rand() % 12;
+}
+
+static void reset(void) {
+  lbm_memory_init(memory, MEMORY_SIZE, bitmap, BITMAP_SIZE);
+  lbm_memory_set_reserve(0);
+  memset(live, 0, sizeof(live));
+  memset(shadow, 0, sizeof(shadow));
+}
+
+static lbm_uint shadow_longest_free(void) {
+  lbm_uint longest = 0;
+  lbm_uint run = 0;
+  for (lbm_uint i = 0; i < MEMORY_SIZE; i ++) {
+    run = shadow[i] ? 0 : run + 1;
+    if (run > longest) longest = run;
+  }
+  return longest;
+}
+
+static bool shadow_alloc(int slot, lbm_uint *ptr, lbm_uint n) {
+  if (!lbm_memory_ptr_inside(ptr) || !lbm_memory_ptr_inside(ptr + n - 1)) {
+    printf("allocation of %u words outside of memory\n", (unsigned int)n);
+    return false;
+  }
+  lbm_uint ix = (lbm_uint)(ptr - memory);
+  for (lbm_uint i = ix; i < ix + n; i ++) {
+    if (shadow[i]) {
+      printf("allocation of %u words at %u overlaps slot %d\n",
+             (unsigned int)n, (unsigned int)ix, shadow[i] - 1);
+      return false;
+    }
+    shadow[i] = slot + 1;
+  }
+  live[slot] = ptr;
+  live_size[slot] = n;
+  return true;
+}
+
+static void shadow_free(int slot, lbm_uint from) {
+  lbm_uint ix = (lbm_uint)(live[slot] - memory);
+  for (lbm_uint i = ix + from; i < ix + live_size[slot]; i ++) {
+    shadow[i] = 0;
+  }
+}
+
+static bool check(void) {
+  reset();
+  lbm_uint used = 0;
+  for (int op = 0; op < CHECK_OPS; op ++) {
+    int slot = (int)(next_rand() % MAX_LIVE);
+    if (live[slot] == NULL) {
+      lbm_uint n = rand_size();
+      lbm_uint longest = shadow_longest_free();
+      lbm_uint *ptr = lbm_memory_allocate(n);
+      if (ptr == NULL) {
+        if (n <= longest) {
+          printf("op %d: allocating %u words failed with %u free in a row\n",
+                 op, (unsigned int)n, (unsigned int)longest);
+          return false;
+        }
+        continue;
+      }
+      if (!shadow_alloc(slot, ptr, n)) return false;
+      used += n;
+    } else if (live_size[slot] > 1 && next_rand() % 4 == 0) {
+      lbm_uint n = 1 + next_rand() % (live_size[slot] - 1);
+      if (!lbm_memory_shrink(live[slot], n)) {
+        printf("op %d: shrink failed\n", op);
+        return false;
+      }
+      shadow_free(slot, n);
+      used -= live_size[slot] - n;
+      live_size[slot] = n;
+    } else {
+      shadow_free(slot, 0);
+      if (!lbm_memory_free(live[slot])) {
+        printf("op %d: free failed\n", op);
+        return false;
+      }
+      used -= live_size[slot];
+      live[slot] = NULL;
+    }
+
+    if (lbm_memory_num_free() != MEMORY_SIZE - used) {
+      printf("op %d: num_free %u, expected %u\n", op,
+             (unsigned int)lbm_memory_num_free(), (unsigned int)(MEMORY_SIZE - used));
+      return false;
+    }
+    lbm_uint longest = shadow_longest_free();
+    if (lbm_memory_longest_free() != longest) {
+      printf("op %d: longest_free %u, expected %u\n", op,
+             (unsigned int)lbm_memory_longest_free(), (unsigned int)longest);
+      return false;
+    }
+  }
+  return true;
+}
+
+static double now_ms(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double)t.tv_sec * 1e3 + (double)t.tv_nsec / 1e6;
+}
+
+// Random allocations and frees with up to MAX_LIVE blocks alive.
+static double bench_mixed(bool query_longest) {
+  reset();
+  double start = now_ms();
+  for (int op = 0; op < BENCH_OPS; op ++) {
+    int slot = (int)(next_rand() % MAX_LIVE);
+    if (live[slot] == NULL) {
+      if (query_longest) (void)lbm_memory_longest_free();
+      live[slot] = lbm_memory_allocate(rand_size());
+    } else {
+      lbm_memory_free(live[slot]);
+      live[slot] = NULL;
+    }
+  }
+  return now_ms() - start;
+}
+
+// Memory filled with 2 word blocks where every other block is freed.
+// Larger blocks then only fit past the fragmented region.
+static double bench_fragmented(void) {
+  reset();
+  static lbm_uint *small[MEMORY_SIZE / 2];
+  lbm_uint num_small = 0;
+  while (lbm_memory_num_free() > MEMORY_SIZE / 4) {
+    small[num_small ++] = lbm_memory_allocate(2);
+  }
+  for (lbm_uint i = 0; i < num_small; i += 2) {
+    lbm_memory_free(small[i]);
+  }
+  double start = now_ms();
+  for (int op = 0; op < BENCH_OPS / 4; op ++) {
+    int slot = op % 64;
+    if (live[slot]) lbm_memory_free(live[slot]);
+    live[slot] = lbm_memory_allocate(4 + next_rand() % 16);
+  }
+  return now_ms() - start;
+}
+
+int main(void) {
+  if (!check()) {
+    printf("Consistency check failed\n");
+    return 1;
+  }
+  printf("Consistency check passed (%d operations)\n", CHECK_OPS);
+
+  printf("%-40s %8.1f ms\n", "Mixed alloc/free", bench_mixed(false));
+  printf("%-40s %8.1f ms\n", "Mixed alloc/free with longest_free", bench_mixed(true));
+  printf("%-40s %8.1f ms\n", "Fragmented, larger blocks", bench_fragmented());
+  return 0;
+}
@@ -0,0 +1,141 @@
+/*
+    Copyright 2026 Joel Svensson  svenssonjoel@yahoo.se
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Measures the time to restart LispBM the way lispif_restart in the VESC
+// firmware does: init, image boot and registration of the built-in
+// extension libraries plus a large set of application extensions.
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lispbm.h"
+#include "lbm_image.h"
+#include "extensions/array_extensions.h"
+#include "extensions/math_extensions.h"
+#include "extensions/string_extensions.h"
+#include "extensions/runtime_extensions.h"
+#include "extensions/random_extensions.h"
+#include "extensions/mutex_extensions.h"
+#include "extensions/set_extensions.h"
+
+#define HEAP_SIZE               2048
+#define GC_STACK_SIZE           96
+#define PRINT_STACK_SIZE        256
+#define EXTENSION_STORAGE_SIZE  400
+#define NUM_APP_EXTENSIONS      230
+#define IMAGE_STORAGE_SIZE      (128 * 1024)
+#define RESTARTS                500
+
+static lbm_cons_t heap[HEAP_SIZE];
+static lbm_uint memory[LBM_MEMORY_SIZE_32K];
+static lbm_uint bitmap[LBM_MEMORY_BITMAP_SIZE_32K];
+static lbm_extension_t extensions[EXTENSION_STORAGE_SIZE];
+static uint32_t image_storage[IMAGE_STORAGE_SIZE / sizeof(uint32_t)];
+static char app_names[NUM_APP_EXTENSIONS][32];
+
+static bool image_write(uint32_t w, int32_t ix, bool const_heap) {
+  (void) const_heap;
+  if (image_storage[ix] == 0xffffffff) {
+    image_storage[ix] = w;
+    return true;
+  }
+  return image_storage[ix] == w;
+}
+
+static lbm_value ext_dummy(lbm_value *args, lbm_uint argn) {
+  (void) args;
+  (void) argn;
+  return ENC_SYM_TRUE;
+}
+
+static bool restart(bool new_image) {
+  if (!lbm_init(heap, HEAP_SIZE,
+                memory, LBM_MEMORY_SIZE_32K,
+                bitmap, LBM_MEMORY_BITMAP_SIZE_32K,
+                GC_STACK_SIZE,
+                PRINT_STACK_SIZE,
+                extensions,
+                EXTENSION_STORAGE_SIZE)) {
+    return false;
+  }
+
+  lbm_image_init(image_storage, IMAGE_STORAGE_SIZE / sizeof(lbm_uint), image_write);
+  if (new_image || !lbm_image_exists()) {
+    memset(image_storage, 0xff, IMAGE_STORAGE_SIZE);
+    lbm_image_create("bench");
+  }
+  if (!lbm_image_boot()) {
+    return false;
+  }
+  lbm_add_eval_symbols();
+
+  lbm_array_extensions_init();
+  lbm_math_extensions_init();
+  lbm_string_extensions_init();
+  lbm_runtime_extensions_init();
+  lbm_random_extensions_init();
+  lbm_mutex_extensions_init();
+  lbm_set_extensions_init();
+
+  for (int i = 0; i < NUM_APP_EXTENSIONS; i ++) {
+    if (!lbm_add_extension(app_names[i], ext_dummy)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static double now_us(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (double)t.tv_sec * 1e6 + (double)t.tv_nsec / 1e3;
+}
+
+static bool bench(const char *name, bool new_image) {
+  double start = now_us();
+  for (int i = 0; i < RESTARTS; i ++) {
+    if (!restart(new_image)) {
+      printf("%s: restart failed\n", name);
+      return false;
+    }
+  }
+  double t = (now_us() - start) / RESTARTS;
+  printf("%-32s %8.1f us per restart, %u extensions\n", name, t, (unsigned int)lbm_get_num_extensions());
+  return true;
+}
+
+int main(void) {
+  for (int i = 0; i < NUM_APP_EXTENSIONS; i ++) {
+    snprintf(app_names[i], sizeof(app_names[i]), "app-extension-%d", i);
+  }
+
+  if (!bench("New image", true)) return 1;
+
+  // Restarts from an image with the extension table saved in it. The
+  // extensions are then found by name and only get their fptr updated.
+  if (!restart(true) || !lbm_image_save_extensions()) {
+    printf("Saving extensions failed\n");
+    return 1;
+  }
+  if (!bench("Image with saved extensions", false)) return 1;
+
+  return 0;
+}
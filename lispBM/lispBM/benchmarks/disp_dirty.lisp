@@ -0,0 +1,57 @@
+; A dashboard frame where only a value and a bar change between frames,
+; rendered with disp-render and with disp-render-dirty through the REPL
+; image display driver. The result is the time in seconds for 200
+; frames each way, the pixels sent per dirty frame and whether both
+; ways produced the same display content. Run in the REPL.
+
+(define fb (img-buffer 'rgb565 320 240 'dirty-track))
+(define screen-full (img-buffer 'rgb888 320 240))
+(define screen-dirty (img-buffer 'rgb888 320 240))
+(display-to-img)
+
+(define static-ui (lambda ()
+  (progn
+    (img-clear fb 0x202020)
+    (img-rectangle fb 10 10 300 60 0x4040F0 '(thickness 4))
+    (img-circle fb 260 170 50 0x40F040 '(thickness 6))
+    (img-rectangle fb 20 200 280 20 0xF0F0F0))))
+
+(define frame (lambda (n)
+  (progn
+    (img-rectangle fb 20 90 120 16 0x202020 '(filled))
+    (img-rectangle fb 20 90 (mod (* n 7) 120) 16 0xF04040 '(filled))
+    (img-setpix fb (mod n 300) 230 0xFFFFFF)
+    (img-line fb 200 120 (+ 200 (mod n 40)) 150 0xF0F040))))
+
+(define pixels (lambda (rects acc)
+  (if (eq rects nil) acc
+    (pixels (cdr rects) (+ acc (* (ix (car rects) 2) (ix (car rects) 3)))))))
+
+(define run-full (lambda (n)
+  (if (= n 0) t
+    (progn (frame n) (disp-render fb 0 0) (run-full (- n 1))))))
+
+(define sent 0)
+(define run-dirty (lambda (n)
+  (if (= n 0) t
+    (progn
+      (frame n)
+      (setq sent (+ sent (pixels (img-dirty fb) 0)))
+      (disp-render-dirty fb 0 0)
+      (run-dirty (- n 1))))))
+
+(set-active-img screen-full)
+(static-ui)
+(define t0 (systime))
+(run-full 200)
+(define t-full (secs-since t0))
+
+(set-active-img screen-dirty)
+(img-dirty-track fb)
+(static-ui)
+(disp-render-dirty fb 0 0)
+(define t0 (systime))
+(run-dirty 200)
+(define t-dirty (secs-since t0))
+
+(list t-full t-dirty (/ sent 200) (eq screen-full screen-dirty))
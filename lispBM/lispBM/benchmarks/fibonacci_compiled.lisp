@@ -0,0 +1,2 @@
+(let ((fib (compile (lambda (n) (if (> 2 n) n (+ (fib (- n 1)) (fib (- n 2))))))))
+  (fib 23))
@@ -0,0 +1,34 @@
+; 16 tap FIR filter over 256 f32 samples, element by element in lisp.
+; fir_vec.lisp computes the same with vec-fir.
+
+(define n 256)
+(define taps 16)
+(define x (bufcreate (* 4 n)))
+(define y (bufcreate (* 4 n)))
+(define c (bufcreate (* 4 taps)))
+
+(define init (lambda (i)
+  (if (= i n) t
+    (progn
+      (bufset-f32 x (* 4 i) (to-float (- (mod (* i 37) 101) 50)) 'little-endian)
+      (if (< i taps) (bufset-f32 c (* 4 i) (/ 1.0 taps) 'little-endian) nil)
+      (init (+ i 1))))))
+(init 0)
+
+(define tap (lambda (i k acc)
+  (if (or (= k taps) (< i k)) acc
+    (tap i (+ k 1) (+ acc (* (bufget-f32 c (* 4 k) 'little-endian)
+                             (bufget-f32 x (* 4 (- i k)) 'little-endian)))))))
+
+(define fir (lambda (i)
+  (if (= i n) t
+    (progn
+      (bufset-f32 y (* 4 i) (tap i 0 0.0) 'little-endian)
+      (fir (+ i 1))))))
+
+(define rounds (lambda (r)
+  (if (= r 0) t
+    (progn (fir 0) (rounds (- r 1))))))
+
+(rounds 20)
+(bufget-f32 y (* 4 (- n 1)) 'little-endian)
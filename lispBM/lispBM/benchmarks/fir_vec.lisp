@@ -0,0 +1,22 @@
+; The filter of fir_lisp.lisp with vec-fir, 100 times as many rounds.
+
+(define n 256)
+(define taps 16)
+(define x (bufcreate (* 4 n)))
+(define y (bufcreate (* 4 n)))
+(define c (bufcreate (* 4 taps)))
+
+(define init (lambda (i)
+  (if (= i n) t
+    (progn
+      (bufset-f32 x (* 4 i) (to-float (- (mod (* i 37) 101) 50)) 'little-endian)
+      (if (< i taps) (bufset-f32 c (* 4 i) (/ 1.0 taps) 'little-endian) nil)
+      (init (+ i 1))))))
+(init 0)
+
+(define rounds (lambda (r)
+  (if (= r 0) t
+    (progn (vec-fir 'f32 y x c) (rounds (- r 1))))))
+
+(rounds 2000)
+(bufget-f32 y (* 4 (- n 1)) 'little-endian)
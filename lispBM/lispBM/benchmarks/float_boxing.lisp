@@ -0,0 +1,12 @@
+; Float arithmetic in a filter loop. On 32-bit platforms every float
+; result is allocated on the heap.
+
+(define lowpass (lambda (i y)
+  (if (= i 0) y
+    (lowpass (- i 1) (+ (* 0.95 y) (* 0.05 (sin (* i 0.01))))))))
+
+(define integrate (lambda (i acc dt)
+  (if (= i 0) acc
+    (integrate (- i 1) (+ acc (* (/ 1.0 (+ 1.0 (* i dt))) dt)) dt))))
+
+(+ (lowpass 30000 0.0) (integrate 30000 0.0 0.001))
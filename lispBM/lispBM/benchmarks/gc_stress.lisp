@@ -0,0 +1,14 @@
+; Allocates short lived lists while a larger structure stays live, so
+; that every collection has to mark the live data.
+
+(define live (map (lambda (i) (list i (* i 2) (list i))) (range 300)))
+
+(define garbage (lambda (n acc)
+  (if (= n 0) acc
+    (garbage (- n 1) (+ acc (length (range 50)))))))
+
+(define rounds (lambda (n acc)
+  (if (= n 0) acc
+    (rounds (- n 1) (+ acc (garbage 20 0) (length live))))))
+
+(rounds 2000 0)
@@ -0,0 +1,365 @@
+
+; A script with a few hundred top-level definitions, about what a
+; larger application ends up with, that touches many of them.
+
+(define v_0 0)
+(define v_1 1)
+(define v_2 2)
+(define v_3 0)
+(define v_4 1)
+(define v_5 2)
+(define v_6 0)
+(define v_7 1)
+(define v_8 2)
+(define v_9 0)
+(define v_10 1)
+(define v_11 2)
+(define v_12 0)
+(define v_13 1)
+(define v_14 2)
+(define v_15 0)
+(define v_16 1)
+(define v_17 2)
+(define v_18 0)
+(define v_19 1)
+
+(define v_20 2)
+(define v_21 0)
+(define v_22 1)
+(define v_23 2)
+(define v_24 0)
+(define v_25 1)
+(define v_26 2)
+(define v_27 0)
+(define v_28 1)
+(define v_29 2)
+(define v_30 0)
+(define v_31 1)
+(define v_32 2)
+(define v_33 0)
+(define v_34 1)
+(define v_35 2)
+(define v_36 0)
+(define v_37 1)
+(define v_38 2)
+(define v_39 0)
+
+(define v_40 1)
+(define v_41 2)
+(define v_42 0)
+(define v_43 1)
+(define v_44 2)
+(define v_45 0)
+(define v_46 1)
+(define v_47 2)
+(define v_48 0)
+(define v_49 1)
+(define v_50 2)
+(define v_51 0)
+(define v_52 1)
+(define v_53 2)
+(define v_54 0)
+(define v_55 1)
+(define v_56 2)
+(define v_57 0)
+(define v_58 1)
+(define v_59 2)
+
+(define v_60 0)
+(define v_61 1)
+(define v_62 2)
+(define v_63 0)
+(define v_64 1)
+(define v_65 2)
+(define v_66 0)
+(define v_67 1)
+(define v_68 2)
+(define v_69 0)
+(define v_70 1)
+(define v_71 2)
+(define v_72 0)
+(define v_73 1)
+(define v_74 2)
+(define v_75 0)
+(define v_76 1)
+(define v_77 2)
+(define v_78 0)
+(define v_79 1)
+
+(define v_80 2)
+(define v_81 0)
+(define v_82 1)
+(define v_83 2)
+(define v_84 0)
+(define v_85 1)
+(define v_86 2)
+(define v_87 0)
+(define v_88 1)
+(define v_89 2)
+(define v_90 0)
+(define v_91 1)
+(define v_92 2)
+(define v_93 0)
+(define v_94 1)
+(define v_95 2)
+(define v_96 0)
+(define v_97 1)
+(define v_98 2)
+(define v_99 0)
+
+(define v_100 1)
+(define v_101 2)
+(define v_102 0)
+(define v_103 1)
+(define v_104 2)
+(define v_105 0)
+(define v_106 1)
+(define v_107 2)
+(define v_108 0)
+(define v_109 1)
+(define v_110 2)
+(define v_111 0)
+(define v_112 1)
+(define v_113 2)
+(define v_114 0)
+(define v_115 1)
+(define v_116 2)
+(define v_117 0)
+(define v_118 1)
+(define v_119 2)
+
+(define v_120 0)
+(define v_121 1)
+(define v_122 2)
+(define v_123 0)
+(define v_124 1)
+(define v_125 2)
+(define v_126 0)
+(define v_127 1)
+(define v_128 2)
+(define v_129 0)
+(define v_130 1)
+(define v_131 2)
+(define v_132 0)
+(define v_133 1)
+(define v_134 2)
+(define v_135 0)
+(define v_136 1)
+(define v_137 2)
+(define v_138 0)
+(define v_139 1)
+
+(define v_140 2)
+(define v_141 0)
+(define v_142 1)
+(define v_143 2)
+(define v_144 0)
+(define v_145 1)
+(define v_146 2)
+(define v_147 0)
+(define v_148 1)
+(define v_149 2)
+(define v_150 0)
+(define v_151 1)
+(define v_152 2)
+(define v_153 0)
+(define v_154 1)
+(define v_155 2)
+(define v_156 0)
+(define v_157 1)
+(define v_158 2)
+(define v_159 0)
+
+(define v_160 1)
+(define v_161 2)
+(define v_162 0)
+(define v_163 1)
+(define v_164 2)
+(define v_165 0)
+(define v_166 1)
+(define v_167 2)
+(define v_168 0)
+(define v_169 1)
+(define v_170 2)
+(define v_171 0)
+(define v_172 1)
+(define v_173 2)
+(define v_174 0)
+(define v_175 1)
+(define v_176 2)
+(define v_177 0)
+(define v_178 1)
+(define v_179 2)
+
+(define v_180 0)
+(define v_181 1)
+(define v_182 2)
+(define v_183 0)
+(define v_184 1)
+(define v_185 2)
+(define v_186 0)
+(define v_187 1)
+(define v_188 2)
+(define v_189 0)
+(define v_190 1)
+(define v_191 2)
+(define v_192 0)
+(define v_193 1)
+(define v_194 2)
+(define v_195 0)
+(define v_196 1)
+(define v_197 2)
+(define v_198 0)
+(define v_199 1)
+
+(define v_200 2)
+(define v_201 0)
+(define v_202 1)
+(define v_203 2)
+(define v_204 0)
+(define v_205 1)
+(define v_206 2)
+(define v_207 0)
+(define v_208 1)
+(define v_209 2)
+(define v_210 0)
+(define v_211 1)
+(define v_212 2)
+(define v_213 0)
+(define v_214 1)
+(define v_215 2)
+(define v_216 0)
+(define v_217 1)
+(define v_218 2)
+(define v_219 0)
+
+(define v_220 1)
+(define v_221 2)
+(define v_222 0)
+(define v_223 1)
+(define v_224 2)
+(define v_225 0)
+(define v_226 1)
+(define v_227 2)
+(define v_228 0)
+(define v_229 1)
+(define v_230 2)
+(define v_231 0)
+(define v_232 1)
+(define v_233 2)
+(define v_234 0)
+(define v_235 1)
+(define v_236 2)
+(define v_237 0)
+(define v_238 1)
+(define v_239 2)
+
+(define v_240 0)
+(define v_241 1)
+(define v_242 2)
+(define v_243 0)
+(define v_244 1)
+(define v_245 2)
+(define v_246 0)
+(define v_247 1)
+(define v_248 2)
+(define v_249 0)
+(define v_250 1)
+(define v_251 2)
+(define v_252 0)
+(define v_253 1)
+(define v_254 2)
+(define v_255 0)
+(define v_256 1)
+(define v_257 2)
+(define v_258 0)
+(define v_259 1)
+
+(define v_260 2)
+(define v_261 0)
+(define v_262 1)
+(define v_263 2)
+(define v_264 0)
+(define v_265 1)
+(define v_266 2)
+(define v_267 0)
+(define v_268 1)
+(define v_269 2)
+(define v_270 0)
+(define v_271 1)
+(define v_272 2)
+(define v_273 0)
+(define v_274 1)
+(define v_275 2)
+(define v_276 0)
+(define v_277 1)
+(define v_278 2)
+(define v_279 0)
+
+(define v_280 1)
+(define v_281 2)
+(define v_282 0)
+(define v_283 1)
+(define v_284 2)
+(define v_285 0)
+(define v_286 1)
+(define v_287 2)
+(define v_288 0)
+(define v_289 1)
+(define v_290 2)
+(define v_291 0)
+(define v_292 1)
+(define v_293 2)
+(define v_294 0)
+(define v_295 1)
+(define v_296 2)
+(define v_297 0)
+(define v_298 1)
+(define v_299 2)
+
+(define v_300 0)
+(define v_301 1)
+(define v_302 2)
+(define v_303 0)
+(define v_304 1)
+(define v_305 2)
+(define v_306 0)
+(define v_307 1)
+(define v_308 2)
+(define v_309 0)
+(define v_310 1)
+(define v_311 2)
+(define v_312 0)
+(define v_313 1)
+(define v_314 2)
+(define v_315 0)
+(define v_316 1)
+(define v_317 2)
+(define v_318 0)
+(define v_319 1)
+
+
+(define sum-all (lambda ()
+  (+ (+ v_0 v_2 v_4 v_6 v_8 v_10 v_12 v_14 v_16 v_18)
+     (+ v_20 v_22 v_24 v_26 v_28 v_30 v_32 v_34 v_36 v_38)
+     (+ v_40 v_42 v_44 v_46 v_48 v_50 v_52 v_54 v_56 v_58)
+     (+ v_60 v_62 v_64 v_66 v_68 v_70 v_72 v_74 v_76 v_78)
+     (+ v_80 v_82 v_84 v_86 v_88 v_90 v_92 v_94 v_96 v_98)
+     (+ v_100 v_102 v_104 v_106 v_108 v_110 v_112 v_114 v_116 v_118)
+     (+ v_120 v_122 v_124 v_126 v_128 v_130 v_132 v_134 v_136 v_138)
+     (+ v_140 v_142 v_144 v_146 v_148 v_150 v_152 v_154 v_156 v_158)
+     (+ v_160 v_162 v_164 v_166 v_168 v_170 v_172 v_174 v_176 v_178)
+     (+ v_180 v_182 v_184 v_186 v_188 v_190 v_192 v_194 v_196 v_198)
+     (+ v_200 v_202 v_204 v_206 v_208 v_210 v_212 v_214 v_216 v_218)
+     (+ v_220 v_222 v_224 v_226 v_228 v_230 v_232 v_234 v_236 v_238)
+     (+ v_240 v_242 v_244 v_246 v_248 v_250 v_252 v_254 v_256 v_258)
+     (+ v_260 v_262 v_264 v_266 v_268 v_270 v_272 v_274 v_276 v_278)
+     (+ v_280 v_282 v_284 v_286 v_288 v_290 v_292 v_294 v_296 v_298)
+     (+ v_300 v_302 v_304 v_306 v_308 v_310 v_312 v_314 v_316 v_318))))
+
+(define f (lambda (n acc)
+  (if (= n 0)
+      acc
+    (f (- n 1) (+ acc (sum-all))))))
+
+(f 20000 0)
@@ -0,0 +1,212 @@
+
+; Globals defined before many other globals end up deep in their
+; buckets of the global environment.
+
+(define k 1)
+
+(define f (lambda (n acc)
+  (if (>= n 100000)
+      acc
+    (f (+ n k) (+ acc k)))))
+
+(define y_0 0)
+(define y_1 0)
+(define y_2 0)
+(define y_3 0)
+(define y_4 0)
+(define y_5 0)
+(define y_6 0)
+(define y_7 0)
+(define y_8 0)
+(define y_9 0)
+(define y_10 0)
+(define y_11 0)
+(define y_12 0)
+(define y_13 0)
+(define y_14 0)
+(define y_15 0)
+(define y_16 0)
+(define y_17 0)
+(define y_18 0)
+(define y_19 0)
+
+(define y_20 0)
+(define y_21 0)
+(define y_22 0)
+(define y_23 0)
+(define y_24 0)
+(define y_25 0)
+(define y_26 0)
+(define y_27 0)
+(define y_28 0)
+(define y_29 0)
+(define y_30 0)
+(define y_31 0)
+(define y_32 0)
+(define y_33 0)
+(define y_34 0)
+(define y_35 0)
+(define y_36 0)
+(define y_37 0)
+(define y_38 0)
+(define y_39 0)
+
+(define y_40 0)
+(define y_41 0)
+(define y_42 0)
+(define y_43 0)
+(define y_44 0)
+(define y_45 0)
+(define y_46 0)
+(define y_47 0)
+(define y_48 0)
+(define y_49 0)
+(define y_50 0)
+(define y_51 0)
+(define y_52 0)
+(define y_53 0)
+(define y_54 0)
+(define y_55 0)
+(define y_56 0)
+(define y_57 0)
+(define y_58 0)
+(define y_59 0)
+
+(define y_60 0)
+(define y_61 0)
+(define y_62 0)
+(define y_63 0)
+(define y_64 0)
+(define y_65 0)
+(define y_66 0)
+(define y_67 0)
+(define y_68 0)
+(define y_69 0)
+(define y_70 0)
+(define y_71 0)
+(define y_72 0)
+(define y_73 0)
+(define y_74 0)
+(define y_75 0)
+(define y_76 0)
+(define y_77 0)
+(define y_78 0)
+(define y_79 0)
+
+(define y_80 0)
+(define y_81 0)
+(define y_82 0)
+(define y_83 0)
+(define y_84 0)
+(define y_85 0)
+(define y_86 0)
+(define y_87 0)
+(define y_88 0)
+(define y_89 0)
+(define y_90 0)
+(define y_91 0)
+(define y_92 0)
+(define y_93 0)
+(define y_94 0)
+(define y_95 0)
+(define y_96 0)
+(define y_97 0)
+(define y_98 0)
+(define y_99 0)
+
+(define y_100 0)
+(define y_101 0)
+(define y_102 0)
+(define y_103 0)
+(define y_104 0)
+(define y_105 0)
+(define y_106 0)
+(define y_107 0)
+(define y_108 0)
+(define y_109 0)
+(define y_110 0)
+(define y_111 0)
+(define y_112 0)
+(define y_113 0)
+(define y_114 0)
+(define y_115 0)
+(define y_116 0)
+(define y_117 0)
+(define y_118 0)
+(define y_119 0)
+
+(define y_120 0)
+(define y_121 0)
+(define y_122 0)
+(define y_123 0)
+(define y_124 0)
+(define y_125 0)
+(define y_126 0)
+(define y_127 0)
+(define y_128 0)
+(define y_129 0)
+(define y_130 0)
+(define y_131 0)
+(define y_132 0)
+(define y_133 0)
+(define y_134 0)
+(define y_135 0)
+(define y_136 0)
+(define y_137 0)
+(define y_138 0)
+(define y_139 0)
+
+(define y_140 0)
+(define y_141 0)
+(define y_142 0)
+(define y_143 0)
+(define y_144 0)
+(define y_145 0)
+(define y_146 0)
+(define y_147 0)
+(define y_148 0)
+(define y_149 0)
+(define y_150 0)
+(define y_151 0)
+(define y_152 0)
+(define y_153 0)
+(define y_154 0)
+(define y_155 0)
+(define y_156 0)
+(define y_157 0)
+(define y_158 0)
+(define y_159 0)
+
+(define y_160 0)
+(define y_161 0)
+(define y_162 0)
+(define y_163 0)
+(define y_164 0)
+(define y_165 0)
+(define y_166 0)
+(define y_167 0)
+(define y_168 0)
+(define y_169 0)
+(define y_170 0)
+(define y_171 0)
+(define y_172 0)
+(define y_173 0)
+(define y_174 0)
+(define y_175 0)
+(define y_176 0)
+(define y_177 0)
+(define y_178 0)
+(define y_179 0)
+
+(define y_180 0)
+(define y_181 0)
+(define y_182 0)
+(define y_183 0)
+(define y_184 0)
+(define y_185 0)
+(define y_186 0)
+(define y_187 0)
+(define y_188 0)
+(define y_189 0)
+
+(f 0 0)
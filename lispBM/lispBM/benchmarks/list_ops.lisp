@@ -0,0 +1,12 @@
+; Higher order list functions over a short list.
+
+(define xs (range 100))
+
+(define rounds (lambda (n acc)
+  (if (= n 0) acc
+    (let ((ys (map (lambda (x) (* x 3)) xs))
+          (zs (filter (lambda (x) (= (mod x 2) 0)) ys))
+          (s (foldl + 0 (append zs (reverse ys)))))
+      (rounds (- n 1) (+ acc s (length zs)))))))
+
+(rounds 300 0)
@@ -0,0 +1,4 @@
+((compile (lambda ()
+  (loop ( (n 200000) )
+        (> n 0)
+        (setq n (- n 1))))))
@@ -0,0 +1,68 @@
+; CAN forwarding style message traffic. A producer sends bursts of
+; frames with 8 different ids to a consumer. The consumer handles the
+; highest priority id first, taking those frames from the middle of its
+; mailbox, and then the rest in arrival order. Finally a stream larger
+; than the mailbox makes the oldest frames get dropped.
+
+(define bursts 300)
+
+(define drain-prio (lambda (n acc)
+  (if (= n 0) acc
+    (recv ((can-frame 7 (? d)) (drain-prio (- n 1) (+ acc d)))))))
+
+(define drain-any (lambda (n acc)
+  (if (= n 0) acc
+    (recv ((can-frame (? i) (? d)) (drain-any (- n 1) (+ acc i d)))))))
+
+(define consumer (lambda (parent n acc)
+  (if (= n 0) (send parent (list 'sum acc))
+    (let ((a (drain-prio 4 acc)))
+      (progn
+        (send parent 'ack)
+        (consumer parent (- n 1) (drain-any 28 a)))))))
+
+(define send-burst (lambda (pid i)
+  (if (= i 32) t
+    (progn
+      (send pid (list 'can-frame (mod i 8) i))
+      (send-burst pid (+ i 1))))))
+
+(define producer (lambda (pid n)
+  (if (= n 0) t
+    (progn
+      (send-burst pid 0)
+      (recv (ack t))
+      (producer pid (- n 1))))))
+
+(define overflow (lambda (pid i)
+  (if (= i 0) t
+    (progn
+      (send pid (list 'can-frame 0 i))
+      (overflow pid (- i 1))))))
+
+; 'go takes the place of the oldest frame in the full mailbox.
+(define flood (lambda (parent)
+  (progn
+    (set-mailbox-size 64)
+    (send parent 'ready)
+    (recv (go t))
+    (send parent (list 'sum (drain-any 63 0))))))
+
+(define consumer-main (lambda (parent)
+  (progn
+    (set-mailbox-size 64)
+    (send parent 'ready)
+    (consumer parent bursts 0))))
+
+(define c (spawn consumer-main (self)))
+(recv (ready t))
+(producer c bursts)
+(define sum (recv ((sum (? s)) s)))
+
+(define f (spawn flood (self)))
+(recv (ready t))
+(overflow f 2000)
+(send f 'go)
+(define sum (+ sum (recv ((sum (? s)) s))))
+
+sum
@@ -0,0 +1,16 @@
+; Ping-pong between two processes.
+
+(define ponger (lambda ()
+  (recv ((ping (? pid) (? n)) (progn (send pid (list 'pong n)) (ponger)))
+        (stop t))))
+
+(define pinger (lambda (pid n acc)
+  (if (= n 0) acc
+    (progn
+      (send pid (list 'ping (self) n))
+      (recv ((pong (? m)) (pinger pid (- n 1) (+ acc m))))))))
+
+(define p (spawn ponger))
+(define res (pinger p 50000 0))
+(send p 'stop)
+res
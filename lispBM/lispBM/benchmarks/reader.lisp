@@ -0,0 +1,9 @@
+; Reader throughput on a program held in a string.
+
+(define src "(define pid-step (lambda (e i d) (let ((p (* kp e)) (i (+ i (* ki e dt))) (d (* kd (- e d)))) (list (+ p i d) i e)))) (define tab '(1 2 3 4 5 6 7 8 9 10 \"str\" 1.5 2u32 3i64 sym-a sym-b))")
+
+(define rounds (lambda (n acc)
+  (if (= n 0) acc
+    (rounds (- n 1) (+ acc (length (read-program src)))))))
+
+(rounds 5000 0)
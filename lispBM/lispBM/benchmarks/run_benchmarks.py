@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+#
+# Runs the benchmark suite in the Linux REPL and reports evaluation
+# steps per second, GC counts and lbm_memory peak as JSON. Results can
+# be compared against a stored baseline, the script exits with status 1
+# if any benchmark regressed by more than the thresholds.
+#
+#   ./run_benchmarks.py                           # run and print
+#   ./run_benchmarks.py --store baseline.json     # record a baseline
+#   ./run_benchmarks.py --baseline baseline.json  # compare
+#
+# Times depend on the machine, store baselines per machine. Step counts
+# are deterministic and catch changes in how much work the evaluator
+# does for the same program.
+
+import argparse
+import json
+import os
+import platform
+import subprocess
+import sys
+import tempfile
+import time
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+
+SUITE = [
+    # Arithmetic
+    'arith.lisp', 'float_boxing.lisp', 'fibonacci.lisp', 'tak.lisp', 'q2.lisp',
+    # Control flow and environment
+    'loop_200k.lisp', 'tail_call_200k.lisp', 'env_lookup.lisp',
+    # Lists, arrays and strings
+    'list_ops.lisp', 'array_ops.lisp', 'string_ops.lisp', 'sort500.lisp',
+    # Signal processing
+    'fir_lisp.lisp', 'fir_vec.lisp',
+    # Display
+    'disp_dirty.lisp',
+    # Processes and messages
+    'message_passing.lisp', 'mailbox_can.lisp',
+    # Memory management and reader
+    'gc_stress.lisp', 'reader.lisp',
+    # Compiled closures, to compare with the interpreted versions above
+    'fibonacci_compiled.lisp', 'tak_compiled.lisp', 'q2_compiled.lisp',
+    'loop_200k_compiled.lisp', 'tail_call_200k_compiled.lisp',
+]
+
+
+def run_one(args, path):
+    best = None
+    with tempfile.TemporaryDirectory() as tmp:
+        out = os.path.join(tmp, 'bench.json')
+        for _ in range(args.runs):
+            cmd = [args.repl, '--silent', '--terminate', '--history_file=',
+                   '-H', str(args.heap_size), '-M', str(args.memory_size),
+                   '--src=' + path, '--bench_json=' + out]
+            try:
+                subprocess.run(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL,
+                               timeout=args.timeout, check=True)
+                with open(out) as f:
+                    res = json.load(f)[0]
+            except (subprocess.SubprocessError, OSError, ValueError, IndexError) as e:
+                return {'error': str(e)}
+            if best is None or res['time_s'] < best['time_s']:
+                best = res
+    del best['file']
+    return best
+
+
+def compare(results, baseline, args):
+    failures = []
+    for name, base in sorted(baseline['benchmarks'].items()):
+        cur = results['benchmarks'].get(name)
+        if cur is None:
+            continue
+        if 'error' in cur:
+            failures.append('%s: %s' % (name, cur['error']))
+            continue
+        if 'error' in base:
+            continue
+        if cur['result'] != base['result']:
+            failures.append('%s: result %s, baseline %s' % (name, cur['result'], base['result']))
+        checks = [
+            ('steps/s', cur['steps_per_s'], base['steps_per_s'], -args.time_threshold),
+            ('steps', cur['steps'], base['steps'], args.steps_threshold),
+            ('gc', cur['gc_num'], base['gc_num'], args.gc_threshold),
+            ('memory', cur['memory_peak_bytes'], base['memory_peak_bytes'], args.memory_threshold),
+        ]
+        for what, c, b, thr in checks:
+            if b == 0:
+                change = 0.0 if c == 0 else 100.0
+            else:
+                change = 100.0 * (c - b) / b
+            if (thr < 0 and change < thr) or (thr >= 0 and change > thr):
+                failures.append('%s: %s %s -> %s (%+.1f%%)' % (name, what, b, c, change))
+    return failures
+
+
+def main():
+    p = argparse.ArgumentParser(description='Run the LispBM benchmark suite in the REPL.')
+    p.add_argument('benchmarks', nargs='*', help='benchmark files, default is the full suite')
+    p.add_argument('--repl', default=os.path.join(SCRIPT_DIR, '..', 'repl', 'repl'))
+    p.add_argument('-H', '--heap_size', type=int, default=16384)
+    p.add_argument('-M', '--memory_size', type=int, default=11,
+                   help='REPL memory-size-index (default 11)')
+    p.add_argument('--runs', type=int, default=5, help='runs per benchmark, the fastest is kept')
+    p.add_argument('--timeout', type=float, default=60.0)
+    p.add_argument('-o', '--output', help='write the results to this file')
+    p.add_argument('--store', help='write the results as a new baseline')
+    p.add_argument('--baseline', help='compare against this baseline')
+    p.add_argument('--time_threshold', type=float, default=20.0,
+                   help='allowed steps/s decrease in percent (default 20)')
+    p.add_argument('--steps_threshold', type=float, default=1.0,
+                   help='allowed step count increase in percent (default 1)')
+    p.add_argument('--gc_threshold', type=float, default=10.0,
+                   help='allowed GC count increase in percent (default 10)')
+    p.add_argument('--memory_threshold', type=float, default=10.0,
+                   help='allowed lbm_memory peak increase in percent (default 10)')
+    args = p.parse_args()
+
+    if not os.path.isfile(args.repl):
+        sys.exit('REPL not found at %s, build it with "make all64" in lispBM/repl' % args.repl)
+
+    files = args.benchmarks or [os.path.join(SCRIPT_DIR, b) for b in SUITE]
+    results = {
+        'date': time.strftime('%Y-%m-%d %H:%M:%S'),
+        'machine': platform.machine(),
+        'heap_size': args.heap_size,
+        'memory_size': args.memory_size,
+        'benchmarks': {},
+    }
+    for path in files:
+        name = os.path.basename(path)
+        res = run_one(args, path)
+        results['benchmarks'][name] = res
+        if 'error' in res:
+            print('%-22s error: %s' % (name, res['error']), file=sys.stderr)
+        else:
+            print('%-22s %8.3f s %12d steps/s %6d gc %8d bytes' %
+                  (name, res['time_s'], res['steps_per_s'], res['gc_num'],
+                   res['memory_peak_bytes']), file=sys.stderr)
+
+    text = json.dumps(results, indent=2, sort_keys=True)
+    for path in (args.output, args.store):
+        if path:
+            with open(path, 'w') as f:
+                f.write(text + '\n')
+    if not args.output and not args.store:
+        print(text)
+
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        failures = compare(results, baseline, args)
+        for msg in failures:
+            print('REGRESSION ' + msg, file=sys.stderr)
+        if failures:
+            return 1
+        print('No regressions against %s' % args.baseline, file=sys.stderr)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
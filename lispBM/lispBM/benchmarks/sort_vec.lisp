@@ -0,0 +1,40 @@
+; Sorting 2000 samples: a list with sort, an i32 byte array with
+; vec-sort and a lisp array with array-sort. The result is the time in
+; seconds for sorting 5 times with each, not counting the time to copy
+; the samples into the arrays. Run with -H 32768.
+
+(define n 2000)
+(define samples (map (lambda (i) (mod (* i 7919) 10007)) (range n)))
+
+(define buf (bufcreate (* 4 n)))
+(define fill-buf (lambda (i xs)
+  (if (eq xs nil) t
+    (progn
+      (bufset-i32 buf (* 4 i) (car xs) 'little-endian)
+      (fill-buf (+ i 1) (cdr xs))))))
+
+(define sort-list (lambda (r acc)
+  (if (= r 0) acc
+    (let ((t0 (systime)))
+      (progn
+        (sort < samples)
+        (sort-list (- r 1) (+ acc (secs-since t0))))))))
+
+(define sort-buf (lambda (r acc)
+  (if (= r 0) acc
+    (progn
+      (fill-buf 0 samples)
+      (let ((t0 (systime)))
+        (progn
+          (vec-sort 'i32 buf)
+          (sort-buf (- r 1) (+ acc (secs-since t0)))))))))
+
+(define sort-arr (lambda (r acc)
+  (if (= r 0) acc
+    (let ((arr (list-to-array samples))
+          (t0 (systime)))
+      (progn
+        (array-sort < arr)
+        (sort-arr (- r 1) (+ acc (secs-since t0))))))))
+
+(list (sort-list 5 0.0) (sort-buf 5 0.0) (sort-arr 5 0.0))
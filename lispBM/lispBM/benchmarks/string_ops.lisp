@@ -0,0 +1,11 @@
+; Building, splitting and converting strings.
+
+(define line (lambda (i)
+  (str-merge "id=" (str-from-n i) ",v=" (str-from-n (* i 3)) ",name=motor")))
+
+(define rounds (lambda (n acc)
+  (if (= n 0) acc
+    (let ((parts (str-split (line n) ",")))
+      (rounds (- n 1) (+ acc (str-len (ix parts 2)) (length parts)))))))
+
+(rounds 3000 0)
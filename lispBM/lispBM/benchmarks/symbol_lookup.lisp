@@ -0,0 +1,11 @@
+(define names (map (lambda (i) (str-merge "sym_" (to-str i))) (range 100)))
+
+(define f (lambda (n)
+  (if (= n 0)
+      t
+    (progn
+      (map str2sym names)
+      (read "(define apa (+ bepa cepa (car depa)))")
+      (f (- n 1))))))
+
+(f 200)
@@ -0,0 +1,5 @@
+(define f (compile (lambda (n)
+  (if (= n 0) ()
+    (f (- n 1))))))
+
+(f 200000)
@@ -0,0 +1,22 @@
+; Drawing and measuring a three line dashboard text with a prepared
+; font. The result is the time in seconds for 200 ttf-text and 2000
+; ttf-text-dims. Run in the REPL from this directory with -H 32768.
+
+(define font (load-file (fopen "../doc/Ubuntu-Regular.ttf" "r")))
+(define chars "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 .,:;!?-+*/()%")
+(define fnt (ttf-prepare font 16 'indexed4 chars))
+(define img (img-buffer 'indexed4 320 240))
+(define txt "Speed: 42.5 km/h\nBattery: 87% Temp: 31.2C\nDistance: 12.45 km Wh/km: 9.8")
+(define draw (lambda (n)
+  (if (= n 0) t
+    (progn (ttf-text img 0 20 '(0 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15) fnt txt) (draw (- n 1))))))
+(define dims (lambda (n)
+  (if (= n 0) t
+    (progn (ttf-text-dims fnt txt) (dims (- n 1))))))
+(define t0 (systime))
+(draw 200)
+(define t-draw (secs-since t0))
+(define t0 (systime))
+(dims 2000)
+(define t-dims (secs-since t0))
+(list t-draw t-dims)
@@ -35,7 +35,8 @@
   (ref-entry "img-buffer"
              (list
               (para (list "Allocate an image buffer from lbm memory or from a compactable region."
-                          "The form of an `img-buffer` expression is `(img-buffer opt-dm format width height)`."
+                          "The form of an `img-buffer` expression is `(img-buffer opt-dm format width height opt-dirty-track)`."
+                          "With `'dirty-track` the buffer also has room for dirty region tracking, which `disp-render-dirty` uses to send only the changed parts of the image."
                           ))
               (code '((define my-img (img-buffer 'indexed2 320 200))
                       ))
@@ -1253,6 +1253,27 @@
                          ))
               end)))
 
+(define built-in-compile
+  (ref-entry "compile"
+             (list
+              (para (list "Compile a closure into bytecode. The form of a `compile` expression is `(compile closure-expr)`."
+                          "The result is a closure that computes the same thing but runs faster, as parameters and local variables"
+                          "are kept in slots on the stack and global variables are looked up once instead of at every use."
+                          "The body of the compiled closure is a `bytecode` form."
+                          ))
+              (para (list "Bodies made up of `quote`, `if`, `cond`, `and`, `or`, `progn`, `var`, `let`, `loop`, `setq` and"
+                          "function applications can be compiled. If the body uses anything else, such as a `lambda`, `match`"
+                          "or `eval`, the closure is returned unchanged. A compiled closure accepts the same arguments as the"
+                          "closure it was compiled from. As bodies that use `rest-args` are not compiled, extra arguments are"
+                          "evaluated and then ignored."
+                          ))
+              (code '((define fib (compile (lambda (n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))))
+                      (fib 20)
+                      (define f (lambda (x) (eval x)))
+                      (eq (compile f) f)
+                      ))
+              end)))
+
 (define built-in-read
   (ref-entry "read"
              (list
@@ -1442,6 +1463,7 @@
                  built-in-eval
                  built-in-eval-program
                  built-in-apply
+                 built-in-compile
                  built-in-read
                  built-in-read-program
                  built-in-read-eval-program
@@ -102,6 +102,79 @@
                       ))
               end)))
 
+(define gc-pause-budget
+  (ref-entry "set-gc-pause-budget"
+             (list
+              (para (list "`set-gc-pause-budget` enables incremental garbage collection. The argument is the"
+                          "number of heap cells the collector may mark or sweep between two evaluation steps."
+                          "Collection then runs in small slices interleaved with the evaluator instead of"
+                          "stopping it for a full collection, whenever the heap is getting full."
+                          "If the heap runs out anyway, the regular stop-the-world collector is used."
+                          "A budget of 0, the default, disables incremental collection."
+                          ))
+              (code '((set-gc-pause-budget 64)
+                      ))
+              end)))
+
+(define gc-log
+  (ref-entry "gc-log"
+             (list
+              (para (list "`gc-log` returns a list of the most recent garbage collections, newest first."
+                          "An optional argument limits how many are returned. Each collection is a list"
+                          "`(trigger timestamp mark-us sweep-us cid free-before recovered recovered-arrays free-after mem-free mem-longest-free)`."
+                          "The trigger is one of `alloc`, `request`, `explicit` or `incremental`."
+                          "Times are in microseconds, free-before, recovered and free-after count heap cells and"
+                          "mem-free and mem-longest-free count words of array and symbol memory."
+                          ))
+              (code '((gc-log 1)
+                      ))
+              end)))
+
+(define gc-histogram
+  (ref-entry "gc-histogram"
+             (list
+              (para (list "`gc-histogram` returns a histogram over all collections as a list of counts."
+                          "With `'pause` the buckets are pause times, below 32us, 32-63us, 64-127us and so on."
+                          "Every slice of an incremental collection is a pause of its own."
+                          "With `'heap-use` the buckets are the percentage of the heap in use after a collection, 0-9%, 10-19% and so on."
+                          "With `'trigger` the counts are the number of collections per trigger, in the order"
+                          "alloc, request, explicit and incremental."
+                          ))
+              (code '((gc-histogram 'heap-use)
+                      ))
+              end)))
+
+(define gc-max-pause
+  (ref-entry "gc-max-pause"
+             (list
+              (para (list "`gc-max-pause` returns the longest garbage collection pause in microseconds."
+                          ))
+              (code '((gc-max-pause)
+                      ))
+              end)))
+
+(define gc-stats-reset
+  (ref-entry "gc-stats-reset"
+             (list
+              (para (list "`gc-stats-reset` clears the garbage collection log, the histograms and the"
+                          "allocation counters of all contexts."
+                          ))
+              (code '((gc-stats-reset)
+                      ))
+              end)))
+
+(define ctx-alloc-cells
+  (ref-entry "ctx-alloc-cells"
+             (list
+              (para (list "`ctx-alloc-cells` returns the number of heap cells a context has allocated."
+                          "Without argument an association list from context id to count is returned for all contexts."
+                          "The count of the running context is brought up to date when it yields, blocks or"
+                          "its quota runs out and before each garbage collection."
+                          ))
+              (code '((ctx-alloc-cells (self))
+                      ))
+              end)))
+
 (define gc-is-always-gc
     (ref-entry "is-always-gc"
 	       (list
@@ -114,6 +187,12 @@
 (define chapter-gc
   (section 2 "GC"
            (list gc-stack
+                 gc-pause-budget
+                 gc-log
+                 gc-histogram
+                 gc-max-pause
+                 gc-stats-reset
+                 ctx-alloc-cells
 		 gc-is-always-gc)))
 
 
@@ -124,6 +203,8 @@
               (para (list "`env-get` can be used to reify, turn into value, parts of the global environment."
                           "The global environment is stored as a hashtable and an index into this hashtable"
                           "is used to extract the bindings stored under that hash."
+                          "The table starts out with 32 entries and grows as definitions are added,"
+                          "`env-stats` gives the current size. Indices wrap around the size of the table."
                           ))
               (code-raw '((env-get 0)
                           (env-get 1)
@@ -180,6 +261,19 @@
               end)))
 
 
+(define environment-stats
+  (ref-entry "env-stats"
+             (list
+              (para (list "`env-stats` returns a list `(roots used-roots bindings max-chain)` describing"
+                          "the global environment hashtable. `roots` is the number of entries in the table,"
+                          "`used-roots` the number of entries holding at least one binding, `bindings` the"
+                          "total number of bindings and `max-chain` the largest number of bindings stored"
+                          "under one entry. The load factor is `bindings` divided by `roots`."
+                          ))
+              (code '((env-stats)
+                      ))
+              end)))
+
 (define local-environment-get
   (ref-entry "local-env-get"
              (list
@@ -196,6 +290,7 @@
   (section 2 "Environments"
            (list environment-get
                  environment-set
+                 environment-stats
                  local-environment-get
                  )))
 
@@ -195,6 +195,7 @@
              (bullet '("Line metrics table - \"lmtx\"" 
                        "Kerning table - \"kern\""
                        "Glyph table - \"glyphs\""
+                       "Index table - \"index\""
                        ))
              (para (list "**Line metrics**"
                          ))
@@ -241,6 +242,25 @@
                        "height : int32"
                        "data : uint8[]"
                        ))
+             (para (list "**Index table**"
+                         ))
+             (bullet '("\"index\" - zero terminated string"
+                       "size - uint32"
+                       "num_glyphs - uint32"
+                       "num_rows - uint32"
+                       "glyphs - index_entry[]"
+                       "rows - index_entry[]"
+                       ))
+             (para (list "index_entry:"
+                         ))
+             (bullet '("utf32 : uint32"
+                       "position : uint32"
+                       ))
+             (para (list "The index table has an entry per glyph and per kerning row, sorted by code,"
+                         "with the position of the glyph or row in the binary blob."
+                         "`ttf-prepare` adds it so that glyphs and kerning pairs are found by binary search."
+                         "Fonts without an index table are searched from the start of the tables."
+                         ))
              )
             )        
    (section 1 "Reference"
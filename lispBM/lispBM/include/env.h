@@ -25,8 +25,26 @@
 extern "C" {
 #endif
 
+/** Initial number of buckets in the global environment. */
 #define GLOBAL_ENV_ROOTS 32
-#define GLOBAL_ENV_MASK  0x1F
+
+/** The global environment doubles its number of buckets, up to this
+ *  limit, when a definition is added to a bucket that already holds
+ *  LBM_GLOBAL_ENV_MAX_CHAIN bindings. Both must be powers of two.
+ */
+#ifndef LBM_GLOBAL_ENV_MAX_ROOTS
+#define LBM_GLOBAL_ENV_MAX_ROOTS 512
+#endif
+#ifndef LBM_GLOBAL_ENV_MAX_CHAIN
+#define LBM_GLOBAL_ENV_MAX_CHAIN 4
+#endif
+
+typedef struct {
+  lbm_uint roots;      // Number of buckets.
+  lbm_uint used_roots; // Buckets holding at least one binding.
+  lbm_uint bindings;   // Number of bindings.
+  lbm_uint max_chain;  // Length of the longest bucket.
+} lbm_global_env_stats_t;
 
 //environment interface
 /** Initialize the global environment. This sets the global environment to NIL
@@ -34,11 +52,21 @@ extern "C" {
  * \return 1
  */
 int lbm_init_env(void);
-/**
+/** The global environment is an array of lbm_get_global_env_roots()
+ *  buckets. The array may be reallocated when a definition is added.
  *
  * \return the global environment
  */
 lbm_value *lbm_get_global_env(void);
+/**
+ * \return The current number of buckets in the global environment.
+ */
+lbm_uint lbm_get_global_env_roots(void);
+/** Collect load statistics for the global environment.
+ *  The load factor is bindings / roots.
+ * \param stats Result is stored here.
+ */
+void lbm_get_global_env_stats(lbm_global_env_stats_t *stats);
 /**
  * \return the size of the global env in number of heap cells.
  */
@@ -65,6 +93,45 @@ bool lbm_env_lookup_b(lbm_value *res, lbm_value sym, lbm_value env);
  * \return True on success or false otherwise.
  */
 bool lbm_global_env_lookup(lbm_value *res, lbm_value sym);
+/** Create or update a binding in the global environment.
+ *
+ * \param key A symbol to associate with a value.
+ * \param val The value.
+ * \return ENC_SYM_TRUE on success or ENC_SYM_MERROR if GC needs to be run.
+ */
+lbm_value lbm_global_env_set(lbm_value key, lbm_value val);
+/** Modify an existing binding in the global environment.
+ *
+ * \param key The key.
+ * \param val The new value to associate with the key.
+ * \return true on success or false if the key is not bound.
+ */
+bool lbm_global_env_modify(lbm_value key, lbm_value val);
+/** Remove a binding from the global environment.
+ *
+ * \param key Key to remove.
+ * \return true on success or false if the key is not bound.
+ */
+bool lbm_global_env_drop(lbm_value key);
+/** Look up the (key . val) cell that binds a symbol in the global
+ *  environment. define and setq update the cell in place, so it stays
+ *  valid until lbm_global_env_changed is called.
+ * \param sym The key to look for.
+ * \return The binding cell or ENC_SYM_NIL if sym is not bound.
+ */
+lbm_value lbm_global_env_binding(lbm_value sym);
+/** A cons cell that stands for the current state of the global
+ *  environment, or ENC_SYM_NIL until one is allocated. Binding cells
+ *  found while a token was current are valid while it stays current.
+ *  A copy of the token, made by flatten or move-to-flash, is never the
+ *  current token. The GC marks it.
+ */
+extern lbm_value lbm_global_env_token;
+/** Must be called whenever a binding cell is removed from the global
+ *  environment or a global environment bucket is replaced by other means
+ *  than lbm_env_set. Drops the current token.
+ */
+void lbm_global_env_changed(void);
 /** Create a new binding on the environment or replace an old binding.
  *
  * \param env Environment to modify.
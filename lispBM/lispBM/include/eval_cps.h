@@ -65,9 +65,10 @@ typedef struct eval_context_s{
   lbm_value program;
   lbm_value curr_exp;
   lbm_value curr_env;
-  lbm_value *mailbox;    /* Message passing mailbox */
+  lbm_value *mailbox;    /* Message passing mailbox, a ring buffer */
   uint32_t  mailbox_size;
   uint32_t  num_mail;    /* Number of messages in mailbox */
+  uint32_t  mail_first;  /* Index of the oldest message */
   uint32_t  flags;
   lbm_value r;
   const char *error_reason;
@@ -79,14 +80,75 @@ typedef struct eval_context_s{
   char *name;
   lbm_cid id;
   lbm_cid parent;
+  lbm_uint alloc_cells;  /* Heap cells allocated while running */
   /* while reading */
   lbm_int row0;
   lbm_int row1;
   /* List structure */
   struct eval_context_s *prev;
   struct eval_context_s *next;
+  /* Deadline ordered list of contexts that wake up on a timeout */
+  struct eval_context_s *timer_prev;
+  struct eval_context_s *timer_next;
 } eval_context_t;
 
+/** Get a message from the mailbox of a context.
+ * \param ctx Context.
+ * \param ix Message index, 0 is the oldest message. Must be less than ctx->num_mail.
+ * \return The message.
+ */
+static inline lbm_value lbm_mailbox_get_mail(eval_context_t *ctx, uint32_t ix) {
+  uint32_t i = ctx->mail_first + ix;
+  if (i >= ctx->mailbox_size) i -= ctx->mailbox_size;
+  return ctx->mailbox[i];
+}
+
+/* GC telemetry */
+#ifndef LBM_GC_LOG_SIZE
+#define LBM_GC_LOG_SIZE 16
+#endif
+#define LBM_GC_PAUSE_BUCKETS 12
+#define LBM_GC_USE_BUCKETS   10
+
+#define LBM_GC_TRIGGER_ALLOC       0  // An allocation failed.
+#define LBM_GC_TRIGGER_REQUEST     1  // lbm_request_gc.
+#define LBM_GC_TRIGGER_EXPLICIT    2  // lbm_perform_gc.
+#define LBM_GC_TRIGGER_INCREMENTAL 3  // An incremental collection completed.
+#define LBM_GC_NUM_TRIGGERS        4
+
+/** One garbage collection. Times are in microseconds as given by the
+ *  timestamp callback. For incremental collections the times are the
+ *  sums over all slices of the collection.
+ */
+typedef struct {
+  uint32_t timestamp;          // When the collection started.
+  uint32_t mark_us;
+  uint32_t sweep_us;
+  uint32_t trigger;            // LBM_GC_TRIGGER_X
+  lbm_cid  cid;                // Context running at the start, -1 if none.
+  lbm_uint free_before;        // Free heap cells when the collection started.
+  lbm_uint recovered;          // Heap cells freed.
+  lbm_uint recovered_arrays;   // Arrays freed.
+  lbm_uint free_after;         // Free heap cells after the collection.
+  lbm_uint mem_free;           // Free lbm_memory words after the collection.
+  lbm_uint mem_longest_free;   // Longest free lbm_memory block after the collection.
+} lbm_gc_record_t;
+
+/** Statistics over all collections since init or lbm_reset_gc_stats.
+ *  Pause bucket 0 counts pauses below 32us and bucket i > 0 pauses in
+ *  [2^(i+4), 2^(i+5)) us, the last bucket everything longer. Every
+ *  incremental slice is a pause of its own. Use bucket i counts
+ *  collections that left [10i, 10(i+1)) percent of the heap in use.
+ */
+typedef struct {
+  lbm_uint num;                              // Number of collections recorded.
+  lbm_uint pause_hist[LBM_GC_PAUSE_BUCKETS];
+  lbm_uint use_hist[LBM_GC_USE_BUCKETS];
+  lbm_uint triggers[LBM_GC_NUM_TRIGGERS];
+  uint32_t max_pause_us;
+  lbm_gc_record_t log[LBM_GC_LOG_SIZE];      // Ring buffer, log[(num - 1) % LBM_GC_LOG_SIZE] is the newest.
+} lbm_gc_stats_t;
+
 typedef enum {
   LBM_EVENT_FOR_HANDLER = 0,
   LBM_EVENT_UNBLOCK_CTX,
@@ -144,8 +206,21 @@ void lbm_set_eval_time_quota(uint32_t quota);
  */
 void lbm_set_eval_step_quota(uint32_t quota);
 #endif
+/** Get the number of evaluation steps performed since the evaluator
+ *  started. The counter wraps around on overflow.
+ * \return Number of evaluation steps.
+ */
+lbm_uint lbm_get_eval_steps(void);
+/** Set the longest time the evaluator sleeps when there is nothing to run.
+ *  While idle the evaluator sleeps until the next sleeping or timeout
+ *  blocked context is due, but never longer than this. Events and
+ *  contexts created from other threads are picked up when it wakes.
+ *  The default is the minimum sleep period, 200us.
+ * \param us Maximum idle sleep in microseconds.
+ */
+void lbm_set_eval_idle_sleep_max(uint32_t us);
 /** Initialize events
- * \param num_events The maximum number of unprocessed events.
+ * \param num_events The maximum number of unprocessed events. Rounded up to a power of two.
  * \return true on success, false otherwise.
  */
 bool lbm_eval_init_events(unsigned int num_events);
@@ -187,6 +262,20 @@ bool lbm_event(lbm_flat_value_t *fv);
  * \return true on success.
  */
 bool lbm_event_unboxed(lbm_value unboxed);
+/** Send an unboxed value as an event to the event handler from an
+ *  interrupt handler. The event queue takes no locks so this can be
+ *  called from any context. Unlike lbm_event_unboxed it does not check
+ *  the free space in the mailbox of the event handler, as that takes
+ *  the context queue mutex.
+ * \param unboxed. An lbm_value (encoded) such as a symbol. int, uint, character.
+ * \return true on success, false if the event queue is full.
+ */
+bool lbm_event_unboxed_isr(lbm_value unboxed);
+/** Get the number of events that were dropped because the event queue
+ *  or the mailbox of the event handler was full.
+ * \return Number of dropped events since lbm_eval_init_events.
+ */
+uint32_t lbm_get_num_dropped_events(void);
 /** Check if the event queue is empty.
  * \return true if event queue is empty, otherwise false.
  */
@@ -249,6 +338,19 @@ void lbm_kill_eval(void);
  * \return Current state of the evaluator.
  */
 uint32_t lbm_get_eval_state(void);
+/** Collect the functions of applications that are waiting for their
+ *  arguments on the continuation stack of a context, innermost first.
+ *  Closures are represented by their body and extensions by their symbol.
+ *  Built in operations are left out. Used by the profiler.
+ *
+ * \param ctx Context to inspect.
+ * \param res Functions are stored here.
+ * \param max Max number of functions to store in res.
+ * \param max_scan Max number of stack elements to inspect.
+ * \param truncated Set to true if not the entire stack was inspected.
+ * \return Number of functions stored in res.
+ */
+lbm_uint lbm_get_pending_applications(eval_context_t *ctx, lbm_value *res, lbm_uint max, lbm_uint max_scan, bool *truncated);
 /** Provide a description of an error as a string.
  *  Use when implementing for example extensions to
  *  report an error message to the programmer in case
@@ -352,6 +454,13 @@ void lbm_set_hide_trapped_error(bool hide);
  * \param fptr Pointer to a sleep function.
  */
 void lbm_set_usleep_callback(void (*fptr)(uint32_t));
+/** Set a callback that wakes up the evaluator thread from the sleep
+ *  in the usleep callback. It is called when an event is added while
+ *  the evaluator is idle, possibly from an interrupt handler.
+ *
+ * \param fptr Pointer to a wakeup function.
+ */
+void lbm_set_eval_wakeup_callback(void (*fptr)(void));
 /** Set a timestamp callback for use by the evaluator thread.
  *
  * \param fptr Pointer to a timestamp generating function.
@@ -422,6 +531,35 @@ bool lbm_find_receiver_and_send(lbm_cid cid, lbm_value msg);
  * \return 1 on success
  */
 int lbm_perform_gc(void);
+/** Make garbage collection incremental. Collections then run in slices
+ *  between evaluation steps, each marking or sweeping at most budget
+ *  heap cells. The mark bitmap and stack of the incremental collector
+ *  are allocated from lbm_memory.
+ *
+ * \param budget Number of cells per slice. 0 disables incremental collection.
+ * \return true on success, false if there was not enough lbm_memory.
+ */
+bool lbm_set_gc_pause_budget(lbm_uint budget);
+/** Get the pause budget of the incremental garbage collector.
+ *
+ * \return Number of cells per slice, 0 if collection is not incremental.
+ */
+lbm_uint lbm_get_gc_pause_budget(void);
+/** Get the statistics collected by the garbage collector.
+ *
+ * \return Pointer to the statistics, updated by every collection.
+ */
+const lbm_gc_stats_t *lbm_get_gc_stats(void);
+/** Get one of the most recent garbage collection records.
+ *
+ * \param n 0 for the newest record, 1 for the one before and so on.
+ * \param rec Record to fill in.
+ * \return true if there was such a record, false otherwise.
+ */
+bool lbm_get_gc_record(lbm_uint n, lbm_gc_record_t *rec);
+/** Clear the garbage collection statistics and the per context allocation counters.
+ */
+void lbm_reset_gc_stats(void);
 /** Request that the runtime system performs a garbage collection on its earliers convenience.
  *  Can be called from any thread and does NOT require that the evaluator is paused.
  */
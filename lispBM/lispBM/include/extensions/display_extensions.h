@@ -44,12 +44,15 @@ typedef enum {
   COLOR_PRE_Y,
 } COLOR_TYPE;
 
+typedef struct img_dirty_s img_dirty_t;
+
 typedef struct {
   color_format_t fmt;
   uint16_t width;
   uint16_t height;
   uint8_t  *data;
   uint8_t  *mem_base;
+  img_dirty_t *dirty; // NULL unless allocated with dirty tracking.
 } image_buffer_t;
 
 
@@ -182,6 +185,12 @@ uint32_t getpixel(image_buffer_t* img, int x_i, int y_i);
 bool lbm_display_is_color(lbm_value v);
 uint32_t lbm_display_rgb888_from_color(color_t color, int x, int y);
 void image_buffer_clear(image_buffer_t *img, uint32_t cc);
+// The dirty region state stored after the pixels of an image buffer
+// allocated with 'dirty-track, NULL for other image buffers.
+img_dirty_t *image_buffer_dirty(lbm_array_header_t *arr);
+// Records that the w x h area at x, y of img changed, for images that
+// have dirty region tracking enabled with img-dirty-track.
+void image_buffer_mark_dirty(image_buffer_t *img, int x, int y, int w, int h);
 
 void lbm_display_extensions_init(void);
 void lbm_display_extensions_set_callbacks(
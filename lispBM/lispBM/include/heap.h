@@ -226,10 +226,22 @@ typedef struct {
   lbm_uint gc_least_free;      // The smallest length of the freelist.
   lbm_uint gc_last_free;       // Number of elements on the freelist
                                // after most recent GC.
+
+  lbm_uint *gc_inc_marks;      // Mark bits of the incremental GC, one per cell.
+  lbm_stack_t gc_inc_stack;    // Values waiting to be marked by the incremental GC.
+  lbm_uint gc_inc_phase;       // LBM_GC_INC_IDLE, LBM_GC_INC_MARK or LBM_GC_INC_SWEEP.
+  lbm_uint gc_inc_sweep_ix;    // Next cell to be swept by the incremental GC.
+  lbm_uint gc_inc_rescan_ix;   // Next cell to be rescanned after an overflow.
+  bool gc_inc_overflow;        // The incremental GC stack overflowed.
 } lbm_heap_state_t;
 
 extern lbm_heap_state_t lbm_heap_state;
 
+/* Phases of the incremental GC */
+#define LBM_GC_INC_IDLE  0
+#define LBM_GC_INC_MARK  1
+#define LBM_GC_INC_SWEEP 2
+
 typedef bool (*const_heap_write_fun)(lbm_uint w, lbm_uint ix);
 
 typedef struct {
@@ -611,6 +623,89 @@ void lbm_gc_mark_roots(lbm_uint *roots, lbm_uint num_roots);
  */
 int lbm_gc_sweep_phase(void);
 
+// Incremental garbage collection
+//
+// The incremental GC marks into a bitmap of its own and keeps the values
+// waiting to be marked on a stack of its own. Heap cells are not touched
+// while marking, so the evaluator can run in between slices of work.
+// Stores of heap values into cells and arrays go through
+// lbm_gc_write_barrier while marking. A stop-the-world GC (lbm_perform_gc)
+// abandons an ongoing incremental collection.
+
+/** Allocate the mark bitmap and stack for the incremental GC from lbm_memory.
+ * \return true on success or if already allocated.
+ */
+bool lbm_gc_inc_init(void);
+/** Start an incremental collection by entering the mark phase. The roots
+ *  are added with lbm_gc_inc_push and lbm_gc_inc_mark_root.
+ */
+void lbm_gc_inc_begin(void);
+/** Abandon an ongoing incremental collection. The cells swept so far are
+ *  on the freelist, everything else is left for the next collection.
+ */
+void lbm_gc_inc_abort(void);
+/** Add a value to the set of values to be marked by lbm_gc_inc_mark.
+ * \param v Value, non heap values are ignored.
+ */
+void lbm_gc_inc_push(lbm_value v);
+/** Mark everything reachable from a root without a work limit.
+ * \param v Root value.
+ */
+void lbm_gc_inc_mark_root(lbm_value v);
+/** lbm_gc_inc_mark_root on the values of an array, with the same extra
+ *  checks as lbm_gc_mark_aux.
+ * \param data Array of roots.
+ * \param n Number of elements in the array.
+ */
+void lbm_gc_inc_mark_aux(lbm_uint *data, lbm_uint n);
+/** Mark cells until no values are left to be marked or the budget runs out.
+ *  Values that did not fit on the stack are found again by rescanning the
+ *  heap, in slices as well.
+ * \param budget Number of cells and array elements that may be visited.
+ *        Decremented by the number visited.
+ * \return true if there are no values left to be marked.
+ */
+bool lbm_gc_inc_mark(lbm_uint *budget);
+/** Leave the mark phase and start sweeping from the first cell.
+ */
+void lbm_gc_inc_start_sweep(void);
+/** Sweep at most budget cells.
+ * \param budget Number of cells to sweep.
+ * \return true when the whole heap has been swept and the collection is done.
+ */
+bool lbm_gc_inc_sweep(lbm_uint budget);
+/** Barrier part of lbm_gc_write_barrier.
+ */
+void lbm_gc_inc_shade(lbm_value target, lbm_value v);
+/** Allocation part of lbm_gc_inc_allocated.
+ */
+void lbm_gc_inc_alloc_cell(lbm_uint ix);
+
+/** Write barrier of the incremental GC. To be called when the heap value v
+ *  is stored into the cons cell or lisp array target, unless target was
+ *  just allocated.
+ * \param target The cell or array written to.
+ * \param v The value stored.
+ */
+static inline void lbm_gc_write_barrier(lbm_value target, lbm_value v) {
+  if (lbm_heap_state.gc_inc_phase == LBM_GC_INC_MARK) {
+    lbm_gc_inc_shade(target, v);
+  }
+}
+
+/** To be called for each cell taken from the freelist. While marking and
+ *  ahead of the sweep the cell is marked, so it is not swept, and while
+ *  marking its contents are queued to be marked in a later slice. Behind
+ *  the sweep the mark is cleared. When idle the marks are not looked at,
+ *  lbm_gc_inc_begin clears them all.
+ * \param ix Heap index of the allocated cell.
+ */
+static inline void lbm_gc_inc_allocated(lbm_uint ix) {
+  if (lbm_heap_state.gc_inc_phase != LBM_GC_INC_IDLE) {
+    lbm_gc_inc_alloc_cell(ix);
+  }
+}
+
 // Array functionality
 /** Allocate an bytearray in symbols and arrays memory (lispbm_memory.h)
  * and create a heap cell that refers to this bytearray.
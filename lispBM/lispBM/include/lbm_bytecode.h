@@ -0,0 +1,125 @@
+/*
+    Copyright 2026 Joel Svensson  svenssonjoel@yahoo.se
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/** \file lbm_bytecode.h
+ *
+ *  Compilation of closures into bytecode.
+ *
+ *  A compiled closure is an ordinary closure whose body has been replaced
+ *  by the form (bytecode code consts). The closure can be printed,
+ *  flattened and moved to flash like any other. The evaluator runs the
+ *  code when the closure is applied, with the arguments and local
+ *  variables in slots on the context stack instead of in an environment.
+ *
+ *  code is a byte array. The first BC_HEADER_SIZE bytes hold the number
+ *  of parameters, the number of local slots (parameters included) and the
+ *  index in consts of the first global reference. The instructions follow.
+ *
+ *  consts is a lisp array. Element BC_CONST_PARAMS holds the parameter
+ *  list. Constants and captured binding cells follow, and last the symbol
+ *  of each global. Element BC_CONST_CELLS is a byte array with the binding
+ *  cell of each global, filled in at first use. The cells are not seen by
+ *  the GC, print or flatten, they are only used while element
+ *  BC_CONST_TOKEN is lbm_global_env_token. Code in flash looks up its
+ *  globals at every use.
+ */
+
+#ifndef LBM_BYTECODE_H_
+#define LBM_BYTECODE_H_
+
+#include "lbm_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Max size in bytes of the code of one closure. */
+#ifndef LBM_BYTECODE_MAX_CODE
+#define LBM_BYTECODE_MAX_CODE 1024
+#endif
+/** Max number of constants and captured bindings of one closure. */
+#ifndef LBM_BYTECODE_MAX_CONSTS
+#define LBM_BYTECODE_MAX_CONSTS 64
+#endif
+/** Max number of globals referenced by one closure. */
+#ifndef LBM_BYTECODE_MAX_GLOBALS
+#define LBM_BYTECODE_MAX_GLOBALS 64
+#endif
+/** Max number of local slots, parameters included. */
+#ifndef LBM_BYTECODE_MAX_LOCALS
+#define LBM_BYTECODE_MAX_LOCALS 32
+#endif
+
+#define BC_HEADER_NUM_PARAMS 0
+#define BC_HEADER_NUM_LOCALS 1
+#define BC_HEADER_GLOBALS    2
+#define BC_HEADER_SIZE       3
+
+#define BC_CONST_TOKEN       0
+#define BC_CONST_PARAMS      1
+#define BC_CONST_CELLS       2
+#define BC_CONST_FIRST       3
+
+// Instructions. n is a local slot, k an index into consts, g a global,
+// a a two byte little endian code address and c an argument count.
+#define BC_CONST      0  // k    push consts[k]
+#define BC_LOCAL      1  // n    push local n
+#define BC_SET_LOCAL  2  // n    local n = top
+#define BC_STORE      3  // n    local n = pop
+#define BC_CELL       4  // k    push cdr of the binding cell consts[k]
+#define BC_SET_CELL   5  // k    cdr of the binding cell consts[k] = top
+#define BC_GLOBAL     6  // g    push value of global g
+#define BC_SET_GLOBAL 7  // g    global g = top
+#define BC_POP        8  //      drop top
+#define BC_JMP        9  // a    jump
+#define BC_JMP_NIL    10 // a    jump if pop is nil
+#define BC_AND        11 // a    jump if top is nil, else pop
+#define BC_OR         12 // a    jump if top is not nil, else pop
+#define BC_FUND       13 // i c  call fundamental i on the top c values
+#define BC_CALL       14 // c    call the function below the top c values
+#define BC_TAIL       15 // c    as BC_CALL, in place of the current call
+#define BC_RET        16 //      return top
+#define BC_NUM_OPS    17
+
+/** The code ends with this many BC_RET, so that no instruction reads
+ *  its operands past the end.
+ */
+#define BC_TRAILER_SIZE 3
+
+/** Compile the body of a closure.
+ *
+ *  Bodies built from quote, if, cond, and, or, progn, var, let, loop,
+ *  setq and function applications are compiled. Parameters and local
+ *  variables become stack slots. Variables captured from the closure
+ *  environment and globals are referred to by their binding cells.
+ *
+ * \param closure Closure to compile.
+ * \return The compiled closure, ENC_SYM_NIL if the body uses something
+ *         that cannot be compiled or ENC_SYM_MERROR if memory ran out.
+ */
+lbm_value lbm_bytecode_compile(lbm_value closure);
+
+/** Check if a closure has been compiled.
+ * \param closure The closure.
+ * \return true if the body of closure is a bytecode form.
+ */
+bool lbm_bytecode_is_compiled(lbm_value closure);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
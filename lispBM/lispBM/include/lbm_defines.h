@@ -257,7 +257,8 @@
 #define SYM_TRAP                0x116
 #define SYM_CALL_CC_UNSAFE      0x117
 #define SYM_CONT_SP             0x118
-#define SPECIAL_FORMS_END       0x118
+#define SYM_BYTECODE            0x119
+#define SPECIAL_FORMS_END       0x119
 
 #ifndef LBM64
 #define SPECIAL_FORMS_MASK        0xFFFFFF00
@@ -346,6 +347,8 @@
 #define SYM_IS_STRING           0x20042
 #define SYM_IS_CONSTANT         0x20043
 #define SYM_MEMBER              0x20044
+#define SYM_COMPILE             0x20045
+#define FUNDAMENTALS_END        0x20045
 
 // Apply funs:
 // Get their arguments in evaluated form on the stack.
@@ -524,6 +527,7 @@
 #define ENC_SYM_TRAP                  ENC_SYM(SYM_TRAP)
 #define ENC_SYM_CALL_CC_UNSAFE        ENC_SYM(SYM_CALL_CC_UNSAFE)
 #define ENC_SYM_CONT_SP               ENC_SYM(SYM_CONT_SP)
+#define ENC_SYM_BYTECODE              ENC_SYM(SYM_BYTECODE)
 #define ENC_SYM_APPLY                 ENC_SYM(SYM_APPLY)
 
 #define ENC_SYM_ADD           ENC_SYM(SYM_ADD)
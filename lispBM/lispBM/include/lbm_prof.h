@@ -23,6 +23,15 @@
 
 #define LBM_PROF_MAX_NAME_SIZE 20
 
+/** Max number of functions recorded per stack sample. */
+#ifndef LBM_PROF_MAX_DEPTH
+#define LBM_PROF_MAX_DEPTH 8
+#endif
+/** Max number of continuation stack elements inspected per sample. */
+#ifndef LBM_PROF_MAX_SCAN
+#define LBM_PROF_MAX_SCAN 256
+#endif
+
 typedef struct {
   lbm_cid cid;
   bool has_name;
@@ -31,12 +40,59 @@ typedef struct {
   lbm_uint gc_count;
 } lbm_prof_t;
 
+/** A sampled call stack. Frames are outermost first and are either
+ *  a code cell in the body of a closure or an extension symbol.
+ */
+typedef struct {
+  lbm_cid  cid;
+  lbm_uint hash;
+  lbm_uint count;
+  lbm_uint depth;
+  bool     gc;
+  bool     truncated;
+  lbm_value frames[LBM_PROF_MAX_DEPTH];
+} lbm_prof_stack_t;
+
+/** Initialize the profiler. Both tables are hash tables and entries
+ *  with cid -1 are unused.
+ *
+ * \param prof_data_buf Storage for samples per context.
+ * \param prof_data_buf_num Number of elements in prof_data_buf.
+ * \return true on success.
+ */
 bool lbm_prof_init(lbm_prof_t *prof_data_buf,
                    lbm_uint    prof_data_buf_num);
+/** Enable stack sampling. Call after lbm_prof_init. Stack sampling
+ *  is disabled again by lbm_prof_init or by passing NULL, which must
+ *  be done before stack_buf is freed.
+ *
+ * \param stack_buf Storage for sampled stacks, or NULL.
+ * \param stack_buf_num Number of elements in stack_buf.
+ * \return true on success.
+ */
+bool lbm_prof_init_stacks(lbm_prof_stack_t *stack_buf,
+                          lbm_uint          stack_buf_num);
 lbm_uint lbm_prof_get_num_samples(void);
 lbm_uint lbm_prof_get_num_system_samples(void);
 lbm_uint lbm_prof_get_num_sleep_samples(void);
+/**
+ * \return Number of samples that did not fit in a table.
+ */
+lbm_uint lbm_prof_get_num_dropped_samples(void);
 lbm_uint lbm_prof_stop(void);
 void lbm_prof_sample(void);
+/** Export the sampled stacks in folded format, one line per stack:
+ *  "context;f;g;extension count". Closures are named after the global
+ *  binding they are stored in. The lines can be fed to flamegraph.pl.
+ *  The evaluator should be paused while exporting.
+ *
+ * \param line Buffer for one line of output.
+ * \param line_size Size of line. Longer lines lose their last frames,
+ *        the count is kept.
+ * \param emit Called with each line.
+ * \return Number of lines emitted.
+ */
+lbm_uint lbm_prof_export_folded(char *line, lbm_uint line_size,
+                                void (*emit)(const char *line));
 
 #endif
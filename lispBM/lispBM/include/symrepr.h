@@ -67,6 +67,16 @@ bool store_symbol_name_flash(char *name, lbm_uint *res);
  * \return 1
  */
 int lbm_symrepr_init(void);
+/** Add an extension to the symbol hash index. Called when a new extension
+ *  name is added to the extension table.
+ *
+ * \param ext_ix Index of the extension in the extension table.
+ */
+void lbm_symrepr_index_add_extension(lbm_uint ext_ix);
+/** Make the symbol hash index rebuild itself on the next lookup. Called
+ *  when the extension table is reset or restored from an image.
+ */
+void lbm_symrepr_index_invalidate(void);
 /** Iterate over all symbol names as strings
  *
  * \param symrepr_name_iterator_fun function taking a string
@@ -12,6 +12,7 @@ LISPBM_SRC = $(LISPBM)/src/env.c \
              $(LISPBM)/src/lispbm.c \
              $(LISPBM)/src/eval_cps.c \
              $(LISPBM)/src/lbm_c_interop.c \
+             $(LISPBM)/src/lbm_bytecode.c \
              $(LISPBM)/src/lbm_custom_type.c \
              $(LISPBM)/src/lbm_channel.c \
              $(LISPBM)/src/lbm_flat_value.c\
@@ -41,6 +42,7 @@ LISPBM_H = $(LISPBM)/include/env.h \
            $(LISPBM)/include/heap_vis.h \
            $(LISPBM)/include/lbm_channel.h \
            $(LISPBM)/include/lbm_c_interop.h \
+           $(LISPBM)/include/lbm_bytecode.h \
            $(LISPBM)/include/lbm_constants.h \
            $(LISPBM)/include/lbm_custom_type.h \
            $(LISPBM)/include/lbm_defines.h \
@@ -168,13 +168,18 @@ static size_t constants_memory_size = 4096;  // size words
 #define EXTENSION_STORAGE_SIZE 1024
 #define STR_SIZE 1024
 #define PROF_DATA_NUM 100
+#define PROF_STACKS_NUM 512
 
 lbm_extension_t extensions[EXTENSION_STORAGE_SIZE];
 lbm_prof_t prof_data[100];
+lbm_prof_stack_t prof_stacks[PROF_STACKS_NUM];
 
 static char *env_input_file = NULL;
 static char *env_output_file = NULL;
 static volatile char *res_output_file = NULL;
+static char *bench_output_file = NULL;
+static volatile uint32_t startup_done_time = 0;
+static char startup_result[256];
 static bool terminate_after_startup = false;
 static volatile lbm_cid startup_cid = -1;
 static volatile lbm_cid store_result_cid = -1;
@@ -382,6 +387,9 @@ void done_callback(eval_context_t *ctx) {
 
   if (startup_cid != -1) {
     if (ctx->id == startup_cid) {
+      startup_done_time = timestamp();
+      strncpy(startup_result, output, sizeof(startup_result) - 1);
+      startup_result[sizeof(startup_result) - 1] = 0;
       startup_cid = -1;
     }
   }
@@ -407,6 +415,12 @@ void sleep_callback(uint32_t us) {
 
 static bool prof_running = false;
 
+static FILE *prof_folded_fp = NULL;
+
+static void prof_emit_folded(const char *line) {
+  fprintf(prof_folded_fp, "%s\n", line);
+}
+
 #ifdef LBM_WIN
 DWORD WINAPI prof_thd(LPVOID lpParam) {
   while (prof_running) {
@@ -547,6 +561,7 @@ lbm_const_heap_t const_heap;
 #define VESCTCP_PORT         0x0408
 #define VESCTCP_PROGRAM_FLASH_SIZE   0x0409
 #define HISTORY_FILE         0x0410
+#define BENCH_JSON           0x0411
 
 struct option options[] = {
   {"help", no_argument, NULL, 'h'},
@@ -565,6 +580,7 @@ struct option options[] = {
   {"vesctcp_port",required_argument, NULL, VESCTCP_PORT},
   {"vesctcp_program_flash_size", required_argument, NULL, VESCTCP_PROGRAM_FLASH_SIZE},
   {"history_file", required_argument, NULL, HISTORY_FILE},
+  {"bench_json", required_argument, NULL, BENCH_JSON},
   {0,0,0,0}};
 
 typedef struct src_list_s {
@@ -636,7 +652,7 @@ void parse_opts(int argc, char **argv) {
   int c;
   opterr = 1;
   int opt_index = 0;
-  while ((c = getopt_long(argc, argv, "H:M:C:hse:",options, &opt_index)) != -1) {
+  while ((c = getopt_long(argc, argv, "H:M:C:hs:e:",options, &opt_index)) != -1) {
     switch (c) {
     case 'H':
       heap_size = (size_t)atoi((char*)optarg);
@@ -722,6 +738,9 @@ void parse_opts(int argc, char **argv) {
       printf("    --terminate                       Terminate the REPL after evaluating the\n" \
              "                                      source files specified with --src/-s\n");
       printf("    --load_image=FILEPATH             load an image-file at startup\n");
+      printf("    --bench_json=FILEPATH             Write time, evaluation steps, GC and\n"\
+             "                                      memory statistics for each program\n"\
+             "                                      specified with --src/-s as JSON.\n");
       printf("\n");
       printf("    --vesctcp                         Open a TCP server talking the VESC\n"\
              "                                      protocol on port %d\n", DEFAULT_VESCIF_TCP_PORT);
@@ -814,6 +833,9 @@ void parse_opts(int argc, char **argv) {
     case VESCTCP_PROGRAM_FLASH_SIZE:
       vescif_program_flash_size= (unsigned int)atoi((char *)optarg);
       break;
+    case BENCH_JSON:
+      bench_output_file = (char*)optarg;
+      break;
     case HISTORY_FILE: {
       size_t len = strlen(optarg);
       history_file_path = malloc(len + 1);
@@ -873,15 +895,8 @@ bool load_flat_library(unsigned char *lib, unsigned int size) {
 
     pos += val_size;
 
-    lbm_uint ix_key  = sym_id & GLOBAL_ENV_MASK;
-    lbm_value *global_env = lbm_get_global_env();
-    lbm_uint orig_env = global_env[ix_key];
-    lbm_value new_env;
-
     // All of this should just succeed with no GC needed.
-    new_env = lbm_env_set(orig_env,sym,val);
-
-    global_env[ix_key] = new_env;
+    lbm_global_env_set(sym,val);
   }
   return true;
 }
@@ -1013,10 +1028,54 @@ int init_repl(void) {
   return 1;
 }
 
+static void json_write_string(FILE *fp, const char *str) {
+  fputc('"', fp);
+  for (const char *c = str; *c; c ++) {
+    if (*c == '"' || *c == '\\') {
+      fputc('\\', fp);
+      fputc(*c, fp);
+    } else if ((unsigned char)*c < 0x20) {
+      fprintf(fp, "\\u%04x", (unsigned int)*c);
+    } else {
+      fputc(*c, fp);
+    }
+  }
+  fputc('"', fp);
+}
+
+static void bench_json_write(FILE *fp, const char *filename, uint32_t time_us,
+                             lbm_uint steps, lbm_uint gc_num, uint32_t gc_max_pause_us) {
+  lbm_memory_update_min_free();
+  double time_s = (double)time_us / 1000000.0;
+  fprintf(fp, "  {\"file\": ");
+  json_write_string(fp, filename);
+  fprintf(fp, ", \"result\": ");
+  json_write_string(fp, startup_result);
+  fprintf(fp, ", \"time_s\": %f, \"steps\": %"PRI_UINT", "
+          "\"steps_per_s\": %.0f, \"gc_num\": %"PRI_UINT", \"gc_max_pause_us\": %"PRIu32", "
+          "\"gc_least_free\": %"PRI_UINT", \"memory_peak_bytes\": %"PRI_UINT"}",
+          time_s,
+          steps,
+          time_s > 0.0 ? (double)steps / time_s : 0.0,
+          gc_num,
+          gc_max_pause_us,
+          lbm_heap_state.gc_least_free,
+          lbm_memory_maximum_used() * sizeof(lbm_uint));
+}
+
 bool evaluate_sources(void) {
 
   src_list_t *curr = sources;
   char *file_str = NULL;
+  FILE *bench_fp = NULL;
+  if (bench_output_file) {
+    bench_fp = fopen(bench_output_file, "w");
+    if (bench_fp) {
+      fprintf(bench_fp, "[\n");
+    } else {
+      printf("ALERT: Cannot open benchmark result file\n");
+    }
+  }
   while (curr) {
     if (file_str) free(file_str);
     file_str = load_file(curr->filename);
@@ -1028,17 +1087,33 @@ bool evaluate_sources(void) {
       sleep_callback(10);
     }
 
+    // Evaluation is paused, GC statistics can be reset safely.
+    lbm_reset_gc_stats();
+    lbm_uint steps_start = lbm_get_eval_steps();
     startup_cid = lbm_load_and_eval_program_incremental(&string_tok, NULL);
     if (res_output_file) {
       store_result_cid = startup_cid;
     }
+    uint32_t start_time = timestamp();
     lbm_continue_eval();
 
     while (startup_cid != -1) {
       sleep_callback(10);
     }
+    if (bench_fp) {
+      if (curr != sources) fprintf(bench_fp, ",\n");
+      bench_json_write(bench_fp, curr->filename,
+                       startup_done_time - start_time,
+                       lbm_get_eval_steps() - steps_start,
+                       lbm_get_gc_stats()->num,
+                       lbm_get_gc_stats()->max_pause_us);
+    }
     curr = curr->next;
   }
+  if (bench_fp) {
+    fprintf(bench_fp, "\n]\n");
+    fclose(bench_fp);
+  }
   return true;
 }
 
@@ -1208,7 +1283,7 @@ int store_env(char *filename) {
     terminate_repl(REPL_EXIT_UNABLE_TO_OPEN_ENV_FILE);
   }
   lbm_value* env = lbm_get_global_env();
-  for (int i = 0; i < GLOBAL_ENV_ROOTS; i ++) {
+  for (int i = 0; i < (int)lbm_get_global_env_roots(); i ++) {
     lbm_value curr = env[i];
     while(lbm_is_cons(curr)) {
       lbm_value name_field = lbm_caar(curr);
@@ -1367,6 +1442,10 @@ int commands_printf_lisp(const char* format, ...) {
   return len_to_print - 1;
 }
 
+static void prof_emit_folded_lisp(const char *line) {
+  commands_printf_lisp("%s", line);
+}
+
 #define UTILS_AGE_S(x)		((float)(timestamp() - x) / 1000.0f)
 //static uint32_t repl_time = 0;
 
@@ -1770,7 +1849,7 @@ void repl_process_cmd(unsigned char *data, unsigned int len,
     send_buffer_global[ind++] = '\0';
 
     lbm_value *glob_env = lbm_get_global_env();
-    for (int i = 0; i < GLOBAL_ENV_ROOTS; i ++) {
+    for (int i = 0; i < (int)lbm_get_global_env_roots(); i ++) {
       if (ind > 300) {
         break;
       }
@@ -1831,6 +1910,9 @@ void repl_process_cmd(unsigned char *data, unsigned int len,
         commands_printf_lisp(
                              ":prof report\n"
                              "  Print profiler report");
+        commands_printf_lisp(
+                             ":prof folded\n"
+                             "  Print sampled stacks in folded format for flame graphs");
         commands_printf_lisp(
                              ":env\n"
                              "  Print current environment and variables");
@@ -1899,6 +1981,7 @@ void repl_process_cmd(unsigned char *data, unsigned int len,
 #endif
         }
         lbm_prof_init(prof_data, PROF_DATA_NUM);
+        lbm_prof_init_stacks(prof_stacks, PROF_STACKS_NUM);
           
 #ifdef LBM_WIN
         prof_thread = CreateThread(
@@ -1935,7 +2018,7 @@ void repl_process_cmd(unsigned char *data, unsigned int len,
         lbm_uint tot_gc = 0;
         commands_printf_lisp("CID\tName\tSamples\t%%Load\t%%GC");
         for (int i = 0; i < PROF_DATA_NUM; i ++) {
-          if (prof_data[i].cid == -1) break;
+          if (prof_data[i].cid == -1) continue;
           tot_gc += prof_data[i].gc_count;
           commands_printf_lisp("%d\t%s\t%u\t%.3f\t%.3f",
                                prof_data[i].cid,
@@ -1949,10 +2032,18 @@ void repl_process_cmd(unsigned char *data, unsigned int len,
         commands_printf_lisp("System:\t%u\t%f%%\n", num_system, (double)(100.0 * ((float)num_system / (float)tot_samples)));
         commands_printf_lisp("Sleep:\t%u\t%f%%\n", num_sleep, (double)(100.0 * ((float)num_sleep / (float)tot_samples)));
         commands_printf_lisp("Total:\t%u samples\n", tot_samples);
+      } else if (strncmp(str, ":prof folded", 12) == 0) {
+        char line[256];
+        lbm_pause_eval();
+        while (lbm_get_eval_state() != EVAL_CPS_STATE_PAUSED) {
+          sleep_callback(10);
+        }
+        lbm_prof_export_folded(line, sizeof(line), prof_emit_folded_lisp);
+        lbm_continue_eval();
       } else if (strncmp(str, ":env", 4) == 0) {
         lbm_value *glob_env = lbm_get_global_env();
         char output[128];
-        for (int i = 0; i < GLOBAL_ENV_ROOTS; i ++) {
+        for (int i = 0; i < (int)lbm_get_global_env_roots(); i ++) {
           lbm_value curr = glob_env[i];
           while (lbm_type_of(curr) == LBM_TYPE_CONS) {
             lbm_print_value(output, sizeof(output), lbm_car(curr));
@@ -2677,6 +2768,7 @@ int main(int argc, char **argv) {
       } else if (strncmp(str, ":prof start", 11) == 0) {
         lbm_prof_init(prof_data,
                       PROF_DATA_NUM);
+        lbm_prof_init_stacks(prof_stacks, PROF_STACKS_NUM);
 #ifndef LBM_WIN
         pthread_t thd; // just forget this id.
         prof_running = true;
@@ -2701,7 +2793,7 @@ int main(int argc, char **argv) {
         lbm_uint tot_gc = 0;
         printf("CID\tName\tSamples\t%%Load\t%%GC\n");
         for (int i = 0; i < PROF_DATA_NUM; i ++) {
-          if (prof_data[i].cid == -1) break;
+          if (prof_data[i].cid == -1) continue;
           tot_gc += prof_data[i].gc_count;
           printf("%"PRI_VALUE"\t%s\t%"PRI_UINT"\t%f\t%f\n",
                  prof_data[i].cid,
@@ -2715,9 +2807,33 @@ int main(int argc, char **argv) {
         printf("System:\t%"PRI_UINT"\t%f%%\n", num_system, 100.0 * ((float)num_system / (float)tot_samples));
         printf("Sleep:\t%"PRI_UINT"\t%f%%\n", num_sleep, 100.0 * ((float)num_sleep / (float)tot_samples));
         printf("Total:\t%"PRI_UINT" samples\n", tot_samples);
+        printf("Dropped:\t%"PRI_UINT" samples\n", lbm_prof_get_num_dropped_samples());
+        free(str);
+      } else if (strncmp(str, ":prof folded", 12) == 0) {
+        // :prof folded [file]
+        char line[256];
+        prof_folded_fp = stdout;
+        if (strlen(str) > 13) {
+          prof_folded_fp = fopen(str + 13, "w");
+          if (!prof_folded_fp) {
+            printf("Unable to open file %s\n", str + 13);
+            free(str);
+            continue;
+          }
+        }
+        lbm_pause_eval();
+        while (lbm_get_eval_state() != EVAL_CPS_STATE_PAUSED) {
+          sleep_callback(10);
+        }
+        lbm_uint n = lbm_prof_export_folded(line, sizeof(line), prof_emit_folded);
+        lbm_continue_eval();
+        if (prof_folded_fp != stdout) {
+          fclose(prof_folded_fp);
+          printf("Wrote %"PRI_UINT" stacks to %s\n", n, str + 13);
+        }
         free(str);
       } else if (strncmp(str, ":env", 4) == 0) {
-        for (int i = 0; i < GLOBAL_ENV_ROOTS; i ++) {
+        for (int i = 0; i < (int)lbm_get_global_env_roots(); i ++) {
           lbm_value *env = lbm_get_global_env();
           lbm_value curr = env[i];
           printf("Environment [%d]:\r\n", i);
@@ -24,18 +24,36 @@
 #include "env.h"
 #include "lbm_memory.h"
 
-static lbm_value env_global[GLOBAL_ENV_ROOTS];
+// The global env is an array of buckets, each an assoc list, indexed by
+// the low bits of the symbol id. It starts out as the static array and
+// grows into lbm_memory as definitions are added.
+static lbm_value env_global_static[GLOBAL_ENV_ROOTS];
+static lbm_value *env_global = env_global_static;
+static lbm_uint env_global_roots = GLOBAL_ENV_ROOTS;
+
+// Replaced whenever a binding cell may have left the global env. Compiled
+// code keeps binding cells and looks them up again when it changes.
+lbm_value lbm_global_env_token = ENC_SYM_NIL;
+
+void lbm_global_env_changed(void) {
+  lbm_global_env_token = ENC_SYM_NIL;
+}
 
 int lbm_init_env(void) {
+  // lbm_memory has been reinitialized when this runs, so a grown bucket
+  // array is dropped rather than freed.
+  env_global = env_global_static;
+  env_global_roots = GLOBAL_ENV_ROOTS;
   for (int i = 0; i < GLOBAL_ENV_ROOTS; i ++) {
     env_global[i] = ENC_SYM_NIL;
   }
+  lbm_global_env_changed();
   return 1;
 }
 
 lbm_uint lbm_get_global_env_size(void) {
   lbm_uint n = 0;
-  for (int i = 0; i < GLOBAL_ENV_ROOTS; i ++) {
+  for (lbm_uint i = 0; i < env_global_roots; i ++) {
     lbm_value curr = env_global[i];
     while (lbm_is_cons(curr)) {
       n++;
@@ -49,6 +67,75 @@ lbm_value *lbm_get_global_env(void) {
   return env_global;
 }
 
+lbm_uint lbm_get_global_env_roots(void) {
+  return env_global_roots;
+}
+
+void lbm_get_global_env_stats(lbm_global_env_stats_t *stats) {
+  stats->roots = env_global_roots;
+  stats->bindings = 0;
+  stats->used_roots = 0;
+  stats->max_chain = 0;
+  for (lbm_uint i = 0; i < env_global_roots; i ++) {
+    lbm_uint n = 0;
+    lbm_value curr = env_global[i];
+    while (lbm_is_cons(curr)) {
+      n++;
+      curr = lbm_cdr(curr);
+    }
+    stats->bindings += n;
+    if (n > 0) stats->used_roots ++;
+    if (n > stats->max_chain) stats->max_chain = n;
+  }
+}
+
+static inline lbm_uint global_env_ix(lbm_value sym) {
+  return lbm_dec_sym(sym) & (env_global_roots - 1);
+}
+
+// Double the number of buckets and move the spine cells over. No heap
+// cells are allocated, the existing spines are relinked. Growing is
+// skipped if the bucket array cannot be allocated, while an incremental
+// collection is in progress or if a spine cell is read-only.
+static void global_env_grow(void) {
+  if (env_global_roots >= LBM_GLOBAL_ENV_MAX_ROOTS ||
+      lbm_heap_state.gc_inc_phase != LBM_GC_INC_IDLE) {
+    return;
+  }
+  for (lbm_uint i = 0; i < env_global_roots; i ++) {
+    lbm_value curr = env_global[i];
+    while (lbm_is_cons(curr)) {
+      if (!lbm_is_cons_rw(curr)) return;
+      curr = lbm_ref_cell(curr)->cdr;
+    }
+  }
+
+  lbm_uint new_roots = env_global_roots * 2;
+  lbm_value *new_env = (lbm_value*)lbm_malloc(new_roots * sizeof(lbm_value));
+  if (!new_env) return;
+  for (lbm_uint i = 0; i < new_roots; i ++) {
+    new_env[i] = ENC_SYM_NIL;
+  }
+  lbm_uint new_mask = new_roots - 1;
+  for (lbm_uint i = 0; i < env_global_roots; i ++) {
+    lbm_value curr = env_global[i];
+    while (lbm_is_cons(curr)) {
+      lbm_cons_t *cell = lbm_ref_cell(curr);
+      lbm_value next = cell->cdr;
+      lbm_uint ix = lbm_dec_sym(lbm_ref_cell(cell->car)->car) & new_mask;
+      lbm_gc_write_barrier(curr, new_env[ix]);
+      cell->cdr = new_env[ix];
+      new_env[ix] = curr;
+      curr = next;
+    }
+  }
+  if (env_global != env_global_static) {
+    lbm_free(env_global);
+  }
+  env_global = new_env;
+  env_global_roots = new_roots;
+}
+
 // Copy the list structure of an environment.
 lbm_value lbm_env_copy_spine(lbm_value env) {
 
@@ -86,8 +173,7 @@ bool lbm_env_lookup_b(lbm_value *res, lbm_value sym, lbm_value env) {
 }
 
 bool lbm_global_env_lookup(lbm_value *res, lbm_value sym) {
-  lbm_uint dec_sym = lbm_dec_sym(sym);
-  lbm_uint ix = dec_sym & GLOBAL_ENV_MASK;
+  lbm_uint ix = global_env_ix(sym);
   lbm_value curr = env_global[ix];
 
   while (lbm_is_ptr(curr)) {
@@ -101,6 +187,59 @@ bool lbm_global_env_lookup(lbm_value *res, lbm_value sym) {
   return false;
 }
 
+lbm_value lbm_global_env_binding(lbm_value sym) {
+  lbm_uint ix = global_env_ix(sym);
+  lbm_value curr = env_global[ix];
+
+  while (lbm_is_ptr(curr)) {
+    lbm_value c = lbm_ref_cell(curr)->car;
+    if ((lbm_ref_cell(c)->car) == sym) {
+      return c;
+    }
+    curr = lbm_ref_cell(curr)->cdr;
+  }
+  return ENC_SYM_NIL;
+}
+
+lbm_value lbm_global_env_set(lbm_value key, lbm_value val) {
+  lbm_uint ix = global_env_ix(key);
+  lbm_value curr = env_global[ix];
+  lbm_uint n = 0;
+
+  while (lbm_is_cons(curr)) {
+    lbm_value binding = lbm_ref_cell(curr)->car;
+    if (lbm_ref_cell(binding)->car == key) {
+      lbm_set_cdr(binding, val);
+      return ENC_SYM_TRUE;
+    }
+    curr = lbm_ref_cell(curr)->cdr;
+    n ++;
+  }
+
+  lbm_value keyval = lbm_cons(key, val);
+  if (lbm_is_symbol(keyval)) return keyval;
+  lbm_value new_env = lbm_cons(keyval, env_global[ix]);
+  if (lbm_is_symbol(new_env)) return new_env;
+  env_global[ix] = new_env;
+  if (n >= LBM_GLOBAL_ENV_MAX_CHAIN) {
+    global_env_grow();
+  }
+  return ENC_SYM_TRUE;
+}
+
+bool lbm_global_env_modify(lbm_value key, lbm_value val) {
+  lbm_uint ix = global_env_ix(key);
+  return !lbm_is_symbol(lbm_env_modify_binding(env_global[ix], key, val));
+}
+
+bool lbm_global_env_drop(lbm_value key) {
+  lbm_uint ix = global_env_ix(key);
+  lbm_value res = lbm_env_drop_binding(env_global[ix], key);
+  if (res == ENC_SYM_NOT_FOUND) return false;
+  env_global[ix] = res;
+  return true;
+}
+
 // TODO: env set should ideally copy environment if it has to update
 // in place. This has never come up as an issue, the rest of the code
 // must be very well behaved.
@@ -168,6 +307,10 @@ lbm_value lbm_env_modify_binding(lbm_value env, lbm_value key, lbm_value val) {
 
 lbm_value lbm_env_drop_binding(lbm_value env, lbm_value key) {
 
+  // The dropped cell may be held by compiled code if env is part of the
+  // global env.
+  lbm_global_env_changed();
+
   lbm_value curr = env;
   // If key is first in env
   if (lbm_car(lbm_car(curr)) == key) {
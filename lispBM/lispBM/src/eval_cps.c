@@ -31,6 +31,7 @@
 #include "platform_mutex.h"
 #include "lbm_flat_value.h"
 #include "lbm_flags.h"
+#include "lbm_bytecode.h"
 
 #ifdef VISUALIZE_HEAP
 #include "heap_vis.h"
@@ -107,7 +108,9 @@ static jmp_buf critical_error_jmp_buf;
 #define READ_START_ARRAY           CONTINUATION(49)
 #define READ_APPEND_ARRAY          CONTINUATION(50)
 #define LOOP_ENV_PREP              CONTINUATION(51)
-#define NUM_CONTINUATIONS          52
+#define BYTECODE_RESUME            CONTINUATION(52)
+#define BYTECODE_YIELD             CONTINUATION(53)
+#define NUM_CONTINUATIONS          54
 
 #define FM_NEED_GC       -1
 #define FM_NO_MATCH      -2
@@ -169,6 +172,7 @@ static bool lbm_error_has_suspect = false;
 static uint32_t lbm_mailbox_free_space_for_cid(lbm_cid cid);
 static void apply_apply(lbm_value *args, lbm_uint nargs, eval_context_t *ctx);
 static int gc(void);
+static void account_alloc(void);
 #ifdef LBM_USE_ERROR_LINENO
 static void error_ctx(lbm_value, int line_no);
 static void error_at_ctx(lbm_value err_val, lbm_value at, int line_no);
@@ -239,11 +243,16 @@ static eval_context_queue_t queue    = {NULL, NULL};
 mutex_t qmutex;
 bool    qmutex_initialized = false;
 
+static eval_context_queue_t timers   = {NULL, NULL};
+
 static void enqueue_ctx(eval_context_queue_t *q, eval_context_t *ctx);
+static void enqueue_blocked_ctx(eval_context_t *ctx);
 
 // The currently executing context.
 eval_context_t *ctx_running = NULL;
 volatile bool  lbm_system_sleeping = false;
+// The extension being applied by ctx_running, read by the profiler.
+volatile lbm_value lbm_current_extension = ENC_SYM_NIL;
 
 static volatile bool gc_requested = false;
 void lbm_request_gc(void) {
@@ -283,6 +292,16 @@ void lbm_set_eval_step_quota(uint32_t quota) {
 }
 #endif
 
+static lbm_uint eval_steps_total = 0;
+lbm_uint lbm_get_eval_steps(void) {
+  return eval_steps_total;
+}
+
+static volatile uint32_t eval_idle_sleep_max = EVAL_CPS_MIN_SLEEP;
+void lbm_set_eval_idle_sleep_max(uint32_t us) {
+  eval_idle_sleep_max = us < EVAL_CPS_MIN_SLEEP ? EVAL_CPS_MIN_SLEEP : us;
+}
+
 static uint32_t          eval_cps_run_state = EVAL_CPS_STATE_DEAD;
 static volatile uint32_t eval_cps_next_state = EVAL_CPS_STATE_NONE;
 static volatile uint32_t eval_cps_next_state_arg = 0;
@@ -320,6 +339,10 @@ static void user_callback_nonsense(void *arg) {
   return;
 }
 
+static void wakeup_nonsense(void) {
+  return;
+}
+
 static void (*critical_error_callback)(void) = critical_nonsense;
 static void (*usleep_callback)(uint32_t) = usleep_nonsense;
 static uint32_t (*timestamp_us_callback)(void) = timestamp_nonsense;
@@ -327,6 +350,12 @@ static void (*ctx_done_callback)(eval_context_t *) = ctx_done_nonsense;
 static int (*printf_callback)(const char *, ...) = printf_nonsense;
 static bool (*dynamic_load_callback)(const char *, const char **) = dynamic_load_nonsense;
 static void (*user_callback)(void *) = user_callback_nonsense;
+static void (*wakeup_callback)(void) = wakeup_nonsense;
+
+void lbm_set_eval_wakeup_callback(void (*fptr)(void)) {
+  if (fptr == NULL) wakeup_callback = wakeup_nonsense;
+  else wakeup_callback = fptr;
+}
 
 void lbm_set_user_callback(void (*fptr)(void *)) {
   if (fptr == NULL) user_callback = user_callback_nonsense;
@@ -363,25 +392,31 @@ void lbm_set_dynamic_load_callback(bool (*fptr)(const char *, const char **)) {
   else  dynamic_load_callback = fptr;
 }
 
-static volatile lbm_event_t *lbm_events = NULL;
-static unsigned int lbm_events_head = 0;
-static unsigned int lbm_events_tail = 0;
-static unsigned int lbm_events_max  = 0;
-static bool         lbm_events_full = false;
+/* Events
+ * The event queue is a bounded multi producer, single consumer ring
+ * that does not take any locks. Producers claim a slot by advancing
+ * the head with a compare and swap and publish it by writing the slot
+ * sequence number. The evaluator is the only consumer. Events can
+ * therefore be added from interrupt handlers.
+ */
+typedef struct {
+  volatile uint32_t seq;
+  lbm_event_t event;
+} lbm_event_slot_t;
+
+static lbm_event_slot_t * volatile lbm_events = NULL;
+static uint32_t     lbm_events_head = 0;  // Next slot to claim, shared by producers.
+static uint32_t     lbm_events_tail = 0;  // Next slot to read, owned by the evaluator.
+static uint32_t     lbm_events_mask = 0;  // Number of slots - 1, a power of two.
+static uint32_t     lbm_events_dropped = 0;
 static mutex_t      lbm_events_mutex;
 static bool         lbm_events_mutex_initialized = false;
 static volatile lbm_cid  lbm_event_handler_pid = -1;
 
 static unsigned int lbm_event_queue_item_count(void) {
-  unsigned int res = lbm_events_max;
-  if (!lbm_events_full) {
-    if (lbm_events_head >= lbm_events_tail) {
-      res = lbm_events_head - lbm_events_tail;
-    } else {
-      res = lbm_events_max - lbm_events_tail + lbm_events_head;
-    }
-  }
-  return res;
+  uint32_t head = __atomic_load_n(&lbm_events_head, __ATOMIC_ACQUIRE);
+  uint32_t tail = __atomic_load_n(&lbm_events_tail, __ATOMIC_ACQUIRE);
+  return (unsigned int)(head - tail);
 }
 
 lbm_cid lbm_get_event_handler_pid(void) {
@@ -397,23 +432,38 @@ bool lbm_event_handler_exists(void) {
 }
 
 static bool event_internal(lbm_event_type_t event_type, lbm_uint parameter, lbm_uint buf_ptr, lbm_uint buf_len) {
-  bool r = false;
-  if (lbm_events) {
-    mutex_lock(&lbm_events_mutex);
-    if (!lbm_events_full) {
-      lbm_event_t event;
-      event.type = event_type;
-      event.parameter = parameter;
-      event.buf_ptr = buf_ptr;
-      event.buf_len = buf_len;
-      lbm_events[lbm_events_head] = event;
-      lbm_events_head = (lbm_events_head + 1) % lbm_events_max;
-      lbm_events_full = lbm_events_head == lbm_events_tail;
-      r = true;
-    }
-    mutex_unlock(&lbm_events_mutex);
+  lbm_event_slot_t *events = lbm_events;
+  if (!events) return false;
+
+  uint32_t pos = __atomic_load_n(&lbm_events_head, __ATOMIC_RELAXED);
+  lbm_event_slot_t *slot;
+  while (true) {
+    slot = &events[pos & lbm_events_mask];
+    uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+    int32_t dif = (int32_t)(seq - pos);
+    if (dif == 0) {
+      if (__atomic_compare_exchange_n(&lbm_events_head, &pos, pos + 1, true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        break;
+      }
+      // pos now holds the updated head, try again.
+    } else if (dif < 0) {
+      // The slot has not been read yet, the queue is full.
+      __atomic_fetch_add(&lbm_events_dropped, 1, __ATOMIC_RELAXED);
+      return false;
+    } else {
+      pos = __atomic_load_n(&lbm_events_head, __ATOMIC_RELAXED);
+    }
   }
-  return r;
+  slot->event.type = event_type;
+  slot->event.parameter = parameter;
+  slot->event.buf_ptr = buf_ptr;
+  slot->event.buf_len = buf_len;
+  __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+  if (lbm_system_sleeping) {
+    wakeup_callback();
+  }
+  return true;
 }
 
 bool lbm_event_define(lbm_value key, lbm_flat_value_t *fv) {
@@ -424,14 +474,19 @@ bool lbm_event_run_user_callback(void *arg) {
   return event_internal(LBM_EVENT_RUN_USER_CALLBACK, (lbm_uint)arg, 0, 0);
 }
 
-bool lbm_event_unboxed(lbm_value unboxed) {
+static bool is_unboxed_event(lbm_value unboxed) {
   lbm_uint t = lbm_type_of(unboxed);
-  if (t == LBM_TYPE_SYMBOL ||
-      t == LBM_TYPE_I ||
-      t == LBM_TYPE_U ||
-      t == LBM_TYPE_CHAR) {
+  return (t == LBM_TYPE_SYMBOL ||
+          t == LBM_TYPE_I ||
+          t == LBM_TYPE_U ||
+          t == LBM_TYPE_CHAR);
+}
+
+bool lbm_event_unboxed(lbm_value unboxed) {
+  if (is_unboxed_event(unboxed)) {
     if (lbm_event_handler_pid > 0) {
       if (lbm_mailbox_free_space_for_cid(lbm_event_handler_pid) <= lbm_event_queue_item_count()) {
+        __atomic_fetch_add(&lbm_events_dropped, 1, __ATOMIC_RELAXED);
         return false;
       }
       return event_internal(LBM_EVENT_FOR_HANDLER, 0, (lbm_uint)unboxed, 0);
@@ -440,9 +495,17 @@ bool lbm_event_unboxed(lbm_value unboxed) {
   return false;
 }
 
+bool lbm_event_unboxed_isr(lbm_value unboxed) {
+  if (is_unboxed_event(unboxed) && lbm_event_handler_pid > 0) {
+    return event_internal(LBM_EVENT_FOR_HANDLER, 0, (lbm_uint)unboxed, 0);
+  }
+  return false;
+}
+
 bool lbm_event(lbm_flat_value_t *fv) {
   if (lbm_event_handler_pid > 0) {
     if (lbm_mailbox_free_space_for_cid(lbm_event_handler_pid) <= lbm_event_queue_item_count()) {
+      __atomic_fetch_add(&lbm_events_dropped, 1, __ATOMIC_RELAXED);
       return false;
     }
     return event_internal(LBM_EVENT_FOR_HANDLER, 0, (lbm_uint)fv->buf, fv->buf_size);
@@ -450,27 +513,30 @@ bool lbm_event(lbm_flat_value_t *fv) {
   return false;
 }
 
+// Only called from the evaluator thread.
 static bool lbm_event_pop(lbm_event_t *event) {
-  mutex_lock(&lbm_events_mutex);
-  if (lbm_events_head == lbm_events_tail && !lbm_events_full) {
-    mutex_unlock(&lbm_events_mutex);
+  lbm_event_slot_t *events = lbm_events;
+  if (!events) return false;
+  uint32_t pos = lbm_events_tail;
+  lbm_event_slot_t *slot = &events[pos & lbm_events_mask];
+  uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+  if (seq != pos + 1) {
+    // Empty, or the producer that claimed the slot has not
+    // finished writing it yet.
     return false;
   }
-  *event = lbm_events[lbm_events_tail];
-  lbm_events_tail = (lbm_events_tail + 1) % lbm_events_max;
-  lbm_events_full = false;
-  mutex_unlock(&lbm_events_mutex);
+  *event = slot->event;
+  __atomic_store_n(&slot->seq, pos + lbm_events_mask + 1, __ATOMIC_RELEASE);
+  __atomic_store_n(&lbm_events_tail, pos + 1, __ATOMIC_RELEASE);
   return true;
 }
 
 bool lbm_event_queue_is_empty(void) {
-  mutex_lock(&lbm_events_mutex);
-  bool empty = false;
-  if (lbm_events_head == lbm_events_tail && !lbm_events_full) {
-    empty = true;
-  }
-  mutex_unlock(&lbm_events_mutex);
-  return empty;
+  return lbm_event_queue_item_count() == 0;
+}
+
+uint32_t lbm_get_num_dropped_events(void) {
+  return __atomic_load_n(&lbm_events_dropped, __ATOMIC_RELAXED);
 }
 
 static bool              eval_running = false;
@@ -545,6 +611,7 @@ static lbm_value cons_with_gc(lbm_value head, lbm_value tail, lbm_value remember
   lbm_uint heap_ix = lbm_dec_ptr(res);
   lbm_heap_state.freelist = lbm_heap_state.heap[heap_ix].cdr;
   lbm_heap_state.num_alloc++;
+  lbm_gc_inc_allocated(heap_ix);
   lbm_heap_state.heap[heap_ix].car = head;
   lbm_heap_state.heap[heap_ix].cdr = tail;
   res = lbm_set_ptr_type(res, LBM_TYPE_CONS);
@@ -681,6 +748,8 @@ static lbm_value allocate_binding(lbm_value key, lbm_value val, lbm_value the_cd
   lbm_uint list_cell_ix = lbm_dec_ptr(list_cell);
   lbm_heap_state.freelist = heap[list_cell_ix].cdr;
   lbm_heap_state.num_alloc += 2;
+  lbm_gc_inc_allocated(binding_cell_ix);
+  lbm_gc_inc_allocated(list_cell_ix);
   heap[binding_cell_ix].car = key;
   heap[binding_cell_ix].cdr = val;
   heap[list_cell_ix].car = binding_cell;
@@ -749,7 +818,8 @@ static void block_current_ctx(uint32_t state, lbm_uint sleep_us,  bool do_cont)
   ctx_running->sleep_us = sleep_us;
   ctx_running->state  = state;
   ctx_running->app_cont = do_cont;
-  enqueue_ctx(&blocked, ctx_running);
+  account_alloc();
+  enqueue_blocked_ctx(ctx_running);
   ctx_running = NULL;
 }
 
@@ -759,7 +829,8 @@ static void reblock_current_ctx(uint32_t state, bool do_cont) {
   if (is_atomic) atomic_error();
   ctx_running->state  = state;
   ctx_running->app_cont = do_cont;
-  enqueue_ctx(&blocked, ctx_running);
+  account_alloc();
+  enqueue_blocked_ctx(ctx_running);
   ctx_running = NULL;
 }
 
@@ -804,8 +875,9 @@ void print_environments(char *buf, unsigned int size) {
   printf_callback("\n\n");
   printf_callback("\tCurrent global environment:\n");
   lbm_value *glob_env = lbm_get_global_env();
+  lbm_uint roots = lbm_get_global_env_roots();
 
-  for (int i = 0; i < GLOBAL_ENV_ROOTS; i ++) {
+  for (lbm_uint i = 0; i < roots; i ++) {
     lbm_value curr_g = glob_env[i];;
     while (lbm_type_of(curr_g) == LBM_TYPE_CONS) {
 
@@ -904,7 +976,7 @@ static void print_error_message(lbm_value error,
 
     printf_callback("\n   Mailbox:\n");
     for (unsigned int i = 0; i < ctx_running->num_mail; i ++) {
-      lbm_print_value(buf, ERROR_MESSAGE_BUFFER_SIZE_BYTES, ctx_running->mailbox[i]);
+      lbm_print_value(buf, ERROR_MESSAGE_BUFFER_SIZE_BYTES, lbm_mailbox_get_mail(ctx_running, i));
       printf_callback("     %s\n", buf);
     }
     printf_callback("\n   Stack:\n");
@@ -1011,6 +1083,70 @@ static void enqueue_ctx(eval_context_queue_t *q, eval_context_t *ctx) {
   mutex_unlock(&qmutex);
 }
 
+/* Timers
+ * Contexts that are sleeping or blocked with a timeout are, in addition
+ * to being in the blocked queue, linked into the timers list ordered by
+ * the time remaining until they are due. Waking up contexts then only
+ * looks at the head of the list. All remaining times decrease at the
+ * same rate so the order stays valid as time passes.
+ */
+
+static lbm_uint timer_remaining(eval_context_t *ctx, uint32_t t_now) {
+  // Unsigned 32 bit difference handles wrap around of the timestamp.
+  lbm_uint elapsed = (uint32_t)(t_now - (uint32_t)ctx->timestamp);
+  return (elapsed >= ctx->sleep_us) ? 0 : ctx->sleep_us - elapsed;
+}
+
+static void timer_insert_nm(eval_context_t *ctx) {
+  uint32_t t_now = timestamp_us_callback();
+  lbm_uint rem = timer_remaining(ctx, t_now);
+  // Searching from the back puts contexts that sleep for the same
+  // period, the common case, in place in one step.
+  eval_context_t *curr = timers.last;
+  while (curr && timer_remaining(curr, t_now) > rem) {
+    curr = curr->timer_prev;
+  }
+  ctx->timer_prev = curr;
+  if (curr) {
+    ctx->timer_next = curr->timer_next;
+    curr->timer_next = ctx;
+  } else {
+    ctx->timer_next = timers.first;
+    timers.first = ctx;
+  }
+  if (ctx->timer_next) {
+    ctx->timer_next->timer_prev = ctx;
+  } else {
+    timers.last = ctx;
+  }
+}
+
+static void timer_remove_nm(eval_context_t *ctx) {
+  if (ctx->timer_prev) {
+    ctx->timer_prev->timer_next = ctx->timer_next;
+  } else if (timers.first == ctx) {
+    timers.first = ctx->timer_next;
+  } else {
+    return; // not in the timers list.
+  }
+  if (ctx->timer_next) {
+    ctx->timer_next->timer_prev = ctx->timer_prev;
+  } else {
+    timers.last = ctx->timer_prev;
+  }
+  ctx->timer_prev = NULL;
+  ctx->timer_next = NULL;
+}
+
+static void enqueue_blocked_ctx(eval_context_t *ctx) {
+  mutex_lock(&qmutex);
+  enqueue_ctx_nm(&blocked, ctx);
+  if (LBM_IS_STATE_WAKE_UP_WAKABLE(ctx->state)) {
+    timer_insert_nm(ctx);
+  }
+  mutex_unlock(&qmutex);
+}
+
 static eval_context_t *lookup_ctx_nm(eval_context_queue_t *q, lbm_cid cid) {
   eval_context_t *curr;
   curr = q->first;
@@ -1039,6 +1175,7 @@ static bool drop_ctx_nm(eval_context_queue_t *q, eval_context_t *ctx) {
   while (curr) {
     if (curr->id == ctx->id) {
       res = true;
+      if (q == &blocked) timer_remove_nm(curr);
       eval_context_t *tmp = curr->next;
       if (curr->prev == NULL) {
         if (curr->next == NULL) {
@@ -1225,64 +1362,47 @@ static eval_context_t *dequeue_ctx_nm(eval_context_queue_t *q) {
   return res;
 }
 
-static void wake_up_ctxs_nm(void) {
-  lbm_uint t_now;
-
-  if (timestamp_us_callback) {
-    t_now = timestamp_us_callback();
-  } else {
-    t_now = 0;
-  }
+// Wake up the contexts that are due, these are at the head of the
+// timers list. Returns the time until the next context is due, or
+// eval_idle_sleep_max if there is none.
+static uint32_t wake_up_ctxs_nm(void) {
+  uint32_t t_now = timestamp_us_callback();
 
   eval_context_queue_t *q = &blocked;
-  eval_context_t *curr = q->first;
-
-  while (curr != NULL) {
-    lbm_uint t_diff;
-    eval_context_t *next = curr->next;
-    if (LBM_IS_STATE_WAKE_UP_WAKABLE(curr->state)) {
-      if ( curr->timestamp > t_now) {
-        /* There was an overflow on the counter */
-#ifndef LBM64
-        t_diff = (0xFFFFFFFF - curr->timestamp) + t_now;
-#else
-        t_diff = (0xFFFFFFFFFFFFFFFF - curr->timestamp) + t_now;
-#endif
+  while (timers.first) {
+    eval_context_t *wake_ctx = timers.first;
+    lbm_uint rem = timer_remaining(wake_ctx, t_now);
+    if (rem > 0) {
+      return (rem < eval_idle_sleep_max) ? (uint32_t)rem : eval_idle_sleep_max;
+    }
+    timer_remove_nm(wake_ctx);
+    if (wake_ctx == q->last) {
+      if (wake_ctx->prev) {
+        q->last = wake_ctx->prev;
+        q->last->next = NULL;
       } else {
-        t_diff = t_now - curr->timestamp;
+        q->first = NULL;
+        q->last = NULL;
       }
-
-      if (t_diff >= curr->sleep_us) {
-        eval_context_t *wake_ctx = curr;
-        if (curr == q->last) {
-          if (curr->prev) {
-            q->last = curr->prev;
-            q->last->next = NULL;
-          } else {
-            q->first = NULL;
-            q->last = NULL;
-          }
-        } else if (curr->prev == NULL) {
-          q->first = curr->next;
-          q->first->prev = NULL;
-        } else {
-          curr->prev->next = curr->next;
-          if (curr->next) {
-            curr->next->prev = curr->prev;
-          }
-        }
-        wake_ctx->next = NULL;
-        wake_ctx->prev = NULL;
-        if (LBM_IS_STATE_TIMEOUT(curr->state)) {
-          mailbox_add_mail(wake_ctx, ENC_SYM_TIMEOUT);
-          wake_ctx->r = ENC_SYM_TIMEOUT;
-        }
-        wake_ctx->state = LBM_THREAD_STATE_READY;
-        enqueue_ctx_nm(&queue, wake_ctx);
+    } else if (wake_ctx->prev == NULL) {
+      q->first = wake_ctx->next;
+      q->first->prev = NULL;
+    } else {
+      wake_ctx->prev->next = wake_ctx->next;
+      if (wake_ctx->next) {
+        wake_ctx->next->prev = wake_ctx->prev;
       }
     }
-    curr = next;
+    wake_ctx->next = NULL;
+    wake_ctx->prev = NULL;
+    if (LBM_IS_STATE_TIMEOUT(wake_ctx->state)) {
+      mailbox_add_mail(wake_ctx, ENC_SYM_TIMEOUT);
+      wake_ctx->r = ENC_SYM_TIMEOUT;
+    }
+    wake_ctx->state = LBM_THREAD_STATE_READY;
+    enqueue_ctx_nm(&queue, wake_ctx);
   }
+  return eval_idle_sleep_max;
 }
 
 static void yield_ctx(lbm_uint sleep_us) {
@@ -1298,7 +1418,8 @@ static void yield_ctx(lbm_uint sleep_us) {
   }
   ctx_running->r = ENC_SYM_TRUE;
   ctx_running->app_cont = true;
-  enqueue_ctx(&blocked,ctx_running);
+  account_alloc();
+  enqueue_blocked_ctx(ctx_running);
   ctx_running = NULL;
 }
 
@@ -1399,9 +1520,12 @@ static lbm_cid lbm_create_ctx_parent(lbm_value program, lbm_value env, lbm_uint
   ctx->mailbox_size = EVAL_CPS_DEFAULT_MAILBOX_SIZE;
   ctx->flags = context_flags;
   ctx->num_mail = 0;
+  ctx->mail_first = 0;
   ctx->app_cont = false;
   ctx->timestamp = 0;
   ctx->sleep_us = 0;
+  ctx->timer_prev = NULL;
+  ctx->timer_next = NULL;
   ctx->state = LBM_THREAD_STATE_READY;
   ctx->prev = NULL;
   ctx->next = NULL;
@@ -1411,6 +1535,7 @@ static lbm_cid lbm_create_ctx_parent(lbm_value program, lbm_value env, lbm_uint
 
   ctx->id = cid;
   ctx->parent = parent;
+  ctx->alloc_cells = 0;
 
   if (!lbm_push(&ctx->K, DONE)) {
     lbm_memory_free((lbm_uint*)ctx->mailbox);
@@ -1449,30 +1574,55 @@ bool lbm_mailbox_change_size(eval_context_t *ctx, lbm_uint new_size) {
     return false;
   }
 
-  for (lbm_uint i = 0; i < ctx->num_mail; i ++ ) {
-    mailbox[i] = ctx->mailbox[i];
+  // Unwrap the ring buffer, keeping the newest messages if
+  // the new mailbox is smaller.
+  uint32_t skip = 0;
+  if (ctx->num_mail > new_size) {
+    skip = ctx->num_mail - (uint32_t)new_size;
+  }
+  for (uint32_t i = skip; i < ctx->num_mail; i ++ ) {
+    mailbox[i - skip] = lbm_mailbox_get_mail(ctx, i);
   }
   lbm_memory_free(ctx->mailbox);
   ctx->mailbox = mailbox;
   ctx->mailbox_size = (uint32_t)new_size;
+  ctx->num_mail -= skip;
+  ctx->mail_first = 0;
   return true;
 }
 
-static void mailbox_remove_mail(eval_context_t *ctx, lbm_uint ix) {
+static inline uint32_t mailbox_ix(eval_context_t *ctx, uint32_t ix) {
+  uint32_t i = ctx->mail_first + ix;
+  return (i >= ctx->mailbox_size) ? i - ctx->mailbox_size : i;
+}
 
-  for (lbm_uint i = ix; i < ctx->num_mail-1; i ++) {
-    ctx->mailbox[i] = ctx->mailbox[i+1];
+// Removing the oldest message is O(1). Otherwise the messages on the
+// shorter side of ix are moved one step to close the gap.
+static void mailbox_remove_mail(eval_context_t *ctx, lbm_uint ix) {
+  uint32_t n = ctx->num_mail;
+  if (ix < n / 2) {
+    for (uint32_t i = (uint32_t)ix; i > 0; i --) {
+      ctx->mailbox[mailbox_ix(ctx, i)] = ctx->mailbox[mailbox_ix(ctx, i - 1)];
+    }
+    ctx->mail_first = mailbox_ix(ctx, 1);
+  } else {
+    for (uint32_t i = (uint32_t)ix; i < n - 1; i ++) {
+      ctx->mailbox[mailbox_ix(ctx, i)] = ctx->mailbox[mailbox_ix(ctx, i + 1)];
+    }
   }
   ctx->num_mail --;
+  if (ctx->num_mail == 0) ctx->mail_first = 0;
 }
 
+// When the mailbox is full the oldest message is dropped.
 static void mailbox_add_mail(eval_context_t *ctx, lbm_value mail) {
 
   if (ctx->num_mail >= ctx->mailbox_size) {
+    if (ctx->mailbox_size == 0) return;
     mailbox_remove_mail(ctx, 0);
   }
 
-  ctx->mailbox[ctx->num_mail] = mail;
+  ctx->mailbox[mailbox_ix(ctx, ctx->num_mail)] = mail;
   ctx->num_mail ++;
 }
 
@@ -1697,13 +1847,13 @@ static bool match(lbm_value p, lbm_value e, lbm_value *env) {
 // Find match is not very picky about syntax.
 // A completely malformed recv form is most likely to
 // just return no_match.
-static int find_match(lbm_value plist, lbm_value *earr, lbm_uint num, lbm_value *e, lbm_value *env) {
+static int find_match(lbm_value plist, eval_context_t *ctx, lbm_value *e, lbm_value *env) {
   // A pattern list is a list of pattern, expression lists.
   // ( (p1 e1) (p2 e2) ... (pn en))
   lbm_value curr_p = plist;
   int n = 0;
-  for (int i = 0; i < (int)num; i ++ ) {
-    lbm_value curr_e = earr[i];
+  for (uint32_t i = 0; i < ctx->num_mail; i ++ ) {
+    lbm_value curr_e = lbm_mailbox_get_mail(ctx, i);
     while (!lbm_is_symbol_nil(curr_p)) {
       lbm_value p[3];
       extract_n(get_car(curr_p), p, 3);
@@ -1734,24 +1884,122 @@ static void mark_context(eval_context_t *ctx, void *arg1, void *arg2) {
   lbm_value roots[3] = {ctx->curr_exp, ctx->program, ctx->r};
   lbm_gc_mark_env(ctx->curr_env);
   lbm_gc_mark_roots(roots, 3);
-  lbm_gc_mark_roots(ctx->mailbox, ctx->num_mail);
+  // The messages are in at most two contiguous parts of the ring buffer.
+  lbm_uint first_part = ctx->mailbox_size - ctx->mail_first;
+  if (ctx->num_mail <= first_part) {
+    lbm_gc_mark_roots(ctx->mailbox + ctx->mail_first, ctx->num_mail);
+  } else {
+    lbm_gc_mark_roots(ctx->mailbox + ctx->mail_first, first_part);
+    lbm_gc_mark_roots(ctx->mailbox, ctx->num_mail - first_part);
+  }
   lbm_gc_mark_aux(ctx->K.data, ctx->K.sp);
 }
 
+/* GC telemetry
+
+   Every collection leaves a record in a ring buffer and is counted in the
+   histograms. The cells allocated by a context are counted from the
+   change of num_alloc while it runs, and collections are taken into
+   account by settling the count before them and restarting it after. */
+
+static lbm_gc_stats_t gc_stats;
+static uint32_t gc_trigger = LBM_GC_TRIGGER_ALLOC;
+static lbm_uint alloc_start = 0;
+static lbm_gc_record_t gc_inc_record;
+
+static void account_alloc(void) {
+  if (ctx_running) {
+    ctx_running->alloc_cells += lbm_heap_state.num_alloc - alloc_start;
+  }
+  alloc_start = lbm_heap_state.num_alloc;
+}
+
+static void gc_stats_begin(lbm_gc_record_t *rec, uint32_t trigger, uint32_t t_start) {
+  rec->timestamp = t_start;
+  rec->mark_us = 0;
+  rec->sweep_us = 0;
+  rec->trigger = trigger;
+  rec->cid = ctx_running ? ctx_running->id : -1;
+  rec->free_before = lbm_heap_num_free();
+  rec->recovered_arrays = lbm_heap_state.gc_recovered_arrays;
+}
+
+static void gc_stats_pause(uint32_t us) {
+  lbm_uint b = 0;
+  uint32_t t = us >> 5;
+  while (t && b < LBM_GC_PAUSE_BUCKETS - 1) {
+    t >>= 1;
+    b ++;
+  }
+  gc_stats.pause_hist[b] ++;
+  if (us > gc_stats.max_pause_us) {
+    gc_stats.max_pause_us = us;
+  }
+}
+
+static void gc_stats_end(lbm_gc_record_t *rec) {
+  rec->recovered = lbm_heap_state.gc_recovered;
+  rec->recovered_arrays = lbm_heap_state.gc_recovered_arrays - rec->recovered_arrays;
+  rec->free_after = lbm_heap_num_free();
+  rec->mem_free = lbm_memory_num_free();
+  rec->mem_longest_free = lbm_memory_longest_free();
+
+  lbm_uint size = lbm_heap_state.heap_size;
+  lbm_uint b = size ? ((size - rec->free_after) * LBM_GC_USE_BUCKETS) / size : 0;
+  if (b >= LBM_GC_USE_BUCKETS) b = LBM_GC_USE_BUCKETS - 1;
+  gc_stats.use_hist[b] ++;
+  gc_stats.triggers[rec->trigger] ++;
+  gc_stats.log[gc_stats.num % LBM_GC_LOG_SIZE] = *rec;
+  gc_stats.num ++;
+}
+
+const lbm_gc_stats_t *lbm_get_gc_stats(void) {
+  return &gc_stats;
+}
+
+bool lbm_get_gc_record(lbm_uint n, lbm_gc_record_t *rec) {
+  if (n >= gc_stats.num || n >= LBM_GC_LOG_SIZE) return false;
+  *rec = gc_stats.log[(gc_stats.num - 1 - n) % LBM_GC_LOG_SIZE];
+  return true;
+}
+
+static void reset_alloc_cells(eval_context_t *ctx, void *arg1, void *arg2) {
+  (void) arg1;
+  (void) arg2;
+  ctx->alloc_cells = 0;
+}
+
+void lbm_reset_gc_stats(void) {
+  memset(&gc_stats, 0, sizeof(gc_stats));
+  lbm_all_ctxs_iterator(reset_alloc_cells, NULL, NULL);
+  alloc_start = lbm_heap_state.num_alloc;
+}
+
 static int gc(void) {
+  uint32_t t_start = timestamp_us_callback();
+  lbm_gc_record_t rec;
+  account_alloc();
+  gc_stats_begin(&rec, gc_trigger, t_start);
+  gc_trigger = LBM_GC_TRIGGER_ALLOC;
+
   if (ctx_running) {
     ctx_running->state = ctx_running->state | LBM_THREAD_STATE_GC_BIT;
   }
 
+  // Anything an incremental collection has swept is already on the
+  // freelist, the rest is collected here.
+  lbm_gc_inc_abort();
   gc_requested = false;
   lbm_gc_state_inc();
 
   // The freelist should generally be NIL when GC runs.
   lbm_nil_freelist();
   lbm_value *env = lbm_get_global_env();
-  for (int i = 0; i < GLOBAL_ENV_ROOTS; i ++) {
+  lbm_uint roots = lbm_get_global_env_roots();
+  for (lbm_uint i = 0; i < roots; i ++) {
     lbm_gc_mark_env(env[i]);
   }
+  lbm_gc_mark_phase(lbm_global_env_token);
 
   mutex_lock(&qmutex); // Lock the queues.
                        // Any concurrent messing with the queues
@@ -1768,9 +2016,17 @@ static int gc(void) {
   heap_vis_gen_image();
 #endif
 
+  uint32_t t_mark = timestamp_us_callback();
   int r = lbm_gc_sweep_phase();
   lbm_heap_new_freelist_length();
   lbm_memory_update_min_free();
+  uint32_t t_end = timestamp_us_callback();
+
+  rec.mark_us = t_mark - t_start;
+  rec.sweep_us = t_end - t_mark;
+  gc_stats_pause(t_end - t_start);
+  gc_stats_end(&rec);
+  alloc_start = lbm_heap_state.num_alloc;
 
   if (ctx_running) {
     ctx_running->state = ctx_running->state & ~LBM_THREAD_STATE_GC_BIT;
@@ -1779,9 +2035,114 @@ static int gc(void) {
 }
 
 int lbm_perform_gc(void) {
+  gc_trigger = LBM_GC_TRIGGER_EXPLICIT;
   return gc();
 }
 
+/* Incremental GC
+
+   When a pause budget is set, a collection is started once half of the
+   cells that were free after the previous collection have been
+   allocated. The collection then runs in slices between evaluation
+   steps. Each slice marks or sweeps at most gc_pause_budget cells, except
+   for the slice that ends marking by marking the roots again. That slice
+   is bounded by what was allocated or stored into the roots since the
+   collection started, rather than by the heap size.
+
+   If memory runs out before the collection is done, gc() finishes the
+   job stop-the-world as without a budget. */
+
+static lbm_uint gc_pause_budget = 0;
+static lbm_uint gc_inc_root_ix = 0;
+
+bool lbm_set_gc_pause_budget(lbm_uint budget) {
+  if (budget > 0 && !lbm_gc_inc_init()) {
+    return false;
+  }
+  lbm_gc_inc_abort();
+  gc_pause_budget = budget;
+  return true;
+}
+
+lbm_uint lbm_get_gc_pause_budget(void) {
+  return gc_pause_budget;
+}
+
+static void mark_context_inc(eval_context_t *ctx, void *arg1, void *arg2) {
+  (void) arg1;
+  (void) arg2;
+  lbm_gc_inc_mark_root(ctx->curr_env);
+  lbm_gc_inc_mark_root(ctx->curr_exp);
+  lbm_gc_inc_mark_root(ctx->program);
+  lbm_gc_inc_mark_root(ctx->r);
+  for (uint32_t i = 0; i < ctx->num_mail; i ++) {
+    lbm_gc_inc_mark_root(lbm_mailbox_get_mail(ctx, i));
+  }
+  lbm_gc_inc_mark_aux(ctx->K.data, ctx->K.sp);
+}
+
+static void gc_inc_mark_all_roots(void) {
+  lbm_value *env = lbm_get_global_env();
+  lbm_uint roots = lbm_get_global_env_roots();
+  for (lbm_uint i = 0; i < roots; i ++) {
+    lbm_gc_inc_mark_root(env[i]);
+  }
+  lbm_gc_inc_mark_root(lbm_global_env_token);
+  mutex_lock(&qmutex);
+  queue_iterator_nm(&queue, mark_context_inc, NULL, NULL);
+  queue_iterator_nm(&blocked, mark_context_inc, NULL, NULL);
+  if (ctx_running) {
+    mark_context_inc(ctx_running, NULL, NULL);
+  }
+  mutex_unlock(&qmutex);
+}
+
+static void gc_slice(void) {
+  uint32_t t_start = timestamp_us_callback();
+  switch (lbm_heap_state.gc_inc_phase) {
+  case LBM_GC_INC_IDLE:
+    if (lbm_heap_num_free() < lbm_heap_state.gc_last_free / 2) {
+      gc_stats_begin(&gc_inc_record, LBM_GC_TRIGGER_INCREMENTAL, t_start);
+      lbm_gc_inc_begin();
+      gc_inc_root_ix = 0;
+    }
+    break;
+  case LBM_GC_INC_MARK: {
+    // The global environment is marked in slices first.
+    lbm_value *env = lbm_get_global_env();
+    lbm_uint budget = gc_pause_budget;
+    while (lbm_gc_inc_mark(&budget)) {
+      if (gc_inc_root_ix < lbm_get_global_env_roots()) {
+        lbm_gc_inc_push(env[gc_inc_root_ix++]);
+      } else {
+        gc_inc_mark_all_roots();
+        lbm_gc_inc_start_sweep();
+        break;
+      }
+    }
+    uint32_t t = timestamp_us_callback() - t_start;
+    gc_inc_record.mark_us += t;
+    gc_stats_pause(t);
+  } break;
+  case LBM_GC_INC_SWEEP: {
+    bool done = lbm_gc_inc_sweep(gc_pause_budget);
+    if (done) {
+      lbm_heap_new_freelist_length();
+      lbm_memory_update_min_free();
+    }
+    uint32_t t = timestamp_us_callback() - t_start;
+    gc_inc_record.sweep_us += t;
+    gc_stats_pause(t);
+    if (done) {
+      gc_stats_end(&gc_inc_record);
+      alloc_start = lbm_heap_state.num_alloc;
+    }
+  } break;
+  default:
+    break;
+  }
+}
+
 /****************************************************/
 /* Evaluation functions                             */
 
@@ -1983,12 +2344,16 @@ static inline lbm_value allocate_closure(lbm_value params, lbm_value body, lbm_v
   // CONS check is not needed. If num_free is correct, then freelist is a cons-cell.
   lbm_cons_t *heap = lbm_heap_state.heap;
   lbm_uint ix = lbm_dec_ptr(res);
+  lbm_gc_inc_allocated(ix);
   heap[ix].car = ENC_SYM_CLOSURE;
   ix = lbm_dec_ptr(heap[ix].cdr);
+  lbm_gc_inc_allocated(ix);
   heap[ix].car = params;
   ix = lbm_dec_ptr(heap[ix].cdr);
+  lbm_gc_inc_allocated(ix);
   heap[ix].car = body;
   ix = lbm_dec_ptr(heap[ix].cdr);
+  lbm_gc_inc_allocated(ix);
   heap[ix].car = env;
   lbm_heap_state.freelist = heap[ix].cdr;
   heap[ix].cdr = ENC_SYM_NIL;
@@ -2348,12 +2713,9 @@ static void eval_receive(eval_context_t *ctx) {
     if (ctx->num_mail == 0) {
       block_current_ctx(LBM_THREAD_STATE_RECV_BL,0,false);
     } else {
-      lbm_value *msgs = ctx->mailbox;
-      lbm_uint  num   = ctx->num_mail;
-
       lbm_value e;
       lbm_value new_env = ctx->curr_env;
-      int n = find_match(pats, msgs, num, &e, &new_env);
+      int n = find_match(pats, ctx, &e, &new_env);
       if (n >= 0 ) { /* Match */
         mailbox_remove_mail(ctx, (lbm_uint)n);
         ctx->curr_env = new_env;
@@ -2383,15 +2745,10 @@ static void cont_set_global_env(eval_context_t *ctx){
   lbm_value val = ctx->r;
 
   lbm_pop(&ctx->K, &key);
-  lbm_uint dec_key = lbm_dec_sym(key);
-  lbm_uint ix_key  = dec_key & GLOBAL_ENV_MASK;
-  lbm_value *global_env = lbm_get_global_env();
-  lbm_uint orig_env = global_env[ix_key];
-  lbm_value new_env;
+  lbm_value res;
   // A key is a symbol and should not need to be remembered.
-  WITH_GC(new_env, lbm_env_set(orig_env,key,val));
-
-  global_env[ix_key] = new_env;
+  WITH_GC(res, lbm_global_env_set(key,val));
+  (void) res;
   ctx->r = val;
 
   ctx->app_cont = true;
@@ -2619,11 +2976,9 @@ static lbm_value perform_setvar(lbm_value key, lbm_value val, lbm_value env) {
   lbm_uint s = lbm_dec_sym(key);
   if (s >= RUNTIME_SYMBOLS_START) {
     lbm_value new_env = lbm_env_modify_binding(env, key, val);
-    if (lbm_is_symbol(new_env) && new_env == ENC_SYM_NOT_FOUND) {
-      lbm_uint ix_key = lbm_dec_sym(key) & GLOBAL_ENV_MASK;
-      lbm_value *glob_env = lbm_get_global_env();
-      new_env = lbm_env_modify_binding(glob_env[ix_key], key, val);
-      glob_env[ix_key] = new_env;
+    if (lbm_is_symbol(new_env) && new_env == ENC_SYM_NOT_FOUND &&
+        lbm_global_env_modify(key, val)) {
+      new_env = ENC_SYM_TRUE;
     }
     if (lbm_is_symbol(new_env) && new_env == ENC_SYM_NOT_FOUND) {
       lbm_set_error_reason((char*)lbm_error_str_variable_not_bound);
@@ -3376,16 +3731,499 @@ static const apply_fun fun_table[] =
    apply_apply,
   };
 
+/***************************************************/
+/* Compiled closures                               */
+
+// A compiled closure (lbm_bytecode.h) runs in a frame on the context stack:
+//
+//   K[base]                (bytecode code consts)
+//   K[base + 1 + i]        local slot i, the arguments first
+//   K[base + 1 + locals]   operands
+//
+// While a frame waits for a call to return, or has given up its time
+// slice, its base and pc are kept on the stack under BYTECODE_RESUME or
+// BYTECODE_YIELD. The code is checked as it runs and malformed code is
+// an error, as a bytecode form can be written by hand.
+
+// Calls and backward jumps before the dispatch loop returns to the scheduler.
+#define BYTECODE_BUDGET 64
+
+typedef struct {
+  const uint8_t *code;
+  lbm_uint code_size;
+  lbm_value consts;
+  lbm_value *cdata;
+  lbm_uint num_consts;
+  lbm_uint base;
+  lbm_uint num_locals;
+  lbm_uint ops;        // Stack index of the first operand.
+} bc_frame_t;
+
+static void application(eval_context_t *ctx, lbm_value *fun_args, lbm_uint arg_count);
+
+static inline bool is_bytecode(lbm_value body) {
+  return lbm_is_cons(body) && lbm_ref_cell(body)->car == ENC_SYM_BYTECODE;
+}
+
+static noreturn void bc_malformed(lbm_value body) {
+  lbm_set_error_reason("Malformed bytecode");
+  ERROR_AT_CTX(ENC_SYM_EERROR, body);
+}
+
+static void bc_load(eval_context_t *ctx, lbm_uint base, bc_frame_t *f) {
+  lbm_value body = ctx->K.data[base];
+  lbm_value parts[3];
+  if (lbm_is_cons(body) && lbm_is_cons(get_cdr(body))) {
+    extract_n(body, parts, 3);
+    lbm_array_header_t *code = lbm_dec_array_r(parts[1]);
+    lbm_array_header_t *consts = lbm_dec_lisp_array_r(parts[2]);
+    if (parts[0] == ENC_SYM_BYTECODE && code && consts &&
+        code->size >= BC_HEADER_SIZE + BC_TRAILER_SIZE &&
+        code->size <= 0x10000 &&
+        consts->size >= BC_CONST_FIRST * sizeof(lbm_value)) {
+      f->code = (const uint8_t*)code->data;
+      f->code_size = code->size;
+      f->consts = parts[2];
+      f->cdata = (lbm_value*)consts->data;
+      f->num_consts = consts->size / sizeof(lbm_value);
+      f->base = base;
+      f->num_locals = f->code[BC_HEADER_NUM_LOCALS];
+      f->ops = base + 1 + f->num_locals;
+      // The profiler takes the running compiled closure from curr_exp.
+      ctx->curr_exp = body;
+      bool ok = (f->code[BC_HEADER_NUM_PARAMS] <= f->num_locals &&
+                 f->code[BC_HEADER_GLOBALS] <= f->num_consts);
+      for (lbm_uint i = 1; i <= BC_TRAILER_SIZE; i ++) {
+        ok = ok && f->code[f->code_size - i] == BC_RET;
+      }
+      if (ok) return;
+    }
+  }
+  bc_malformed(body);
+}
+
+// The body is at K[base] and nargs arguments above it. Check the
+// arguments and make room for the other locals. Arguments past the
+// parameters would be rest-args to an interpreted closure. Bodies using
+// rest-args are not compiled, so they are dropped.
+static void bc_enter(eval_context_t *ctx, lbm_uint base, lbm_uint nargs, bc_frame_t *f) {
+  bc_load(ctx, base, f);
+  lbm_uint num_params = f->code[BC_HEADER_NUM_PARAMS];
+  if (nargs < num_params) {
+    lbm_set_error_reason((char*)lbm_error_str_num_args);
+    ERROR_AT_CTX(ENC_SYM_EERROR, ctx->K.data[base]);
+  }
+  ctx->K.sp = base + 1 + num_params;
+  lbm_uint n = f->num_locals - num_params;
+  if (n > 0) {
+    lbm_value *locals = stack_reserve(ctx, (unsigned int)n);
+    for (lbm_uint i = 0; i < n; i ++) {
+      locals[i] = ENC_SYM_NIL;
+    }
+  }
+}
+
+// The binding cell of global g, ENC_SYM_NIL if unbound. Cells are kept
+// while the global environment token stays the same. A kept cell is
+// checked to be a cell binding the symbol, as the cells array can be
+// written to from lisp.
+static lbm_value bc_global_cell(bc_frame_t *f, lbm_uint g) {
+  lbm_value *cdata = f->cdata;
+  lbm_value sym = cdata[f->code[BC_HEADER_GLOBALS] + g];
+  lbm_array_header_t *cells = lbm_dec_array_rw(cdata[BC_CONST_CELLS]);
+  if ((f->consts & LBM_PTR_TO_CONSTANT_BIT) || !cells ||
+      cells->size < (g + 1) * sizeof(lbm_value)) {
+    return lbm_global_env_binding(sym);
+  }
+  lbm_value *cell_data = (lbm_value*)cells->data;
+  if (lbm_is_symbol_nil(lbm_global_env_token) ||
+      cdata[BC_CONST_TOKEN] != lbm_global_env_token) {
+    if (lbm_is_symbol_nil(lbm_global_env_token)) {
+      lbm_value token = lbm_cons(ENC_SYM_NIL, ENC_SYM_NIL);
+      if (!lbm_is_cons(token)) return lbm_global_env_binding(sym);
+      lbm_global_env_token = token;
+    }
+    for (lbm_uint i = 0; i < cells->size / sizeof(lbm_value); i ++) {
+      cell_data[i] = ENC_SYM_NIL;
+    }
+    lbm_gc_write_barrier(f->consts, lbm_global_env_token);
+    cdata[BC_CONST_TOKEN] = lbm_global_env_token;
+  }
+  lbm_value cell = cell_data[g];
+  if (lbm_is_cons_rw(cell) &&
+      lbm_dec_ptr(cell) < lbm_heap_state.heap_size &&
+      lbm_ref_cell(cell)->car == sym) {
+    return cell;
+  }
+  cell = lbm_global_env_binding(sym);
+  cell_data[g] = cell;
+  return cell;
+}
+
+static lbm_value bc_fundamental(eval_context_t *ctx, lbm_uint ix, lbm_value *args, lbm_uint n) {
+  lbm_value res;
+#ifdef LBM_ALWAYS_GC
+  gc();
+#endif
+  res = fundamental_table[ix](args, n, ctx);
+  if (lbm_is_error(res)) {
+    if (lbm_is_symbol_merror(res)) {
+      gc();
+      res = fundamental_table[ix](args, n, ctx);
+    }
+    if (lbm_is_error(res)) {
+      ERROR_AT_CTX(res, lbm_enc_sym(FUNDAMENTAL_SYMBOLS_START | ix));
+    }
+  }
+  return res;
+}
+
+// Apply something other than a compiled closure to the arguments above
+// K[fun_ix], the top of the stack.
+static void bc_apply(eval_context_t *ctx, lbm_uint fun_ix, lbm_uint nargs) {
+  lbm_value *fun_args = &ctx->K.data[fun_ix];
+  lbm_value fun = fun_args[0];
+  if (lbm_is_symbol(fun)) {
+    application(ctx, fun_args, nargs);
+    return;
+  }
+  if (lbm_is_closure(fun)) {
+    lbm_value cl[3];
+    extract_n(get_cdr(fun), cl, 3);
+    lbm_value env = cl[CLO_ENV];
+    lbm_value params = cl[CLO_PARAMS];
+    lbm_uint i = 1;
+    while (lbm_is_cons(params) && i <= nargs) {
+      env = allocate_binding(get_car(params), fun_args[i], env);
+      params = get_cdr(params);
+      i ++;
+    }
+    if (!lbm_is_cons(params) && i > nargs) {
+      lbm_stack_drop(&ctx->K, nargs + 1);
+      ctx->curr_env = env;
+      ctx->curr_exp = cl[CLO_BODY];
+      return;
+    }
+  }
+  // Everything else, and closures that take rest arguments or get
+  // too few, go through apply.
+  lbm_value args;
+  WITH_GC(args, lbm_heap_allocate_list(nargs));
+  lbm_value curr = args;
+  for (lbm_uint i = 1; i <= nargs; i ++) {
+    lbm_set_car(curr, fun_args[i]);
+    curr = get_cdr(curr);
+  }
+  if (nargs < 2) {
+    stack_reserve(ctx, (unsigned int)(2 - nargs));
+  } else {
+    lbm_stack_drop(&ctx->K, nargs - 2);
+  }
+  fun_args[0] = ENC_SYM_APPLY;
+  fun_args[1] = fun;
+  fun_args[2] = args;
+  application(ctx, fun_args, 2);
+}
+
+static void run_bytecode(eval_context_t *ctx, lbm_uint base, lbm_uint pc) {
+  lbm_value *stack = ctx->K.data;
+  lbm_uint size = ctx->K.size;
+  lbm_uint budget = BYTECODE_BUDGET;
+  bc_frame_t f;
+  bc_load(ctx, base, &f);
+  if (pc >= f.code_size) bc_malformed(stack[base]);
+  lbm_value *locals = &stack[f.base + 1];
+  lbm_uint sp = ctx->K.sp;
+  lbm_uint fun_ix;
+  lbm_uint nargs;
+  lbm_uint target;
+  lbm_value v;
+
+#define BC_PUSH(x) do {                         \
+    if (sp >= size) goto stack_error;           \
+    stack[sp++] = (x);                          \
+  } while (0)
+#define BC_NEED(n) do {                         \
+    if (sp < f.ops + (n)) goto malformed;       \
+  } while (0)
+#define BC_TARGET(ip) ((lbm_uint)(ip)[1] | ((lbm_uint)(ip)[2] << 8))
+
+  while (true) {
+    const uint8_t *ip = &f.code[pc];
+    switch (ip[0]) {
+    case BC_CONST:
+      if (ip[1] >= f.num_consts) goto malformed;
+      BC_PUSH(f.cdata[ip[1]]);
+      pc += 2;
+      break;
+    case BC_LOCAL:
+      if (ip[1] >= f.num_locals) goto malformed;
+      BC_PUSH(locals[ip[1]]);
+      pc += 2;
+      break;
+    case BC_SET_LOCAL:
+      if (ip[1] >= f.num_locals) goto malformed;
+      BC_NEED(1);
+      locals[ip[1]] = stack[sp - 1];
+      pc += 2;
+      break;
+    case BC_STORE:
+      if (ip[1] >= f.num_locals) goto malformed;
+      BC_NEED(1);
+      locals[ip[1]] = stack[--sp];
+      pc += 2;
+      break;
+    case BC_CELL: {
+      if (ip[1] >= f.num_consts) goto malformed;
+      lbm_value cell = f.cdata[ip[1]];
+      if (!lbm_is_cons(cell)) goto malformed;
+      BC_PUSH(lbm_ref_cell(cell)->cdr);
+      pc += 2;
+    } break;
+    case BC_SET_CELL: {
+      if (ip[1] >= f.num_consts) goto malformed;
+      lbm_value cell = f.cdata[ip[1]];
+      if (!lbm_is_cons(cell)) goto malformed;
+      BC_NEED(1);
+      lbm_set_cdr(cell, stack[sp - 1]);
+      pc += 2;
+    } break;
+    case BC_GLOBAL: {
+      if (f.code[BC_HEADER_GLOBALS] + (lbm_uint)ip[1] >= f.num_consts) goto malformed;
+      lbm_value cell = bc_global_cell(&f, ip[1]);
+      if (!lbm_is_cons(cell)) {
+        // Unbound, the evaluator tries a dynamic load.
+        v = f.cdata[f.code[BC_HEADER_GLOBALS] + ip[1]];
+        pc += 2;
+        goto lookup;
+      }
+      pc += 2;
+      BC_PUSH(lbm_ref_cell(cell)->cdr);
+    } break;
+    case BC_SET_GLOBAL: {
+      if (f.code[BC_HEADER_GLOBALS] + (lbm_uint)ip[1] >= f.num_consts) goto malformed;
+      BC_NEED(1);
+      lbm_value cell = bc_global_cell(&f, ip[1]);
+      if (!lbm_is_cons(cell)) {
+        ctx->K.sp = sp;
+        lbm_set_error_reason((char*)lbm_error_str_variable_not_bound);
+        ERROR_AT_CTX(ENC_SYM_NOT_FOUND, f.cdata[f.code[BC_HEADER_GLOBALS] + ip[1]]);
+      }
+      lbm_set_cdr(cell, stack[sp - 1]);
+      pc += 2;
+    } break;
+    case BC_POP:
+      BC_NEED(1);
+      sp --;
+      pc ++;
+      break;
+    case BC_JMP:
+      target = BC_TARGET(ip);
+      goto jump;
+    case BC_JMP_NIL:
+      BC_NEED(1);
+      sp --;
+      if (lbm_is_symbol_nil(stack[sp])) {
+        target = BC_TARGET(ip);
+        goto jump;
+      }
+      pc += 3;
+      break;
+    case BC_AND:
+      BC_NEED(1);
+      if (lbm_is_symbol_nil(stack[sp - 1])) {
+        target = BC_TARGET(ip);
+        goto jump;
+      }
+      sp --;
+      pc += 3;
+      break;
+    case BC_OR:
+      BC_NEED(1);
+      if (!lbm_is_symbol_nil(stack[sp - 1])) {
+        target = BC_TARGET(ip);
+        goto jump;
+      }
+      sp --;
+      pc += 3;
+      break;
+    case BC_FUND: {
+      lbm_uint ix = ip[1];
+      nargs = ip[2];
+      if (ix > FUNDAMENTALS_END - FUNDAMENTAL_SYMBOLS_START) goto malformed;
+      BC_NEED(nargs);
+      ctx->K.sp = sp;
+      v = bc_fundamental(ctx, ix, &stack[sp - nargs], nargs);
+      sp -= nargs;
+      BC_PUSH(v);
+      pc += 3;
+    } break;
+    case BC_CALL:
+      nargs = ip[1];
+      BC_NEED(nargs + 1);
+      if (sp + 3 > size) goto stack_error;
+      fun_ix = sp - nargs - 1;
+      memmove(&stack[fun_ix + 3], &stack[fun_ix], (nargs + 1) * sizeof(lbm_value));
+      stack[fun_ix] = lbm_enc_u(f.base);
+      stack[fun_ix + 1] = lbm_enc_u(pc + 2);
+      stack[fun_ix + 2] = BYTECODE_RESUME;
+      fun_ix += 3;
+      sp += 3;
+      goto call;
+    case BC_TAIL:
+      nargs = ip[1];
+      BC_NEED(nargs + 1);
+      fun_ix = sp - nargs - 1;
+      memmove(&stack[f.base], &stack[fun_ix], (nargs + 1) * sizeof(lbm_value));
+      fun_ix = f.base;
+      sp = fun_ix + nargs + 1;
+      goto call;
+    case BC_RET:
+      BC_NEED(1);
+      ctx->r = stack[sp - 1];
+      ctx->K.sp = f.base;
+      ctx->app_cont = true;
+      goto resume;
+    default:
+      goto malformed;
+    }
+    continue;
+
+  jump:
+    if (target >= f.code_size) goto malformed;
+    if (target <= pc && --budget == 0) {
+      pc = target;
+      goto yield;
+    }
+    pc = target;
+    continue;
+
+  call: {
+      lbm_value fun = stack[fun_ix];
+      if (lbm_is_closure(fun)) {
+        lbm_value body = get_car(get_cdr(get_cdr(fun)));
+        if (is_bytecode(body)) {
+          stack[fun_ix] = body;
+          ctx->K.sp = sp;
+          bc_enter(ctx, fun_ix, nargs, &f);
+          sp = ctx->K.sp;
+          locals = &stack[f.base + 1];
+          pc = BC_HEADER_SIZE;
+          if (--budget == 0) goto yield;
+          continue;
+        }
+      }
+      ctx->K.sp = sp;
+      bc_apply(ctx, fun_ix, nargs);
+    }
+  resume:
+    // Continue inline when a result is ready for a waiting frame.
+    if (ctx_running != ctx || !ctx->app_cont ||
+        ctx->K.sp < 3 || stack[ctx->K.sp - 1] != BYTECODE_RESUME) {
+      return;
+    }
+    ctx->app_cont = false;
+    sp = ctx->K.sp - 3;
+    pc = lbm_dec_u(stack[sp + 1]);
+    ctx->K.sp = sp;
+    bc_load(ctx, lbm_dec_u(stack[sp]), &f);
+    if (pc >= f.code_size) goto malformed;
+    locals = &stack[f.base + 1];
+    BC_PUSH(ctx->r);
+    continue;
+  }
+
+ lookup:
+  if (sp + 3 > size) goto stack_error;
+  stack[sp++] = lbm_enc_u(f.base);
+  stack[sp++] = lbm_enc_u(pc);
+  stack[sp++] = BYTECODE_RESUME;
+  ctx->K.sp = sp;
+  ctx->curr_exp = v;
+  ctx->curr_env = ENC_SYM_NIL;
+  return;
+ yield:
+  if (sp + 3 > size) goto stack_error;
+  stack[sp++] = lbm_enc_u(f.base);
+  stack[sp++] = lbm_enc_u(pc);
+  stack[sp++] = BYTECODE_YIELD;
+  ctx->K.sp = sp;
+  ctx->app_cont = true;
+  return;
+ stack_error:
+  ctx->K.sp = sp;
+  ERROR_CTX(ENC_SYM_STACK_ERROR);
+ malformed:
+  ctx->K.sp = sp;
+  bc_malformed(stack[f.base]);
+#undef BC_PUSH
+#undef BC_NEED
+#undef BC_TARGET
+}
+
+// fun_args[0] is a compiled closure, from cont_application_start.
+static void apply_compiled(eval_context_t *ctx, lbm_value *fun_args, lbm_uint arg_count) {
+  lbm_uint base = (lbm_uint)(fun_args - ctx->K.data);
+  fun_args[0] = get_car(get_cdr(get_cdr(fun_args[0])));
+  bc_frame_t f;
+  bc_enter(ctx, base, arg_count, &f);
+  run_bytecode(ctx, base, BC_HEADER_SIZE);
+}
+
+static void cont_bytecode_resume(eval_context_t *ctx) {
+  lbm_value base;
+  lbm_value pc;
+  lbm_pop_2(&ctx->K, &pc, &base);
+  stack_reserve(ctx, 1)[0] = ctx->r;
+  run_bytecode(ctx, lbm_dec_u(base), lbm_dec_u(pc));
+}
+
+static void cont_bytecode_yield(eval_context_t *ctx) {
+  lbm_value base;
+  lbm_value pc;
+  lbm_pop_2(&ctx->K, &pc, &base);
+  run_bytecode(ctx, lbm_dec_u(base), lbm_dec_u(pc));
+}
+
+// (bytecode code consts) is the body of a compiled closure that something
+// other than application has bound the parameters of, as spawn, sort and
+// merge do. The arguments are taken from the environment.
+static void eval_bytecode(eval_context_t *ctx) {
+  lbm_uint base = ctx->K.sp;
+  stack_reserve(ctx, 1)[0] = ctx->curr_exp;
+  bc_frame_t f;
+  bc_load(ctx, base, &f);
+  lbm_uint nargs = 0;
+  for (lbm_value params = f.cdata[BC_CONST_PARAMS]; lbm_is_cons(params); params = get_cdr(params)) {
+    lbm_value p = get_car(params);
+    lbm_value v;
+    if (!lbm_env_lookup_b(&v, p, ctx->curr_env)) {
+      lbm_set_error_reason((char*)lbm_error_str_variable_not_bound);
+      ERROR_AT_CTX(ENC_SYM_NOT_FOUND, p);
+    }
+    stack_reserve(ctx, 1)[0] = v;
+    nargs ++;
+  }
+  bc_enter(ctx, base, nargs, &f);
+  run_bytecode(ctx, base, BC_HEADER_SIZE);
+}
+
 /***************************************************/
 /* Application of function that takes arguments    */
 /* passed over the stack.                          */
 
 static void application(eval_context_t *ctx, lbm_value *fun_args, lbm_uint arg_count) {
-  /* If arriving here, we know that the fun is a symbol.
-   *  and can be a built in operation or an extension.
+  /* If arriving here, we know that the fun is a symbol
+   *  and can be a built in operation or an extension,
+   *  or it is a compiled closure.
    */
   lbm_value fun = fun_args[0];
 
+  if (lbm_is_cons(fun)) {
+    apply_compiled(ctx, fun_args, arg_count);
+    return;
+  }
+
   lbm_uint fun_val = lbm_dec_sym(fun);
   lbm_uint fun_kind = SYMBOL_KIND(fun_val);
 
@@ -3394,7 +4232,9 @@ static void application(eval_context_t *ctx, lbm_value *fun_args, lbm_uint arg_c
     extension_fptr f = extension_table[SYMBOL_IX(fun_val)].fptr;
 
     lbm_value ext_res;
+    lbm_current_extension = fun;
     WITH_GC(ext_res, f(&fun_args[1], arg_count));
+    lbm_current_extension = ENC_SYM_NIL;
     if (lbm_is_error(ext_res)) { //Error other than merror
       ERROR_AT_CTX(ext_res, fun);
     }
@@ -3501,6 +4341,7 @@ static void cont_closure_args_rest(eval_context_t *ctx) {
   lbm_uint binding_ix = lbm_dec_ptr(binding);
   lbm_heap_state.freelist = heap[binding_ix].cdr;
   lbm_heap_state.num_alloc += 1;
+  lbm_gc_inc_allocated(binding_ix);
   heap[binding_ix].car = ctx->r;
   heap[binding_ix].cdr = ENC_SYM_NIL;
 
@@ -4591,6 +5432,7 @@ static void cont_read_append_array(eval_context_t *ctx) {
     ctx->r = array;
     ctx->app_cont = true;
   } else {
+    lbm_gc_write_barrier(array, ctx->r);
     ((lbm_uint*)arr->data)[ix] = ctx->r;
 
     sptr[2] = lbm_enc_u(ix + 1);
@@ -4820,6 +5662,12 @@ static void cont_application_start(eval_context_t *ctx) {
     case ENC_SYM_CLOSURE: {
       lbm_value cl[3];
       extract_n(get_cdr(ctx->r), cl, 3);
+      if (is_bytecode(cl[CLO_BODY])) {
+        // The arguments go on the stack, as for a symbol.
+        stack_reserve(ctx,1)[0] = lbm_enc_u(0);
+        cont_application_args(ctx);
+        return;
+      }
       lbm_value arg_env = (lbm_value)sptr[0];
       lbm_value arg0, arg_rest;
       get_car_and_cdr(args, &arg0, &arg_rest);
@@ -5372,7 +6220,7 @@ static void cont_recv_to(eval_context_t *ctx) {
     if (ctx->num_mail > 0) {
       lbm_value e;
       lbm_value new_env = ctx->curr_env;
-      int n = find_match(sptr[0], ctx->mailbox, ctx->num_mail, &e, &new_env);
+      int n = find_match(sptr[0], ctx, &e, &new_env);
       if (n >= 0) { // match
         mailbox_remove_mail(ctx, (lbm_uint)n);
         ctx->curr_env = new_env;
@@ -5403,7 +6251,7 @@ static void cont_recv_to_retry(eval_context_t *ctx) {
   if (ctx->num_mail > 0) {
     lbm_value e;
     lbm_value new_env = ctx->curr_env;
-    int n = find_match(sptr[0], ctx->mailbox, ctx->num_mail, &e, &new_env);
+    int n = find_match(sptr[0], ctx, &e, &new_env);
     if (n >= 0) { // match
       mailbox_remove_mail(ctx, (lbm_uint)n);
       ctx->curr_env = new_env;
@@ -5484,6 +6332,8 @@ static const cont_fun continuations[NUM_CONTINUATIONS] =
     cont_read_start_array,
     cont_read_append_array,
     cont_loop_env_prep,
+    cont_bytecode_resume,
+    cont_bytecode_yield,
   };
 
 /*********************************************************/
@@ -5517,6 +6367,7 @@ static const evaluator_fun evaluators[] =
    eval_trap,
    eval_call_cc_unsafe,
    eval_selfevaluating, // cont_sp
+   eval_bytecode,
   };
 
 
@@ -5525,6 +6376,7 @@ static const evaluator_fun evaluators[] =
 
 static void evaluation_step(void){
   eval_context_t *ctx = ctx_running;
+  eval_steps_total ++;
 #ifdef VISUALIZE_HEAP
   heap_vis_gen_image();
 #endif
@@ -5613,6 +6465,26 @@ static void apply_apply(lbm_value *args, lbm_uint nargs, eval_context_t *ctx) {
         case ENC_SYM_CLOSURE: {          
           lbm_value closure[3];
           extract_n(get_cdr(fun), closure, 3);
+
+          if (is_bytecode(closure[CLO_BODY])) {
+            // apply can be called from compiled code, so the frame is
+            // set up here and runs in the next step.
+            lbm_uint base = ctx->K.sp;
+            stack_reserve(ctx, 1)[0] = closure[CLO_BODY];
+            lbm_uint arg_count = 0;
+            for (lbm_value current = arg_list; lbm_is_cons(current); current = get_cdr(current)) {
+              stack_reserve(ctx, 1)[0] = get_car(current);
+              arg_count++;
+            }
+            bc_frame_t f;
+            bc_enter(ctx, base, arg_count, &f);
+            lbm_value *sptr = stack_reserve(ctx, 3);
+            sptr[0] = lbm_enc_u(base);
+            sptr[1] = lbm_enc_u(BC_HEADER_SIZE);
+            sptr[2] = BYTECODE_YIELD;
+            ctx->app_cont = true;
+            return;
+          }
           
           // Only placed here to protect from GC. Will be overriden later.
           // ctx->r = arg_list; // Should already be placed there.
@@ -5723,6 +6595,57 @@ void lbm_kill_eval(void) {
   if (eval_cps_next_state != eval_cps_run_state) eval_cps_state_changed = true;
 }
 
+// Frames of applications that wait for their arguments to be evaluated:
+//   [fun, arg_0 .. arg_n-1, env, rest, n+1, APPLICATION_ARGS]
+//   [arg_env, body, clo_env, params, args, CLOSURE_ARGS]
+//   [arg_env, body, clo_env, args, last, CLOSURE_ARGS_REST]
+// and of compiled closures, with their body at K[base], that wait for a
+// call to return or for their next time slice:
+//   [base, pc, BYTECODE_RESUME]
+//   [base, pc, BYTECODE_YIELD]
+// The stack may be read while the context runs, so every frame is
+// checked to lie within the stack before it is used.
+lbm_uint lbm_get_pending_applications(eval_context_t *ctx, lbm_value *res, lbm_uint max, lbm_uint max_scan, bool *truncated) {
+  lbm_uint *data = ctx->K.data;
+  lbm_uint sp = ctx->K.sp;
+  lbm_uint n = 0;
+  lbm_uint i = sp;
+  lbm_uint stop = (sp > max_scan) ? sp - max_scan : 0;
+  *truncated = stop > 0;
+  if (sp > ctx->K.size) return 0;
+  while (i > stop) {
+    i --;
+    lbm_uint k = data[i];
+    lbm_value f = ENC_SYM_NIL;
+    if (k == APPLICATION_ARGS && i >= 3) {
+      lbm_uint count = lbm_dec_u(data[i-1]);
+      if (lbm_type_of(data[i-1]) == LBM_TYPE_U && count + 3 <= i) {
+        lbm_value fun = data[i - 3 - count];
+        if (lbm_is_symbol(fun) &&
+            SYMBOL_KIND(lbm_dec_sym(fun)) == SYMBOL_KIND_EXTENSION) {
+          f = fun;
+        }
+      }
+    } else if ((k == CLOSURE_ARGS || k == CLOSURE_ARGS_REST) && i >= 4) {
+      if (lbm_is_cons(data[i-4])) f = data[i-4];
+    } else if ((k == BYTECODE_RESUME || k == BYTECODE_YIELD) && i >= 2) {
+      lbm_uint base = lbm_dec_u(data[i-2]);
+      if (lbm_type_of(data[i-2]) == LBM_TYPE_U && base < i - 2 &&
+          lbm_is_cons(data[base])) {
+        f = data[base];
+      }
+    }
+    if (f != ENC_SYM_NIL) {
+      if (n == max) {
+        *truncated = true;
+        break;
+      }
+      res[n++] = f;
+    }
+  }
+  return n;
+}
+
 uint32_t lbm_get_eval_state(void) {
   return eval_cps_run_state;
 }
@@ -5748,15 +6671,10 @@ static void handle_event_unblock_ctx(lbm_cid cid, lbm_value v) {
 }
 
 static void handle_event_define(lbm_value key, lbm_value val) {
-  lbm_uint dec_key = lbm_dec_sym(key);
-  lbm_uint ix_key  = dec_key & GLOBAL_ENV_MASK;
-  lbm_value *global_env = lbm_get_global_env();
-  lbm_uint orig_env = global_env[ix_key];
-  lbm_value new_env;
+  lbm_value res;
   // A key is a symbol and should not need to be remembered.
-  WITH_GC(new_env, lbm_env_set(orig_env,key,val));
-
-  global_env[ix_key] = new_env;
+  WITH_GC(res, lbm_global_env_set(key,val));
+  (void) res;
 }
 
 static lbm_value get_event_value(lbm_event_t *e) {
@@ -5835,6 +6753,7 @@ void lbm_run_eval(void){
   }
 
   setjmp(error_jmp_buf);
+  lbm_current_extension = ENC_SYM_NIL;
 
   while (eval_running) {
     if (eval_cps_state_changed  || eval_cps_run_state == EVAL_CPS_STATE_PAUSED) {
@@ -5845,6 +6764,8 @@ void lbm_run_eval(void){
           is_atomic = false;
           blocked.first = NULL;
           blocked.last = NULL;
+          timers.first = NULL;
+          timers.last = NULL;
           queue.first = NULL;
           queue.last = NULL;
           ctx_running = NULL;
@@ -5898,8 +6819,12 @@ void lbm_run_eval(void){
         // are on same side of overflow.
         eval_current_quota = timestamp_us_callback() + eval_time_refill;
         if (!is_atomic) {
+          account_alloc();
           if (gc_requested) {
+            gc_trigger = LBM_GC_TRIGGER_REQUEST;
             gc();
+          } else if (gc_pause_budget) {
+            gc_slice();
           }
           process_events();
           mutex_lock(&qmutex);
@@ -5907,13 +6832,15 @@ void lbm_run_eval(void){
             enqueue_ctx_nm(&queue, ctx_running);
             ctx_running = NULL;
           }
-          wake_up_ctxs_nm();
+          uint32_t idle_us = wake_up_ctxs_nm();
           ctx_running = dequeue_ctx_nm(&queue);
+          alloc_start = lbm_heap_state.num_alloc;
           mutex_unlock(&qmutex);
           if (!ctx_running) {
             lbm_system_sleeping = true;
-            //Fixed sleep interval to poll events regularly.
-            usleep_callback(EVAL_CPS_MIN_SLEEP);
+            // Sleep until the next timer is due but at most
+            // eval_idle_sleep_max to poll events regularly.
+            usleep_callback(idle_us < EVAL_CPS_MIN_SLEEP ? EVAL_CPS_MIN_SLEEP : idle_us);
             lbm_system_sleeping = false;
           }
         }
@@ -5926,8 +6853,12 @@ void lbm_run_eval(void){
         if (eval_cps_state_changed) break;
         eval_steps_quota = eval_steps_refill;
         if (!is_atomic) {
+          account_alloc();
           if (gc_requested) {
+            gc_trigger = LBM_GC_TRIGGER_REQUEST;
             gc();
+          } else if (gc_pause_budget) {
+            gc_slice();
           }
           process_events();
           mutex_lock(&qmutex);
@@ -5935,13 +6866,15 @@ void lbm_run_eval(void){
             enqueue_ctx_nm(&queue, ctx_running);
             ctx_running = NULL;
           }
-          wake_up_ctxs_nm();
+          uint32_t idle_us = wake_up_ctxs_nm();
           ctx_running = dequeue_ctx_nm(&queue);
+          alloc_start = lbm_heap_state.num_alloc;
           mutex_unlock(&qmutex);
           if (!ctx_running) {
             lbm_system_sleeping = true;
-            //Fixed sleep interval to poll events regularly.
-            usleep_callback(EVAL_CPS_MIN_SLEEP);
+            // Sleep until the next timer is due but at most
+            // eval_idle_sleep_max to poll events regularly.
+            usleep_callback(idle_us < EVAL_CPS_MIN_SLEEP ? EVAL_CPS_MIN_SLEEP : idle_us);
             lbm_system_sleeping = false;
           }
         }
@@ -5978,11 +6911,18 @@ int lbm_eval_init(void) {
 
   blocked.first = NULL;
   blocked.last = NULL;
+  timers.first = NULL;
+  timers.last = NULL;
   queue.first = NULL;
   queue.last = NULL;
   ctx_running = NULL;
 
   eval_cps_run_state = EVAL_CPS_STATE_RUNNING;
+  gc_pause_budget = 0;
+  gc_trigger = LBM_GC_TRIGGER_ALLOC;
+  alloc_start = 0;
+  memset(&gc_stats, 0, sizeof(gc_stats));
+  eval_steps_total = 0;
 
   mutex_unlock(&lbm_events_mutex);
   mutex_unlock(&qmutex);
@@ -5995,14 +6935,23 @@ int lbm_eval_init(void) {
 bool lbm_eval_init_events(unsigned int num_events) {
 
   mutex_lock(&lbm_events_mutex);
-  lbm_events = (lbm_event_t*)lbm_malloc(num_events * sizeof(lbm_event_t));
+  lbm_events = NULL;
+  // The number of slots is rounded up to a power of two so that
+  // slot indices stay consistent when the counters wrap.
+  uint32_t n = 1;
+  while (n < num_events) n <<= 1;
+  lbm_event_slot_t *events = (lbm_event_slot_t*)lbm_malloc(n * sizeof(lbm_event_slot_t));
   bool r = false;
-  if (lbm_events) {
-    lbm_events_max = num_events;
+  if (events) {
+    for (uint32_t i = 0; i < n; i ++) {
+      events[i].seq = i;
+    }
+    lbm_events_mask = n - 1;
     lbm_events_head = 0;
     lbm_events_tail = 0;
-    lbm_events_full = false;
+    lbm_events_dropped = 0;
     lbm_event_handler_pid = -1;
+    __atomic_store_n(&lbm_events, events, __ATOMIC_RELEASE);
     r = true;
   }
   mutex_unlock(&lbm_events_mutex);
@@ -28,11 +28,17 @@
 
 static lbm_uint ext_max    = 0;
 static lbm_uint next_extension_ix = 0;
+// Extensions restored from an image are usually added again in the same
+// order, so the entry after the last one added is checked before the name
+// is looked up.
+static lbm_uint expected_extension_ix = 0;
 
 lbm_extension_t *extension_table = NULL;
 
 void lbm_extensions_set_next(lbm_uint i) {
   next_extension_ix = i;
+  expected_extension_ix = 0;
+  lbm_symrepr_index_invalidate();
 }
 
 lbm_value lbm_extensions_default(lbm_value *args, lbm_uint argn) {
@@ -52,7 +58,9 @@ int lbm_extensions_init(lbm_extension_t *extension_storage, lbm_uint extension_s
   }
 
   next_extension_ix = 0;
+  expected_extension_ix = 0;
   ext_max = (lbm_uint)extension_storage_size;
+  lbm_symrepr_index_invalidate();
 
   return 1;
 }
@@ -98,6 +106,15 @@ bool lbm_lookup_extension_id(char *sym_str, lbm_uint *ix) {
 bool lbm_add_extension(char *sym_str, extension_fptr ext) {
   lbm_value symbol;
 
+  if (expected_extension_ix < next_extension_ix) {
+    char *name = extension_table[expected_extension_ix].name;
+    if (name && (name == sym_str || str_eq(name, sym_str))) {
+      extension_table[expected_extension_ix].fptr = ext;
+      expected_extension_ix ++;
+      return true;
+    }
+  }
+
   // symbol_by_name loops through all symbols. It may be enough
   // to search only the extension table, but unsure what the effect will
   // be if adding an extension with same str-name as a built-in or special
@@ -108,6 +125,7 @@ bool lbm_add_extension(char *sym_str, extension_fptr ext) {
     if (lbm_is_extension(lbm_enc_sym(symbol))) {
       // update the extension entry.
       extension_table[SYMBOL_IX(symbol)].fptr = ext;
+      expected_extension_ix = SYMBOL_IX(symbol) + 1;
       return true;
     }
     return false;
@@ -117,6 +135,8 @@ bool lbm_add_extension(char *sym_str, extension_fptr ext) {
     lbm_uint sym_ix = next_extension_ix ++;
     extension_table[sym_ix].name = sym_str;
     extension_table[sym_ix].fptr = ext;
+    expected_extension_ix = next_extension_ix;
+    lbm_symrepr_index_add_extension(sym_ix);
     return true;
   }
   return false;
@@ -59,6 +59,28 @@ static lbm_value array_extensions_bufclear(lbm_value *args, lbm_uint argn);
 static lbm_value array_extensions_bufcpy(lbm_value *args, lbm_uint argn);
 static lbm_value array_extensions_bufset_bit(lbm_value *args, lbm_uint argn);
 
+static lbm_value array_extensions_vec_add(lbm_value *args, lbm_uint argn);
+static lbm_value array_extensions_vec_mul(lbm_value *args, lbm_uint argn);
+static lbm_value array_extensions_vec_scale(lbm_value *args, lbm_uint argn);
+static lbm_value array_extensions_vec_axpy(lbm_value *args, lbm_uint argn);
+static lbm_value array_extensions_vec_dot(lbm_value *args, lbm_uint argn);
+static lbm_value array_extensions_vec_sum(lbm_value *args, lbm_uint argn);
+static lbm_value array_extensions_vec_min(lbm_value *args, lbm_uint argn);
+static lbm_value array_extensions_vec_max(lbm_value *args, lbm_uint argn);
+static lbm_value array_extensions_vec_fir(lbm_value *args, lbm_uint argn);
+static lbm_value array_extensions_vec_biquad(lbm_value *args, lbm_uint argn);
+static lbm_value array_extensions_vec_movavg(lbm_value *args, lbm_uint argn);
+static lbm_value array_extensions_vec_interp(lbm_value *args, lbm_uint argn);
+static lbm_value array_extensions_vec_resample(lbm_value *args, lbm_uint argn);
+static lbm_value array_extensions_vec_sort(lbm_value *args, lbm_uint argn);
+static lbm_value array_extensions_vec_argsort(lbm_value *args, lbm_uint argn);
+static lbm_value array_extensions_vec_search(lbm_value *args, lbm_uint argn);
+static lbm_value array_extensions_array_sort(lbm_value *args, lbm_uint argn);
+
+static lbm_uint sym_i16 = 0;
+static lbm_uint sym_i32 = 0;
+static lbm_uint sym_f32 = 0;
+
 void lbm_array_extensions_init(void) {
 
   lbm_add_symbol_const("little-endian", &little_endian);
@@ -87,6 +109,28 @@ void lbm_array_extensions_init(void) {
   lbm_add_extension("bufclear", array_extensions_bufclear);
   lbm_add_extension("bufcpy", array_extensions_bufcpy);
   lbm_add_extension("bufset-bit", array_extensions_bufset_bit);
+
+  lbm_add_symbol_const("i16", &sym_i16);
+  lbm_add_symbol_const("i32", &sym_i32);
+  lbm_add_symbol_const("f32", &sym_f32);
+
+  lbm_add_extension("vec-add", array_extensions_vec_add);
+  lbm_add_extension("vec-mul", array_extensions_vec_mul);
+  lbm_add_extension("vec-scale", array_extensions_vec_scale);
+  lbm_add_extension("vec-axpy", array_extensions_vec_axpy);
+  lbm_add_extension("vec-dot", array_extensions_vec_dot);
+  lbm_add_extension("vec-sum", array_extensions_vec_sum);
+  lbm_add_extension("vec-min", array_extensions_vec_min);
+  lbm_add_extension("vec-max", array_extensions_vec_max);
+  lbm_add_extension("vec-fir", array_extensions_vec_fir);
+  lbm_add_extension("vec-biquad", array_extensions_vec_biquad);
+  lbm_add_extension("vec-movavg", array_extensions_vec_movavg);
+  lbm_add_extension("vec-interp", array_extensions_vec_interp);
+  lbm_add_extension("vec-resample", array_extensions_vec_resample);
+  lbm_add_extension("vec-sort", array_extensions_vec_sort);
+  lbm_add_extension("vec-argsort", array_extensions_vec_argsort);
+  lbm_add_extension("vec-search", array_extensions_vec_search);
+  lbm_add_extension("array-sort", array_extensions_array_sort);
 }
 
 lbm_value array_extension_unsafe_free_array(lbm_value *args, lbm_uint argn) {
@@ -689,3 +733,899 @@ static lbm_value array_extensions_bufset_bit(lbm_value *args, lbm_uint argn) {
   }
   return res;
 }
+
+// Vector kernels
+//
+// The vec- extensions treat byte arrays as arrays of i16, i32 or f32
+// elements in native byte order, the element type is given by the
+// symbol 'i16, 'i32 or 'f32. Buffers filled with bufset- should use
+// 'little-endian on little-endian targets. All loops run in C without
+// allocation. Element counts are the minimum over the arrays involved.
+// f32 and i16 elements are computed on as float, which holds every i16
+// exactly and runs on single precision FPUs. i32 elements are computed
+// on as double, which holds every i32 exactly. Means and resampling of
+// integer elements are exact integer computations. Integer results are
+// rounded half away from zero and saturated to the element type.
+
+#define VEC_I16 0
+#define VEC_I32 1
+#define VEC_F32 2
+
+typedef struct {
+  void *data;
+  lbm_uint len; // Number of elements.
+} vec_t;
+
+static bool vec_type(lbm_value v, int *type, lbm_uint *esize) {
+  if (!lbm_is_symbol(v)) return false;
+  lbm_uint s = lbm_dec_sym(v);
+  if (s == sym_i16) {
+    *type = VEC_I16;
+    *esize = 2;
+  } else if (s == sym_i32) {
+    *type = VEC_I32;
+    *esize = 4;
+  } else if (s == sym_f32) {
+    *type = VEC_F32;
+    *esize = 4;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+static bool vec_arg(lbm_value v, lbm_uint esize, bool rw, vec_t *vec) {
+  lbm_array_header_t *array = rw ? lbm_dec_array_rw(v) : lbm_dec_array_r(v);
+  if (!array || ((lbm_uint)array->data & (esize - 1))) return false;
+  vec->data = array->data;
+  vec->len = array->size / esize;
+  return true;
+}
+
+static inline lbm_uint vec_min_len(lbm_uint a, lbm_uint b) {
+  return a < b ? a : b;
+}
+
+static inline int16_t vec_sat_i16(int32_t v) {
+  if (v > INT16_MAX) return INT16_MAX;
+  if (v < INT16_MIN) return INT16_MIN;
+  return (int16_t)v;
+}
+
+static inline int32_t vec_sat_i32(int64_t v) {
+  if (v > INT32_MAX) return INT32_MAX;
+  if (v < INT32_MIN) return INT32_MIN;
+  return (int32_t)v;
+}
+
+static inline int32_t vec_get_int(int type, const void *data, lbm_uint i) {
+  return type == VEC_I16 ? ((const int16_t*)data)[i] : ((const int32_t*)data)[i];
+}
+
+static inline void vec_set_int(int type, void *data, lbm_uint i, int64_t v) {
+  if (type == VEC_I16) ((int16_t*)data)[i] = vec_sat_i16((int32_t)vec_sat_i32(v));
+  else ((int32_t*)data)[i] = vec_sat_i32(v);
+}
+
+// The limits are converted from the integer macros, as constants are
+// single precision in the firmware build.
+static inline int16_t vec_round_i16(float v) {
+  if (v >= (float)INT16_MAX) return INT16_MAX;
+  if (v <= (float)INT16_MIN) return INT16_MIN;
+  return (int16_t)(v < 0.0f ? v - 0.5f : v + 0.5f);
+}
+
+static inline int32_t vec_round_i32(double v) {
+  if (v >= (double)INT32_MAX) return INT32_MAX;
+  if (v <= (double)INT32_MIN) return INT32_MIN;
+  return (int32_t)(v < (double)0.0 ? v - (double)0.5 : v + (double)0.5);
+}
+
+// a / b rounded half away from zero, for b > 0.
+static inline int64_t vec_div_round(int64_t a, int64_t b) {
+  int64_t q = a / b;
+  int64_t r = a % b;
+  if (2 * r >= b) q ++;
+  else if (-2 * r >= b) q --;
+  return q;
+}
+
+// (vec-add type dst a b) and (vec-mul type dst a b). dst may be a or b.
+static lbm_value vec_binop(lbm_value *args, lbm_uint argn, bool mul) {
+  lbm_value res = ENC_SYM_EERROR;
+  if (argn == 4) {
+    res = ENC_SYM_TERROR;
+    int type;
+    lbm_uint es;
+    vec_t d, a, b;
+    if (vec_type(args[0], &type, &es) &&
+        vec_arg(args[1], es, true, &d) &&
+        vec_arg(args[2], es, false, &a) &&
+        vec_arg(args[3], es, false, &b)) {
+      lbm_uint n = vec_min_len(d.len, vec_min_len(a.len, b.len));
+      switch (type) {
+      case VEC_I16: {
+        int16_t *dp = (int16_t*)d.data;
+        const int16_t *ap = (const int16_t*)a.data;
+        const int16_t *bp = (const int16_t*)b.data;
+        if (mul) {
+          for (lbm_uint i = 0; i < n; i ++) dp[i] = vec_sat_i16((int32_t)ap[i] * bp[i]);
+        } else {
+          for (lbm_uint i = 0; i < n; i ++) dp[i] = vec_sat_i16((int32_t)ap[i] + bp[i]);
+        }
+      } break;
+      case VEC_I32: {
+        int32_t *dp = (int32_t*)d.data;
+        const int32_t *ap = (const int32_t*)a.data;
+        const int32_t *bp = (const int32_t*)b.data;
+        if (mul) {
+          for (lbm_uint i = 0; i < n; i ++) dp[i] = vec_sat_i32((int64_t)ap[i] * bp[i]);
+        } else {
+          for (lbm_uint i = 0; i < n; i ++) dp[i] = vec_sat_i32((int64_t)ap[i] + bp[i]);
+        }
+      } break;
+      default: {
+        float *dp = (float*)d.data;
+        const float *ap = (const float*)a.data;
+        const float *bp = (const float*)b.data;
+        if (mul) {
+          for (lbm_uint i = 0; i < n; i ++) dp[i] = ap[i] * bp[i];
+        } else {
+          for (lbm_uint i = 0; i < n; i ++) dp[i] = ap[i] + bp[i];
+        }
+      } break;
+      }
+      res = ENC_SYM_TRUE;
+    }
+  }
+  return res;
+}
+
+static lbm_value array_extensions_vec_add(lbm_value *args, lbm_uint argn) {
+  return vec_binop(args, argn, false);
+}
+
+static lbm_value array_extensions_vec_mul(lbm_value *args, lbm_uint argn) {
+  return vec_binop(args, argn, true);
+}
+
+// (vec-scale type dst src k): dst = k * src
+static lbm_value array_extensions_vec_scale(lbm_value *args, lbm_uint argn) {
+  lbm_value res = ENC_SYM_EERROR;
+  if (argn == 4) {
+    res = ENC_SYM_TERROR;
+    int type;
+    lbm_uint es;
+    vec_t d, a;
+    if (vec_type(args[0], &type, &es) &&
+        vec_arg(args[1], es, true, &d) &&
+        vec_arg(args[2], es, false, &a) &&
+        lbm_is_number(args[3])) {
+      lbm_uint n = vec_min_len(d.len, a.len);
+      switch (type) {
+      case VEC_I16: {
+        float k = lbm_dec_as_float(args[3]);
+        int16_t *dp = (int16_t*)d.data;
+        const int16_t *ap = (const int16_t*)a.data;
+        for (lbm_uint i = 0; i < n; i ++) dp[i] = vec_round_i16(k * (float)ap[i]);
+      } break;
+      case VEC_I32: {
+        double k = lbm_dec_as_double(args[3]);
+        int32_t *dp = (int32_t*)d.data;
+        const int32_t *ap = (const int32_t*)a.data;
+        for (lbm_uint i = 0; i < n; i ++) dp[i] = vec_round_i32(k * (double)ap[i]);
+      } break;
+      default: {
+        float k = lbm_dec_as_float(args[3]);
+        float *dp = (float*)d.data;
+        const float *ap = (const float*)a.data;
+        for (lbm_uint i = 0; i < n; i ++) dp[i] = k * ap[i];
+      } break;
+      }
+      res = ENC_SYM_TRUE;
+    }
+  }
+  return res;
+}
+
+// (vec-axpy type y k x): y = k * x + y
+static lbm_value array_extensions_vec_axpy(lbm_value *args, lbm_uint argn) {
+  lbm_value res = ENC_SYM_EERROR;
+  if (argn == 4) {
+    res = ENC_SYM_TERROR;
+    int type;
+    lbm_uint es;
+    vec_t y, x;
+    if (vec_type(args[0], &type, &es) &&
+        vec_arg(args[1], es, true, &y) &&
+        lbm_is_number(args[2]) &&
+        vec_arg(args[3], es, false, &x)) {
+      lbm_uint n = vec_min_len(y.len, x.len);
+      switch (type) {
+      case VEC_I16: {
+        float k = lbm_dec_as_float(args[2]);
+        int16_t *yp = (int16_t*)y.data;
+        const int16_t *xp = (const int16_t*)x.data;
+        for (lbm_uint i = 0; i < n; i ++) yp[i] = vec_round_i16(k * (float)xp[i] + (float)yp[i]);
+      } break;
+      case VEC_I32: {
+        double k = lbm_dec_as_double(args[2]);
+        int32_t *yp = (int32_t*)y.data;
+        const int32_t *xp = (const int32_t*)x.data;
+        for (lbm_uint i = 0; i < n; i ++) yp[i] = vec_round_i32(k * (double)xp[i] + (double)yp[i]);
+      } break;
+      default: {
+        float k = lbm_dec_as_float(args[2]);
+        float *yp = (float*)y.data;
+        const float *xp = (const float*)x.data;
+        for (lbm_uint i = 0; i < n; i ++) yp[i] += k * xp[i];
+      } break;
+      }
+      res = ENC_SYM_TRUE;
+    }
+  }
+  return res;
+}
+
+// (vec-dot type a b), exact i64 for the integer types.
+static lbm_value array_extensions_vec_dot(lbm_value *args, lbm_uint argn) {
+  lbm_value res = ENC_SYM_EERROR;
+  if (argn == 3) {
+    res = ENC_SYM_TERROR;
+    int type;
+    lbm_uint es;
+    vec_t a, b;
+    if (vec_type(args[0], &type, &es) &&
+        vec_arg(args[1], es, false, &a) &&
+        vec_arg(args[2], es, false, &b)) {
+      lbm_uint n = vec_min_len(a.len, b.len);
+      switch (type) {
+      case VEC_I16: {
+        const int16_t *ap = (const int16_t*)a.data;
+        const int16_t *bp = (const int16_t*)b.data;
+        int64_t acc = 0;
+        for (lbm_uint i = 0; i < n; i ++) acc += (int32_t)ap[i] * bp[i];
+        res = lbm_enc_i64(acc);
+      } break;
+      case VEC_I32: {
+        const int32_t *ap = (const int32_t*)a.data;
+        const int32_t *bp = (const int32_t*)b.data;
+        int64_t acc = 0;
+        for (lbm_uint i = 0; i < n; i ++) acc += (int64_t)ap[i] * bp[i];
+        res = lbm_enc_i64(acc);
+      } break;
+      default: {
+        const float *ap = (const float*)a.data;
+        const float *bp = (const float*)b.data;
+        float acc = 0.0f;
+        for (lbm_uint i = 0; i < n; i ++) acc += ap[i] * bp[i];
+        res = lbm_enc_float(acc);
+      } break;
+      }
+    }
+  }
+  return res;
+}
+
+// (vec-sum type a), exact i64 for the integer types.
+static lbm_value array_extensions_vec_sum(lbm_value *args, lbm_uint argn) {
+  lbm_value res = ENC_SYM_EERROR;
+  if (argn == 2) {
+    res = ENC_SYM_TERROR;
+    int type;
+    lbm_uint es;
+    vec_t a;
+    if (vec_type(args[0], &type, &es) &&
+        vec_arg(args[1], es, false, &a)) {
+      switch (type) {
+      case VEC_I16: {
+        const int16_t *ap = (const int16_t*)a.data;
+        int64_t acc = 0;
+        for (lbm_uint i = 0; i < a.len; i ++) acc += ap[i];
+        res = lbm_enc_i64(acc);
+      } break;
+      case VEC_I32: {
+        const int32_t *ap = (const int32_t*)a.data;
+        int64_t acc = 0;
+        for (lbm_uint i = 0; i < a.len; i ++) acc += ap[i];
+        res = lbm_enc_i64(acc);
+      } break;
+      default: {
+        const float *ap = (const float*)a.data;
+        float acc = 0.0f;
+        for (lbm_uint i = 0; i < a.len; i ++) acc += ap[i];
+        res = lbm_enc_float(acc);
+      } break;
+      }
+    }
+  }
+  return res;
+}
+
+// (vec-min type a) and (vec-max type a), nil for an empty array.
+static lbm_value vec_extreme(lbm_value *args, lbm_uint argn, bool max) {
+  lbm_value res = ENC_SYM_EERROR;
+  if (argn == 2) {
+    res = ENC_SYM_TERROR;
+    int type;
+    lbm_uint es;
+    vec_t a;
+    if (vec_type(args[0], &type, &es) &&
+        vec_arg(args[1], es, false, &a)) {
+      if (a.len == 0) return ENC_SYM_NIL;
+      switch (type) {
+      case VEC_I16: {
+        const int16_t *ap = (const int16_t*)a.data;
+        int16_t m = ap[0];
+        for (lbm_uint i = 1; i < a.len; i ++) {
+          if (max ? ap[i] > m : ap[i] < m) m = ap[i];
+        }
+        res = lbm_enc_i(m);
+      } break;
+      case VEC_I32: {
+        const int32_t *ap = (const int32_t*)a.data;
+        int32_t m = ap[0];
+        for (lbm_uint i = 1; i < a.len; i ++) {
+          if (max ? ap[i] > m : ap[i] < m) m = ap[i];
+        }
+        res = lbm_enc_i32(m);
+      } break;
+      default: {
+        const float *ap = (const float*)a.data;
+        float m = ap[0];
+        for (lbm_uint i = 1; i < a.len; i ++) {
+          if (max ? ap[i] > m : ap[i] < m) m = ap[i];
+        }
+        res = lbm_enc_float(m);
+      } break;
+      }
+    }
+  }
+  return res;
+}
+
+static lbm_value array_extensions_vec_min(lbm_value *args, lbm_uint argn) {
+  return vec_extreme(args, argn, false);
+}
+
+static lbm_value array_extensions_vec_max(lbm_value *args, lbm_uint argn) {
+  return vec_extreme(args, argn, true);
+}
+
+// (vec-fir type dst src coeffs)
+// dst[i] = sum over k of coeffs[k] * src[i - k], samples before the
+// start of src count as 0. coeffs is always an f32 array. Runs from the
+// end towards the start so that dst may be src.
+static lbm_value array_extensions_vec_fir(lbm_value *args, lbm_uint argn) {
+  lbm_value res = ENC_SYM_EERROR;
+  if (argn == 4) {
+    res = ENC_SYM_TERROR;
+    int type;
+    lbm_uint es;
+    vec_t d, x, c;
+    if (vec_type(args[0], &type, &es) &&
+        vec_arg(args[1], es, true, &d) &&
+        vec_arg(args[2], es, false, &x) &&
+        vec_arg(args[3], 4, false, &c)) {
+      lbm_uint n = vec_min_len(d.len, x.len);
+      const float *cp = (const float*)c.data;
+      switch (type) {
+      case VEC_I16: {
+        const int16_t *xp = (const int16_t*)x.data;
+        int16_t *dp = (int16_t*)d.data;
+        for (lbm_uint i = n; i > 0; i --) {
+          lbm_uint ix = i - 1;
+          lbm_uint taps = vec_min_len(c.len, i);
+          float acc = 0.0f;
+          for (lbm_uint k = 0; k < taps; k ++) acc += cp[k] * (float)xp[ix - k];
+          dp[ix] = vec_round_i16(acc);
+        }
+      } break;
+      case VEC_I32: {
+        const int32_t *xp = (const int32_t*)x.data;
+        int32_t *dp = (int32_t*)d.data;
+        for (lbm_uint i = n; i > 0; i --) {
+          lbm_uint ix = i - 1;
+          lbm_uint taps = vec_min_len(c.len, i);
+          double acc = (double)0.0;
+          for (lbm_uint k = 0; k < taps; k ++) acc += (double)cp[k] * (double)xp[ix - k];
+          dp[ix] = vec_round_i32(acc);
+        }
+      } break;
+      default: {
+        const float *xp = (const float*)x.data;
+        float *dp = (float*)d.data;
+        for (lbm_uint i = n; i > 0; i --) {
+          lbm_uint ix = i - 1;
+          lbm_uint taps = vec_min_len(c.len, i);
+          float acc = 0.0f;
+          for (lbm_uint k = 0; k < taps; k ++) acc += cp[k] * xp[ix - k];
+          dp[ix] = acc;
+        }
+      } break;
+      }
+      res = ENC_SYM_TRUE;
+    }
+  }
+  return res;
+}
+
+// (vec-biquad type dst src coeffs optState)
+// Second order IIR section in transposed direct form II. coeffs is an
+// f32 array holding b0 b1 b2 a1 a2 with a0 normalized to 1. The
+// optional f32 array state holds 2 values that are carried between
+// calls so that a signal can be filtered block by block. dst may be src.
+static lbm_value array_extensions_vec_biquad(lbm_value *args, lbm_uint argn) {
+  lbm_value res = ENC_SYM_EERROR;
+  if (argn == 4 || argn == 5) {
+    res = ENC_SYM_TERROR;
+    int type;
+    lbm_uint es;
+    vec_t d, x, c;
+    vec_t st = {NULL, 0};
+    if (vec_type(args[0], &type, &es) &&
+        vec_arg(args[1], es, true, &d) &&
+        vec_arg(args[2], es, false, &x) &&
+        vec_arg(args[3], 4, false, &c) && c.len >= 5 &&
+        (argn == 4 || (vec_arg(args[4], 4, true, &st) && st.len >= 2))) {
+      const float *cp = (const float*)c.data;
+      float b0 = cp[0], b1 = cp[1], b2 = cp[2], a1 = cp[3], a2 = cp[4];
+      float z1 = 0.0f;
+      float z2 = 0.0f;
+      if (st.data) {
+        z1 = ((float*)st.data)[0];
+        z2 = ((float*)st.data)[1];
+      }
+      lbm_uint n = vec_min_len(d.len, x.len);
+      switch (type) {
+      case VEC_I16: {
+        const int16_t *xp = (const int16_t*)x.data;
+        int16_t *dp = (int16_t*)d.data;
+        for (lbm_uint i = 0; i < n; i ++) {
+          float in = (float)xp[i];
+          float out = b0 * in + z1;
+          z1 = b1 * in - a1 * out + z2;
+          z2 = b2 * in - a2 * out;
+          dp[i] = vec_round_i16(out);
+        }
+      } break;
+      case VEC_I32: {
+        const int32_t *xp = (const int32_t*)x.data;
+        int32_t *dp = (int32_t*)d.data;
+        double db0 = (double)b0, db1 = (double)b1, db2 = (double)b2;
+        double da1 = (double)a1, da2 = (double)a2;
+        double w1 = (double)z1;
+        double w2 = (double)z2;
+        for (lbm_uint i = 0; i < n; i ++) {
+          double in = (double)xp[i];
+          double out = db0 * in + w1;
+          w1 = db1 * in - da1 * out + w2;
+          w2 = db2 * in - da2 * out;
+          dp[i] = vec_round_i32(out);
+        }
+        z1 = (float)w1;
+        z2 = (float)w2;
+      } break;
+      default: {
+        const float *xp = (const float*)x.data;
+        float *dp = (float*)d.data;
+        for (lbm_uint i = 0; i < n; i ++) {
+          float in = xp[i];
+          float out = b0 * in + z1;
+          z1 = b1 * in - a1 * out + z2;
+          z2 = b2 * in - a2 * out;
+          dp[i] = out;
+        }
+      } break;
+      }
+      if (st.data) {
+        ((float*)st.data)[0] = z1;
+        ((float*)st.data)[1] = z2;
+      }
+      res = ENC_SYM_TRUE;
+    }
+  }
+  return res;
+}
+
+// (vec-movavg type dst src n)
+// dst[i] is the mean of the last n samples of src up to and including
+// src[i], fewer at the start. dst cannot be src.
+static lbm_value array_extensions_vec_movavg(lbm_value *args, lbm_uint argn) {
+  lbm_value res = ENC_SYM_EERROR;
+  if (argn == 4) {
+    res = ENC_SYM_TERROR;
+    int type;
+    lbm_uint es;
+    vec_t d, x;
+    if (vec_type(args[0], &type, &es) &&
+        vec_arg(args[1], es, true, &d) &&
+        vec_arg(args[2], es, false, &x) &&
+        lbm_is_number(args[3])) {
+      lbm_uint w = lbm_dec_as_u32(args[3]);
+      if (w == 0 || d.data == x.data) return ENC_SYM_EERROR;
+      lbm_uint n = vec_min_len(d.len, x.len);
+      // Integer sums and means are exact, the means are rounded.
+      if (type == VEC_F32) {
+        const float *xp = (const float*)x.data;
+        float *dp = (float*)d.data;
+        float acc = 0.0f;
+        for (lbm_uint i = 0; i < n; i ++) {
+          acc += xp[i];
+          if (i >= w) acc -= xp[i - w];
+          dp[i] = acc / (float)(i < w ? i + 1 : w);
+        }
+      } else {
+        int64_t acc = 0;
+        for (lbm_uint i = 0; i < n; i ++) {
+          acc += vec_get_int(type, x.data, i);
+          if (i >= w) acc -= vec_get_int(type, x.data, i - w);
+          vec_set_int(type, d.data, i, vec_div_round(acc, (int64_t)(i < w ? i + 1 : w)));
+        }
+      }
+      res = ENC_SYM_TRUE;
+    }
+  }
+  return res;
+}
+
+static inline float vec_get_float(int type, const void *data, lbm_uint i) {
+  return type == VEC_I16 ? (float)((const int16_t*)data)[i] : ((const float*)data)[i];
+}
+
+// f32 and i16 tables.
+static float vec_interp_float(int type, const void *xs, const void *ys, lbm_uint n, float x) {
+  if (x <= vec_get_float(type, xs, 0)) return vec_get_float(type, ys, 0);
+  if (x >= vec_get_float(type, xs, n - 1)) return vec_get_float(type, ys, n - 1);
+  // xs[lo] < x < xs[hi]
+  lbm_uint lo = 0;
+  lbm_uint hi = n - 1;
+  while (hi - lo > 1) {
+    lbm_uint mid = lo + (hi - lo) / 2;
+    if (vec_get_float(type, xs, mid) <= x) lo = mid;
+    else hi = mid;
+  }
+  float x0 = vec_get_float(type, xs, lo);
+  float x1 = vec_get_float(type, xs, hi);
+  float y0 = vec_get_float(type, ys, lo);
+  float y1 = vec_get_float(type, ys, hi);
+  return y0 + (y1 - y0) * (x - x0) / (x1 - x0);
+}
+
+static float vec_interp_i32(const int32_t *xs, const int32_t *ys, lbm_uint n, double x) {
+  if (x <= (double)xs[0]) return (float)ys[0];
+  if (x >= (double)xs[n - 1]) return (float)ys[n - 1];
+  lbm_uint lo = 0;
+  lbm_uint hi = n - 1;
+  while (hi - lo > 1) {
+    lbm_uint mid = lo + (hi - lo) / 2;
+    if ((double)xs[mid] <= x) lo = mid;
+    else hi = mid;
+  }
+  double x0 = (double)xs[lo];
+  double y0 = (double)ys[lo];
+  double dy = (double)ys[hi] - y0;
+  return (float)(y0 + dy * (x - x0) / ((double)xs[hi] - x0));
+}
+
+// (vec-interp type xs ys x)
+// Piecewise linear interpolation in the table given by xs, sorted in
+// ascending order, and ys. x outside of the table is clamped to the
+// first or last point. Returns a float.
+static lbm_value array_extensions_vec_interp(lbm_value *args, lbm_uint argn) {
+  lbm_value res = ENC_SYM_EERROR;
+  if (argn == 4) {
+    res = ENC_SYM_TERROR;
+    int type;
+    lbm_uint es;
+    vec_t xs, ys;
+    if (vec_type(args[0], &type, &es) &&
+        vec_arg(args[1], es, false, &xs) &&
+        vec_arg(args[2], es, false, &ys) &&
+        lbm_is_number(args[3])) {
+      lbm_uint n = vec_min_len(xs.len, ys.len);
+      if (n == 0) return ENC_SYM_EERROR;
+      if (type == VEC_I32) {
+        res = lbm_enc_float(vec_interp_i32((const int32_t*)xs.data, (const int32_t*)ys.data, n,
+                                           lbm_dec_as_double(args[3])));
+      } else {
+        res = lbm_enc_float(vec_interp_float(type, xs.data, ys.data, n, lbm_dec_as_float(args[3])));
+      }
+    }
+  }
+  return res;
+}
+
+// (vec-resample type dst src)
+// Linear resampling of src to the length of dst, the first and last
+// samples are kept. dst cannot be src.
+static lbm_value array_extensions_vec_resample(lbm_value *args, lbm_uint argn) {
+  lbm_value res = ENC_SYM_EERROR;
+  if (argn == 3) {
+    res = ENC_SYM_TERROR;
+    int type;
+    lbm_uint es;
+    vec_t d, x;
+    if (vec_type(args[0], &type, &es) &&
+        vec_arg(args[1], es, true, &d) &&
+        vec_arg(args[2], es, false, &x)) {
+      if (x.len == 0 || d.data == x.data) return ENC_SYM_EERROR;
+      if (d.len == 1 || x.len == 1) {
+        for (lbm_uint i = 0; i < d.len; i ++) memcpy((uint8_t*)d.data + i * es, x.data, es);
+        return ENC_SYM_TRUE;
+      }
+      // Sample i is at x position i * (x.len - 1) / (d.len - 1), which is
+      // split exactly into an index and a remainder.
+      uint64_t den = d.len - 1;
+      for (lbm_uint i = 0; i < d.len; i ++) {
+        uint64_t num = (uint64_t)i * (x.len - 1);
+        lbm_uint ix = (lbm_uint)(num / den);
+        int64_t rem = (int64_t)(num % den);
+        if (rem == 0) {
+          memcpy((uint8_t*)d.data + i * es, (uint8_t*)x.data + ix * es, es);
+        } else if (type == VEC_F32) {
+          const float *xp = (const float*)x.data;
+          ((float*)d.data)[i] = xp[ix] + (xp[ix + 1] - xp[ix]) * ((float)rem / (float)den);
+        } else {
+          int64_t y0 = vec_get_int(type, x.data, ix);
+          int64_t y1 = vec_get_int(type, x.data, ix + 1);
+          vec_set_int(type, d.data, i, y0 + vec_div_round((y1 - y0) * rem, (int64_t)den));
+        }
+      }
+      res = ENC_SYM_TRUE;
+    }
+  }
+  return res;
+}
+
+// Sorting and searching
+//
+// Heapsort sorts in place without allocation or recursion, and the
+// comparisons run in C. It is not stable, vec-argsort breaks ties by
+// index and is.
+
+typedef bool (*sort_less_fun)(void *ctx, lbm_uint i, lbm_uint j);
+typedef void (*sort_swap_fun)(void *ctx, lbm_uint i, lbm_uint j);
+
+static void heap_sort(lbm_uint n, sort_less_fun less, sort_swap_fun swap, void *ctx) {
+  if (n < 2) return;
+  lbm_uint start = n / 2;
+  lbm_uint end = n;
+  while (end > 1) {
+    if (start > 0) {
+      start --;        // Building the heap
+    } else {
+      end --;          // Moving the largest element to the end
+      swap(ctx, 0, end);
+    }
+    lbm_uint root = start;
+    while (2 * root + 1 < end) {
+      lbm_uint child = 2 * root + 1;
+      if (child + 1 < end && less(ctx, child, child + 1)) child ++;
+      if (!less(ctx, root, child)) break;
+      swap(ctx, root, child);
+      root = child;
+    }
+  }
+}
+
+typedef struct {
+  int type;
+  void *data;
+  int32_t *idx;   // Permutation sorted by vec-argsort, NULL for vec-sort.
+  bool desc;
+} vec_sort_t;
+
+static inline bool vec_elem_less(int type, const void *data, lbm_uint a, lbm_uint b) {
+  switch (type) {
+  case VEC_I16: return ((const int16_t*)data)[a] < ((const int16_t*)data)[b];
+  case VEC_I32: return ((const int32_t*)data)[a] < ((const int32_t*)data)[b];
+  default: return ((const float*)data)[a] < ((const float*)data)[b];
+  }
+}
+
+static bool vec_sort_less(void *ctx, lbm_uint i, lbm_uint j) {
+  vec_sort_t *s = (vec_sort_t*)ctx;
+  return s->desc ? vec_elem_less(s->type, s->data, j, i) : vec_elem_less(s->type, s->data, i, j);
+}
+
+static void vec_sort_swap(void *ctx, lbm_uint i, lbm_uint j) {
+  vec_sort_t *s = (vec_sort_t*)ctx;
+  if (s->type == VEC_I16) {
+    int16_t *d = (int16_t*)s->data;
+    int16_t tmp = d[i]; d[i] = d[j]; d[j] = tmp;
+  } else {
+    // i32 and f32 are moved as 32 bit words.
+    uint32_t *d = (uint32_t*)s->data;
+    uint32_t tmp = d[i]; d[i] = d[j]; d[j] = tmp;
+  }
+}
+
+static bool vec_argsort_less(void *ctx, lbm_uint i, lbm_uint j) {
+  vec_sort_t *s = (vec_sort_t*)ctx;
+  lbm_uint a = (lbm_uint)s->idx[i];
+  lbm_uint b = (lbm_uint)s->idx[j];
+  if (vec_elem_less(s->type, s->data, a, b)) return !s->desc;
+  if (vec_elem_less(s->type, s->data, b, a)) return s->desc;
+  return a < b;
+}
+
+static void vec_argsort_swap(void *ctx, lbm_uint i, lbm_uint j) {
+  vec_sort_t *s = (vec_sort_t*)ctx;
+  int32_t tmp = s->idx[i]; s->idx[i] = s->idx[j]; s->idx[j] = tmp;
+}
+
+// Ascending for <, descending for >.
+static bool sort_order(lbm_value v, bool *desc) {
+  if (v == ENC_SYM_LT) {
+    *desc = false;
+  } else if (v == ENC_SYM_GT) {
+    *desc = true;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// (vec-sort type arr optOrder)
+// Sorts arr in place, in ascending order or descending if optOrder is >.
+static lbm_value array_extensions_vec_sort(lbm_value *args, lbm_uint argn) {
+  lbm_value res = ENC_SYM_EERROR;
+  if (argn == 2 || argn == 3) {
+    res = ENC_SYM_TERROR;
+    int type;
+    lbm_uint es;
+    vec_t a;
+    vec_sort_t s;
+    s.desc = false;
+    if (vec_type(args[0], &type, &es) &&
+        vec_arg(args[1], es, true, &a) &&
+        (argn == 2 || sort_order(args[2], &s.desc))) {
+      s.type = type;
+      s.data = a.data;
+      s.idx = NULL;
+      heap_sort(a.len, vec_sort_less, vec_sort_swap, &s);
+      res = ENC_SYM_TRUE;
+    }
+  }
+  return res;
+}
+
+// (vec-argsort type arr idx optOrder)
+// Fills the i32 array idx with the indices of arr in sorted order,
+// arr is not modified. Equal elements keep their relative order.
+static lbm_value array_extensions_vec_argsort(lbm_value *args, lbm_uint argn) {
+  lbm_value res = ENC_SYM_EERROR;
+  if (argn == 3 || argn == 4) {
+    res = ENC_SYM_TERROR;
+    int type;
+    lbm_uint es;
+    vec_t a, ix;
+    vec_sort_t s;
+    s.desc = false;
+    if (vec_type(args[0], &type, &es) &&
+        vec_arg(args[1], es, false, &a) &&
+        vec_arg(args[2], 4, true, &ix) &&
+        (argn == 3 || sort_order(args[3], &s.desc))) {
+      lbm_uint n = vec_min_len(a.len, ix.len);
+      s.type = type;
+      s.data = a.data;
+      s.idx = (int32_t*)ix.data;
+      for (lbm_uint i = 0; i < n; i ++) s.idx[i] = (int32_t)i;
+      heap_sort(n, vec_argsort_less, vec_argsort_swap, &s);
+      res = ENC_SYM_TRUE;
+    }
+  }
+  return res;
+}
+
+// (vec-search type arr x)
+// Binary search in arr sorted in ascending order. Returns the index of
+// the first element that is not less than x, the length of arr if there
+// is none.
+static lbm_value array_extensions_vec_search(lbm_value *args, lbm_uint argn) {
+  lbm_value res = ENC_SYM_EERROR;
+  if (argn == 3) {
+    res = ENC_SYM_TERROR;
+    int type;
+    lbm_uint es;
+    vec_t a;
+    if (vec_type(args[0], &type, &es) &&
+        vec_arg(args[1], es, false, &a) &&
+        lbm_is_number(args[2])) {
+      lbm_uint lo = 0;
+      lbm_uint hi = a.len;
+      if (type == VEC_F32) {
+        float x = lbm_dec_as_float(args[2]);
+        const float *ap = (const float*)a.data;
+        while (lo < hi) {
+          lbm_uint mid = lo + (hi - lo) / 2;
+          if (ap[mid] < x) lo = mid + 1;
+          else hi = mid;
+        }
+      } else {
+        int64_t x;
+        lbm_type t = lbm_type_of(args[2]);
+        if (t == LBM_TYPE_FLOAT || t == LBM_TYPE_DOUBLE) {
+          // An integer is less than x exactly when it is less than
+          // ceil(x). The bound is clamped to the i32 range plus one, and
+          // NaN, which no element is less than, becomes the lowest.
+          double d = ceil(lbm_dec_as_double(args[2]));
+          if (d > (double)INT32_MAX) {
+            x = (int64_t)INT32_MAX + 1;
+          } else if (d >= (double)INT32_MIN) {
+            x = (int64_t)d;
+          } else {
+            x = INT32_MIN;
+          }
+        } else {
+          x = lbm_dec_as_i64(args[2]);
+        }
+        while (lo < hi) {
+          lbm_uint mid = lo + (hi - lo) / 2;
+          if (vec_get_int(type, a.data, mid) < x) lo = mid + 1;
+          else hi = mid;
+        }
+      }
+      res = lbm_enc_i((lbm_int)lo);
+    }
+  }
+  return res;
+}
+
+typedef struct {
+  lbm_value *data;
+  lbm_value key;  // Index into each element, nil to compare the elements.
+  bool desc;
+} array_sort_t;
+
+static lbm_value array_sort_key(lbm_value v, lbm_value key) {
+  if (lbm_is_symbol_nil(key)) return v;
+  int32_t k = lbm_dec_as_i32(key);
+  if (lbm_is_cons(v)) {
+    return lbm_index_list(v, k);
+  }
+  lbm_array_header_t *arr = lbm_dec_lisp_array_r(v);
+  if (arr && k >= 0 && (lbm_uint)k < arr->size / sizeof(lbm_value)) {
+    return ((lbm_value*)arr->data)[k];
+  }
+  return ENC_SYM_NIL;
+}
+
+static bool array_sort_less(void *ctx, lbm_uint i, lbm_uint j) {
+  array_sort_t *s = (array_sort_t*)ctx;
+  double a = lbm_dec_as_double(array_sort_key(s->data[i], s->key));
+  double b = lbm_dec_as_double(array_sort_key(s->data[j], s->key));
+  return s->desc ? b < a : a < b;
+}
+
+static void array_sort_swap(void *ctx, lbm_uint i, lbm_uint j) {
+  array_sort_t *s = (array_sort_t*)ctx;
+  lbm_value tmp = s->data[i]; s->data[i] = s->data[j]; s->data[j] = tmp;
+}
+
+// (array-sort cmp arr optKey)
+// Sorts the lisp array arr in place. cmp is < or > and the elements,
+// or element optKey of each element if they are lists or arrays, must be
+// numbers. Other comparators need a closure call per comparison, use
+// sort on a list for those.
+static lbm_value array_extensions_array_sort(lbm_value *args, lbm_uint argn) {
+  lbm_value res = ENC_SYM_EERROR;
+  if (argn == 2 || argn == 3) {
+    res = ENC_SYM_TERROR;
+    array_sort_t s;
+    lbm_array_header_t *arr = lbm_dec_lisp_array_rw(args[1]);
+    if (sort_order(args[0], &s.desc) && arr &&
+        (argn == 2 || lbm_is_number(args[2]))) {
+      s.data = (lbm_value*)arr->data;
+      s.key = argn == 3 ? args[2] : ENC_SYM_NIL;
+      lbm_uint n = arr->size / sizeof(lbm_value);
+      for (lbm_uint i = 0; i < n; i ++) {
+        if (!lbm_is_number(array_sort_key(s.data[i], s.key))) return res;
+      }
+      heap_sort(n, array_sort_less, array_sort_swap, &s);
+      res = ENC_SYM_TRUE;
+    }
+  }
+  return res;
+}
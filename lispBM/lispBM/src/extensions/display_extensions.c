@@ -114,6 +114,7 @@ static lbm_uint symbol_rotate = 0;
 static lbm_uint symbol_resolution = 0;
 static lbm_uint symbol_tile = 0;
 static lbm_uint symbol_clip = 0;
+static lbm_uint symbol_dirty_track = 0;
 
 
 static lbm_uint symbol_regular = 0;
@@ -187,10 +188,9 @@ uint32_t image_dims_to_size_bytes(color_format_t fmt, uint16_t width, uint16_t h
   }
 }
 
-static lbm_value image_buffer_lift(uint8_t *buf, color_format_t fmt, uint16_t width, uint16_t height) {
+static lbm_value image_buffer_lift(uint8_t *buf, lbm_uint size, color_format_t fmt, uint16_t width, uint16_t height) {
   lbm_value res = ENC_SYM_MERROR;
-  lbm_uint size = image_dims_to_size_bytes(fmt, width, height);
-  if ( lbm_lift_array(&res, (char*)buf, IMAGE_BUFFER_HEADER_SIZE + size)) {
+  if ( lbm_lift_array(&res, (char*)buf, size)) {
     buf[0] = (uint8_t)(width >> 8);
     buf[1] = (uint8_t)width;
     buf[2] = (uint8_t)(height >> 8);
@@ -268,25 +268,185 @@ static lbm_value color_allocate(COLOR_TYPE type, int32_t color1, int32_t color2,
   return res;
 }
 
-static lbm_value image_buffer_allocate(color_format_t fmt, uint16_t width, uint16_t height) {
-  uint32_t size_bytes = image_dims_to_size_bytes(fmt, width, height);
+// Dirty region tracking
+//
+// The regions of an image buffer touched by the drawing extensions are
+// recorded as a short list of rectangles so that disp-render-dirty only
+// has to send those to the display. The list is stored in the array of
+// the image buffer, after the pixels, so it is freed and moved together
+// with the buffer. Buffers allocated without room for it are rendered
+// in full.
+
+#define IMG_DIRTY_MAGIC       (uint32_t)0x44495254
+#define IMG_DIRTY_MAX_RECTS   8
+// Number of clean pixels that may be sent needlessly when merging two
+// rectangles. Every rectangle costs a window setup on the display.
+#define IMG_DIRTY_MERGE_SLACK 256
+
+typedef struct {
+  uint16_t x;
+  uint16_t y;
+  uint16_t w;
+  uint16_t h;
+} img_rect_t;
+
+struct img_dirty_s {
+  uint32_t magic;
+  uint32_t on;
+  int num_rects;
+  img_rect_t rects[IMG_DIRTY_MAX_RECTS];
+};
+
+// Offset of the dirty state in the array, word aligned.
+static lbm_uint img_dirty_offset(color_format_t fmt, uint16_t width, uint16_t height) {
+  lbm_uint end = IMAGE_BUFFER_HEADER_SIZE + image_dims_to_size_bytes(fmt, width, height);
+  return (end + 3) & ~(lbm_uint)3;
+}
+
+img_dirty_t *image_buffer_dirty(lbm_array_header_t *arr) {
+  uint8_t *data = (uint8_t*)arr->data;
+  lbm_uint offset = img_dirty_offset(image_buffer_format(data),
+                                     image_buffer_width(data),
+                                     image_buffer_height(data));
+  if (arr->size < offset + sizeof(img_dirty_t) ||
+      ((lbm_uint)data & 3)) {
+    return NULL;
+  }
+  img_dirty_t *d = (img_dirty_t*)(data + offset);
+  return d->magic == IMG_DIRTY_MAGIC ? d : NULL;
+}
+
+static img_dirty_t *img_dirty_get(image_buffer_t *img) {
+  img_dirty_t *d = img->dirty;
+  return (d && d->on) ? d : NULL;
+}
+
+static void img_dirty_set_all(img_dirty_t *d, uint16_t width, uint16_t height) {
+  d->num_rects = 1;
+  d->rects[0].x = 0;
+  d->rects[0].y = 0;
+  d->rects[0].w = width;
+  d->rects[0].h = height;
+}
+
+static void img_dirty_track(image_buffer_t *img, bool on) {
+  img_dirty_t *d = img->dirty;
+  d->on = on;
+  // What is on the display is unknown at this point.
+  img_dirty_set_all(d, img->width, img->height);
+}
+
+static inline uint32_t rect_area(const img_rect_t *r) {
+  return (uint32_t)r->w * (uint32_t)r->h;
+}
+
+static img_rect_t rect_union(const img_rect_t *a, const img_rect_t *b) {
+  uint32_t x0 = a->x < b->x ? a->x : b->x;
+  uint32_t y0 = a->y < b->y ? a->y : b->y;
+  uint32_t x1 = (uint32_t)(a->x + a->w);
+  uint32_t y1 = (uint32_t)(a->y + a->h);
+  if ((uint32_t)(b->x + b->w) > x1) x1 = (uint32_t)(b->x + b->w);
+  if ((uint32_t)(b->y + b->h) > y1) y1 = (uint32_t)(b->y + b->h);
+  img_rect_t u = {(uint16_t)x0, (uint16_t)y0, (uint16_t)(x1 - x0), (uint16_t)(y1 - y0)};
+  return u;
+}
+
+// Pixels covered by the union of a and b but by neither of them.
+// Negative when a and b overlap.
+static int32_t rect_merge_cost(const img_rect_t *a, const img_rect_t *b) {
+  img_rect_t u = rect_union(a, b);
+  return (int32_t)rect_area(&u) - (int32_t)rect_area(a) - (int32_t)rect_area(b);
+}
+
+static void img_dirty_add(img_dirty_t *d, img_rect_t r) {
+  while (true) {
+    // A merged rectangle can become cheap to merge with one that was
+    // checked earlier, so start over after each merge.
+    int i = 0;
+    while (i < d->num_rects) {
+      if (rect_merge_cost(&d->rects[i], &r) <= IMG_DIRTY_MERGE_SLACK) {
+        r = rect_union(&d->rects[i], &r);
+        d->num_rects --;
+        d->rects[i] = d->rects[d->num_rects];
+        i = 0;
+      } else {
+        i ++;
+      }
+    }
+    if (d->num_rects < IMG_DIRTY_MAX_RECTS) {
+      d->rects[d->num_rects] = r;
+      d->num_rects ++;
+      return;
+    }
+    // Out of rectangles, merge with the one that wastes the least.
+    int best = 0;
+    int32_t best_cost = INT32_MAX;
+    for (i = 0; i < d->num_rects; i ++) {
+      int32_t cost = rect_merge_cost(&d->rects[i], &r);
+      if (cost < best_cost) {
+        best_cost = cost;
+        best = i;
+      }
+    }
+    r = rect_union(&d->rects[best], &r);
+    d->num_rects --;
+    d->rects[best] = d->rects[d->num_rects];
+  }
+}
+
+// Marks the inclusive box x0,y0 - x1,y1 as changed.
+static void img_dirty_box(image_buffer_t *img, int64_t x0, int64_t y0, int64_t x1, int64_t y1) {
+  img_dirty_t *d = img_dirty_get(img);
+  if (!d) return;
+  if (x0 < 0) x0 = 0;
+  if (y0 < 0) y0 = 0;
+  if (x1 >= img->width) x1 = img->width - 1;
+  if (y1 >= img->height) y1 = img->height - 1;
+  if (x1 < x0 || y1 < y0) return;
+  img_rect_t r = {(uint16_t)x0, (uint16_t)y0, (uint16_t)(x1 - x0 + 1), (uint16_t)(y1 - y0 + 1)};
+  img_dirty_add(d, r);
+}
+
+void image_buffer_mark_dirty(image_buffer_t *img, int x, int y, int w, int h) {
+  img_dirty_box(img, x, y, (int64_t)x + w - 1, (int64_t)y + h - 1);
+}
 
-  uint8_t *buf = lbm_malloc(IMAGE_BUFFER_HEADER_SIZE + size_bytes);
+// Size of an image buffer array, with room for the dirty state when
+// tracked.
+static lbm_uint image_buffer_alloc_size(color_format_t fmt, uint16_t width, uint16_t height, bool track) {
+  if (track) {
+    return img_dirty_offset(fmt, width, height) + sizeof(img_dirty_t);
+  }
+  return IMAGE_BUFFER_HEADER_SIZE + image_dims_to_size_bytes(fmt, width, height);
+}
+
+// Tracking starts with everything dirty.
+static void image_buffer_init_dirty(uint8_t *buf, color_format_t fmt, uint16_t width, uint16_t height) {
+  img_dirty_t *d = (img_dirty_t*)(buf + img_dirty_offset(fmt, width, height));
+  d->magic = IMG_DIRTY_MAGIC;
+  d->on = 1;
+  img_dirty_set_all(d, width, height);
+}
+
+static lbm_value image_buffer_allocate(color_format_t fmt, uint16_t width, uint16_t height, bool track) {
+  lbm_uint size = image_buffer_alloc_size(fmt, width, height, track);
+
+  uint8_t *buf = lbm_malloc(size);
   if (!buf) {
     return ENC_SYM_MERROR;
   }
-  memset(buf, 0, size_bytes + IMAGE_BUFFER_HEADER_SIZE);
-  lbm_value res = image_buffer_lift(buf, fmt, width, height);
+  memset(buf, 0, size);
+  lbm_value res = image_buffer_lift(buf, size, fmt, width, height);
   if (lbm_is_symbol(res)) { /* something is wrong, free */
     lbm_free(buf);
+  } else if (track) {
+    image_buffer_init_dirty(buf, fmt, width, height);
   }
   return res;
 }
 
-static lbm_value image_buffer_allocate_dm(lbm_uint *dm, color_format_t fmt, uint16_t width, uint16_t height) {
-  uint32_t size_bytes = image_dims_to_size_bytes(fmt, width, height);
-
-  lbm_value res = lbm_defrag_mem_alloc(dm, IMAGE_BUFFER_HEADER_SIZE + size_bytes);
+static lbm_value image_buffer_allocate_dm(lbm_uint *dm, color_format_t fmt, uint16_t width, uint16_t height, bool track) {
+  lbm_value res = lbm_defrag_mem_alloc(dm, image_buffer_alloc_size(fmt, width, height, track));
   lbm_array_header_t *arr = lbm_dec_array_r(res);
   if (arr) {
     uint8_t *buf = (uint8_t*)arr->data;
@@ -295,6 +455,7 @@ static lbm_value image_buffer_allocate_dm(lbm_uint *dm, color_format_t fmt, uint
     buf[2] = (uint8_t)(height >> 8);
     buf[3] = (uint8_t)height;
     buf[4] = color_format_to_byte(fmt);
+    if (track) image_buffer_init_dirty(buf, fmt, width, height);
   }
   return res;
 }
@@ -340,6 +501,7 @@ static bool register_symbols(void) {
   res = res && lbm_add_symbol_const("resolution", &symbol_resolution);
   res = res && lbm_add_symbol_const("tile", &symbol_tile);
   res = res && lbm_add_symbol_const("clip", &symbol_clip);
+  res = res && lbm_add_symbol_const("dirty-track", &symbol_dirty_track);
 
   res = res && lbm_add_symbol_const("regular", &symbol_regular);
   res = res && lbm_add_symbol_const("gradient_x", &symbol_gradient_x);
@@ -487,60 +649,184 @@ static uint32_t  rgb565to888(uint16_t rgb) {
   return res_rgb888;
 }
 
-void image_buffer_clear(image_buffer_t *img, uint32_t cc) {
-  color_format_t fmt = img->fmt;
-  uint32_t w = img->width;
-  uint32_t h = img->height;
-  uint32_t img_size = w * h;
-  uint8_t *data = img->data;
+// Stored pixel values
+//
+// The color format enum values are the number of bits per pixel. pos
+// counts pixels from the start of the buffer, rows of indexed formats
+// do not start at byte boundaries.
+
+static inline bool is_color_format(color_format_t fmt) {
   switch (fmt) {
-  case indexed2: {
-    uint32_t bytes = (img_size / 8) + (img_size % 8 ? 1 : 0);
-    uint8_t c8 = (uint8_t)((cc & 1) ? 0xFF : 0x0);
-    memset(data, c8, bytes);
+  case indexed2:
+  case indexed4:
+  case indexed16:
+  case rgb332:
+  case rgb565:
+  case rgb888:
+    return true;
+  default:
+    return false;
   }
-    break;
-  case indexed4: {
-    static const uint8_t index4_table[4] = {0x00, 0x55, 0xAA, 0xFF};
-    uint32_t bytes = (img_size / 4) + (img_size % 4 ? 1 : 0);
-    uint8_t ix = (uint8_t)(cc & 0x3);
-    memset(data, index4_table[ix], bytes);
+}
+
+static inline uint32_t pixel_get_raw(color_format_t fmt, const uint8_t *data, uint32_t pos) {
+  switch (fmt) {
+  case indexed2:
+    return (uint32_t)(data[pos >> 3] >> (7 - (pos & 0x7))) & 0x1;
+  case indexed4:
+    return (uint32_t)(data[pos >> 2] >> ((3 - (pos & 0x3)) << 1)) & 0x3;
+  case indexed16:
+    return (uint32_t)(data[pos >> 1] >> ((1 - (pos & 0x1)) << 2)) & 0xF;
+  case rgb332:
+    return data[pos];
+  case rgb565:
+    return (uint32_t)data[2 * pos] << 8 | (uint32_t)data[2 * pos + 1];
+  case rgb888:
+    return (uint32_t)data[3 * pos] << 16 | (uint32_t)data[3 * pos + 1] << 8 | (uint32_t)data[3 * pos + 2];
+  default:
+    return 0;
   }
+}
+
+static inline void pixel_set_bits(uint8_t *b, uint32_t shift, uint32_t mask, uint32_t raw) {
+  *b = (uint8_t)((*b & ~(mask << shift)) | ((raw & mask) << shift));
+}
+
+static inline void pixel_set_raw(color_format_t fmt, uint8_t *data, uint32_t pos, uint32_t raw) {
+  switch (fmt) {
+  case indexed2:
+    pixel_set_bits(&data[pos >> 3], 7 - (pos & 0x7), 0x1, raw);
     break;
-  case indexed16: {
-    uint32_t bytes = (img_size / 2) + (img_size % 2 ? 1 : 0);
-    uint8_t ix = (uint8_t)(cc & 0xF);
-    uint8_t color = (uint8_t)(ix | ix << 4);  // create a color based on duplication of index
-    memset(data, color, bytes);
+  case indexed4:
+    pixel_set_bits(&data[pos >> 2], (3 - (pos & 0x3)) << 1, 0x3, raw);
+    break;
+  case indexed16:
+    pixel_set_bits(&data[pos >> 1], (1 - (pos & 0x1)) << 2, 0xF, raw);
+    break;
+  case rgb332:
+    data[pos] = (uint8_t)raw;
+    break;
+  case rgb565:
+    data[2 * pos] = (uint8_t)(raw >> 8);
+    data[2 * pos + 1] = (uint8_t)raw;
+    break;
+  case rgb888:
+    data[3 * pos] = (uint8_t)(raw >> 16);
+    data[3 * pos + 1] = (uint8_t)(raw >> 8);
+    data[3 * pos + 2] = (uint8_t)raw;
+    break;
+  default:
+    break;
+  }
+}
+
+// The color getpixel returns for a stored value.
+static inline uint32_t pixel_raw_to_color(color_format_t fmt, uint32_t raw) {
+  switch (fmt) {
+  case rgb332:
+    return rgb332to888((uint8_t)raw);
+  case rgb565:
+    return rgb565to888((uint16_t)raw);
+  default:
+    return raw;
   }
+}
+
+// The value putpixel stores for a color. putpixel does not mask indices
+// that are out of range for indexed4 and indexed16, callers that need
+// to behave the same have to leave those to putpixel.
+static inline uint32_t pixel_color_to_raw(color_format_t fmt, uint32_t c) {
+  switch (fmt) {
+  case indexed2:
+    return c ? 1 : 0;
+  case indexed4:
+    return c & 0x3;
+  case indexed16:
+    return c & 0xF;
+  case rgb332:
+    return rgb888to332(c);
+  case rgb565:
+    return rgb888to565(c);
+  case rgb888:
+    return c & 0xFFFFFF;
+  default:
+    return 0;
+  }
+}
+
+// Writes num copies of the size byte pattern pat to dst. The filled
+// part is doubled by each memcpy so that most bytes are written by
+// the word wide copy loops of memcpy, whatever the alignment of dst.
+static void fill_pattern(uint8_t *dst, const uint8_t *pat, uint32_t size, uint32_t num) {
+  if (num == 0) {
+    return;
+  }
+  uint32_t total = size * num;
+  uint32_t done = size;
+  memcpy(dst, pat, size);
+  while (done < total) {
+    uint32_t n = (done < total - done) ? done : total - done;
+    memcpy(dst + done, dst, n);
+    done += n;
+  }
+}
+
+// Sets len pixels starting at pos to the stored value raw.
+static void pixel_fill_raw(color_format_t fmt, uint8_t *data, uint32_t pos, uint32_t len, uint32_t raw) {
+  switch (fmt) {
+  case indexed2:
+  case indexed4:
+  case indexed16: {
+    uint32_t bpp = (uint32_t)fmt;
+    uint32_t ppb = 8 / bpp;
+    while (len > 0 && (pos % ppb) != 0) {
+      pixel_set_raw(fmt, data, pos, raw);
+      pos ++;
+      len --;
+    }
+    uint32_t bytes = len / ppb;
+    // Repeat the index over the byte, 0xFF, 0x55 or 0x11 times it.
+    memset(data + pos / ppb, (int)((0xFFu / ((1u << bpp) - 1)) * raw), bytes);
+    pos += bytes * ppb;
+    len -= bytes * ppb;
+    while (len > 0) {
+      pixel_set_raw(fmt, data, pos, raw);
+      pos ++;
+      len --;
+    }
     break;
-  case rgb332: {
-    memset(data, rgb888to332(cc), img_size);
   }
+  case rgb332:
+    memset(data + pos, (int)raw, len);
     break;
   case rgb565: {
-    uint16_t c = rgb888to565(cc);
-    uint8_t *dp = (uint8_t*)data;
-    for (unsigned int i = 0; i < img_size/2; i +=2) {
-      dp[i] = (uint8_t)(c >> 8);
-      dp[i+1] = (uint8_t)c;
-    }
-  }
+    uint8_t pat[2] = {(uint8_t)(raw >> 8), (uint8_t)raw};
+    fill_pattern(data + 2 * pos, pat, 2, len);
     break;
-  case rgb888: {
-    uint8_t *dp = (uint8_t*)data;
-    for (unsigned int i = 0; i < img_size * 3; i+= 3) {
-      dp[i]   = (uint8_t)(cc >> 16);
-      dp[i+1] = (uint8_t)(cc >> 8);
-      dp[i+2] = (uint8_t)cc;
-    }
   }
+  case rgb888: {
+    uint8_t pat[3] = {(uint8_t)(raw >> 16), (uint8_t)(raw >> 8), (uint8_t)raw};
+    fill_pattern(data + 3 * pos, pat, 3, len);
     break;
+  }
   default:
     break;
   }
 }
 
+void image_buffer_clear(image_buffer_t *img, uint32_t cc) {
+  // Clearing an indexed2 image uses the lowest bit of the color, where
+  // putpixel sets any nonzero color.
+  uint32_t raw = (img->fmt == indexed2) ? (cc & 1) : pixel_color_to_raw(img->fmt, cc);
+  uint32_t num_pix = (uint32_t)img->width * img->height;
+  if (img->fmt < rgb332) {
+    // Fill the unused bits of the last byte as well.
+    uint32_t ppb = 8 / (uint32_t)img->fmt;
+    num_pix = ((num_pix + ppb - 1) / ppb) * ppb;
+  }
+  pixel_fill_raw(img->fmt, img->data, 0, num_pix, raw);
+}
+
 static const uint8_t indexed4_mask[4] = {0x03, 0x0C, 0x30, 0xC0};
 static const uint8_t indexed4_shift[4] = {0, 2, 4, 6};
 static const uint8_t indexed16_mask[4] = {0x0F, 0xF0};
@@ -659,9 +945,27 @@ uint32_t getpixel(image_buffer_t* img, int x_i, int y_i) {
 }
 
 static void h_line(image_buffer_t* img, int x, int y, int len, uint32_t c) {
-  for (int i = 0; i < len; i ++) {
-    putpixel(img, x+i, y, c);
+  if ((img->fmt == indexed4 && c > 0x3) || (img->fmt == indexed16 && c > 0xF)) {
+    // Keep how putpixel spills the extra bits of these.
+    for (int i = 0; i < len; i ++) {
+      putpixel(img, x+i, y, c);
+    }
+    return;
   }
+
+  if (y < 0 || y >= img->height || len <= 0) {
+    return;
+  }
+  int64_t x0 = x < 0 ? 0 : x;
+  int64_t x1 = (int64_t)x + len;
+  if (x1 > img->width) x1 = img->width;
+  if (x1 <= x0) {
+    return;
+  }
+  pixel_fill_raw(img->fmt, img->data,
+                 (uint32_t)y * img->width + (uint32_t)x0,
+                 (uint32_t)(x1 - x0),
+                 pixel_color_to_raw(img->fmt, c));
 }
 
 static void v_line(image_buffer_t* img, int x, int y, int len, uint32_t c) {
@@ -1823,6 +2127,161 @@ static inline void copy_pixel(
     }
 }
 
+#define BLIT_SKIP 0xFFFFFFFF
+
+// The row loops of blit_rows. They are inlined with a constant format
+// in each case of the switches in blit_rows, which resolves the format
+// switches of the pixel accessors at compile time.
+
+static inline __attribute__ ((always_inline)) void blit_row_same(color_format_t fmt,
+                                                                 uint8_t *dest, uint32_t dpos,
+                                                                 const uint8_t *src, uint32_t spos,
+                                                                 uint32_t n, bool has_tc, uint32_t tc_raw) {
+  for (uint32_t i = 0; i < n; i ++) {
+    uint32_t raw = pixel_get_raw(fmt, src, spos + i);
+    if (!has_tc || raw != tc_raw) {
+      pixel_set_raw(fmt, dest, dpos + i, raw);
+    }
+  }
+}
+
+static inline __attribute__ ((always_inline)) void blit_row_lut(color_format_t sfmt, color_format_t dfmt,
+                                                                uint8_t *dest, uint32_t dpos,
+                                                                const uint8_t *src, uint32_t spos,
+                                                                uint32_t n, const uint32_t *lut) {
+  for (uint32_t i = 0; i < n; i ++) {
+    uint32_t raw = lut[pixel_get_raw(sfmt, src, spos + i)];
+    if (raw != BLIT_SKIP) {
+      pixel_set_raw(dfmt, dest, dpos + i, raw);
+    }
+  }
+}
+
+// Unscaled and unrotated blit between two different buffers without
+// tiling. Works row by row on the stored values instead of through
+// getpixel and putpixel. Returns false for the cases it does not
+// handle, those have to take the per pixel path.
+static bool blit_rows(image_buffer_t *dest, image_buffer_t *src,
+                      int offset_x, int offset_y,
+                      int x_start, int y_start, int x_end, int y_end,
+                      int32_t transparent_color) {
+  color_format_t dfmt = dest->fmt;
+  color_format_t sfmt = src->fmt;
+
+  if (dest->data == src->data || !is_color_format(dfmt) || !is_color_format(sfmt)) {
+    return false;
+  }
+  // Only sources whose values fit in the destination indices.
+  if ((dfmt == indexed4 || dfmt == indexed16) && sfmt > dfmt) {
+    return false;
+  }
+
+  if (x_start < 0) x_start = 0;
+  if (y_start < 0) y_start = 0;
+  if (x_start < offset_x) x_start = offset_x;
+  if (y_start < offset_y) y_start = offset_y;
+  if (x_end > dest->width) x_end = dest->width;
+  if (y_end > dest->height) y_end = dest->height;
+  if ((int64_t)offset_x + src->width < x_end) x_end = offset_x + src->width;
+  if ((int64_t)offset_y + src->height < y_end) y_end = offset_y + src->height;
+  if (x_end <= x_start || y_end <= y_start) {
+    return true;
+  }
+
+  uint32_t n = (uint32_t)(x_end - x_start);
+  uint32_t src_x = (uint32_t)(x_start - offset_x);
+  bool has_tc = transparent_color != -1;
+
+  if (sfmt == dfmt) {
+    // Conversion to rgb888 and back is the identity for all formats,
+    // compare the stored values against the stored transparent color.
+    uint32_t tc_raw = 0;
+    if (has_tc) {
+      tc_raw = pixel_color_to_raw(sfmt, (uint32_t)transparent_color);
+      has_tc = pixel_raw_to_color(sfmt, tc_raw) == (uint32_t)transparent_color;
+    }
+    // Pixels per byte of the indexed formats.
+    uint32_t ppb = (sfmt < rgb332) ? 8 / (uint32_t)sfmt : 1;
+    for (int y = y_start; y < y_end; y ++) {
+      uint32_t dpos = (uint32_t)y * dest->width + (uint32_t)x_start;
+      uint32_t spos = (uint32_t)(y - offset_y) * src->width + src_x;
+      if (!has_tc && sfmt >= rgb332) {
+        uint32_t bytes_pp = (uint32_t)sfmt / 8;
+        memcpy(dest->data + dpos * bytes_pp, src->data + spos * bytes_pp, n * bytes_pp);
+        continue;
+      }
+      if (!has_tc && (dpos % ppb) == (spos % ppb)) {
+        // Same position within the bytes, copy whole bytes in between.
+        uint32_t i = 0;
+        while (i < n && ((dpos + i) % ppb) != 0) {
+          pixel_set_raw(dfmt, dest->data, dpos + i, pixel_get_raw(sfmt, src->data, spos + i));
+          i ++;
+        }
+        uint32_t bytes = (n - i) / ppb;
+        memcpy(dest->data + (dpos + i) / ppb, src->data + (spos + i) / ppb, bytes);
+        i += bytes * ppb;
+        while (i < n) {
+          pixel_set_raw(dfmt, dest->data, dpos + i, pixel_get_raw(sfmt, src->data, spos + i));
+          i ++;
+        }
+        continue;
+      }
+      switch (sfmt) {
+      case indexed2: blit_row_same(indexed2, dest->data, dpos, src->data, spos, n, has_tc, tc_raw); break;
+      case indexed4: blit_row_same(indexed4, dest->data, dpos, src->data, spos, n, has_tc, tc_raw); break;
+      case indexed16: blit_row_same(indexed16, dest->data, dpos, src->data, spos, n, has_tc, tc_raw); break;
+      case rgb332: blit_row_same(rgb332, dest->data, dpos, src->data, spos, n, has_tc, tc_raw); break;
+      case rgb565: blit_row_same(rgb565, dest->data, dpos, src->data, spos, n, has_tc, tc_raw); break;
+      default: blit_row_same(rgb888, dest->data, dpos, src->data, spos, n, has_tc, tc_raw); break;
+      }
+    }
+  } else {
+    // At most 256 source values, convert them once. The table for the
+    // indexed formats fits on the stack, the one for rgb332 is taken
+    // from lbm_memory and the blit is done per pixel if that fails.
+    uint32_t lut_indexed[1u << indexed16];
+    uint32_t *lut = NULL;
+    if (sfmt <= rgb332 && n * (uint32_t)(y_end - y_start) >= (1u << sfmt)) {
+      lut = (sfmt <= indexed16) ? lut_indexed : lbm_malloc((1u << sfmt) * sizeof(uint32_t));
+    }
+    if (lut) {
+      uint32_t num_values = 1u << sfmt;
+      for (uint32_t v = 0; v < num_values; v ++) {
+        uint32_t c = pixel_raw_to_color(sfmt, v);
+        lut[v] = (has_tc && c == (uint32_t)transparent_color) ? BLIT_SKIP : pixel_color_to_raw(dfmt, c);
+      }
+      for (int y = y_start; y < y_end; y ++) {
+        uint32_t dpos = (uint32_t)y * dest->width + (uint32_t)x_start;
+        uint32_t spos = (uint32_t)(y - offset_y) * src->width + src_x;
+        // Specialized on the destination, where most of the work is.
+        switch (dfmt) {
+        case indexed2: blit_row_lut(sfmt, indexed2, dest->data, dpos, src->data, spos, n, lut); break;
+        case indexed4: blit_row_lut(sfmt, indexed4, dest->data, dpos, src->data, spos, n, lut); break;
+        case indexed16: blit_row_lut(sfmt, indexed16, dest->data, dpos, src->data, spos, n, lut); break;
+        case rgb332: blit_row_lut(sfmt, rgb332, dest->data, dpos, src->data, spos, n, lut); break;
+        case rgb565: blit_row_lut(sfmt, rgb565, dest->data, dpos, src->data, spos, n, lut); break;
+        default: blit_row_lut(sfmt, rgb888, dest->data, dpos, src->data, spos, n, lut); break;
+        }
+      }
+      if (lut != lut_indexed) {
+        lbm_free(lut);
+      }
+    } else {
+      for (int y = y_start; y < y_end; y ++) {
+        uint32_t dpos = (uint32_t)y * dest->width + (uint32_t)x_start;
+        uint32_t spos = (uint32_t)(y - offset_y) * src->width + src_x;
+        for (uint32_t i = 0; i < n; i ++) {
+          uint32_t c = pixel_raw_to_color(sfmt, pixel_get_raw(sfmt, src->data, spos + i));
+          if (!has_tc || c != (uint32_t)transparent_color) {
+            pixel_set_raw(dfmt, dest->data, dpos + i, pixel_color_to_raw(dfmt, c));
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
 // Copy pixels from source to destination with transformations
 void blit(
     image_buffer_t *img_dest,  // Destination image buffer
@@ -1852,6 +2311,13 @@ void blit(
         if ((dest_y_end - dest_offset_y) > src_h) dest_y_end = src_h + dest_offset_y;
     }
 
+    if (!tile &&
+        blit_rows(img_dest, img_src, dest_offset_x, dest_offset_y,
+                  dest_x_start, dest_y_start, dest_x_end, dest_y_end,
+                  transparent_color)) {
+      return;
+    }
+
     for (int dest_y = dest_y_start; dest_y < dest_y_end; dest_y++) {
       for (int dest_x = dest_x_start; dest_x < dest_x_end; dest_x++) {
         int src_x = dest_x - dest_offset_x;
@@ -1952,6 +2418,7 @@ static img_args_t decode_args(lbm_value *args, lbm_uint argn, int num_expected)
     res.img.fmt = image_buffer_format((uint8_t*)arr->data);
     res.img.mem_base = (uint8_t*)arr->data;
     res.img.data = image_buffer_data((uint8_t*)arr->data);
+    res.img.dirty = image_buffer_dirty(arr);
 
 
     int num_dec = 0;
@@ -2047,6 +2514,34 @@ static img_args_t decode_args(lbm_value *args, lbm_uint argn, int num_expected)
   return res;
 }
 
+// Marks the bounding box of the first num_points coordinate pairs in
+// the arguments, grown by the thickness attribute.
+static void img_dirty_args_points(img_args_t *a, int num_points) {
+  int64_t pad = abs(lbm_dec_as_i32(a->attr_thickness.args[0]));
+  int64_t x0 = INT64_MAX;
+  int64_t y0 = INT64_MAX;
+  int64_t x1 = INT64_MIN;
+  int64_t y1 = INT64_MIN;
+  for (int i = 0; i < num_points; i ++) {
+    int64_t x = lbm_dec_as_i32(a->args[2 * i]);
+    int64_t y = lbm_dec_as_i32(a->args[2 * i + 1]);
+    if (x < x0) x0 = x;
+    if (x > x1) x1 = x;
+    if (y < y0) y0 = y;
+    if (y > y1) y1 = y;
+  }
+  img_dirty_box(&a->img, x0 - pad, y0 - pad, x1 + pad, y1 + pad);
+}
+
+// Marks the box around a circle given as cx cy r in the arguments.
+// Covers arcs, sectors and segments of it as well.
+static void img_dirty_args_circle(img_args_t *a) {
+  int64_t x = lbm_dec_as_i32(a->args[0]);
+  int64_t y = lbm_dec_as_i32(a->args[1]);
+  int64_t r = abs(lbm_dec_as_i32(a->args[2])) + abs(lbm_dec_as_i32(a->attr_thickness.args[0])) + 1;
+  img_dirty_box(&a->img, x - r, y - r, x + r, y + r);
+}
+
 static lbm_value ext_image_dims(lbm_value *args, lbm_uint argn) {
   img_args_t arg_dec = decode_args(args, argn, 0);
 
@@ -2071,6 +2566,14 @@ static lbm_value ext_image_buffer(lbm_value *args, lbm_uint argn) {
   color_format_t fmt = indexed2;
   lbm_uint w = 0;
   lbm_uint h = 0;
+  bool track = false;
+
+  if (argn >= 4 &&
+      lbm_is_symbol(args[argn - 1]) &&
+      lbm_dec_sym(args[argn - 1]) == symbol_dirty_track) {
+    track = true;
+    argn --;
+  }
 
   if (argn == 4 &&
       lbm_is_defrag_mem(args[0]) &&
@@ -2093,9 +2596,9 @@ static lbm_value ext_image_buffer(lbm_value *args, lbm_uint argn) {
 
   if (args_ok && fmt != format_not_supported && w > 0 && h > 0 && w < MAX_WIDTH && h < MAX_HEIGHT) {
     if (argn == 3) {
-      res = image_buffer_allocate(fmt, (uint16_t)w, (uint16_t)h);
+      res = image_buffer_allocate(fmt, (uint16_t)w, (uint16_t)h, track);
     } else {
-      res = image_buffer_allocate_dm((lbm_uint*)lbm_car(args[0]), fmt, (uint16_t)w, (uint16_t)h);
+      res = image_buffer_allocate_dm((lbm_uint*)lbm_car(args[0]), fmt, (uint16_t)w, (uint16_t)h, track);
     }
   }
   return res;
@@ -2333,6 +2836,7 @@ static lbm_value ext_clear(lbm_value *args, lbm_uint argn) {
     img_buf.fmt = image_buffer_format((uint8_t*)arr->data);
     img_buf.mem_base = (uint8_t*)arr->data;
     img_buf.data = image_buffer_data((uint8_t*)arr->data);
+    img_buf.dirty = image_buffer_dirty(arr);
 
     uint32_t color = 0;
     if (argn == 2) {
@@ -2340,6 +2844,7 @@ static lbm_value ext_clear(lbm_value *args, lbm_uint argn) {
     }
 
     image_buffer_clear(&img_buf, color);
+    image_buffer_mark_dirty(&img_buf, 0, 0, img_buf.width, img_buf.height);
     res = ENC_SYM_TRUE;
   }
   return res;
@@ -2352,10 +2857,10 @@ static lbm_value ext_putpixel(lbm_value *args, lbm_uint argn) {
     return ENC_SYM_TERROR;
   }
 
-  putpixel(&arg_dec.img,
-           lbm_dec_as_i32(arg_dec.args[0]),
-           lbm_dec_as_i32(arg_dec.args[1]),
-           lbm_dec_as_u32(arg_dec.args[2]));
+  int x = lbm_dec_as_i32(arg_dec.args[0]);
+  int y = lbm_dec_as_i32(arg_dec.args[1]);
+  putpixel(&arg_dec.img, x, y, lbm_dec_as_u32(arg_dec.args[2]));
+  img_dirty_box(&arg_dec.img, x, y, x, y);
   return ENC_SYM_TRUE;
 }
 
@@ -2377,6 +2882,7 @@ static lbm_value ext_line(lbm_value *args, lbm_uint argn) {
        lbm_dec_as_i32(arg_dec.attr_dotted.args[1]),
        lbm_dec_as_u32(arg_dec.args[4]));
 
+  img_dirty_args_points(&arg_dec, 2);
   return ENC_SYM_TRUE;
 }
 
@@ -2417,6 +2923,7 @@ static lbm_value ext_circle(lbm_value *args, lbm_uint argn) {
            lbm_dec_as_u32(arg_dec.args[3]));
   }
 
+  img_dirty_args_circle(&arg_dec);
   return ENC_SYM_TRUE;
 }
 
@@ -2443,6 +2950,7 @@ static lbm_value ext_arc(lbm_value *args, lbm_uint argn) {
       lbm_dec_as_i32(arg_dec.attr_resolution.args[0]),
       lbm_dec_as_u32(arg_dec.args[5]));
 
+  img_dirty_args_circle(&arg_dec);
   return ENC_SYM_TRUE;
 }
 
@@ -2469,6 +2977,7 @@ static lbm_value ext_circle_sector(lbm_value *args, lbm_uint argn) {
       lbm_dec_as_i32(arg_dec.attr_resolution.args[0]),
       lbm_dec_as_u32(arg_dec.args[5]));
 
+  img_dirty_args_circle(&arg_dec);
   return ENC_SYM_TRUE;
 }
 
@@ -2495,7 +3004,7 @@ static lbm_value ext_circle_segment(lbm_value *args, lbm_uint argn) {
       lbm_dec_as_i32(arg_dec.attr_resolution.args[0]),
       lbm_dec_as_u32(arg_dec.args[5]));
 
-
+  img_dirty_args_circle(&arg_dec);
   return ENC_SYM_TRUE;
 }
 
@@ -2563,6 +3072,11 @@ static lbm_value ext_rectangle(lbm_value *args, lbm_uint argn) {
               color);
   }
 
+  // The outline includes the pixels at x + width and y + height.
+  int pad = abs(thickness);
+  img_dirty_box(img,
+                (int64_t)x - pad, (int64_t)y - pad,
+                (int64_t)x + width + pad, (int64_t)y + height + pad);
   return ENC_SYM_TRUE;
 }
 
@@ -2594,6 +3108,7 @@ static lbm_value ext_triangle(lbm_value *args, lbm_uint argn) {
     line(img, x2, y2, x0, y0, thickness, dot1, dot2, color);
   }
 
+  img_dirty_args_points(&arg_dec, 3);
   return ENC_SYM_TRUE;
 }
 
@@ -2657,6 +3172,7 @@ static lbm_value ext_text(lbm_value *args, lbm_uint argn) {
   img_buf.fmt = image_buffer_format((uint8_t*)arr->data);
   img_buf.mem_base = (uint8_t*)arr->data;
   img_buf.data = image_buffer_data((uint8_t*)arr->data);
+  img_buf.dirty = image_buffer_dirty(arr);
 
   lbm_array_header_t *font = 0;
   // Allow both const and non-const fonts.
@@ -2698,6 +3214,16 @@ static lbm_value ext_text(lbm_value *args, lbm_uint argn) {
     ind++;
   }
 
+  if (ind > 0) {
+    int64_t len = (int64_t)ind * w;
+    if (up) {
+      img_dirty_box(&img_buf, x, y - len + 1, (int64_t)x + h - 1, y);
+    } else if (down) {
+      img_dirty_box(&img_buf, (int64_t)x - h + 1, y, x, y + len - 1);
+    } else {
+      img_dirty_box(&img_buf, x, y, x + len - 1, (int64_t)y + h - 1);
+    }
+  }
   return ENC_SYM_TRUE;
 }
 
@@ -2713,33 +3239,132 @@ static lbm_value ext_blit(lbm_value *args, lbm_uint argn) {
     dest_buf.fmt = image_buffer_format((uint8_t*)arr->data);
     dest_buf.mem_base = (uint8_t*)arr->data;
     dest_buf.data = image_buffer_data((uint8_t*)arr->data);
+    dest_buf.dirty = image_buffer_dirty(arr);
 
     float scale = 1.0;
     if (arg_dec.attr_scale.is_valid) {
       scale = lbm_dec_as_float(arg_dec.attr_scale.args[0]);
     }
-    
+    float rot_angle = lbm_dec_as_float(arg_dec.attr_rotate.args[2]);
+    int dest_x = lbm_dec_as_i32(arg_dec.args[0]);
+    int dest_y = lbm_dec_as_i32(arg_dec.args[1]);
+    int clip_x = arg_dec.attr_clip.is_valid ? lbm_dec_as_i32(arg_dec.attr_clip.args[0]) : 0;
+    int clip_y = arg_dec.attr_clip.is_valid ? lbm_dec_as_i32(arg_dec.attr_clip.args[1]) : 0;
+    int clip_w = arg_dec.attr_clip.is_valid ? lbm_dec_as_i32(arg_dec.attr_clip.args[2]) : dest_buf.width;
+    int clip_h = arg_dec.attr_clip.is_valid ? lbm_dec_as_i32(arg_dec.attr_clip.args[3]) : dest_buf.height;
+
     blit(
         &dest_buf,
         &arg_dec.img,
-        lbm_dec_as_i32(arg_dec.args[0]),
-        lbm_dec_as_i32(arg_dec.args[1]),
+        dest_x,
+        dest_y,
         lbm_dec_as_float(arg_dec.attr_rotate.args[0]),
         lbm_dec_as_float(arg_dec.attr_rotate.args[1]),
-        lbm_dec_as_float(arg_dec.attr_rotate.args[2]),
+        rot_angle,
         scale,
         lbm_dec_as_i32(arg_dec.args[2]),
         arg_dec.attr_tile.is_valid,
-        arg_dec.attr_clip.is_valid ? lbm_dec_as_i32(arg_dec.attr_clip.args[0]) : 0,
-        arg_dec.attr_clip.is_valid ? lbm_dec_as_i32(arg_dec.attr_clip.args[1]) : 0,
-        arg_dec.attr_clip.is_valid ? lbm_dec_as_i32(arg_dec.attr_clip.args[2]) : dest_buf.width,
-        arg_dec.attr_clip.is_valid ? lbm_dec_as_i32(arg_dec.attr_clip.args[3]) : dest_buf.height
+        clip_x,
+        clip_y,
+        clip_w,
+        clip_h
     );
+
+    // The clip end is an end coordinate rather than a size in blit.
+    int64_t x0 = clip_x;
+    int64_t y0 = clip_y;
+    int64_t x1 = (int64_t)clip_w - 1;
+    int64_t y1 = (int64_t)clip_h - 1;
+    if (rot_angle == 0.0f && scale == 1.0f && !arg_dec.attr_tile.is_valid) {
+      if (dest_x > x0) x0 = dest_x;
+      if (dest_y > y0) y0 = dest_y;
+      if ((int64_t)dest_x + arg_dec.img.width - 1 < x1) x1 = (int64_t)dest_x + arg_dec.img.width - 1;
+      if ((int64_t)dest_y + arg_dec.img.height - 1 < y1) y1 = (int64_t)dest_y + arg_dec.img.height - 1;
+    }
+    img_dirty_box(&dest_buf, x0, y0, x1, y1);
+    res = ENC_SYM_TRUE;
+  }
+  return res;
+}
+
+static bool decode_image_buffer(lbm_value v, image_buffer_t *img) {
+  lbm_array_header_t *arr = get_image_buffer(v);
+  if (!arr) return false;
+  img->width = image_buffer_width((uint8_t*)arr->data);
+  img->height = image_buffer_height((uint8_t*)arr->data);
+  img->fmt = image_buffer_format((uint8_t*)arr->data);
+  img->mem_base = (uint8_t*)arr->data;
+  img->data = image_buffer_data((uint8_t*)arr->data);
+  img->dirty = image_buffer_dirty(arr);
+  return true;
+}
+
+static char *msg_no_dirty_track = "Image buffer not allocated with 'dirty-track";
+
+// lisp args: img opt-on
+static lbm_value ext_dirty_track(lbm_value *args, lbm_uint argn) {
+  lbm_value res = ENC_SYM_TERROR;
+  image_buffer_t img;
+  if ((argn == 1 || argn == 2) && decode_image_buffer(args[0], &img)) {
+    if (!img.dirty) {
+      lbm_set_error_reason(msg_no_dirty_track);
+      return ENC_SYM_EERROR;
+    }
+    img_dirty_track(&img, argn == 1 || !lbm_is_symbol_nil(args[1]));
     res = ENC_SYM_TRUE;
   }
   return res;
 }
 
+// lisp args: img opt-x opt-y opt-w opt-h
+static lbm_value ext_dirty_mark(lbm_value *args, lbm_uint argn) {
+  lbm_value res = ENC_SYM_TERROR;
+  image_buffer_t img;
+  if ((argn == 1 || argn == 5) && decode_image_buffer(args[0], &img)) {
+    if (argn == 1) {
+      image_buffer_mark_dirty(&img, 0, 0, img.width, img.height);
+      res = ENC_SYM_TRUE;
+    } else if (lbm_is_number(args[1]) && lbm_is_number(args[2]) &&
+               lbm_is_number(args[3]) && lbm_is_number(args[4])) {
+      image_buffer_mark_dirty(&img,
+                              lbm_dec_as_i32(args[1]),
+                              lbm_dec_as_i32(args[2]),
+                              lbm_dec_as_i32(args[3]),
+                              lbm_dec_as_i32(args[4]));
+      res = ENC_SYM_TRUE;
+    }
+  }
+  return res;
+}
+
+// lisp args: img
+// Returns the dirty rectangles as a list of (x y w h).
+static lbm_value ext_dirty(lbm_value *args, lbm_uint argn) {
+  image_buffer_t img;
+  if (argn != 1 || !decode_image_buffer(args[0], &img)) {
+    return ENC_SYM_TERROR;
+  }
+  img_dirty_t *d = img_dirty_get(&img);
+  if (!d) return ENC_SYM_NIL;
+
+  // Five cells per rectangle, checked up front so the list can be built
+  // without partial results.
+  if (lbm_heap_num_free() < (lbm_uint)d->num_rects * 5) {
+    return ENC_SYM_MERROR;
+  }
+  lbm_value res = ENC_SYM_NIL;
+  for (int i = d->num_rects - 1; i >= 0; i --) {
+    img_rect_t *r = &d->rects[i];
+    lbm_value rect = lbm_heap_allocate_list_init(4,
+                                                 lbm_enc_i(r->x),
+                                                 lbm_enc_i(r->y),
+                                                 lbm_enc_i(r->w),
+                                                 lbm_enc_i(r->h));
+    res = lbm_cons(rect, res);
+  }
+  return res;
+}
+
 void display_dummy_reset(void) {
   return;
 }
@@ -2802,6 +3427,33 @@ static lbm_value ext_disp_clear(lbm_value *args, lbm_uint argn) {
   return ENC_SYM_TRUE;
 }
 
+static char *msg_render_failed = "Could not render image. Check if the format and location is compatible with the display.";
+
+// Decodes the optional list of colors to render an image with.
+static bool decode_render_colors(lbm_value *args, lbm_uint argn, color_t *colors) {
+  memset(colors, 0, sizeof(color_t) * 16);
+
+  if (argn == 4 && lbm_is_list(args[3])) {
+    int i = 0;
+    lbm_value curr = args[3];
+    while (lbm_is_cons(curr) && i < 16) {
+      lbm_value arg = lbm_car(curr);
+      color_t *color;
+      if (lbm_is_number(arg)) {
+        colors[i].color1 = (int)lbm_dec_as_u32(arg);
+      } else if ((color = get_color(arg))) { // color assignment
+        colors[i] = *color;
+      } else {
+        return false;
+      }
+
+      curr = lbm_cdr(curr);
+      i++;
+    }
+  }
+  return true;
+}
+
 static lbm_value ext_disp_render(lbm_value *args, lbm_uint argn) {
   if (disp_render_image == NULL) {
     lbm_set_error_reason(msg_not_supported);
@@ -2820,40 +3472,124 @@ static lbm_value ext_disp_render(lbm_value *args, lbm_uint argn) {
     img_buf.height = image_buffer_height((uint8_t*)arr->data);
     img_buf.mem_base = (uint8_t*)arr->data;
     img_buf.data = image_buffer_data((uint8_t*)arr->data);
+    img_buf.dirty = image_buffer_dirty(arr);
 
     color_t colors[16];
-    memset(colors, 0, sizeof(color_t) * 16);
-
-    if (argn == 4 && lbm_is_list(args[3])) {
-      int i = 0;
-      lbm_value curr = args[3];
-      while (lbm_is_cons(curr) && i < 16) {
-        lbm_value arg = lbm_car(curr);
-        color_t *color;
-        if (lbm_is_number(arg)) {
-          colors[i].color1 = (int)lbm_dec_as_u32(arg);
-        } else if ((color = get_color(arg))) { // color assignment
-          colors[i] = *color;
-        } else {
-          return ENC_SYM_TERROR;
-        }
-
-        curr = lbm_cdr(curr);
-        i++;
-      }
+    if (!decode_render_colors(args, argn, colors)) {
+      return ENC_SYM_TERROR;
     }
 
     // img_buf is a stack allocated image_buffer_t.
     bool render_res = disp_render_image(&img_buf, (uint16_t)lbm_dec_as_u32(args[1]), (uint16_t)lbm_dec_as_u32(args[2]), colors);
     if (!render_res) {
-      lbm_set_error_reason("Could not render image. Check if the format and location is compatible with the display.");
+      lbm_set_error_reason(msg_render_failed);
       return ENC_SYM_EERROR;
     }
+    img_dirty_t *d = img_dirty_get(&img_buf);
+    if (d) d->num_rects = 0;
     res = ENC_SYM_TRUE;
   }
   return res;
 }
 
+// Copies rectangle r of img into the image buffer at buf, which must
+// have room for it, and sets up sub to refer to it.
+static void image_buffer_copy_rect(image_buffer_t *img, img_rect_t *r, uint8_t *buf, image_buffer_t *sub) {
+  buf[0] = (uint8_t)(r->w >> 8);
+  buf[1] = (uint8_t)r->w;
+  buf[2] = (uint8_t)(r->h >> 8);
+  buf[3] = (uint8_t)r->h;
+  buf[4] = color_format_to_byte(img->fmt);
+  sub->fmt = img->fmt;
+  sub->width = r->w;
+  sub->height = r->h;
+  sub->mem_base = buf;
+  sub->data = image_buffer_data(buf);
+  sub->dirty = NULL;
+
+  if (img->fmt >= rgb332) {
+    uint32_t bytes_pp = (uint32_t)img->fmt / 8;
+    uint32_t row_bytes = r->w * bytes_pp;
+    for (uint32_t j = 0; j < r->h; j ++) {
+      uint32_t src = ((r->y + j) * img->width + r->x) * bytes_pp;
+      memcpy(sub->data + j * row_bytes, img->data + src, row_bytes);
+    }
+  } else {
+    for (int j = 0; j < r->h; j ++) {
+      for (int i = 0; i < r->w; i ++) {
+        putpixel(sub, i, j, getpixel(img, r->x + i, r->y + j));
+      }
+    }
+  }
+}
+
+// lisp args: img x y opt-colors
+// Like disp-render but only sends the regions of a tracked image that
+// changed since it was last rendered.
+static lbm_value ext_disp_render_dirty(lbm_value *args, lbm_uint argn) {
+  if (disp_render_image == NULL) {
+    lbm_set_error_reason(msg_not_supported);
+    return ENC_SYM_EERROR;
+  }
+
+  lbm_array_header_t *arr;
+  if ((argn != 3 && argn != 4) ||
+      !(arr = get_image_buffer(args[0])) ||
+      !lbm_is_number(args[1]) ||
+      !lbm_is_number(args[2])) {
+    return ENC_SYM_TERROR;
+  }
+
+  image_buffer_t img_buf;
+  img_buf.fmt = image_buffer_format((uint8_t*)arr->data);
+  img_buf.width = image_buffer_width((uint8_t*)arr->data);
+  img_buf.height = image_buffer_height((uint8_t*)arr->data);
+  img_buf.mem_base = (uint8_t*)arr->data;
+  img_buf.data = image_buffer_data((uint8_t*)arr->data);
+  img_buf.dirty = image_buffer_dirty(arr);
+
+  color_t colors[16];
+  if (!decode_render_colors(args, argn, colors)) {
+    return ENC_SYM_TERROR;
+  }
+
+  uint16_t x = (uint16_t)lbm_dec_as_u32(args[1]);
+  uint16_t y = (uint16_t)lbm_dec_as_u32(args[2]);
+
+  img_dirty_t *d = img_dirty_get(&img_buf);
+  uint8_t *buf = NULL;
+  if (d && d->num_rects > 0 &&
+      !(d->num_rects == 1 && rect_area(&d->rects[0]) == (uint32_t)img_buf.width * img_buf.height)) {
+    uint32_t max_size = 0;
+    for (int i = 0; i < d->num_rects; i ++) {
+      uint32_t size = image_dims_to_size_bytes(img_buf.fmt, d->rects[i].w, d->rects[i].h);
+      if (size > max_size) max_size = size;
+    }
+    buf = lbm_malloc(IMAGE_BUFFER_HEADER_SIZE + max_size);
+  }
+
+  bool render_res = true;
+  if (buf) {
+    for (int i = 0; i < d->num_rects && render_res; i ++) {
+      img_rect_t *r = &d->rects[i];
+      image_buffer_t sub;
+      image_buffer_copy_rect(&img_buf, r, buf, &sub);
+      render_res = disp_render_image(&sub, (uint16_t)(x + r->x), (uint16_t)(y + r->y), colors);
+    }
+    lbm_free(buf);
+  } else if (!d || d->num_rects > 0) {
+    // Untracked, all dirty or no memory for the copies.
+    render_res = disp_render_image(&img_buf, x, y, colors);
+  }
+
+  if (!render_res) {
+    lbm_set_error_reason(msg_render_failed);
+    return ENC_SYM_EERROR;
+  }
+  if (d) d->num_rects = 0;
+  return ENC_SYM_TRUE;
+}
+
 // Jpg decoder
 
 typedef struct {
@@ -2888,6 +3624,7 @@ int jpg_output_func (	/* 1:Ok, 0:Aborted */
   image_buffer_t img;
   img.mem_base = (uint8_t*)bitmap;
   img.data = (uint8_t*)bitmap;
+  img.dirty = NULL;
   img.width = (uint16_t)(rect->right - rect->left + 1);
   img.height = (uint16_t)(rect->bottom - rect->top + 1);
   img.fmt = rgb888;
@@ -2959,10 +3696,14 @@ void lbm_display_extensions_init(void) {
   lbm_add_extension("img-rectangle", ext_rectangle);
   lbm_add_extension("img-triangle", ext_triangle);
   lbm_add_extension("img-blit", ext_blit);
+  lbm_add_extension("img-dirty-track", ext_dirty_track);
+  lbm_add_extension("img-dirty-mark", ext_dirty_mark);
+  lbm_add_extension("img-dirty", ext_dirty);
 
   lbm_add_extension("disp-reset", ext_disp_reset);
   lbm_add_extension("disp-clear", ext_disp_clear);
   lbm_add_extension("disp-render", ext_disp_render);
+  lbm_add_extension("disp-render-dirty", ext_disp_render_dirty);
   lbm_add_extension("disp-render-jpg", ext_disp_render_jpg);
 }
 
@@ -42,6 +42,13 @@ static lbm_uint sym_num_gc_recovered_cells;
 static lbm_uint sym_num_gc_recovered_arrays;
 static lbm_uint sym_num_least_free;
 static lbm_uint sym_num_last_free;
+static lbm_uint sym_gc_alloc;
+static lbm_uint sym_gc_request;
+static lbm_uint sym_gc_explicit;
+static lbm_uint sym_gc_incremental;
+static lbm_uint sym_gc_pause;
+static lbm_uint sym_gc_heap_use;
+static lbm_uint sym_gc_trigger;
 #endif
 
 lbm_value ext_eval_set_quota(lbm_value *args, lbm_uint argn) {
@@ -146,7 +153,7 @@ lbm_value ext_lbm_heap_state(lbm_value *args, lbm_uint argn) {
 
 lbm_value ext_env_get(lbm_value *args, lbm_uint argn) {
   if (argn == 1 && lbm_is_number(args[0])) {
-    lbm_uint ix = lbm_dec_as_u32(args[0]) & GLOBAL_ENV_MASK;
+    lbm_uint ix = lbm_dec_as_u32(args[0]) & (lbm_get_global_env_roots() - 1);
     return lbm_get_global_env()[ix];
   }
   return ENC_SYM_TERROR;
@@ -161,9 +168,10 @@ lbm_value ext_local_env_get(lbm_value *args, lbm_uint argn) {
 
 lbm_value ext_env_set(lbm_value *args, lbm_uint argn) {
   if (argn == 2 && lbm_is_number(args[0])) {
-    lbm_uint ix = lbm_dec_as_u32(args[0]) & GLOBAL_ENV_MASK;
+    lbm_uint ix = lbm_dec_as_u32(args[0]) & (lbm_get_global_env_roots() - 1);
     lbm_value *glob_env = lbm_get_global_env();
     glob_env[ix] = args[1];
+    lbm_global_env_changed();
     return ENC_SYM_TRUE;
   }
   return ENC_SYM_NIL;
@@ -187,6 +195,117 @@ lbm_value ext_set_gc_stack_size(lbm_value *args, lbm_uint argn) {
   return ENC_SYM_TERROR;
 }
 
+lbm_value ext_set_gc_pause_budget(lbm_value *args, lbm_uint argn) {
+  if (argn == 1 && lbm_is_number(args[0])) {
+    if (lbm_set_gc_pause_budget(lbm_dec_as_u32(args[0]))) {
+      return ENC_SYM_TRUE;
+    }
+    return ENC_SYM_MERROR;
+  }
+  return ENC_SYM_TERROR;
+}
+
+static lbm_value gc_trigger_symbol(uint32_t trigger) {
+  switch (trigger) {
+  case LBM_GC_TRIGGER_REQUEST: return lbm_enc_sym(sym_gc_request);
+  case LBM_GC_TRIGGER_EXPLICIT: return lbm_enc_sym(sym_gc_explicit);
+  case LBM_GC_TRIGGER_INCREMENTAL: return lbm_enc_sym(sym_gc_incremental);
+  default: return lbm_enc_sym(sym_gc_alloc);
+  }
+}
+
+// Returns the most recent GC records, newest first, as lists:
+// (trigger timestamp mark-us sweep-us cid free-before recovered
+//  recovered-arrays free-after mem-free mem-longest-free)
+lbm_value ext_gc_log(lbm_value *args, lbm_uint argn) {
+  lbm_uint n = LBM_GC_LOG_SIZE;
+  if (argn == 1 && lbm_is_number(args[0])) {
+    n = lbm_dec_as_u32(args[0]);
+  } else if (argn != 0) {
+    return ENC_SYM_TERROR;
+  }
+  if (n > LBM_GC_LOG_SIZE) n = LBM_GC_LOG_SIZE;
+
+  lbm_value res = ENC_SYM_NIL;
+  lbm_gc_record_t rec;
+  // Build from the oldest so the newest ends up first.
+  for (lbm_uint i = n; i > 0; i --) {
+    if (!lbm_get_gc_record(i - 1, &rec)) continue;
+    lbm_value ts = lbm_enc_u32(rec.timestamp);
+    if (lbm_is_symbol_merror(ts)) return ts;
+    lbm_value r = lbm_heap_allocate_list(11);
+    if (!lbm_is_ptr(r)) return ENC_SYM_MERROR;
+    lbm_value vals[11] = {gc_trigger_symbol(rec.trigger),
+                          ts,
+                          lbm_enc_u(rec.mark_us),
+                          lbm_enc_u(rec.sweep_us),
+                          lbm_enc_i(rec.cid),
+                          lbm_enc_u(rec.free_before),
+                          lbm_enc_u(rec.recovered),
+                          lbm_enc_u(rec.recovered_arrays),
+                          lbm_enc_u(rec.free_after),
+                          lbm_enc_u(rec.mem_free),
+                          lbm_enc_u(rec.mem_longest_free)};
+    lbm_value curr = r;
+    for (int j = 0; j < 11; j ++) {
+      lbm_set_car(curr, vals[j]);
+      curr = lbm_cdr(curr);
+    }
+    res = lbm_cons(r, res);
+    if (lbm_is_symbol_merror(res)) return res;
+  }
+  return res;
+}
+
+static lbm_value uint_list(const lbm_uint *vals, lbm_uint n) {
+  lbm_value res = lbm_heap_allocate_list(n);
+  if (!lbm_is_ptr(res)) return ENC_SYM_MERROR;
+  lbm_value curr = res;
+  for (lbm_uint i = 0; i < n; i ++) {
+    lbm_set_car(curr, lbm_enc_u(vals[i]));
+    curr = lbm_cdr(curr);
+  }
+  return res;
+}
+
+// (gc-histogram 'pause), (gc-histogram 'heap-use) or (gc-histogram 'trigger)
+lbm_value ext_gc_histogram(lbm_value *args, lbm_uint argn) {
+  if (argn != 1 || !lbm_is_symbol(args[0])) return ENC_SYM_TERROR;
+  const lbm_gc_stats_t *stats = lbm_get_gc_stats();
+  lbm_uint s = lbm_dec_sym(args[0]);
+  if (s == sym_gc_pause) {
+    return uint_list(stats->pause_hist, LBM_GC_PAUSE_BUCKETS);
+  } else if (s == sym_gc_heap_use) {
+    return uint_list(stats->use_hist, LBM_GC_USE_BUCKETS);
+  } else if (s == sym_gc_trigger) {
+    return uint_list(stats->triggers, LBM_GC_NUM_TRIGGERS);
+  }
+  return ENC_SYM_NIL;
+}
+
+// (env-stats) -> (roots used-roots bindings max-chain)
+lbm_value ext_env_stats(lbm_value *args, lbm_uint argn) {
+  (void) args;
+  (void) argn;
+  lbm_global_env_stats_t s;
+  lbm_get_global_env_stats(&s);
+  lbm_uint vals[4] = {s.roots, s.used_roots, s.bindings, s.max_chain};
+  return uint_list(vals, 4);
+}
+
+lbm_value ext_gc_max_pause(lbm_value *args, lbm_uint argn) {
+  (void) args;
+  (void) argn;
+  return lbm_enc_u32(lbm_get_gc_stats()->max_pause_us);
+}
+
+lbm_value ext_gc_stats_reset(lbm_value *args, lbm_uint argn) {
+  (void) args;
+  (void) argn;
+  lbm_reset_gc_stats();
+  return ENC_SYM_TRUE;
+}
+
 lbm_value ext_is_64bit(lbm_value *args, lbm_uint argn) {
   (void) args;
   (void) argn;
@@ -257,9 +376,9 @@ lbm_value ext_mailbox_get(lbm_uint *args, lbm_uint argn) {
       res = ls;
       if (lbm_is_ptr(ls)) {
         lbm_value curr = ls;
-        int i = 0;
+        uint32_t i = 0;
         while (lbm_is_ptr(curr)) {
-          lbm_set_car(curr, ctx->mailbox[i++]);
+          lbm_set_car(curr, lbm_mailbox_get_mail(ctx, i++));
           curr = lbm_cdr(curr);
         }
       }
@@ -269,6 +388,38 @@ lbm_value ext_mailbox_get(lbm_uint *args, lbm_uint argn) {
 }
 #endif
 
+#ifdef FULL_RTS_LIB
+static void alloc_cells_acc(eval_context_t *ctx, void *arg1, void *arg2) {
+  lbm_value *res = (lbm_value*)arg1;
+  (void) arg2;
+  if (lbm_is_symbol_merror(*res)) return;
+  lbm_value entry = lbm_cons(lbm_enc_i(ctx->id), lbm_enc_u(ctx->alloc_cells));
+  if (lbm_is_symbol_merror(entry)) {
+    *res = entry;
+  } else {
+    *res = lbm_cons(entry, *res);
+  }
+}
+
+// (ctx-alloc-cells cid) is the number of heap cells allocated by a
+// context. Without argument an association list from cid to count is
+// returned for all contexts.
+lbm_value ext_ctx_alloc_cells(lbm_value *args, lbm_uint argn) {
+  if (argn == 1 && lbm_is_number(args[0])) {
+    lbm_cid cid = lbm_dec_as_i32(args[0]);
+    eval_context_t *ctx = NULL;
+    lbm_all_ctxs_iterator(find_cid, (void*)cid, (void*)&ctx);
+    if (ctx) return lbm_enc_u(ctx->alloc_cells);
+    return ENC_SYM_NIL;
+  } else if (argn == 0) {
+    lbm_value res = ENC_SYM_NIL;
+    lbm_all_ctxs_iterator(alloc_cells_acc, (void*)&res, NULL);
+    return res;
+  }
+  return ENC_SYM_TERROR;
+}
+#endif
+
 
 void lbm_runtime_extensions_init(void) {
 
@@ -283,6 +434,13 @@ void lbm_runtime_extensions_init(void) {
     lbm_add_symbol_const("get-gc-num-recovered-arrays", &sym_num_gc_recovered_arrays);
     lbm_add_symbol_const("get-gc-num-least-free", &sym_num_least_free);
     lbm_add_symbol_const("get-gc-num-last-free", &sym_num_last_free);
+    lbm_add_symbol_const("alloc", &sym_gc_alloc);
+    lbm_add_symbol_const("request", &sym_gc_request);
+    lbm_add_symbol_const("explicit", &sym_gc_explicit);
+    lbm_add_symbol_const("incremental", &sym_gc_incremental);
+    lbm_add_symbol_const("pause", &sym_gc_pause);
+    lbm_add_symbol_const("heap-use", &sym_gc_heap_use);
+    lbm_add_symbol_const("trigger", &sym_gc_trigger);
 #endif
 
 #if defined(LBM_USE_EXT_MAILBOX_GET) || defined(FULL_RTS_LIB)
@@ -305,8 +463,15 @@ void lbm_runtime_extensions_init(void) {
     lbm_add_extension("lbm-heap-state", ext_lbm_heap_state);
     lbm_add_extension("env-get", ext_env_get);
     lbm_add_extension("env-set", ext_env_set);
+    lbm_add_extension("env-stats", ext_env_stats);
     lbm_add_extension("local-env-get", ext_local_env_get);
     lbm_add_extension("set-gc-stack-size", ext_set_gc_stack_size);
+    lbm_add_extension("set-gc-pause-budget", ext_set_gc_pause_budget);
+    lbm_add_extension("gc-log", ext_gc_log);
+    lbm_add_extension("gc-histogram", ext_gc_histogram);
+    lbm_add_extension("gc-max-pause", ext_gc_max_pause);
+    lbm_add_extension("gc-stats-reset", ext_gc_stats_reset);
+    lbm_add_extension("ctx-alloc-cells", ext_ctx_alloc_cells);
     lbm_add_extension("is-64bit", ext_is_64bit);
     lbm_add_extension("symtab-size", ext_symbol_table_size);
     lbm_add_extension("symtab-size-flash", ext_symbol_table_size_flash);
@@ -61,6 +61,7 @@ static SFT mk_sft(SFT_Font *ft, float x_scale, float y_scale) {
 #define FONT_LINE_METRICS_STRING    "lmtx"
 #define FONT_KERNING_STRING         "kern"
 #define FONT_GLYPHS_STRING          "glyphs"
+#define FONT_INDEX_STRING           "index"
 
 // sizeof when used on string literals include the the terminating 0
 #define FONT_PREAMBLE_SIZE          (sizeof(uint16_t) * 2 + sizeof(FONT_MAGIC_STRING))
@@ -72,6 +73,8 @@ static SFT mk_sft(SFT_Font *ft, float x_scale, float y_scale) {
 #define FONT_KERN_TABLE_SIZE        (uint32_t)(sizeof(FONT_KERNING_STRING) + 4 + 4)
 #define FONT_GLYPH_TABLE_SIZE       (uint32_t)(sizeof(FONT_GLYPHS_STRING) + 4 + 4 + 4)
 #define FONT_GLYPH_SIZE             (uint32_t)(6*4)
+#define FONT_INDEX_TABLE_SIZE       (uint32_t)(sizeof(FONT_INDEX_STRING) + 4 + 4 + 4)
+#define FONT_INDEX_ENTRY_SIZE       (uint32_t)(4 + 4)
 
 static int num_kern_pairs_row(SFT *sft, uint32_t utf32, uint32_t *codes, uint32_t num_codes) {
 
@@ -124,15 +127,14 @@ static bool kern_table_dims(SFT *sft, uint32_t *codes, uint32_t num_codes, int *
   return true;
 }
 
-static int kern_table_size_bytes(SFT *sft, uint32_t *codes, uint32_t num_codes) {
-  int rows = 0;
+static int kern_table_size_bytes(SFT *sft, uint32_t *codes, uint32_t num_codes, int *rows) {
   int tot_pairs = 0;
 
   int size_bytes;
-  if (kern_table_dims(sft, codes, num_codes, &rows, &tot_pairs)) {
+  if (kern_table_dims(sft, codes, num_codes, rows, &tot_pairs)) {
     size_bytes =
       (int)(FONT_KERN_PAIR_SIZE * (uint32_t)tot_pairs +
-            FONT_KERN_ROW_SIZE * (uint32_t)rows +
+            FONT_KERN_ROW_SIZE * (uint32_t)*rows +
             FONT_KERN_TABLE_SIZE);
   } else {
     return -1;
@@ -260,6 +262,7 @@ static int buffer_append_glyph(uint8_t *buffer, SFT *sft, color_format_t fmt, ui
   img.fmt = fmt;
   img.mem_base = &buffer[*index];
   img.data = &buffer[*index];
+  img.dirty = NULL;
 
   int r = sft_render(sft, gid, &img);
   *index += (int32_t)image_dims_to_size_bytes(fmt, (uint16_t)gmtx.minWidth, (uint16_t)gmtx.minHeight);
@@ -287,6 +290,36 @@ static int buffer_append_glyph_table(uint8_t *buffer, SFT *sft, color_format_t f
   return r;
 }
 
+// The index table is built from the glyph and kerning tables already
+// in the buffer. glyphs_index is the first glyph record and kern_index
+// the number of rows field of the kerning table.
+static void buffer_append_index_table(uint8_t *buffer, color_format_t fmt, int32_t glyphs_index, uint32_t num_codes, int32_t kern_index, int32_t *index) {
+  int32_t k = kern_index;
+  uint32_t num_rows = buffer_get_uint32(buffer, &k);
+
+  buffer_append_string(buffer, FONT_INDEX_STRING, index);
+  buffer_append_uint32(buffer, 8 + (num_codes + num_rows) * FONT_INDEX_ENTRY_SIZE, index);
+  buffer_append_uint32(buffer, num_codes, index);
+  buffer_append_uint32(buffer, num_rows, index);
+
+  int32_t g = glyphs_index;
+  for (uint32_t i = 0; i < num_codes; i ++) {
+    buffer_append_uint32(buffer, buffer_get_uint32(buffer, &g), index);
+    buffer_append_uint32(buffer, (uint32_t)(g - 4), index);
+    g += 12;
+    int32_t w = buffer_get_int32(buffer, &g);
+    int32_t h = buffer_get_int32(buffer, &g);
+    g += (int32_t)image_dims_to_size_bytes(fmt, (uint16_t)w, (uint16_t)h);
+  }
+
+  for (uint32_t r = 0; r < num_rows; r ++) {
+    buffer_append_uint32(buffer, buffer_get_uint32(buffer, &k), index);
+    buffer_append_uint32(buffer, (uint32_t)(k - 4), index);
+    uint32_t row_len = buffer_get_uint32(buffer, &k);
+    k += (int32_t)(row_len * FONT_KERN_PAIR_SIZE);
+  }
+}
+
 //returns the increment for n
 static int insert_nub(uint32_t *arr, uint32_t n, uint32_t new_elt) {
   uint32_t i;
@@ -353,7 +386,8 @@ lbm_value ext_ttf_prepare_bin(lbm_value *args, lbm_uint argn) {
       // There could be zero kerning pairs and then we dont
       // need the kerning table at all.
       // TODO: Fix this.
-      int kern_tab_bytes = kern_table_size_bytes(&sft, unique_utf32, n);
+      int kern_rows = 0;
+      int kern_tab_bytes = kern_table_size_bytes(&sft, unique_utf32, n, &kern_rows);
       if (kern_tab_bytes <=  0) {
         lbm_free(unique_utf32);
         return ENC_SYM_EERROR;
@@ -371,7 +405,9 @@ lbm_value ext_ttf_prepare_bin(lbm_value *args, lbm_uint argn) {
         (uint32_t)kern_tab_bytes +
         FONT_GLYPH_TABLE_SIZE +
         n * FONT_GLYPH_SIZE + // per glyph metrics
-        (uint32_t)glyph_gfx_size;
+        (uint32_t)glyph_gfx_size +
+        FONT_INDEX_TABLE_SIZE +
+        (n + (uint32_t)kern_rows) * FONT_INDEX_ENTRY_SIZE;
 
       uint8_t *buffer = (uint8_t*)lbm_malloc(bytes_required);
       if (!buffer) {
@@ -393,8 +429,10 @@ lbm_value ext_ttf_prepare_bin(lbm_value *args, lbm_uint argn) {
                                  lmtx.descender,
                                  lmtx.lineGap,
                                  &index);
+      int32_t kern_index = index + (int32_t)sizeof(FONT_KERNING_STRING) + 4;
       buffer_append_kerning_table(buffer, &sft, unique_utf32, n, &index);
 
+      int32_t glyphs_index = index + (int32_t)FONT_GLYPH_TABLE_SIZE;
       int r = buffer_append_glyph_table(buffer, &sft, fmt, unique_utf32, n, &index);
       if ( r == SFT_MEM_ERROR) {
         lbm_free(unique_utf32);
@@ -409,6 +447,7 @@ lbm_value ext_ttf_prepare_bin(lbm_value *args, lbm_uint argn) {
       }
 
       lbm_free(unique_utf32); // tmp data nolonger needed
+      buffer_append_index_table(buffer, fmt, glyphs_index, n, kern_index, &index);
       result_array_header->size = (lbm_uint)index;
       result_array_header->data = (lbm_uint*)buffer;
       lbm_set_car(result_array_cell, (lbm_uint)result_array_header);
@@ -481,6 +520,62 @@ static bool font_get_glyphs_table_index(uint8_t *buffer, int32_t buffer_size, in
   return false;
 }
 
+// Index table
+//
+// Finding a glyph or a kerning pair by walking the tables means a pass
+// over every record before it. ttf-prepare ends the font with an index
+// table holding the code and position of each glyph record and kerning
+// row. Both tables are written sorted by code, so lookups are binary
+// searches over the index. The index is part of the font array and is
+// freed with it. Fonts without an index table are looked up by walking
+// the tables.
+
+typedef struct {
+  int32_t glyphs;       // Position of the first glyph entry.
+  uint32_t num_glyphs;
+  int32_t rows;         // Position of the first kerning row entry.
+  uint32_t num_rows;
+} font_index_t;
+
+static bool font_get_index(uint8_t *buffer, int32_t buffer_size, font_index_t *ix, int32_t index) {
+  while (index < buffer_size) {
+    char *str = (char*)&buffer[index];
+    if (strncmp(str, FONT_INDEX_STRING, 5) == 0) {
+      int32_t i = index + 6;
+      uint32_t size = buffer_get_uint32(buffer, &i);
+      ix->num_glyphs = buffer_get_uint32(buffer, &i);
+      ix->num_rows = buffer_get_uint32(buffer, &i);
+      ix->glyphs = i;
+      ix->rows = i + (int32_t)(ix->num_glyphs * FONT_INDEX_ENTRY_SIZE);
+      uint64_t entries_size = ((uint64_t)ix->num_glyphs + ix->num_rows) * FONT_INDEX_ENTRY_SIZE;
+      return
+        size == 8 + entries_size &&
+        (uint64_t)i + entries_size <= (uint64_t)buffer_size;
+    }
+    index += (int32_t)(strlen(str) + 1);
+    index += (int32_t)buffer_get_uint32(buffer,&index);
+  }
+  return false;
+}
+
+// Finds code among n index entries and gives the position of its record.
+static bool font_index_find(uint8_t *buffer, int32_t entries, uint32_t n, uint32_t code, int32_t *res) {
+  uint32_t lo = 0;
+  uint32_t hi = n;
+  while (lo < hi) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    int32_t i = entries + (int32_t)(mid * FONT_INDEX_ENTRY_SIZE);
+    uint32_t c = buffer_get_uint32(buffer, &i);
+    if (c == code) {
+      *res = (int32_t)buffer_get_uint32(buffer, &i);
+      return true;
+    }
+    if (c < code) lo = mid + 1;
+    else hi = mid;
+  }
+  return false;
+}
+
 static bool font_get_glyph(uint8_t *buffer,
                            float *advance_width,
                            float *left_side_bearing,
@@ -491,7 +586,20 @@ static bool font_get_glyph(uint8_t *buffer,
                            uint32_t utf32,
                            uint32_t num_codes,
                            color_format_t fmt,
-                           int32_t index) {
+                           int32_t index,
+                           font_index_t *ix) {
+
+  if (ix) {
+    if (!font_index_find(buffer, ix->glyphs, ix->num_glyphs, utf32, &index)) return false;
+    index += 4;
+    *advance_width = buffer_get_float32_auto(buffer, &index);
+    *left_side_bearing = buffer_get_float32_auto(buffer, &index);
+    *y_offset = buffer_get_int32(buffer, &index);
+    *width = buffer_get_int32(buffer, &index);
+    *height = buffer_get_int32(buffer,&index);
+    *gfx = &buffer[index];
+    return true;
+  }
 
   uint32_t i = 0;
   while (i < num_codes) {
@@ -515,7 +623,28 @@ static bool font_get_glyph(uint8_t *buffer,
   return false;
 }
 
-bool font_get_kerning(uint8_t *buffer, uint32_t left, uint32_t right, float *x_shift, float *y_shift, int32_t index) {
+bool font_get_kerning(uint8_t *buffer, uint32_t left, uint32_t right, float *x_shift, float *y_shift, int32_t index, font_index_t *ix) {
+
+  if (ix) {
+    int32_t row;
+    if (!font_index_find(buffer, ix->rows, ix->num_rows, left, &row)) return false;
+    row += 4;
+    uint32_t lo = 0;
+    uint32_t hi = buffer_get_uint32(buffer, &row);
+    while (lo < hi) {
+      uint32_t mid = lo + (hi - lo) / 2;
+      int32_t i = row + (int32_t)(mid * FONT_KERN_PAIR_SIZE);
+      uint32_t code = buffer_get_uint32(buffer, &i);
+      if (code == right) {
+        *x_shift = buffer_get_float32_auto(buffer, &i);
+        *y_shift = buffer_get_float32_auto(buffer, &i);
+        return true;
+      }
+      if (code < right) lo = mid + 1;
+      else hi = mid;
+    }
+    return false;
+  }
 
   uint32_t num_rows = buffer_get_uint32(buffer, &index);
 
@@ -617,6 +746,12 @@ lbm_value ttf_text_bin(lbm_value *args, lbm_uint argn) {
     return ENC_SYM_EERROR;
   }
 
+  font_index_t font_ix;
+  font_index_t *ix = NULL;
+  if (font_get_index((uint8_t*)font_arr->data, (int32_t)font_arr->size, &font_ix, index)) {
+    ix = &font_ix;
+  }
+
   color_format_t fmt = (color_format_t)color_fmt;
   float x = 0.0;
   float y = 0.0;
@@ -627,6 +762,7 @@ lbm_value ttf_text_bin(lbm_value *args, lbm_uint argn) {
   tgt.fmt = image_buffer_format((uint8_t*)img_arr->data);
   tgt.mem_base = (uint8_t*)img_arr->data;
   tgt.data = image_buffer_data((uint8_t*)img_arr->data);
+  tgt.dirty = image_buffer_dirty(img_arr);
 
   uint32_t utf32;
   uint32_t prev;
@@ -661,7 +797,8 @@ lbm_value ttf_text_bin(lbm_value *args, lbm_uint argn) {
                        utf32,
                        num_codes,
                        fmt,
-                       glyphs_index)) {
+                       glyphs_index,
+                       ix)) {
 
       float x_shift = 0;
       float y_shift = 0;
@@ -671,7 +808,8 @@ lbm_value ttf_text_bin(lbm_value *args, lbm_uint argn) {
                          utf32,
                          &x_shift,
                          &y_shift,
-                         kern_index);
+                         kern_index,
+                         ix);
       }
       x_n += x_shift;
       y_n += y_shift;
@@ -684,6 +822,16 @@ lbm_value ttf_text_bin(lbm_value *args, lbm_uint argn) {
       //src.mem_base = gfx;
       src.data = gfx;
 
+      int gx = (int)(x_n + left_side_bearing);
+      int gy = (int)y_n;
+      if (up) {
+        image_buffer_mark_dirty(&tgt, x_pos + gy, y_pos - gx - width + 1, height, width);
+      } else if (down) {
+        image_buffer_mark_dirty(&tgt, x_pos - gy - height + 1, y_pos + gx, height, width);
+      } else {
+        image_buffer_mark_dirty(&tgt, x_pos + gx, y_pos + gy, width, height);
+      }
+
       uint32_t num_colors = 1 << src.fmt;
       for (int j = 0; j < src.height; j++) {
         for (int k = 0; k < src.width; k ++) {
@@ -776,6 +924,12 @@ lbm_value ext_ttf_wh(lbm_value *args, lbm_uint argn) {
     return ENC_SYM_EERROR;
   }
 
+  font_index_t font_ix;
+  font_index_t *ix = NULL;
+  if (font_get_index((uint8_t*)font_arr->data, (int32_t)font_arr->size, &font_ix, index)) {
+    ix = &font_ix;
+  }
+
   float x = 0.0;
   float y = 0.0;
   float max_x = 0.0;
@@ -813,7 +967,8 @@ lbm_value ext_ttf_wh(lbm_value *args, lbm_uint argn) {
                        utf32,
                        num_codes,
                        (color_format_t)color_fmt,
-                       glyphs_index)) {
+                       glyphs_index,
+                       ix)) {
 
       float x_shift = 0;
       float y_shift = 0;
@@ -823,7 +978,8 @@ lbm_value ext_ttf_wh(lbm_value *args, lbm_uint argn) {
                          utf32,
                          &x_shift,
                          &y_shift,
-                         kern_index);
+                         kern_index,
+                         ix);
       }
       x_n += x_shift;
     } else {
@@ -870,6 +1026,12 @@ lbm_value ext_ttf_glyph_dims(lbm_value *args, lbm_uint argn) {
       return ENC_SYM_EERROR;
     }
 
+    font_index_t font_ix;
+    font_index_t *ix = NULL;
+    if (font_get_index((uint8_t*)font_arr->data, (int32_t)font_arr->size, &font_ix, index)) {
+      ix = &font_ix;
+    }
+
     lbm_array_header_t *utf8_array_header = (lbm_array_header_t*)(lbm_car(args[1]));
     if (!utf8_array_header) return ENC_SYM_FATAL_ERROR;
 
@@ -894,7 +1056,8 @@ lbm_value ext_ttf_glyph_dims(lbm_value *args, lbm_uint argn) {
                        utf32,
                        num_codes,
                        (color_format_t)color_fmt,
-                       glyphs_index)) {
+                       glyphs_index,
+                       ix)) {
 
       return lbm_heap_allocate_list_init(2,
                                         lbm_enc_u((uint32_t)(width)),
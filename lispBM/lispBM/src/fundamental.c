@@ -27,6 +27,7 @@
 #include "fundamental.h"
 #include "lbm_defrag_mem.h"
 #include "print.h" // printable string?
+#include "lbm_bytecode.h"
 
 #include <stdio.h>
 #include <math.h>
@@ -726,27 +727,15 @@ static lbm_value fundamental_append(lbm_value *args, lbm_uint nargs, eval_contex
 
 static lbm_value fundamental_undefine(lbm_value *args, lbm_uint nargs, eval_context_t *ctx) {
   (void) ctx;
-  lbm_value *global_env = lbm_get_global_env();
   if (nargs == 1 && lbm_is_symbol(args[0])) {
-    lbm_value key = args[0];
-    lbm_uint ix_key = lbm_dec_sym(key) & GLOBAL_ENV_MASK;
-    lbm_value env = global_env[ix_key];
-    lbm_value res = lbm_env_drop_binding(env, key);
-    if (res == ENC_SYM_NOT_FOUND) {
+    if (!lbm_global_env_drop(args[0])) {
       return ENC_SYM_NIL;
     }
-    global_env[ix_key] = res;
     return ENC_SYM_TRUE;
   } else if (nargs == 1 && lbm_is_cons(args[0])) {
     lbm_value curr = args[0];
     while (lbm_type_of(curr) == LBM_TYPE_CONS) {
-      lbm_value key = lbm_car(curr);
-      lbm_uint ix_key = lbm_dec_sym(key) & GLOBAL_ENV_MASK;
-      lbm_value env = global_env[ix_key];
-      lbm_value res = lbm_env_drop_binding(env, key);
-      if (res != ENC_SYM_NOT_FOUND) {
-        global_env[ix_key] = res;
-      }
+      lbm_global_env_drop(lbm_car(curr));
       curr = lbm_cdr(curr);
     }
     return ENC_SYM_TRUE;
@@ -884,6 +873,7 @@ static lbm_value fundamental_set_ix(lbm_value *args, lbm_uint nargs, eval_contex
       lbm_uint size = header->size / sizeof(lbm_value);
       if (index < 0) index = (int32_t)size + index;
       if ((uint32_t)index < size) {
+        lbm_gc_write_barrier(args[0], args[2]);
         arrdata[index] = args[2]; // value
         result = args[0];
       }  // index out of range will be eval error.
@@ -1489,6 +1479,19 @@ static lbm_value fundamental_member(lbm_value *args, lbm_uint argn, eval_context
   return res;
 }
 
+// Returns the closure unchanged if its body cannot be compiled.
+static lbm_value fundamental_compile(lbm_value *args, lbm_uint argn, eval_context_t *ctx) {
+  (void)ctx;
+  lbm_value res = ENC_SYM_TERROR;
+  if (argn == 1 && lbm_is_closure(args[0])) {
+    res = lbm_bytecode_compile(args[0]);
+    if (lbm_is_symbol_nil(res)) {
+      res = args[0];
+    }
+  }
+  return res;
+}
+
 
 const fundamental_fun fundamental_table[] =
   {fundamental_add,
@@ -1559,5 +1562,6 @@ const fundamental_fun fundamental_table[] =
    fundamental_array,
    fundamental_is_string,
    fundamental_is_constant,
-   fundamental_member
+   fundamental_member,
+   fundamental_compile
   };
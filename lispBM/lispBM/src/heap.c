@@ -556,6 +556,7 @@ static int generate_freelist(size_t num_cells) {
 
   // Replace the incorrect pointer at the last cell.
   t = lbm_ref_cell(lbm_enc_cons_ptr(num_cells-1));
+  t->car = ENC_SYM_RECOVERED;
   t->cdr = ENC_SYM_NIL;
 
   return 1;
@@ -582,6 +583,12 @@ static void heap_init_state(lbm_cons_t *addr, lbm_uint num_cells,
   lbm_heap_state.gc_recovered_arrays = 0;
   lbm_heap_state.gc_least_free       = num_cells;
   lbm_heap_state.gc_last_free        = num_cells;
+
+  lbm_heap_state.gc_inc_marks        = NULL;
+  lbm_heap_state.gc_inc_phase        = LBM_GC_INC_IDLE;
+  lbm_heap_state.gc_inc_sweep_ix     = 0;
+  lbm_heap_state.gc_inc_rescan_ix    = 0;
+  lbm_heap_state.gc_inc_overflow     = false;
 }
 
 void lbm_heap_new_freelist_length(void) {
@@ -617,6 +624,7 @@ lbm_value lbm_heap_allocate_cell(lbm_type ptr_type, lbm_value car, lbm_value cdr
     lbm_uint heap_ix = lbm_dec_ptr(cell);
     lbm_heap_state.freelist = lbm_heap_state.heap[heap_ix].cdr;
     lbm_heap_state.num_alloc++;
+    lbm_gc_inc_allocated(heap_ix);
     lbm_heap_state.heap[heap_ix].car = car;
     lbm_heap_state.heap[heap_ix].cdr = cdr;
     r = lbm_set_ptr_type(cell, ptr_type);
@@ -637,6 +645,7 @@ lbm_value lbm_heap_allocate_list(lbm_uint n) {
     lbm_cons_t *c_cell = NULL;
     lbm_uint count = 0;
     do {
+      lbm_gc_inc_allocated(lbm_dec_ptr(curr));
       c_cell = lbm_ref_cell(curr);
       c_cell->car = ENC_SYM_NIL;
       curr = c_cell->cdr;
@@ -661,6 +670,7 @@ lbm_value lbm_heap_allocate_list_init_va(unsigned int n, va_list valist) {
     lbm_cons_t *c_cell = NULL;
     unsigned int count = 0;
     do {
+      lbm_gc_inc_allocated(lbm_dec_ptr(curr));
       c_cell = lbm_ref_cell(curr);
       c_cell->car = va_arg(valist, lbm_value);
       curr = c_cell->cdr;
@@ -713,7 +723,7 @@ static inline void value_assign(lbm_value *a, lbm_value b) {
 #ifdef LBM_USE_GC_PTR_REV
 /* ************************************************************
    Deutch-Schorr-Waite (DSW) pointer reversal GC for 2-ptr cells
-   with a hack-solution for the lisp-array case (n-ptr cells).
+   and lisp arrays (n-ptr cells).
 
    DSW visits each branch node 3 times compared to 2 times for
    the stack based recursive mark.
@@ -727,10 +737,19 @@ static inline void value_assign(lbm_value *a, lbm_value b) {
    is introuded to keep other processes out of the heap while
    marking.
 
-   TODO: See if the extra index field in arrays can be used
-   to mark arrays without resorting to recursive mark calls.
+   Lisp arrays are n-ptr cells. While an array is being marked, the
+   extra index field holds the position of the next element to visit
+   and the element before it holds the reversed pointer. This is the
+   same scheme as used by lbm_ptr_rev_trav, so nested arrays are marked
+   without recursion on the C stack.
 */
 
+static inline bool is_mark_ptr(lbm_value v) {
+  return (lbm_is_ptr(v) &&
+          (lbm_dec_ptr(v) != LBM_PTR_NULL) &&
+          ((v & LBM_PTR_TO_CONSTANT_BIT) == 0) &&
+          ((v & LBM_CONTINUATION_INTERNAL) != LBM_CONTINUATION_INTERNAL));
+}
 
 void lbm_gc_mark_phase_nm(lbm_value root) {
   bool work_to_do = true;
@@ -741,9 +760,7 @@ void lbm_gc_mark_phase_nm(lbm_value root) {
 
   while (work_to_do) {
     // follow leftwards pointers
-    while (lbm_is_ptr(curr) &&
-           (lbm_dec_ptr(curr) != LBM_PTR_NULL) &&
-           ((curr & LBM_PTR_TO_CONSTANT_BIT) == 0) &&
+    while (is_mark_ptr(curr) &&
            !lbm_get_gc_mark(lbm_cdr(curr))) {
       // Mark the cell if not a constant cell
       lbm_cons_t *cell = lbm_ref_cell(curr);
@@ -757,31 +774,45 @@ void lbm_gc_mark_phase_nm(lbm_value root) {
       } else if (lbm_type_of(curr) == LBM_TYPE_LISPARRAY) {
         lbm_array_header_extended_t *arr = (lbm_array_header_extended_t*)cell->car;
         lbm_value *arr_data = (lbm_value *)arr->data;
-        size_t  arr_size = (size_t)arr->size / sizeof(lbm_value);
-        // C stack recursion as deep as there are nested arrays.
-        // TODO: Try to do this without recursion on the C side.
-        for (size_t i = 0; i < arr_size; i ++) {
-          lbm_gc_mark_phase_nm(arr_data[i]);
+        if (arr->size >= sizeof(lbm_value)) {
+          // Step into element 0, it now holds the reversed pointer.
+          arr->index = 1;
+          lbm_value next = 0;
+          value_assign(&next, arr_data[0]);
+          value_assign(&arr_data[0], prev);
+          value_assign(&prev, curr);
+          value_assign(&curr, next);
         }
       }
       // Will jump out next iteration as gc mark is set in curr.
     }
+    // Retreat from conses with both car and cdr visited and from
+    // arrays with all elements visited.
     while (lbm_is_ptr(prev) &&
-           (lbm_dec_ptr(prev) != LBM_PTR_NULL) &&
-           lbm_get_gc_flag(lbm_car(prev)) ) {
-      // clear the flag
+           (lbm_dec_ptr(prev) != LBM_PTR_NULL)) {
       lbm_cons_t *cell = lbm_ref_cell(prev);
-      cell->car = lbm_clr_gc_flag(cell->car);
       lbm_value next = 0;
-      value_assign(&next, cell->cdr);
-      value_assign(&cell->cdr, curr);
+      if (lbm_is_cons(prev)) {
+        if (!lbm_get_gc_flag(cell->car)) break;
+        // clear the flag
+        cell->car = lbm_clr_gc_flag(cell->car);
+        value_assign(&next, cell->cdr);
+        value_assign(&cell->cdr, curr);
+      } else {
+        lbm_array_header_extended_t *arr = (lbm_array_header_extended_t*)cell->car;
+        lbm_value *arr_data = (lbm_value *)arr->data;
+        if (arr->index < arr->size / sizeof(lbm_value)) break;
+        value_assign(&next, arr_data[arr->index-1]);
+        value_assign(&arr_data[arr->index-1], curr);
+        arr->index = 0;
+      }
       value_assign(&curr, prev);
       value_assign(&prev, next);
     }
     if (lbm_is_ptr(prev) &&
         lbm_dec_ptr(prev) == LBM_PTR_NULL) {
       work_to_do = false;
-    } else if (lbm_is_ptr(prev)) {
+    } else if (lbm_is_cons(prev)) {
       // set the flag
       lbm_cons_t *cell = lbm_ref_cell(prev);
       cell->car = lbm_set_gc_flag(cell->car);
@@ -790,6 +821,17 @@ void lbm_gc_mark_phase_nm(lbm_value root) {
       value_assign(&cell->car, curr);
       value_assign(&curr, cell->cdr);
       value_assign(&cell->cdr, next);
+    } else if (lbm_is_ptr(prev)) {
+      // Move on to the next element of the array.
+      lbm_cons_t *cell = lbm_ref_cell(prev);
+      lbm_array_header_extended_t *arr = (lbm_array_header_extended_t*)cell->car;
+      lbm_value *arr_data = (lbm_value *)arr->data;
+      lbm_value next = 0;
+      value_assign(&next, arr_data[arr->index-1]);
+      value_assign(&arr_data[arr->index-1], curr);
+      value_assign(&curr, arr_data[arr->index]);
+      value_assign(&arr_data[arr->index], next);
+      arr->index = arr->index + 1;
     }
   }
 }
@@ -821,12 +863,19 @@ extern eval_context_t *ctx_running;
 void lbm_gc_mark_phase(lbm_value root) {
   lbm_value t_ptr;
   lbm_stack_t *s = &lbm_heap_state.gc_stack;
-  s->data[s->sp++] = root;
+  s->data[s->sp++] = lbm_clr_gc_mark(root);
 
   while (!lbm_stack_is_empty(s)) {
     lbm_value curr;
     lbm_pop(s, &curr);
 
+    // A pointer with the mark bit set is an array that has been
+    // partially marked.
+    if (lbm_is_ptr(curr) && (curr & LBM_GC_MARKED)) {
+      curr = curr & ~LBM_GC_MASK;
+      goto mark_array;
+    }
+
   mark_shortcut:
 
     if (!lbm_is_ptr(curr) ||
@@ -844,33 +893,37 @@ void lbm_gc_mark_phase(lbm_value root) {
 
     // An array is marked in O(N) time using an additional 32bit
     // value per array that keeps track of how far into the array GC
-    // has progressed.
+    // has progressed. The array itself is marked first so that
+    // arrays referring back to themselves are not revisited. While
+    // an element is being marked, the array is kept on the stack
+    // tagged with the mark bit, so nesting costs one stack entry
+    // per level.
     if (t_ptr == LBM_TYPE_LISPARRAY) {
-      lbm_array_header_extended_t *arr = (lbm_array_header_extended_t*)cell->car;
-      lbm_value *arrdata = (lbm_value *)arr->data;
-      uint32_t index = arr->index;
-      if (arr->size > 0) {
-        lbm_push(s, curr); // put array back as bookkeeping.
-        // Potential optimization.
-        // 1. CONS pointers are set to curr and recurse.
-        // 2. Any other ptr is marked immediately and index is increased.
-        if (lbm_is_ptr(arrdata[index]) && ((arrdata[index] & LBM_PTR_TO_CONSTANT_BIT) == 0) &&
-            !((arrdata[index] & LBM_CONTINUATION_INTERNAL) == LBM_CONTINUATION_INTERNAL)) {
-          lbm_cons_t *elt = &lbm_heap_state.heap[lbm_dec_ptr(arrdata[index])];
-          if (!lbm_get_gc_mark(elt->cdr)) {
-            curr = arrdata[index];
+      cell->cdr = lbm_set_gc_mark(cell->cdr);
+      lbm_heap_state.gc_marked ++;
+    mark_array: {
+        lbm_array_header_extended_t *arr = (lbm_array_header_extended_t*)lbm_ref_cell(curr)->car;
+        lbm_value *arrdata = (lbm_value *)arr->data;
+        uint32_t size = (uint32_t)(arr->size / sizeof(lbm_value));
+        while (arr->index < size) {
+          lbm_value elt = arrdata[arr->index++];
+          if (lbm_is_ptr(elt) && ((elt & LBM_PTR_TO_CONSTANT_BIT) == 0) &&
+              !((elt & LBM_CONTINUATION_INTERNAL) == LBM_CONTINUATION_INTERNAL) &&
+              !lbm_get_gc_mark(lbm_heap_state.heap[lbm_dec_ptr(elt)].cdr)) {
+            if (arr->index < size) {
+              if (!lbm_push(s, curr | LBM_GC_MARKED)) {
+                lbm_critical_error();
+                break;
+              }
+            } else {
+              arr->index = 0;
+            }
+            curr = elt;
             goto mark_shortcut;
           }
         }
-        if (index < ((arr->size/(sizeof(lbm_value))) - 1)) {
-          arr->index++;
-          continue;
-        }
         arr->index = 0;
-        lbm_pop(s, &curr); // Remove array from GC stack as we are done marking it.
       }
-      cell->cdr = lbm_set_gc_mark(cell->cdr);
-      lbm_heap_state.gc_marked ++;
       continue;
     } else if (t_ptr == LBM_TYPE_CHANNEL) {
       cell->cdr = lbm_set_gc_mark(cell->cdr);
@@ -889,7 +942,7 @@ void lbm_gc_mark_phase(lbm_value root) {
 
     if (t_ptr == LBM_TYPE_CONS) {
       if (lbm_is_ptr(cell->cdr)) {
-        if (!lbm_push(s, cell->cdr)) {
+        if (!lbm_push(s, lbm_clr_gc_mark(cell->cdr))) {
           lbm_critical_error();
           break;
         }
@@ -938,6 +991,58 @@ void lbm_gc_mark_roots(lbm_uint *roots, lbm_uint num_roots) {
   }
 }
 
+// Free the resources of a non-marked cell and put it on the freelist.
+static void sweep_cell(lbm_cons_t *heap, lbm_uint i) {
+  // Check if this cell is a pointer to an array
+  // and free it.
+  if (lbm_type_of(heap[i].cdr) == LBM_TYPE_SYMBOL) {
+    switch(heap[i].cdr) {
+
+    case ENC_SYM_IND_I_TYPE: /* fall through */
+    case ENC_SYM_IND_U_TYPE:
+    case ENC_SYM_IND_F_TYPE:
+      lbm_memory_free((lbm_uint*)heap[i].car);
+      break;
+    case ENC_SYM_DEFRAG_LISPARRAY_TYPE: /* fall through */
+    case ENC_SYM_DEFRAG_ARRAY_TYPE:
+      lbm_defrag_mem_free((lbm_uint*)heap[i].car);
+      break;
+    case ENC_SYM_LISPARRAY_TYPE: /* fall through */
+    case ENC_SYM_ARRAY_TYPE:{
+      lbm_array_header_t *arr = (lbm_array_header_t*)heap[i].car;
+      lbm_memory_free((lbm_uint *)arr->data);
+      lbm_heap_state.gc_recovered_arrays++;
+      lbm_memory_free((lbm_uint *)arr);
+    } break;
+    case ENC_SYM_CHANNEL_TYPE:{
+      lbm_char_channel_t *chan = (lbm_char_channel_t*)heap[i].car;
+      lbm_memory_free((lbm_uint*)chan->state);
+      lbm_memory_free((lbm_uint*)chan);
+    } break;
+    case ENC_SYM_CUSTOM_TYPE: {
+      lbm_uint *t = (lbm_uint*)heap[i].car;
+      lbm_custom_type_destroy(t);
+      lbm_memory_free(t);
+    } break;
+    case ENC_SYM_DEFRAG_MEM_TYPE: {
+      lbm_uint *ptr = (lbm_uint *)heap[i].car;
+      lbm_defrag_mem_destroy(ptr);
+    } break;
+    default:
+      break;
+    }
+  }
+  // create pointer to use as new freelist
+  lbm_uint addr = lbm_enc_cons_ptr(i);
+
+  // Clear the "freed" cell.
+  heap[i].car = ENC_SYM_RECOVERED;
+  heap[i].cdr = lbm_heap_state.freelist;
+  lbm_heap_state.freelist = addr;
+  lbm_heap_state.num_alloc --;
+  lbm_heap_state.gc_recovered ++;
+}
+
 // Sweep moves non-marked heap objects to the free list.
 int lbm_gc_sweep_phase(void) {
   unsigned int i = 0;
@@ -947,59 +1052,320 @@ int lbm_gc_sweep_phase(void) {
     if ( lbm_get_gc_mark(heap[i].cdr)) {
       heap[i].cdr = lbm_clr_gc_mark(heap[i].cdr);
     } else {
-      // Check if this cell is a pointer to an array
-      // and free it.
-      if (lbm_type_of(heap[i].cdr) == LBM_TYPE_SYMBOL) {
-        switch(heap[i].cdr) {
-
-        case ENC_SYM_IND_I_TYPE: /* fall through */
-        case ENC_SYM_IND_U_TYPE:
-        case ENC_SYM_IND_F_TYPE:
-          lbm_memory_free((lbm_uint*)heap[i].car);
-          break;
-        case ENC_SYM_DEFRAG_LISPARRAY_TYPE: /* fall through */
-        case ENC_SYM_DEFRAG_ARRAY_TYPE:
-          lbm_defrag_mem_free((lbm_uint*)heap[i].car);
-          break;
-        case ENC_SYM_LISPARRAY_TYPE: /* fall through */
-        case ENC_SYM_ARRAY_TYPE:{
-          lbm_array_header_t *arr = (lbm_array_header_t*)heap[i].car;
-          lbm_memory_free((lbm_uint *)arr->data);
-          lbm_heap_state.gc_recovered_arrays++;
-          lbm_memory_free((lbm_uint *)arr);
-        } break;
-        case ENC_SYM_CHANNEL_TYPE:{
-          lbm_char_channel_t *chan = (lbm_char_channel_t*)heap[i].car;
-          lbm_memory_free((lbm_uint*)chan->state);
-          lbm_memory_free((lbm_uint*)chan);
-        } break;
-        case ENC_SYM_CUSTOM_TYPE: {
-          lbm_uint *t = (lbm_uint*)heap[i].car;
-          lbm_custom_type_destroy(t);
-          lbm_memory_free(t);
-          } break;
-        case ENC_SYM_DEFRAG_MEM_TYPE: {
-          lbm_uint *ptr = (lbm_uint *)heap[i].car;
-          lbm_defrag_mem_destroy(ptr);
-          } break;
-        default:
-          break;
-        }
-      }
-      // create pointer to use as new freelist
-      lbm_uint addr = lbm_enc_cons_ptr(i);
-
-      // Clear the "freed" cell.
-      heap[i].car = ENC_SYM_RECOVERED;
-      heap[i].cdr = lbm_heap_state.freelist;
-      lbm_heap_state.freelist = addr;
-      lbm_heap_state.num_alloc --;
-      lbm_heap_state.gc_recovered ++;
+      sweep_cell(heap, i);
     }
   }
   return 1;
 }
 
+/****************************************************/
+/* Incremental GC                                   */
+
+/* The incremental GC marks cells in a bitmap instead of in the cdr, as
+   the evaluator reads and writes cells in between slices of marking.
+   Its stack holds values waiting to be marked. A lisp array that is
+   partially marked takes two entries, the index of the next element
+   below the array value tagged with LBM_GC_MARKED, a bit that plain
+   values never have.
+
+   While marking, a value stored into a marked cell or array is pushed
+   onto the stack (lbm_gc_write_barrier). The roots are marked once more
+   when the stack runs empty, and as values are only ever stored into
+   cells and arrays through the barrier, everything reachable from the
+   roots is then marked.
+
+   A value that does not fit on the stack is dropped and the overflow is
+   recorded. Its parent is marked, so once the stack runs empty the heap
+   is scanned for marked cells and their unmarked children are pushed.
+   The scan starts over if the stack overflows again.
+
+   Sweeping leaves marked cells and cells on the freelist, which all have
+   the car "RECOVERED", in place.
+
+   A cell taken from the freelist may have a mark left from before it was
+   freed, so lbm_gc_inc_allocated decides its mark by phase. While marking
+   the cell is marked and pushed with INC_SCAN_TAG. Its contents are
+   written right after allocation, without the barrier, so they are
+   marked when the entry is popped in a later slice. Ahead of the sweep
+   the cell is marked so that it is not swept and behind the sweep the
+   mark is cleared. */
+
+#define INC_BITS_PER_WORD (sizeof(lbm_uint) * 8)
+#define INC_ARRAY_TAG     LBM_GC_MARKED
+#define INC_SCAN_TAG      LBM_PTR_TO_CONSTANT_BIT
+
+static inline bool inc_marked(lbm_uint ix) {
+  return (lbm_heap_state.gc_inc_marks[ix / INC_BITS_PER_WORD] >> (ix % INC_BITS_PER_WORD)) & 1;
+}
+
+static inline void inc_set_mark(lbm_uint ix) {
+  lbm_heap_state.gc_inc_marks[ix / INC_BITS_PER_WORD] |= ((lbm_uint)1) << (ix % INC_BITS_PER_WORD);
+}
+
+static inline void inc_clr_mark(lbm_uint ix) {
+  lbm_heap_state.gc_inc_marks[ix / INC_BITS_PER_WORD] &= ~(((lbm_uint)1) << (ix % INC_BITS_PER_WORD));
+}
+
+static inline bool inc_is_heap_ptr(lbm_value v) {
+  return lbm_is_ptr(v) &&
+    !(v & LBM_PTR_TO_CONSTANT_BIT) &&
+    lbm_dec_ptr(v) < lbm_heap_state.heap_size;
+}
+
+static inline void inc_push(lbm_uint v) {
+  if (!lbm_push(&lbm_heap_state.gc_inc_stack, v)) {
+    lbm_heap_state.gc_inc_overflow = true;
+  }
+}
+
+// Both entries of a partially marked array, or neither.
+static inline void inc_push_array(lbm_value arr_v, lbm_uint i) {
+  lbm_stack_t *s = &lbm_heap_state.gc_inc_stack;
+  if (s->sp + 2 > s->size) {
+    lbm_heap_state.gc_inc_overflow = true;
+  } else {
+    lbm_push(s, i);
+    lbm_push(s, arr_v | INC_ARRAY_TAG);
+  }
+}
+
+bool lbm_gc_inc_init(void) {
+  if (lbm_heap_state.gc_inc_marks) return true;
+  lbm_uint num_words = (lbm_heap_state.heap_size + INC_BITS_PER_WORD - 1) / INC_BITS_PER_WORD;
+  lbm_uint stack_size = lbm_heap_state.gc_stack.size;
+  lbm_uint *marks = (lbm_uint*)lbm_malloc(num_words * sizeof(lbm_uint));
+  lbm_uint *stack = (lbm_uint*)lbm_malloc(stack_size * sizeof(lbm_uint));
+  if (marks == NULL || stack == NULL) {
+    lbm_free(marks);
+    lbm_free(stack);
+    return false;
+  }
+  lbm_stack_create(&lbm_heap_state.gc_inc_stack, stack, stack_size);
+  lbm_heap_state.gc_inc_marks = marks;
+  lbm_heap_state.gc_inc_phase = LBM_GC_INC_IDLE;
+  return true;
+}
+
+void lbm_gc_inc_begin(void) {
+  lbm_uint num_words = (lbm_heap_state.heap_size + INC_BITS_PER_WORD - 1) / INC_BITS_PER_WORD;
+  memset(lbm_heap_state.gc_inc_marks, 0, num_words * sizeof(lbm_uint));
+  lbm_heap_state.gc_inc_stack.sp = 0;
+  lbm_heap_state.gc_inc_rescan_ix = 0;
+  lbm_heap_state.gc_inc_overflow = false;
+  lbm_gc_state_inc();
+  lbm_heap_state.gc_inc_phase = LBM_GC_INC_MARK;
+}
+
+void lbm_gc_inc_abort(void) {
+  lbm_heap_state.gc_inc_phase = LBM_GC_INC_IDLE;
+}
+
+void lbm_gc_inc_push(lbm_value v) {
+  v = v & ~LBM_GC_MASK;
+  if (inc_is_heap_ptr(v) && !inc_marked(lbm_dec_ptr(v))) {
+    inc_push(v);
+  }
+}
+
+void lbm_gc_inc_shade(lbm_value target, lbm_value v) {
+  if (inc_is_heap_ptr(target) && inc_marked(lbm_dec_ptr(target))) {
+    lbm_gc_inc_push(v);
+  }
+}
+
+void lbm_gc_inc_alloc_cell(lbm_uint ix) {
+  if (lbm_heap_state.gc_inc_phase == LBM_GC_INC_MARK) {
+    inc_set_mark(ix);
+    inc_push(lbm_enc_cons_ptr(ix) | INC_SCAN_TAG);
+  } else if (ix >= lbm_heap_state.gc_inc_sweep_ix) {
+    inc_set_mark(ix);
+  } else {
+    inc_clr_mark(ix);
+  }
+}
+
+// Mark v and follow car pointers while the budget lasts. Cdrs are pushed
+// and so are lisp arrays, to have their elements marked one at a time.
+static lbm_uint inc_mark_value(lbm_value v, lbm_uint budget) {
+  while (inc_is_heap_ptr(v)) {
+    lbm_uint ix = lbm_dec_ptr(v);
+    if (inc_marked(ix)) break;
+    if (budget == 0) {
+      inc_push(v & ~INC_ARRAY_TAG);
+      break;
+    }
+    budget --;
+    inc_set_mark(ix);
+    lbm_heap_state.gc_marked ++;
+    lbm_cons_t *cell = &lbm_heap_state.heap[ix];
+    lbm_type t = lbm_type_of(v);
+    if (t == LBM_TYPE_CONS) {
+      lbm_value cdr = lbm_clr_gc_mark(cell->cdr);
+      if (inc_is_heap_ptr(cdr)) inc_push(cdr);
+      v = lbm_clr_gc_flag(cell->car);
+    } else if (t == LBM_TYPE_LISPARRAY) {
+      inc_push_array(v, 0);
+      break;
+    } else if (t == LBM_TYPE_CHANNEL && cell->car != ENC_SYM_NIL) {
+      lbm_char_channel_t *chan = (lbm_char_channel_t *)cell->car;
+      v = chan->dependency;
+    } else {
+      break;
+    }
+  }
+  return budget;
+}
+
+// Continue marking the elements of a lisp array from index i. The first
+// element that needs marking is marked depth first, with the rest of the
+// array pushed below it.
+static lbm_uint inc_mark_array(lbm_value arr_v, lbm_uint i, lbm_uint budget) {
+  lbm_array_header_t *arr = (lbm_array_header_t*)lbm_heap_state.heap[lbm_dec_ptr(arr_v)].car;
+  lbm_value *data = (lbm_value*)arr->data;
+  lbm_uint n = arr->size / sizeof(lbm_value);
+  while (i < n) {
+    if (budget == 0) {
+      inc_push_array(arr_v, i);
+      break;
+    }
+    budget --;
+    lbm_value v = data[i++];
+    if (inc_is_heap_ptr(v) &&
+        !((v & LBM_CONTINUATION_INTERNAL) == LBM_CONTINUATION_INTERNAL) &&
+        !inc_marked(lbm_dec_ptr(v))) {
+      if (i < n) {
+        inc_push_array(arr_v, i);
+      }
+      return inc_mark_value(v, budget);
+    }
+  }
+  return budget;
+}
+
+// Mark the contents of a cell that was marked when it was allocated. The
+// kind of cell is told from the cdr, as in sweep_cell.
+static lbm_uint inc_scan_cell(lbm_uint ix, lbm_uint budget) {
+  lbm_cons_t *cell = &lbm_heap_state.heap[ix];
+  budget --;
+  switch (cell->cdr) {
+  case ENC_SYM_LISPARRAY_TYPE:
+    return inc_mark_array(lbm_enc_cons_ptr(ix), 0, budget);
+  case ENC_SYM_CHANNEL_TYPE:
+    if (cell->car != ENC_SYM_NIL) {
+      lbm_gc_inc_push(((lbm_char_channel_t *)cell->car)->dependency);
+    }
+    break;
+  case ENC_SYM_IND_I_TYPE: /* fall through */
+  case ENC_SYM_IND_U_TYPE:
+  case ENC_SYM_IND_F_TYPE:
+  case ENC_SYM_ARRAY_TYPE:
+  case ENC_SYM_DEFRAG_ARRAY_TYPE:
+  case ENC_SYM_DEFRAG_LISPARRAY_TYPE:
+  case ENC_SYM_CUSTOM_TYPE:
+  case ENC_SYM_DEFRAG_MEM_TYPE:
+    break;
+  default:
+    lbm_gc_inc_push(cell->cdr);
+    lbm_gc_inc_push(lbm_clr_gc_flag(cell->car));
+    break;
+  }
+  return budget;
+}
+
+// Scan marked cells for unmarked children after an overflow. The scan
+// pauses as soon as something is pushed, to keep the stack short.
+static lbm_uint inc_rescan(lbm_uint budget) {
+  lbm_cons_t *heap = lbm_heap_state.heap;
+  lbm_uint i = lbm_heap_state.gc_inc_rescan_ix;
+  if (i == 0) lbm_heap_state.gc_inc_overflow = false;
+  while (budget > 0 && lbm_stack_is_empty(&lbm_heap_state.gc_inc_stack)) {
+    if (i >= lbm_heap_state.heap_size) {
+      i = 0;
+      break;
+    }
+    if (inc_marked(i) && heap[i].car != ENC_SYM_RECOVERED) {
+      budget = inc_scan_cell(i, budget);
+    } else {
+      budget --;
+    }
+    i ++;
+  }
+  lbm_heap_state.gc_inc_rescan_ix = i;
+  return budget;
+}
+
+static inline bool inc_rescan_pending(void) {
+  return lbm_heap_state.gc_inc_overflow || lbm_heap_state.gc_inc_rescan_ix > 0;
+}
+
+bool lbm_gc_inc_mark(lbm_uint *budget) {
+  lbm_stack_t *s = &lbm_heap_state.gc_inc_stack;
+  lbm_uint b = *budget;
+  while (b > 0) {
+    if (lbm_stack_is_empty(s)) {
+      if (!inc_rescan_pending()) break;
+      b = inc_rescan(b);
+      continue;
+    }
+    lbm_value v;
+    lbm_pop(s, &v);
+    if (v & INC_ARRAY_TAG) {
+      lbm_uint i;
+      lbm_pop(s, &i);
+      b = inc_mark_array(v & ~INC_ARRAY_TAG, i, b);
+    } else if (v & INC_SCAN_TAG) {
+      b = inc_scan_cell(lbm_dec_ptr(v & ~INC_SCAN_TAG), b);
+    } else {
+      b = inc_mark_value(v, b);
+    }
+  }
+  *budget = b;
+  return lbm_stack_is_empty(s) && !inc_rescan_pending();
+}
+
+void lbm_gc_inc_mark_root(lbm_value v) {
+  lbm_gc_inc_push(v);
+  lbm_uint budget;
+  do {
+    budget = lbm_heap_state.heap_size;
+  } while (!lbm_gc_inc_mark(&budget));
+}
+
+void lbm_gc_inc_mark_aux(lbm_uint *data, lbm_uint n) {
+  for (lbm_uint i = 0; i < n; i ++) {
+    if (lbm_is_ptr(data[i])) {
+      lbm_type pt_t = lbm_type_of(data[i]);
+      if (pt_t >= LBM_POINTER_TYPE_FIRST &&
+          pt_t <= LBM_POINTER_TYPE_LAST) {
+        lbm_gc_inc_mark_root(data[i]);
+      }
+    }
+  }
+}
+
+void lbm_gc_inc_start_sweep(void) {
+  lbm_heap_state.gc_inc_sweep_ix = 0;
+  lbm_heap_state.gc_inc_phase = LBM_GC_INC_SWEEP;
+}
+
+bool lbm_gc_inc_sweep(lbm_uint budget) {
+  lbm_cons_t *heap = lbm_heap_state.heap;
+  lbm_uint i = lbm_heap_state.gc_inc_sweep_ix;
+  lbm_uint end = lbm_heap_state.heap_size;
+  if (end - i > budget) end = i + budget;
+  for (; i < end; i ++) {
+    if (!inc_marked(i) && heap[i].car != ENC_SYM_RECOVERED) {
+      sweep_cell(heap, i);
+    }
+  }
+  lbm_heap_state.gc_inc_sweep_ix = i;
+  if (i >= lbm_heap_state.heap_size) {
+    lbm_heap_state.gc_inc_phase = LBM_GC_INC_IDLE;
+    return true;
+  }
+  return false;
+}
+
 void lbm_gc_state_inc(void) {
   lbm_heap_state.gc_num ++;
   lbm_heap_state.gc_recovered = 0;
@@ -1069,6 +1435,7 @@ int lbm_set_car(lbm_value c, lbm_value v) {
 
   if (lbm_type_of(c) == LBM_TYPE_CONS) {
     lbm_cons_t *cell = lbm_ref_cell(c);
+    lbm_gc_write_barrier(c, v);
     cell->car = v;
     r = 1;
   }
@@ -1079,6 +1446,7 @@ int lbm_set_cdr(lbm_value c, lbm_value v) {
   int r = 0;
   if (lbm_is_cons_rw(c)){
     lbm_cons_t *cell = lbm_ref_cell(c);
+    lbm_gc_write_barrier(c, v);
     cell->cdr = v;
     r = 1;
   }
@@ -1089,6 +1457,8 @@ int lbm_set_car_and_cdr(lbm_value c, lbm_value car_val, lbm_value cdr_val) {
   int r = 0;
   if (lbm_is_cons_rw(c)) {
     lbm_cons_t *cell = lbm_ref_cell(c);
+    lbm_gc_write_barrier(c, car_val);
+    lbm_gc_write_barrier(c, cdr_val);
     cell->car = car_val;
     cell->cdr = cdr_val;
     r = 1;
@@ -0,0 +1,470 @@
+/*
+    Copyright 2026 Joel Svensson  svenssonjoel@yahoo.se
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+
+#include "lbm_bytecode.h"
+#include "lbm_defines.h"
+#include "lbm_memory.h"
+#include "heap.h"
+#include "env.h"
+
+// The compiler emits into fixed size buffers and allocates nothing on the
+// heap until the code is complete, so the GC cannot run while values are
+// held only in the buffers.
+typedef struct {
+  uint8_t code[LBM_BYTECODE_MAX_CODE];
+  lbm_uint pc;
+  lbm_value consts[LBM_BYTECODE_MAX_CONSTS];
+  lbm_uint num_consts;
+  lbm_value globals[LBM_BYTECODE_MAX_GLOBALS];
+  lbm_uint num_globals;
+  lbm_value locals[LBM_BYTECODE_MAX_LOCALS]; // Symbol bound in each slot.
+  lbm_uint num_locals;
+  lbm_uint max_locals;
+  lbm_value env;                             // Environment of the closure.
+  bool ok;
+} compiler_t;
+
+// End of a chain of jumps that are patched together.
+#define NO_JUMP 0xFFFF
+
+static void compile_exp(compiler_t *c, lbm_value exp, bool tail);
+
+static void emit(compiler_t *c, uint8_t b) {
+  if (c->pc < LBM_BYTECODE_MAX_CODE - BC_TRAILER_SIZE) {
+    c->code[c->pc++] = b;
+  } else {
+    c->ok = false;
+  }
+}
+
+static void emit_op(compiler_t *c, uint8_t op, lbm_uint arg) {
+  if (arg > 0xFF) {
+    c->ok = false;
+    return;
+  }
+  emit(c, op);
+  emit(c, (uint8_t)arg);
+}
+
+// Emit a jump to the address link and return the position of the jump
+// so that it can be patched, or linked into a chain of jumps.
+static lbm_uint emit_jump(compiler_t *c, uint8_t op, lbm_uint link) {
+  lbm_uint pos = c->pc;
+  emit(c, op);
+  emit(c, (uint8_t)(link & 0xFF));
+  emit(c, (uint8_t)(link >> 8));
+  return pos;
+}
+
+// Point a chain of jumps to the current position.
+static void patch_jumps(compiler_t *c, lbm_uint pos) {
+  while (c->ok && pos != NO_JUMP) {
+    lbm_uint next = (lbm_uint)c->code[pos + 1] | ((lbm_uint)c->code[pos + 2] << 8);
+    c->code[pos + 1] = (uint8_t)(c->pc & 0xFF);
+    c->code[pos + 2] = (uint8_t)(c->pc >> 8);
+    pos = next;
+  }
+}
+
+static lbm_uint add_const(compiler_t *c, lbm_value v) {
+  for (lbm_uint i = 0; i < c->num_consts; i ++) {
+    if (c->consts[i] == v) return BC_CONST_FIRST + i;
+  }
+  if (c->num_consts == LBM_BYTECODE_MAX_CONSTS) {
+    c->ok = false;
+    return 0;
+  }
+  c->consts[c->num_consts] = v;
+  return BC_CONST_FIRST + c->num_consts++;
+}
+
+static lbm_uint add_global(compiler_t *c, lbm_value sym) {
+  for (lbm_uint i = 0; i < c->num_globals; i ++) {
+    if (c->globals[i] == sym) return i;
+  }
+  if (c->num_globals == LBM_BYTECODE_MAX_GLOBALS) {
+    c->ok = false;
+    return 0;
+  }
+  c->globals[c->num_globals] = sym;
+  return c->num_globals++;
+}
+
+static int find_local(compiler_t *c, lbm_value sym) {
+  for (int i = (int)c->num_locals - 1; i >= 0; i --) {
+    if (c->locals[i] == sym) return i;
+  }
+  return -1;
+}
+
+static lbm_uint push_local(compiler_t *c, lbm_value sym) {
+  if (!lbm_is_symbol(sym) || lbm_dec_sym(sym) < RUNTIME_SYMBOLS_START ||
+      c->num_locals == LBM_BYTECODE_MAX_LOCALS) {
+    c->ok = false;
+    return 0;
+  }
+  c->locals[c->num_locals] = sym;
+  c->num_locals ++;
+  if (c->num_locals > c->max_locals) c->max_locals = c->num_locals;
+  return c->num_locals - 1;
+}
+
+// The binding cell of sym in the closure environment. Cells that hold a
+// placeholder are returned too, they are filled in by let before the
+// closure is called.
+static lbm_value find_cell(compiler_t *c, lbm_value sym) {
+  lbm_value curr = c->env;
+  while (lbm_is_cons(curr)) {
+    lbm_value b = lbm_car(curr);
+    if (lbm_is_cons(b) && lbm_car(b) == sym) return b;
+    curr = lbm_cdr(curr);
+  }
+  return ENC_SYM_NIL;
+}
+
+typedef enum {
+  VAR_LOCAL,
+  VAR_CELL,
+  VAR_GLOBAL
+} var_kind_t;
+
+static var_kind_t resolve_var(compiler_t *c, lbm_value sym, lbm_uint *ix) {
+  int n = find_local(c, sym);
+  if (n >= 0) {
+    *ix = (lbm_uint)n;
+    return VAR_LOCAL;
+  }
+  lbm_value cell = find_cell(c, sym);
+  if (lbm_is_cons(cell)) {
+    *ix = add_const(c, cell);
+    return VAR_CELL;
+  }
+  *ix = add_global(c, sym);
+  return VAR_GLOBAL;
+}
+
+static void compile_symbol(compiler_t *c, lbm_value sym) {
+  if (lbm_dec_sym(sym) < RUNTIME_SYMBOLS_START) {
+    emit_op(c, BC_CONST, add_const(c, sym));
+    return;
+  }
+  lbm_uint ix;
+  switch (resolve_var(c, sym, &ix)) {
+  case VAR_LOCAL:  emit_op(c, BC_LOCAL, ix); break;
+  case VAR_CELL:   emit_op(c, BC_CELL, ix); break;
+  case VAR_GLOBAL: emit_op(c, BC_GLOBAL, ix); break;
+  }
+}
+
+// Compile the elements of a list and return how many there were.
+static lbm_uint compile_args(compiler_t *c, lbm_value args) {
+  lbm_uint n = 0;
+  while (lbm_is_cons(args)) {
+    compile_exp(c, lbm_car(args), false);
+    args = lbm_cdr(args);
+    n ++;
+  }
+  if (!lbm_is_symbol_nil(args)) c->ok = false;
+  return n;
+}
+
+static bool is_macro(lbm_value v) {
+  return lbm_is_cons(v) && lbm_car(v) == ENC_SYM_MACRO;
+}
+
+// (f arg ...)
+static void compile_application(compiler_t *c, lbm_value exp, bool tail) {
+  lbm_value fun = lbm_car(exp);
+  lbm_value args = lbm_cdr(exp);
+  if (lbm_is_symbol(fun)) {
+    lbm_uint s = lbm_dec_sym(fun);
+    switch (SYMBOL_KIND(s)) {
+    case SYMBOL_KIND_FUNDAMENTAL: {
+      lbm_uint n = compile_args(c, args);
+      emit_op(c, BC_FUND, SYMBOL_IX(s));
+      if (n > 0xFF) c->ok = false;
+      emit(c, (uint8_t)n);
+      return;
+    }
+    case SYMBOL_KIND_APPFUN:
+      // These use the local environment, which compiled code does not have.
+      if (s == SYM_SETVAR || s == SYM_EVAL || s == SYM_EVAL_PROGRAM ||
+          s == SYM_READ_AND_EVAL_PROGRAM || s == SYM_REST_ARGS) {
+        c->ok = false;
+        return;
+      }
+      break;
+    default:
+      if (s >= RUNTIME_SYMBOLS_START && find_local(c, fun) < 0) {
+        // Macros are expanded at application, which the compiled code
+        // would skip.
+        lbm_value cell = find_cell(c, fun);
+        lbm_value v = ENC_SYM_NIL;
+        if ((lbm_is_cons(cell) && is_macro(lbm_cdr(cell))) ||
+            (!lbm_is_cons(cell) && lbm_global_env_lookup(&v, fun) && is_macro(v))) {
+          c->ok = false;
+          return;
+        }
+      }
+      break;
+    }
+  }
+  compile_exp(c, fun, false);
+  lbm_uint n = compile_args(c, args);
+  emit_op(c, tail ? BC_TAIL : BC_CALL, n);
+}
+
+// (progn exp ...) with (var sym exp) bindings at the top level.
+static void compile_progn(compiler_t *c, lbm_value exps, bool tail) {
+  if (!lbm_is_cons(exps)) {
+    emit_op(c, BC_CONST, add_const(c, ENC_SYM_NIL));
+    return;
+  }
+  lbm_uint saved = c->num_locals;
+  while (lbm_is_cons(exps)) {
+    lbm_value e = lbm_car(exps);
+    bool last = !lbm_is_cons(lbm_cdr(exps));
+    if (lbm_is_cons(e) && lbm_car(e) == ENC_SYM_PROGN_VAR) {
+      lbm_value parts = lbm_cdr(e);
+      compile_exp(c, lbm_car(lbm_cdr(parts)), false);
+      lbm_uint n = push_local(c, lbm_car(parts));
+      emit_op(c, last ? BC_SET_LOCAL : BC_STORE, n);
+    } else {
+      compile_exp(c, e, last && tail);
+      if (!last) emit(c, BC_POP);
+    }
+    exps = lbm_cdr(exps);
+  }
+  c->num_locals = saved;
+}
+
+// Bind ((sym exp) ...) to new local slots. Each exp sees the bindings
+// before it, as when let evaluates it.
+static void compile_bindings(compiler_t *c, lbm_value binds) {
+  while (lbm_is_cons(binds)) {
+    lbm_value b = lbm_car(binds);
+    if (!lbm_is_cons(b)) {
+      c->ok = false;
+      return;
+    }
+    compile_exp(c, lbm_car(lbm_cdr(b)), false);
+    emit_op(c, BC_STORE, push_local(c, lbm_car(b)));
+    binds = lbm_cdr(binds);
+  }
+}
+
+// (let ((sym exp) ...) body)
+static void compile_let(compiler_t *c, lbm_value parts, bool tail) {
+  lbm_uint saved = c->num_locals;
+  compile_bindings(c, lbm_car(parts));
+  compile_exp(c, lbm_car(lbm_cdr(parts)), tail);
+  c->num_locals = saved;
+}
+
+// (loop ((sym exp) ...) cond body)
+static void compile_loop(compiler_t *c, lbm_value parts) {
+  lbm_uint saved = c->num_locals;
+  compile_bindings(c, lbm_car(parts));
+  lbm_uint top = c->pc;
+  compile_exp(c, lbm_car(lbm_cdr(parts)), false);
+  lbm_uint exit = emit_jump(c, BC_JMP_NIL, NO_JUMP);
+  compile_exp(c, lbm_car(lbm_cdr(lbm_cdr(parts))), false);
+  emit(c, BC_POP);
+  emit_jump(c, BC_JMP, top);
+  patch_jumps(c, exit);
+  emit_op(c, BC_CONST, add_const(c, ENC_SYM_NIL));
+  c->num_locals = saved;
+}
+
+// (if cond then else)
+static void compile_if(compiler_t *c, lbm_value parts, bool tail) {
+  compile_exp(c, lbm_car(parts), false);
+  lbm_uint else_jump = emit_jump(c, BC_JMP_NIL, NO_JUMP);
+  parts = lbm_cdr(parts);
+  compile_exp(c, lbm_car(parts), tail);
+  lbm_uint end_jump = emit_jump(c, BC_JMP, NO_JUMP);
+  patch_jumps(c, else_jump);
+  compile_exp(c, lbm_car(lbm_cdr(parts)), tail);
+  patch_jumps(c, end_jump);
+}
+
+// (cond (cond exp) ...)
+static void compile_cond(compiler_t *c, lbm_value clauses, bool tail) {
+  lbm_uint end_jumps = NO_JUMP;
+  while (lbm_is_cons(clauses)) {
+    lbm_value clause = lbm_car(clauses);
+    if (lbm_list_length(clause) != 2) {
+      c->ok = false;
+      return;
+    }
+    compile_exp(c, lbm_car(clause), false);
+    lbm_uint next = emit_jump(c, BC_JMP_NIL, NO_JUMP);
+    compile_exp(c, lbm_car(lbm_cdr(clause)), tail);
+    end_jumps = emit_jump(c, BC_JMP, end_jumps);
+    patch_jumps(c, next);
+    clauses = lbm_cdr(clauses);
+  }
+  emit_op(c, BC_CONST, add_const(c, ENC_SYM_NIL));
+  patch_jumps(c, end_jumps);
+}
+
+// (and exp ...) and (or exp ...)
+static void compile_and_or(compiler_t *c, lbm_value exps, uint8_t op, lbm_value empty, bool tail) {
+  if (!lbm_is_cons(exps)) {
+    emit_op(c, BC_CONST, add_const(c, empty));
+    return;
+  }
+  lbm_uint end_jumps = NO_JUMP;
+  while (lbm_is_cons(exps)) {
+    bool last = !lbm_is_cons(lbm_cdr(exps));
+    compile_exp(c, lbm_car(exps), last && tail);
+    if (!last) end_jumps = emit_jump(c, op, end_jumps);
+    exps = lbm_cdr(exps);
+  }
+  patch_jumps(c, end_jumps);
+}
+
+// (setq sym exp)
+static void compile_setq(compiler_t *c, lbm_value parts) {
+  lbm_value sym = lbm_car(parts);
+  if (!lbm_is_symbol(sym) || lbm_dec_sym(sym) < RUNTIME_SYMBOLS_START) {
+    c->ok = false;
+    return;
+  }
+  compile_exp(c, lbm_car(lbm_cdr(parts)), false);
+  lbm_uint ix;
+  switch (resolve_var(c, sym, &ix)) {
+  case VAR_LOCAL:  emit_op(c, BC_SET_LOCAL, ix); break;
+  case VAR_CELL:   emit_op(c, BC_SET_CELL, ix); break;
+  case VAR_GLOBAL: emit_op(c, BC_SET_GLOBAL, ix); break;
+  }
+}
+
+static void compile_exp(compiler_t *c, lbm_value exp, bool tail) {
+  if (!c->ok) return;
+  if (lbm_is_symbol(exp)) {
+    compile_symbol(c, exp);
+  } else if (lbm_is_cons(exp)) {
+    lbm_value head = lbm_car(exp);
+    lbm_value rest = lbm_cdr(exp);
+    if (lbm_is_symbol(head) &&
+        (lbm_dec_sym(head) & SPECIAL_FORMS_MASK) == SPECIAL_FORMS_BIT) {
+      switch (lbm_dec_sym(head)) {
+      case SYM_QUOTE: emit_op(c, BC_CONST, add_const(c, lbm_car(rest))); break;
+      case SYM_IF:    compile_if(c, rest, tail); break;
+      case SYM_COND:  compile_cond(c, rest, tail); break;
+      case SYM_AND:   compile_and_or(c, rest, BC_AND, ENC_SYM_TRUE, tail); break;
+      case SYM_OR:    compile_and_or(c, rest, BC_OR, ENC_SYM_NIL, tail); break;
+      case SYM_PROGN: compile_progn(c, rest, tail); break;
+      case SYM_LET:   compile_let(c, rest, tail); break;
+      case SYM_LOOP:  compile_loop(c, rest); break;
+      case SYM_SETQ:  compile_setq(c, rest); break;
+      default:        c->ok = false; break;
+      }
+    } else {
+      compile_application(c, exp, tail);
+    }
+  } else {
+    emit_op(c, BC_CONST, add_const(c, exp));
+  }
+}
+
+bool lbm_bytecode_is_compiled(lbm_value closure) {
+  if (!lbm_is_closure(closure)) return false;
+  lbm_value body = lbm_car(lbm_cdr(lbm_cdr(closure)));
+  return lbm_is_cons(body) && lbm_car(body) == ENC_SYM_BYTECODE;
+}
+
+static lbm_value build_closure(compiler_t *c, lbm_value params) {
+  lbm_value code;
+  if (!lbm_heap_allocate_array(&code, c->pc)) return ENC_SYM_MERROR;
+  memcpy(lbm_heap_array_get_data_rw(code), c->code, c->pc);
+
+  lbm_value cells;
+  if (!lbm_heap_allocate_array(&cells, c->num_globals * sizeof(lbm_value))) return ENC_SYM_MERROR;
+  lbm_value *cell_data = (lbm_value*)lbm_heap_array_get_data_rw(cells);
+  for (lbm_uint i = 0; i < c->num_globals; i ++) {
+    cell_data[i] = ENC_SYM_NIL;
+  }
+
+  lbm_uint num_consts = BC_CONST_FIRST + c->num_consts + c->num_globals;
+  lbm_value consts;
+  if (!lbm_heap_allocate_lisp_array(&consts, num_consts)) return ENC_SYM_MERROR;
+  lbm_value *data = (lbm_value*)lbm_dec_lisp_array_rw(consts)->data;
+  lbm_uint ix = 0;
+  data[ix++] = ENC_SYM_NIL; // No token, the cells are looked up at first use.
+  data[ix++] = params;
+  data[ix++] = cells;
+  lbm_gc_write_barrier(consts, params);
+  lbm_gc_write_barrier(consts, cells);
+  for (lbm_uint i = 0; i < c->num_consts; i ++) {
+    lbm_gc_write_barrier(consts, c->consts[i]);
+    data[ix++] = c->consts[i];
+  }
+  for (lbm_uint i = 0; i < c->num_globals; i ++) {
+    data[ix++] = c->globals[i];
+  }
+
+  lbm_value body = lbm_heap_allocate_list_init(3, ENC_SYM_BYTECODE, code, consts);
+  if (lbm_is_symbol_merror(body)) return body;
+  return lbm_heap_allocate_list_init(4, ENC_SYM_CLOSURE, params, body, c->env);
+}
+
+lbm_value lbm_bytecode_compile(lbm_value closure) {
+  if (lbm_bytecode_is_compiled(closure)) return closure;
+  if (!lbm_is_closure(closure)) return ENC_SYM_NIL;
+
+  compiler_t *c = (compiler_t*)lbm_malloc(sizeof(compiler_t));
+  if (!c) return ENC_SYM_MERROR;
+  memset(c, 0, sizeof(compiler_t));
+  c->ok = true;
+
+  lbm_value parts = lbm_cdr(closure);
+  lbm_value params = lbm_car(parts);
+  lbm_value body = lbm_car(lbm_cdr(parts));
+  c->env = lbm_car(lbm_cdr(lbm_cdr(parts)));
+
+  lbm_uint num_params = 0;
+  lbm_value curr = params;
+  while (lbm_is_cons(curr)) {
+    lbm_value p = lbm_car(curr);
+    if (find_local(c, p) >= 0) c->ok = false;
+    push_local(c, p);
+    num_params ++;
+    curr = lbm_cdr(curr);
+  }
+  if (!lbm_is_symbol_nil(curr)) c->ok = false;
+
+  c->pc = BC_HEADER_SIZE;
+  compile_exp(c, body, true);
+  emit(c, BC_RET);
+
+  lbm_value res = ENC_SYM_NIL;
+  if (c->ok) {
+    for (int i = 0; i < BC_TRAILER_SIZE; i ++) {
+      c->code[c->pc++] = BC_RET;
+    }
+    c->code[BC_HEADER_NUM_PARAMS] = (uint8_t)num_params;
+    c->code[BC_HEADER_NUM_LOCALS] = (uint8_t)c->max_locals;
+    c->code[BC_HEADER_GLOBALS] = (uint8_t)(BC_CONST_FIRST + c->num_consts);
+    res = build_closure(c, params);
+  }
+  lbm_free(c);
+  return res;
+}
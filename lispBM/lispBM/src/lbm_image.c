@@ -680,8 +680,9 @@ lbm_uint *lbm_image_add_and_link_symbol(char *name, lbm_uint id, lbm_uint symlis
 
 bool lbm_image_save_global_env(void) {
   lbm_value *env = lbm_get_global_env();
+  lbm_uint roots = lbm_get_global_env_roots();
   if (env) {
-    for (int i = 0; i < GLOBAL_ENV_ROOTS; i ++) {
+    for (lbm_uint i = 0; i < roots; i ++) {
       lbm_value curr = env[i];
       while(lbm_is_cons(curr)) {
         lbm_value name_field = lbm_caar(curr);
@@ -871,15 +872,9 @@ bool lbm_image_boot(void) {
       lbm_uint bind_val = read_u32(pos-1);
       pos -= 2;
 #endif
-      lbm_uint ix_key  = lbm_dec_sym(bind_key) & GLOBAL_ENV_MASK;
-      lbm_value *global_env = lbm_get_global_env();
-      lbm_uint orig_env = global_env[ix_key];
-      lbm_value new_env = lbm_env_set(orig_env,bind_key,bind_val);
-
-      if (lbm_is_symbol(new_env)) {
+      if (lbm_is_symbol_merror(lbm_global_env_set(bind_key,bind_val))) {
         return false;
       }
-      global_env[ix_key] = new_env;
     } break;
     case BINDING_FLAT: {
       // on 64 bit           | on 32 bit
@@ -909,15 +904,9 @@ bool lbm_image_boot(void) {
         lbm_unflatten_value(&fv, &unflattened);
       }
 
-      lbm_uint ix_key  = lbm_dec_sym(bind_key) & GLOBAL_ENV_MASK;
-      lbm_value *global_env = lbm_get_global_env();
-      lbm_uint orig_env = global_env[ix_key];
-      lbm_value new_env = lbm_env_set(orig_env,bind_key,unflattened);
-
-      if (lbm_is_symbol(new_env)) {
+      if (lbm_is_symbol_merror(lbm_global_env_set(bind_key,unflattened))) {
         return false;
       }
-      global_env[ix_key] = new_env;
       pos --;
     } break;
     case SYMBOL_ENTRY: {
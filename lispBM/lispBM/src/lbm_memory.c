@@ -32,12 +32,9 @@ void lbm_request_gc(void);
 #define START         2  //10b
 #define START_END     3  //11b
 
-/* States in memory_allocate state-machine*/
-#define INIT                 0
-#define FREE_LENGTH_CHECK    1
-#define SKIP                 2
-#define ALLOC_DONE           0xF00DF00D
-#define ALLOC_FAILED         0xDEADBEAF
+/* Size classes for the free hints: class c holds sizes 2^c to 2^(c+1) - 1,
+   the last class holds everything larger. */
+#define NUM_SIZE_CLASSES     8
 
 static lbm_uint *bitmap = NULL;
 static lbm_uint *memory = NULL;
@@ -49,7 +46,20 @@ static lbm_uint memory_min_free = 0;
 static volatile lbm_uint memory_reserve_level = 0;
 static mutex_t lbm_mem_mutex;
 static bool    lbm_mem_mutex_initialized;
-static lbm_uint alloc_offset = 0;
+// No free range of at least 2^c words starts before free_hint[c].
+static lbm_uint free_hint[NUM_SIZE_CLASSES];
+// Start of the most recently freed range in each size class, or
+// memory_size. The range may since have been allocated over.
+static lbm_uint recent_free[NUM_SIZE_CLASSES];
+// Length of the longest free range, if longest_free_valid.
+static lbm_uint longest_free = 0;
+static bool longest_free_valid = false;
+
+static void reset_free_hints(lbm_uint ix) {
+  for (int i = 0; i < NUM_SIZE_CLASSES; i ++) {
+    if (free_hint[i] > ix) free_hint[i] = ix;
+  }
+}
 
 int lbm_memory_init(lbm_uint *data, lbm_uint data_size,
                     lbm_uint *bits, lbm_uint bits_size) {
@@ -59,8 +69,6 @@ int lbm_memory_init(lbm_uint *data, lbm_uint data_size,
     lbm_mem_mutex_initialized = true;
   }
 
-  alloc_offset = 0;
-
   mutex_lock(&lbm_mem_mutex);
   int res = 0;
   if (data == NULL || bits == NULL) return 0;
@@ -89,6 +97,13 @@ int lbm_memory_init(lbm_uint *data, lbm_uint data_size,
     memory_min_free = data_size;
     memory_num_free = data_size;
     memory_reserve_level = (lbm_uint)(0.1 * (lbm_float)data_size);
+    for (int i = 0; i < NUM_SIZE_CLASSES; i ++) {
+      free_hint[i] = 0;
+      recent_free[i] = data_size;
+    }
+    recent_free[NUM_SIZE_CLASSES - 1] = 0;
+    longest_free = data_size;
+    longest_free_valid = true;
     res = 1;
   }
   mutex_unlock(&lbm_mem_mutex);
@@ -127,10 +142,34 @@ static inline lbm_uint *bitmap_ix_to_address(lbm_uint ix) {
 #define WORD_IX_SHIFT 5
 #define WORD_MOD_MASK 0x1F
 #define BITMAP_SIZE_SHIFT 4  // 16 statuses per bitmap word
+#define STATUS_IX_MASK 0xF
 #else
 #define WORD_IX_SHIFT 6      // divide by 64
 #define WORD_MOD_MASK 0x3F   // mod 64
 #define BITMAP_SIZE_SHIFT 5  // times 32, 32 statuses per bitmap word
+#define STATUS_IX_MASK 0x1F
+#endif
+
+// Index of the lowest and highest set bit, x must not be 0.
+#if defined(__GNUC__) || defined(__clang__)
+#ifndef LBM64
+#define CTZ(x) ((lbm_uint)__builtin_ctz(x))
+#define HIGHEST_BIT(x) ((lbm_uint)(31 - __builtin_clz(x)))
+#else
+#define CTZ(x) ((lbm_uint)__builtin_ctzll(x))
+#define HIGHEST_BIT(x) ((lbm_uint)(63 - __builtin_clzll(x)))
+#endif
+#else
+static inline lbm_uint CTZ(lbm_uint x) {
+  lbm_uint n = 0;
+  while (!(x & 1)) { x >>= 1; n ++; }
+  return n;
+}
+static inline lbm_uint HIGHEST_BIT(lbm_uint x) {
+  lbm_uint n = 0;
+  while (x >>= 1) n ++;
+  return n;
+}
 #endif
 
 static inline lbm_uint status(lbm_uint i) {
@@ -175,49 +214,76 @@ void lbm_memory_update_min_free(void) {
     memory_min_free = memory_num_free;
 }
 
+// Position of the first status that is not FREE_OR_USED at or after i,
+// or memory_size if there is none. The bitmap is scanned a word at a time.
+static lbm_uint next_marked(lbm_uint i) {
+  if (i >= memory_size) return memory_size;
+  lbm_uint word_ix = i >> BITMAP_SIZE_SHIFT;
+  lbm_uint bits = bitmap[word_ix] >> ((i & STATUS_IX_MASK) << 1);
+  if (bits) {
+    return i + (CTZ(bits) >> 1);
+  }
+  for (word_ix ++; word_ix < bitmap_size; word_ix ++) {
+    if (bitmap[word_ix]) {
+      return (word_ix << BITMAP_SIZE_SHIFT) + (CTZ(bitmap[word_ix]) >> 1);
+    }
+  }
+  return memory_size;
+}
+
+// Position of the last status that is not FREE_OR_USED before i.
+static bool prev_marked(lbm_uint i, lbm_uint *res) {
+  if (i == 0) return false;
+  i --;
+  lbm_uint word_ix = i >> BITMAP_SIZE_SHIFT;
+  lbm_uint top = ((i & STATUS_IX_MASK) << 1) + 2; // bits to keep
+  lbm_uint bits = bitmap[word_ix];
+  if (top < (sizeof(lbm_uint) * 8)) {
+    bits &= (((lbm_uint)1) << top) - 1;
+  }
+  for (;;) {
+    if (bits) {
+      *res = (word_ix << BITMAP_SIZE_SHIFT) + (HIGHEST_BIT(bits) >> 1);
+      return true;
+    }
+    if (word_ix == 0) return false;
+    word_ix --;
+    bits = bitmap[word_ix];
+  }
+}
+
+// Start of the free range that ends right before i.
+static lbm_uint free_range_start(lbm_uint i) {
+  lbm_uint p;
+  if (prev_marked(i, &p)) return p + 1;
+  return 0;
+}
+
+static lbm_uint longest_free_scan(void) {
+  lbm_uint max_length = 0;
+  lbm_uint i = 0;
+  while (i < memory_size) {
+    lbm_uint p = next_marked(i);
+    if (p - i > max_length) max_length = p - i;
+    if (p >= memory_size) break;
+    if (status(p) == START) {
+      p = next_marked(p + 1); // END of the allocation
+    }
+    i = p + 1;
+  }
+  return max_length;
+}
+
 lbm_uint lbm_memory_longest_free(void) {
   if (memory == NULL || bitmap == NULL) {
     return 0;
   }
   mutex_lock(&lbm_mem_mutex);
-  unsigned int state = INIT;
-  lbm_uint max_length = 0;
-
-  lbm_uint curr_length = 0;
-  for (unsigned int i = 0; i < (bitmap_size << BITMAP_SIZE_SHIFT); i ++) {
-
-    switch(status(i)) {
-    case FREE_OR_USED:
-      switch (state) {
-      case INIT:
-        curr_length = 1;
-        if (curr_length > max_length) max_length = curr_length;
-        state = FREE_LENGTH_CHECK;
-        break;
-      case FREE_LENGTH_CHECK:
-        curr_length ++;
-        if (curr_length > max_length) max_length = curr_length;
-        state = FREE_LENGTH_CHECK;
-        break;
-      case SKIP:
-        break;
-      }
-      break;
-    case END:
-      state = INIT;
-      break;
-    case START:
-      state = SKIP;
-      break;
-    case START_END:
-      state = INIT;
-      break;
-    default:
-      mutex_unlock(&lbm_mem_mutex);
-      return 0;
-      break;
-    }
+  if (!longest_free_valid) {
+    longest_free = longest_free_scan();
+    longest_free_valid = true;
   }
+  lbm_uint max_length = longest_free;
   mutex_unlock(&lbm_mem_mutex);
   if (memory_num_free - max_length < memory_reserve_level) {
     lbm_uint n = memory_reserve_level - (memory_num_free - max_length);
@@ -226,81 +292,105 @@ lbm_uint lbm_memory_longest_free(void) {
   return max_length;
 }
 
+static inline lbm_uint size_class(lbm_uint num_words) {
+  lbm_uint c = 0;
+  while (c < (NUM_SIZE_CLASSES - 1) && (((lbm_uint)2) << c) <= num_words) {
+    c ++;
+  }
+  return c;
+}
+
+static inline void mark_allocated(lbm_uint i, lbm_uint num_words) {
+  lbm_uint end_ix = i + num_words - 1;
+  if (i == end_ix) {
+    set_status(i, START_END);
+  } else {
+    set_status(i, START);
+    set_status(end_ix, END);
+  }
+  memory_num_free -= num_words;
+}
+
+// Recently freed ranges are tried first, then first fit starting at the
+// hint for the size class. Free ranges are found by skipping to the next
+// status that is set, so runs of free or used words are passed a bitmap
+// word at a time.
 static lbm_uint *lbm_memory_allocate_internal(lbm_uint num_words) {
 
-  if (memory == NULL || bitmap == NULL) {
+  if (memory == NULL || bitmap == NULL || num_words == 0) {
     return NULL;
   }
 
   mutex_lock(&lbm_mem_mutex);
 
-  lbm_uint start_ix = 0;
-  lbm_uint end_ix = 0;
-  lbm_uint free_length = 0;
-  unsigned int state = INIT;
-  lbm_uint loop_max = (bitmap_size << BITMAP_SIZE_SHIFT);
-
-  for (lbm_uint i = 0; i < loop_max; i ++) {
-    switch(status(alloc_offset)) {
-    case FREE_OR_USED:
-      switch (state) {
-      case INIT:
-        start_ix = alloc_offset;
-        if (num_words == 1) {
-          end_ix = alloc_offset;
-          state = ALLOC_DONE;
-        } else {
-          state = FREE_LENGTH_CHECK;
-          free_length = 1;
-        }
-        break;
-      case FREE_LENGTH_CHECK:
-        free_length ++;
-        if (free_length == num_words) {
-          end_ix = alloc_offset;
-          state = ALLOC_DONE;
-        } else {
-          state = FREE_LENGTH_CHECK;
-        }
-        break;
-      case SKIP:
-        break;
-      }
-      break;
-    case END:
-      state = INIT;
-      break;
-    case START:
-      state = SKIP;
-      break;
-    case START_END:
-      state = INIT;
-      break;
-    default: // error case
-      mutex_unlock(&lbm_mem_mutex);
-      return NULL;
+  if (longest_free_valid && num_words > longest_free) {
+    mutex_unlock(&lbm_mem_mutex);
+    return NULL;
+  }
+
+  lbm_uint c = size_class(num_words);
+  lbm_uint p;
+
+  // Most allocations fit in a recently freed range of the same or a
+  // larger size class.
+  for (lbm_uint k = c; k < NUM_SIZE_CLASSES; k ++) {
+    lbm_uint i = recent_free[k];
+    if (i >= memory_size || status(i) != FREE_OR_USED) continue;
+    if (prev_marked(i, &p) && status(p) == START) continue;
+    lbm_uint end = next_marked(i);
+    if (end - i < num_words) continue;
+    lbm_uint length = end - free_range_start(i);
+    recent_free[k] = memory_size;
+    if (end - i > num_words) {
+      recent_free[size_class(end - i - num_words)] = i + num_words;
     }
+    if (length == longest_free) {
+      longest_free_valid = false;
+    }
+    mark_allocated(i, num_words);
+    mutex_unlock(&lbm_mem_mutex);
+    return bitmap_ix_to_address(i);
+  }
 
-    if (state == ALLOC_DONE) break;
+  lbm_uint class_min = ((lbm_uint)1) << c;
+  lbm_uint first_in_class = memory_size;
+  lbm_uint max_length = 0;
+  lbm_uint i = free_hint[c];
 
-    alloc_offset++;
-    if (alloc_offset == loop_max ) {
-      free_length = 0;
-      alloc_offset = 0;
-      state = INIT;
-    }
+  // The hint may point into an allocation
+  if (prev_marked(i, &p) && status(p) == START) {
+    i = next_marked(i) + 1;
   }
 
-  if (state == ALLOC_DONE) {
-    if (start_ix == end_ix) {
-      set_status(start_ix, START_END);
-    } else {
-      set_status(start_ix, START);
-      set_status(end_ix, END);
+  while (i < memory_size) {
+    p = next_marked(i);
+    lbm_uint length = p - i;
+    if (length > max_length) max_length = length;
+    if (length >= class_min && first_in_class == memory_size) {
+      first_in_class = i;
     }
-    memory_num_free -= num_words;
-    mutex_unlock(&lbm_mem_mutex);
-    return bitmap_ix_to_address(start_ix);
+    if (length >= num_words) {
+      mark_allocated(i, num_words);
+      free_hint[c] = first_in_class;
+      if (length == longest_free) {
+        longest_free_valid = false;
+      }
+      mutex_unlock(&lbm_mem_mutex);
+      return bitmap_ix_to_address(i);
+    }
+    if (p >= memory_size) break;
+    if (status(p) == START) {
+      p = next_marked(p + 1); // END of the allocation
+    }
+    i = p + 1;
+  }
+
+  free_hint[c] = first_in_class;
+  // Ranges before the hint are shorter than class_min, so unless they
+  // could be longer than what was found the scan gave the longest range.
+  if (max_length + 1 >= class_min) {
+    longest_free = max_length;
+    longest_free_valid = true;
   }
   mutex_unlock(&lbm_mem_mutex);
   return NULL;
@@ -314,25 +404,33 @@ lbm_uint *lbm_memory_allocate(lbm_uint num_words) {
   return lbm_memory_allocate_internal(num_words);
 }
 
+// Update hints and the longest free range after the words from ix were freed.
+static void freed_range(lbm_uint ix) {
+  lbm_uint start = free_range_start(ix);
+  lbm_uint length = next_marked(start) - start;
+  reset_free_hints(start);
+  recent_free[size_class(length)] = start;
+  if (longest_free_valid && length > longest_free) {
+    longest_free = length;
+  }
+}
+
 int lbm_memory_free(lbm_uint *ptr) {
   int r = 0;
   if (lbm_memory_ptr_inside(ptr)) {
     mutex_lock(&lbm_mem_mutex);
     lbm_uint ix = address_to_bitmap_ix(ptr);
     lbm_uint count_freed = 0;
-    alloc_offset = ix;
     switch(status(ix)) {
-    case START:
-      set_status(ix, FREE_OR_USED);
-      for (lbm_uint i = ix; i < (bitmap_size << BITMAP_SIZE_SHIFT); i ++) {
-        count_freed ++;
-        if (status(i) == END) {
-          set_status(i, FREE_OR_USED);
-          r = 1;
-          break;
-        }
+    case START: {
+      lbm_uint end_ix = next_marked(ix + 1);
+      if (end_ix < memory_size && status(end_ix) == END) {
+        set_status(ix, FREE_OR_USED);
+        set_status(end_ix, FREE_OR_USED);
+        count_freed = end_ix - ix + 1;
+        r = 1;
       }
-      break;
+    } break;
     case START_END:
       set_status(ix, FREE_OR_USED);
       count_freed = 1;
@@ -342,9 +440,7 @@ int lbm_memory_free(lbm_uint *ptr) {
       break;
     }
     if (r) {
-      while (alloc_offset > 0 && status(alloc_offset - 1) == FREE_OR_USED) {
-        alloc_offset--;
-      }
+      freed_range(ix);
     }
     memory_num_free += count_freed;
     mutex_unlock(&lbm_mem_mutex);
@@ -398,41 +494,21 @@ int lbm_memory_shrink(lbm_uint *ptr, lbm_uint n) {
     return 0; // ptr does not point to the start of an allocated range.
   }
 
-  bool done = false;
-  unsigned int i = 0;
-
-  for (i = 0; i < ((bitmap_size << BITMAP_SIZE_SHIFT) - ix); i ++) {
-    if (status(ix+i) == END && i < n) {
-      mutex_unlock(&lbm_mem_mutex);
-      return 0; // cannot shrink allocation to a larger size
-    }
-
-    if (i == (n-1)) {
-      if (status(ix+i) == END ||
-          status(ix+i) == START_END) {
-        done = true;
-      }
-      if (i == 0) {
-        set_status(ix+i, START_END);
-      }
-      else {
-        set_status(ix+i, END);
-      }
-      break;
-    }
+  lbm_uint end_ix = next_marked(ix + 1);
+  if (end_ix >= memory_size || end_ix - ix + 1 < n) {
+    mutex_unlock(&lbm_mem_mutex);
+    return 0; // cannot shrink allocation to a larger size
   }
-  alloc_offset = ix+i;
-
-  lbm_uint count = 0;
-  if (!done) {
-    i++; // move to next position, prev position should be END or START_END
-    for (;i < ((bitmap_size << BITMAP_SIZE_SHIFT) - ix); i ++) {
-      count ++;
-      if (status(ix+i) == END) {
-        set_status(ix+i, FREE_OR_USED);
-        break;
-      }
+
+  lbm_uint count = end_ix - ix + 1 - n;
+  if (count > 0) {
+    set_status(end_ix, FREE_OR_USED);
+    if (n == 1) {
+      set_status(ix, START_END);
+    } else {
+      set_status(ix + n - 1, END);
     }
+    freed_range(ix + n);
   }
 
   memory_num_free += count;
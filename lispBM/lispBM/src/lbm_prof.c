@@ -17,26 +17,41 @@
 
 #include "lbm_prof.h"
 #include "platform_mutex.h"
+#include "env.h"
+#include "symrepr.h"
+
+#include <stdio.h>
 
 static lbm_uint num_samples = 0;
 static lbm_uint num_system_samples = 0;
 static lbm_uint num_sleep_samples = 0;
+static lbm_uint num_dropped_samples = 0;
 extern eval_context_t *ctx_running;
 extern mutex_t qmutex;
 extern bool    qmutex_initialized;
 extern volatile bool lbm_system_sleeping;
+extern volatile lbm_value lbm_current_extension;
 
 static lbm_prof_t *prof_data;
 static lbm_uint    prof_data_num;
 
+static lbm_prof_stack_t *prof_stacks = NULL;
+static lbm_uint          prof_stacks_num = 0;
+
 #define TRUNC_SIZE(N) (((N) > LBM_PROF_MAX_NAME_SIZE -1) ? LBM_PROF_MAX_NAME_SIZE-1 : N)
 
+// Limits for looking up which closure a code cell belongs to.
+#define CODE_WALK_STACK  32
+#define CODE_WALK_CELLS  10000
+
 bool lbm_prof_init(lbm_prof_t *prof_data_buf,
                    lbm_uint    prof_data_buf_num) {
   if (qmutex_initialized && prof_data_buf && prof_data_buf_num > 0) {
+    mutex_lock(&qmutex);
     num_samples = 0;
     num_system_samples = 0;
     num_sleep_samples = 0;
+    num_dropped_samples = 0;
     prof_data_num = prof_data_buf_num;
     prof_data = prof_data_buf;
     for (lbm_uint i = 0; i < prof_data_num; i ++) {
@@ -44,7 +59,29 @@ bool lbm_prof_init(lbm_prof_t *prof_data_buf,
       prof_data[i].has_name = false;
       memset(&prof_data_buf[i].name, 0, LBM_PROF_MAX_NAME_SIZE);
       prof_data_buf[i].count = 0;
+      prof_data_buf[i].gc_count = 0;
+    }
+    prof_stacks = NULL;
+    prof_stacks_num = 0;
+    mutex_unlock(&qmutex);
+    return true;
+  }
+  return false;
+}
+
+bool lbm_prof_init_stacks(lbm_prof_stack_t *stack_buf,
+                          lbm_uint          stack_buf_num) {
+  if (qmutex_initialized) {
+    if (stack_buf_num == 0) stack_buf = NULL;
+    mutex_lock(&qmutex);
+    for (lbm_uint i = 0; stack_buf && i < stack_buf_num; i ++) {
+      stack_buf[i].cid = -1;
+      stack_buf[i].count = 0;
     }
+    prof_stacks = stack_buf;
+    prof_stacks_num = stack_buf ? stack_buf_num : 0;
+    mutex_unlock(&qmutex);
+    return true;
   }
   return false;
 }
@@ -61,6 +98,108 @@ lbm_uint lbm_prof_get_num_sleep_samples(void) {
   return num_sleep_samples;
 }
 
+lbm_uint lbm_prof_get_num_dropped_samples(void) {
+  return num_dropped_samples;
+}
+
+static lbm_uint hash_word(lbm_uint h, lbm_uint w) {
+  // FNV-1a over the bytes of w.
+  for (unsigned int i = 0; i < sizeof(lbm_uint); i ++) {
+    h ^= (w >> (i * 8)) & 0xFF;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static lbm_prof_t *find_ctx_entry(lbm_cid id, char *name, lbm_uint name_len) {
+  lbm_uint ix = hash_word(2166136261u, (lbm_uint)id) % prof_data_num;
+  for (lbm_uint n = 0; n < prof_data_num; n ++) {
+    lbm_prof_t *p = &prof_data[ix];
+    if (p->cid == -1) {
+      p->cid = id;
+      p->count = 0;
+      p->gc_count = 0;
+      if (name) {
+        memcpy(&p->name, name, TRUNC_SIZE(name_len));
+        p->name[LBM_PROF_MAX_NAME_SIZE - 1] = 0;
+        p->has_name = true;
+      }
+      return p;
+    }
+    if (p->cid == id &&
+        p->has_name &&
+        name != NULL &&
+        strncmp(p->name, name, TRUNC_SIZE(name_len)) == 0) {
+      return p;
+    }
+    if (p->cid == id &&
+        !p->has_name &&
+        name == NULL) {
+      return p;
+    }
+    ix = (ix + 1) % prof_data_num;
+  }
+  return NULL;
+}
+
+static void sample_stack(eval_context_t *ctx, bool doing_gc) {
+  lbm_value pending[LBM_PROF_MAX_DEPTH];
+  lbm_value frames[LBM_PROF_MAX_DEPTH];
+  bool truncated;
+  lbm_uint n = lbm_get_pending_applications(ctx, pending, LBM_PROF_MAX_DEPTH, LBM_PROF_MAX_SCAN, &truncated);
+
+  lbm_uint depth = 0;
+  for (lbm_uint i = n; i > 0; i --) {
+    frames[depth++] = pending[i-1];
+  }
+  // The innermost frame is the extension being applied or the code
+  // being evaluated.
+  lbm_value leaf = lbm_current_extension;
+  if (leaf == ENC_SYM_NIL && lbm_is_cons(ctx->curr_exp)) {
+    leaf = ctx->curr_exp;
+  }
+  if (leaf != ENC_SYM_NIL) {
+    if (depth == LBM_PROF_MAX_DEPTH) {
+      memmove(frames, frames + 1, (LBM_PROF_MAX_DEPTH - 1) * sizeof(lbm_value));
+      depth --;
+      truncated = true;
+    }
+    frames[depth++] = leaf;
+  }
+
+  lbm_uint h = hash_word(2166136261u, (lbm_uint)ctx->id);
+  h = hash_word(h, ((lbm_uint)doing_gc << 1) | (lbm_uint)truncated);
+  for (lbm_uint i = 0; i < depth; i ++) {
+    h = hash_word(h, frames[i]);
+  }
+
+  lbm_uint ix = h % prof_stacks_num;
+  for (lbm_uint k = 0; k < prof_stacks_num; k ++) {
+    lbm_prof_stack_t *s = &prof_stacks[ix];
+    if (s->cid == -1) {
+      s->cid = ctx->id;
+      s->hash = h;
+      s->count = 1;
+      s->depth = depth;
+      s->gc = doing_gc;
+      s->truncated = truncated;
+      memcpy(s->frames, frames, depth * sizeof(lbm_value));
+      return;
+    }
+    if (s->hash == h &&
+        s->cid == ctx->id &&
+        s->depth == depth &&
+        s->gc == doing_gc &&
+        s->truncated == truncated &&
+        memcmp(s->frames, frames, depth * sizeof(lbm_value)) == 0) {
+      s->count ++;
+      return;
+    }
+    ix = (ix + 1) % prof_stacks_num;
+  }
+  num_dropped_samples ++;
+}
+
 void lbm_prof_sample(void) {
   num_samples ++;
 
@@ -77,35 +216,15 @@ void lbm_prof_sample(void) {
       doing_gc = true;
     }
     if (name) name_len = strlen(name) + 1;
-    for (lbm_uint i = 0; i < prof_data_num; i ++) {
-      if (prof_data[i].cid == -1) {
-        // add new sample:
-        prof_data[i].cid = id;
-        prof_data[i].count = 1;
-        prof_data[i].gc_count = doing_gc ? 1 : 0;
-        if (name) {
-          memcpy(&prof_data[i].name, name, TRUNC_SIZE(name_len));
-          prof_data[i].name[LBM_PROF_MAX_NAME_SIZE - 1] = 0;
-          prof_data[i].has_name = true;
-        }
-        break;
-      }
-      if (prof_data[i].cid == id &&
-          prof_data[i].has_name &&
-          name != NULL &&
-          strncmp(prof_data[i].name, name, TRUNC_SIZE(name_len)) == 0) {
-        // found a named existing measurement.
-        prof_data[i].count ++;
-        prof_data[i].gc_count += doing_gc ? 1 : 0;
-        break;
-      }
-      if (prof_data[i].cid == id &&
-          !prof_data[i].has_name &&
-          name == NULL) {
-        prof_data[i].count ++;
-        prof_data[i].gc_count += doing_gc ? 1 : 0;
-        break;
-      }
+    lbm_prof_t *p = find_ctx_entry(id, name, name_len);
+    if (p) {
+      p->count ++;
+      p->gc_count += doing_gc ? 1 : 0;
+    } else {
+      num_dropped_samples ++;
+    }
+    if (prof_stacks) {
+      sample_stack(curr, doing_gc);
     }
   } else {
     if (lbm_system_sleeping) {
@@ -116,3 +235,119 @@ void lbm_prof_sample(void) {
   }
   mutex_unlock(&qmutex);
 }
+
+static bool code_contains(lbm_value code, lbm_value cell) {
+  lbm_value stack[CODE_WALK_STACK];
+  int sp = 0;
+  int visited = 0;
+  lbm_value curr = code;
+  while (visited < CODE_WALK_CELLS) {
+    if (lbm_is_cons(curr)) {
+      if (curr == cell) return true;
+      visited ++;
+      if (sp < CODE_WALK_STACK) {
+        stack[sp++] = lbm_cdr(curr);
+      }
+      curr = lbm_car(curr);
+    } else if (sp > 0) {
+      curr = stack[--sp];
+    } else {
+      break;
+    }
+  }
+  return false;
+}
+
+// Name of the global closure that the code cell belongs to.
+static const char *closure_name(lbm_value cell) {
+  lbm_value *env = lbm_get_global_env();
+  lbm_uint roots = lbm_get_global_env_roots();
+  for (lbm_uint i = 0; i < roots; i ++) {
+    lbm_value curr = env[i];
+    while (lbm_is_cons(curr)) {
+      lbm_value binding = lbm_car(curr);
+      lbm_value val = lbm_cdr(binding);
+      if (lbm_is_closure(val)) {
+        lbm_value body = lbm_car(lbm_cdr(lbm_cdr(val)));
+        if (code_contains(body, cell)) {
+          return lbm_get_name_by_symbol(lbm_dec_sym(lbm_car(binding)));
+        }
+      }
+      curr = lbm_cdr(curr);
+    }
+  }
+  return NULL;
+}
+
+static lbm_uint append(char *line, lbm_uint line_size, lbm_uint pos, const char *str) {
+  while (*str && pos + 1 < line_size) {
+    char c = *str++;
+    // ';' and ' ' separate frames and count in the folded format.
+    line[pos++] = (c == ';' || c == ' ') ? '_' : c;
+  }
+  line[pos] = 0;
+  return pos;
+}
+
+static lbm_uint append_frame(char *line, lbm_uint line_size, lbm_uint pos, const char *str) {
+  if (pos + 1 < line_size) line[pos++] = ';';
+  return append(line, line_size, pos, str);
+}
+
+lbm_uint lbm_prof_export_folded(char *line, lbm_uint line_size,
+                                void (*emit)(const char *line)) {
+  if (!prof_stacks || line_size < 2) return 0;
+  lbm_uint lines = 0;
+  char num[24];
+  for (lbm_uint i = 0; i < prof_stacks_num; i ++) {
+    lbm_prof_stack_t *s = &prof_stacks[i];
+    if (s->cid == -1) continue;
+    int num_len = snprintf(num, sizeof(num), "%u", (unsigned int)s->count);
+    // Frames are cut short to leave room for " <count>".
+    lbm_uint size = 1;
+    if (num_len > 0 && line_size > (lbm_uint)num_len + 2) {
+      size = line_size - (lbm_uint)num_len - 1;
+    }
+    lbm_uint pos = 0;
+    line[0] = 0;
+    const char *ctx_name = NULL;
+    for (lbm_uint j = 0; prof_data && j < prof_data_num; j ++) {
+      if (prof_data[j].cid == s->cid && prof_data[j].has_name) {
+        ctx_name = prof_data[j].name;
+        break;
+      }
+    }
+    if (ctx_name) {
+      pos = append(line, size, pos, ctx_name);
+    } else {
+      char ctx_num[24];
+      snprintf(ctx_num, sizeof(ctx_num), "ctx-%d", (int)s->cid);
+      pos = append(line, size, pos, ctx_num);
+    }
+    if (s->truncated) {
+      pos = append_frame(line, size, pos, "...");
+    }
+    for (lbm_uint j = 0; j < s->depth; j ++) {
+      lbm_value f = s->frames[j];
+      const char *name = NULL;
+      if (lbm_is_symbol(f)) {
+        name = lbm_get_name_by_symbol(lbm_dec_sym(f));
+      } else {
+        name = closure_name(f);
+      }
+      pos = append_frame(line, size, pos, name ? name : "[lambda]");
+    }
+    if (s->gc) {
+      pos = append_frame(line, size, pos, "[gc]");
+    }
+    if (pos + 1 < line_size) line[pos++] = ' ';
+    line[pos] = 0;
+    for (const char *c = num; *c && pos + 1 < line_size; c ++) {
+      line[pos++] = *c;
+    }
+    line[pos] = 0;
+    emit(line);
+    lines ++;
+  }
+  return lines;
+}
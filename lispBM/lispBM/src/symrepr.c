@@ -84,6 +84,7 @@ special_sym const special_symbols[] =  {
   {"rest-args"    , SYM_REST_ARGS},
   {"rotate"       , SYM_ROTATE},
   {"call-cc-unsafe", SYM_CALL_CC_UNSAFE},
+  {"bytecode"     , SYM_BYTECODE},
   {"apply"        , SYM_APPLY},
 
   // pattern matching
@@ -200,6 +201,7 @@ special_sym const special_symbols[] =  {
   {"length"           , SYM_LIST_LENGTH},
   {"range"            , SYM_RANGE},
   {"member"           , SYM_MEMBER},
+  {"compile"          , SYM_COMPILE},
 
   {"assoc"          , SYM_ASSOC}, // lookup an association
   {"cossa"          , SYM_COSSA}, // lookup an association "backwards"
@@ -265,9 +267,221 @@ static lbm_uint symbol_table_size_list_flash = 0;
 static lbm_uint symbol_table_size_strings = 0;
 static lbm_uint symbol_table_size_strings_flash = 0;
 
+// Hash index over the special symbols, the extensions and the symlist.
+// Runtime symbol ids are handed out in order, so symlist entries are kept in
+// an array indexed by id - RUNTIME_SYMBOLS_START, which gives id to name
+// lookups directly. Name to id lookups use an open addressing table of 16 bit
+// handles, where handle - 1 indexes special_symbols, then extension_table
+// and then the runtime entry array. Both live in lbm_memory.
+//
+// When the index is full, new symbols are kept out of it and counted in
+// sym_index_pending. They are at the head of the symlist and are searched
+// linearly until a larger index can be allocated. Without an index at all
+// the linear searches are used.
+#define SYM_INDEX_MIN_SIZE     64
+#define SYM_INDEX_MIN_RETRY    16
+#define SYM_INDEX_MAX_RETRY    1024
+#define SYM_INDEX_MAX_HANDLE   0xFFFF
+
+static uint16_t *sym_index = NULL;
+static lbm_uint sym_index_size = 0;
+static lbm_uint sym_index_num = 0;
+static lbm_uint **sym_index_entries = NULL;
+static lbm_uint sym_index_entries_size = 0;
+static lbm_uint sym_index_ext_max = 0;
+static lbm_uint sym_index_pending = 0;
+static lbm_uint sym_index_retry = 0;
+static lbm_uint sym_index_backoff = SYM_INDEX_MIN_RETRY;
+
+static uint32_t sym_index_hash(const char *name) {
+  // FNV-1a
+  uint32_t h = 2166136261u;
+  while (*name) {
+    h ^= (uint8_t)*name++;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static const char *sym_index_handle_name(lbm_uint handle, lbm_uint *id) {
+  lbm_uint ix = handle - 1;
+  if (ix < NUM_SPECIAL_SYMBOLS) {
+    *id = special_symbols[ix].id;
+    return special_symbols[ix].name;
+  }
+  ix -= NUM_SPECIAL_SYMBOLS;
+  if (ix < sym_index_ext_max) {
+    *id = EXTENSION_SYMBOLS_START + ix;
+    return extension_table[ix].name; // NULL if cleared
+  }
+  lbm_uint *entry = sym_index_entries[ix - sym_index_ext_max];
+  *id = entry[ID];
+  return (const char*)entry[NAME];
+}
+
+static bool sym_index_handle_is_runtime(lbm_uint handle) {
+  return (handle - 1) >= (NUM_SPECIAL_SYMBOLS + sym_index_ext_max);
+}
+
+// Returns the slot holding name, or the empty slot where it would go.
+static lbm_uint sym_index_find(char *name) {
+  lbm_uint mask = sym_index_size - 1;
+  lbm_uint i = sym_index_hash(name) & mask;
+  while (sym_index[i]) {
+    lbm_uint id;
+    const char *str = sym_index_handle_name(sym_index[i], &id);
+    if (str && str_eq(name, (char*)str)) {
+      break;
+    }
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+// The linear search looks at special symbols first, then extensions and
+// then the symlist from the newest entry. To give the same result for
+// duplicate names an existing slot is only replaced if it refers to a
+// symlist entry and shadow is set.
+static void sym_index_put(const char *name, lbm_uint handle, bool shadow) {
+  lbm_uint i = sym_index_find((char*)name);
+  if (!sym_index[i]) {
+    sym_index[i] = (uint16_t)handle;
+    sym_index_num ++;
+  } else if (shadow && sym_index_handle_is_runtime(sym_index[i])) {
+    sym_index[i] = (uint16_t)handle;
+  }
+}
+
+static bool sym_index_put_entry(lbm_uint *entry, bool shadow) {
+  lbm_uint ix = entry[ID] - RUNTIME_SYMBOLS_START;
+  if (entry[ID] < RUNTIME_SYMBOLS_START || ix >= sym_index_entries_size) {
+    return false;
+  }
+  if (sym_index_entries[ix] && !shadow) {
+    return true; // Only the newest entry with an id is used.
+  }
+  sym_index_entries[ix] = entry;
+  sym_index_put((const char*)entry[NAME], 1 + NUM_SPECIAL_SYMBOLS + sym_index_ext_max + ix, shadow);
+  return true;
+}
+
+static void sym_index_free(void) {
+  if (sym_index) lbm_free(sym_index);
+  if (sym_index_entries) lbm_free(sym_index_entries);
+  sym_index = NULL;
+  sym_index_entries = NULL;
+  sym_index_size = 0;
+  sym_index_entries_size = 0;
+  sym_index_num = 0;
+}
+
+static void sym_index_rebuild(void) {
+  lbm_uint n = NUM_SPECIAL_SYMBOLS;
+  lbm_uint ext_max = lbm_get_max_extensions();
+  for (lbm_uint i = 0; i < ext_max; i ++) {
+    if (extension_table[i].name) n ++;
+  }
+  lbm_uint num_entries = next_symbol_id - RUNTIME_SYMBOLS_START;
+  for (lbm_uint *curr = symlist; curr; curr = (lbm_uint*)curr[NEXT]) {
+    if (curr[ID] >= RUNTIME_SYMBOLS_START + num_entries) {
+      num_entries = curr[ID] + 1 - RUNTIME_SYMBOLS_START;
+    }
+    n ++;
+  }
+
+  // Room for some more symbols before the next rebuild
+  lbm_uint entries_size = num_entries + num_entries / 2 + SYM_INDEX_MIN_RETRY;
+  lbm_uint size = SYM_INDEX_MIN_SIZE;
+  while (size * 3 < (n + n / 4) * 4) {
+    size <<= 1;
+  }
+
+  uint16_t *new_index = NULL;
+  lbm_uint **new_entries = NULL;
+  if (1 + NUM_SPECIAL_SYMBOLS + ext_max + entries_size <= SYM_INDEX_MAX_HANDLE) {
+    // The old index is kept if there is no room for a new one.
+    new_index = (uint16_t*)lbm_malloc(size * sizeof(uint16_t));
+    new_entries = (lbm_uint**)lbm_malloc(entries_size * sizeof(lbm_uint*));
+  }
+  if (!new_index || !new_entries) {
+    if (new_index) lbm_free(new_index);
+    if (new_entries) lbm_free(new_entries);
+    sym_index_retry = sym_index_pending + sym_index_backoff;
+    if (sym_index_backoff < SYM_INDEX_MAX_RETRY) {
+      sym_index_backoff <<= 1;
+    }
+    return;
+  }
+
+  sym_index_free();
+  memset(new_index, 0, size * sizeof(uint16_t));
+  memset(new_entries, 0, entries_size * sizeof(lbm_uint*));
+  sym_index = new_index;
+  sym_index_size = size;
+  sym_index_entries = new_entries;
+  sym_index_entries_size = entries_size;
+  sym_index_ext_max = ext_max;
+
+  for (lbm_uint i = 0; i < NUM_SPECIAL_SYMBOLS; i ++) {
+    sym_index_put(special_symbols[i].name, 1 + i, false);
+  }
+  for (lbm_uint i = 0; i < ext_max; i ++) {
+    if (extension_table[i].name) {
+      sym_index_put(extension_table[i].name, 1 + NUM_SPECIAL_SYMBOLS + i, false);
+    }
+  }
+  // Newest first, so older duplicates are not used.
+  for (lbm_uint *curr = symlist; curr; curr = (lbm_uint*)curr[NEXT]) {
+    sym_index_put_entry(curr, false);
+  }
+
+  sym_index_pending = 0;
+  sym_index_backoff = SYM_INDEX_MIN_RETRY;
+  sym_index_retry = SYM_INDEX_MIN_RETRY;
+}
+
+static bool sym_index_ready(void) {
+  if (sym_index_pending >= sym_index_retry) {
+    sym_index_rebuild();
+  }
+  return sym_index != NULL;
+}
+
+static bool sym_index_has_room(void) {
+  return (sym_index_num + 1) * 4 <= sym_index_size * 3;
+}
+
+static void sym_index_add_entry(lbm_uint *entry) {
+  if (!(sym_index &&
+        sym_index_pending == 0 &&
+        sym_index_has_room() &&
+        sym_index_put_entry(entry, true))) {
+    sym_index_pending ++;
+  }
+}
+
+void lbm_symrepr_index_add_extension(lbm_uint ext_ix) {
+  if (!sym_index) {
+    return;
+  }
+  if (sym_index_has_room() && ext_ix < sym_index_ext_max) {
+    sym_index_put(extension_table[ext_ix].name, 1 + NUM_SPECIAL_SYMBOLS + ext_ix, true);
+  } else {
+    lbm_symrepr_index_invalidate();
+  }
+}
+
+void lbm_symrepr_index_invalidate(void) {
+  sym_index_free();
+  sym_index_pending = 0;
+  sym_index_retry = 0;
+  sym_index_backoff = SYM_INDEX_MIN_RETRY;
+}
+
 // When rebooting an image...
 void lbm_symrepr_set_symlist(lbm_uint *ls) {
   symlist = ls;
+  lbm_symrepr_index_invalidate();
 }
 
 
@@ -286,6 +500,16 @@ int lbm_symrepr_init(void) {
   symbol_table_size_list_flash = 0;
   symbol_table_size_strings = 0;
   symbol_table_size_strings_flash = 0;
+  // lbm_memory is initialized before the symbol table, so the old index
+  // is gone already.
+  sym_index = NULL;
+  sym_index_size = 0;
+  sym_index_num = 0;
+  sym_index_entries = NULL;
+  sym_index_entries_size = 0;
+  sym_index_pending = 0;
+  sym_index_retry = 0;
+  sym_index_backoff = SYM_INDEX_MIN_RETRY;
   return 1;
 }
 
@@ -300,6 +524,21 @@ void lbm_symrepr_name_iterator(symrepr_name_iterator_fun f) {
 
 const char *lookup_symrepr_name_memory(lbm_uint id) {
 
+  if (sym_index_ready()) {
+    lbm_uint ix = id - RUNTIME_SYMBOLS_START;
+    if (id >= RUNTIME_SYMBOLS_START && ix < sym_index_entries_size && sym_index_entries[ix]) {
+      return (const char *)sym_index_entries[ix][NAME];
+    }
+    lbm_uint *curr = symlist;
+    for (lbm_uint i = 0; i < sym_index_pending && curr; i ++) {
+      if (id == curr[ID]) {
+        return (const char *)curr[NAME];
+      }
+      curr = (lbm_uint*)curr[NEXT];
+    }
+    return NULL;
+  }
+
   lbm_uint *curr = symlist;
   while (curr) {
     if (id == curr[ID]) {
@@ -351,6 +590,29 @@ lbm_uint *lbm_get_symbol_list_entry_by_name(char *name) {
 // Lookup symbol id given symbol name
 int lbm_get_symbol_by_name(char *name, lbm_uint* id) {
 
+  if (sym_index_ready()) {
+    lbm_uint handle = sym_index[sym_index_find(name)];
+    if (handle && !sym_index_handle_is_runtime(handle)) {
+      sym_index_handle_name(handle, id);
+      return 1;
+    }
+    // Symbols that have not made it into the index yet are newer than the
+    // ones that have.
+    lbm_uint *curr = symlist;
+    for (lbm_uint i = 0; i < sym_index_pending && curr; i ++) {
+      if (str_eq(name, (char*)curr[NAME])) {
+        *id = curr[ID];
+        return 1;
+      }
+      curr = (lbm_uint*)curr[NEXT];
+    }
+    if (handle) {
+      sym_index_handle_name(handle, id);
+      return 1;
+    }
+    return 0;
+  }
+
   // loop through special symbols
   for (unsigned int i = 0; i < NUM_SPECIAL_SYMBOLS; i ++) {
     if (str_eq(name, (char *)special_symbols[i].name)) {
@@ -426,6 +688,7 @@ int lbm_add_symbol_base(char *name, lbm_uint *id) {
     return 0;
   }
   symlist = new_symlist;
+  sym_index_add_entry(symlist);
   *id = next_symbol_id ++;
   return 1;
 }
@@ -453,6 +716,7 @@ int lbm_add_symbol_const_base(char *name, lbm_uint* id, bool link) {
   }
   if (new_symlist) {
     symlist = new_symlist;
+    sym_index_add_entry(symlist);
     *id = next_symbol_id ++;
     return 1;
   }
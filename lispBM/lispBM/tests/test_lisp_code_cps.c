@@ -35,9 +35,11 @@
 #include "extensions/set_extensions.h"
 #include "extensions/mutex_extensions.h"
 #include "extensions/lbm_dyn_lib.h"
+#include "extensions/display_extensions.h"
 #include "lbm_channel.h"
 #include "lbm_flat_value.h"
 #include "lbm_image.h"
+#include "lbm_prof.h"
 
 #define WAIT_TIMEOUT 2500
 
@@ -287,6 +289,37 @@ LBM_EXTENSION(ext_event_list_of_float, args, argn) {
   return res;
 }
 
+#define ISR_EVENT_THREADS 4
+
+static void *isr_event_producer(void *arg) {
+  lbm_uint n = (lbm_uint)arg;
+  for (lbm_uint i = 1; i <= n; i ++) {
+    // Retry while the event queue is full.
+    while (!lbm_event_unboxed_isr(lbm_enc_i((lbm_int)i))) {
+      usleep(10);
+    }
+  }
+  return NULL;
+}
+
+// Start a number of threads that each send the events 1 .. n
+// concurrently through the lock free event queue.
+LBM_EXTENSION(ext_event_isr_threads, args, argn) {
+  lbm_value res = ENC_SYM_TERROR;
+  if (argn == 1 && lbm_is_number(args[0])) {
+    lbm_uint n = lbm_dec_as_u32(args[0]);
+    res = ENC_SYM_TRUE;
+    for (int i = 0; i < ISR_EVENT_THREADS; i ++) {
+      pthread_t t;
+      if (pthread_create(&t, NULL, isr_event_producer, (void*)n) != 0) {
+        return ENC_SYM_NIL;
+      }
+      pthread_detach(t);
+    }
+  }
+  return res;
+}
+
 LBM_EXTENSION(ext_event_array, args, argn) {
   lbm_value res = ENC_SYM_EERROR;
   if (argn == 1 && lbm_is_symbol(args[0])) {
@@ -443,6 +476,130 @@ LBM_EXTENSION(ext_flatten_depth, args, argn) {
   return res;
 }
 
+// The display renders into a log of the images it was sent, so that
+// tests can check what disp-render and disp-render-dirty send.
+#define RENDER_LOG_SIZE 16
+
+typedef struct {
+  uint16_t x;
+  uint16_t y;
+  uint16_t w;
+  uint16_t h;
+  uint32_t first_pixel;
+} render_log_t;
+
+static render_log_t render_log[RENDER_LOG_SIZE];
+static int render_log_num = 0;
+
+static bool render_image(image_buffer_t *img, uint16_t x, uint16_t y, color_t *colors) {
+  (void) colors;
+  if (render_log_num < RENDER_LOG_SIZE) {
+    render_log_t *r = &render_log[render_log_num ++];
+    r->x = x;
+    r->y = y;
+    r->w = img->width;
+    r->h = img->height;
+    r->first_pixel = getpixel(img, 0, 0);
+  }
+  return true;
+}
+
+// Returns the images rendered since the last call as a list of
+// (x y w h first-pixel) and clears the log.
+LBM_EXTENSION(ext_render_log, args, argn) {
+  (void) args;
+  (void) argn;
+  if (lbm_heap_num_free() < (lbm_uint)render_log_num * 6) {
+    return ENC_SYM_MERROR;
+  }
+  lbm_value res = ENC_SYM_NIL;
+  for (int i = render_log_num - 1; i >= 0; i --) {
+    render_log_t *r = &render_log[i];
+    lbm_value entry = lbm_heap_allocate_list_init(5,
+                                                  lbm_enc_i(r->x),
+                                                  lbm_enc_i(r->y),
+                                                  lbm_enc_i(r->w),
+                                                  lbm_enc_i(r->h),
+                                                  lbm_enc_i((lbm_int)r->first_pixel));
+    res = lbm_cons(entry, res);
+  }
+  render_log_num = 0;
+  return res;
+}
+
+// Returns (truncated f1 ... fn), the pending applications of the
+// calling context innermost first, at most max of them.
+LBM_EXTENSION(ext_pending_apps, args, argn) {
+  lbm_value pending[16];
+  if (argn != 1 || !lbm_is_number(args[0])) return ENC_SYM_TERROR;
+  lbm_uint max = lbm_dec_as_u32(args[0]);
+  if (max > 16) max = 16;
+  bool truncated;
+  lbm_uint n = lbm_get_pending_applications(lbm_get_current_context(), pending, max, 256, &truncated);
+  if (lbm_heap_num_free() < n + 1) return ENC_SYM_MERROR;
+  lbm_value res = ENC_SYM_NIL;
+  for (lbm_uint i = n; i > 0; i --) {
+    res = lbm_cons(pending[i - 1], res);
+  }
+  return lbm_cons(truncated ? ENC_SYM_TRUE : ENC_SYM_NIL, res);
+}
+
+// The profiler is sampled by hand from prof-sample, so that the
+// sampled stack is known.
+#define PROF_NUM 4
+#define PROF_STACKS_NUM 8
+
+static lbm_prof_t prof_data[PROF_NUM];
+static lbm_prof_stack_t prof_stacks[PROF_STACKS_NUM];
+static char prof_lines[PROF_STACKS_NUM][128];
+static int prof_num_lines = 0;
+
+LBM_EXTENSION(ext_prof_start, args, argn) {
+  (void) args;
+  (void) argn;
+  if (lbm_prof_init(prof_data, PROF_NUM) &&
+      lbm_prof_init_stacks(prof_stacks, PROF_STACKS_NUM)) {
+    return ENC_SYM_TRUE;
+  }
+  return ENC_SYM_NIL;
+}
+
+LBM_EXTENSION(ext_prof_sample, args, argn) {
+  (void) args;
+  (void) argn;
+  lbm_prof_sample();
+  return ENC_SYM_TRUE;
+}
+
+static void prof_emit(const char *line) {
+  if (prof_num_lines < PROF_STACKS_NUM) {
+    strncpy(prof_lines[prof_num_lines], line, 128);
+    prof_lines[prof_num_lines][127] = 0;
+    prof_num_lines ++;
+  }
+}
+
+// Returns the folded stacks as a list of strings, exported with lines
+// of at most line-size bytes.
+LBM_EXTENSION(ext_prof_folded, args, argn) {
+  if (argn != 1 || !lbm_is_number(args[0])) return ENC_SYM_TERROR;
+  lbm_uint line_size = lbm_dec_as_u32(args[0]);
+  if (line_size > 128) line_size = 128;
+  char line[128];
+  prof_num_lines = 0;
+  lbm_prof_export_folded(line, line_size, prof_emit);
+  lbm_value res = ENC_SYM_NIL;
+  for (int i = prof_num_lines; i > 0; i --) {
+    lbm_value str;
+    size_t len = strlen(prof_lines[i - 1]);
+    if (!lbm_create_array(&str, len + 1)) return ENC_SYM_MERROR;
+    memcpy(((lbm_array_header_t*)lbm_car(str))->data, prof_lines[i - 1], len + 1);
+    res = lbm_cons(str, res);
+    if (lbm_is_symbol_merror(res)) return res;
+  }
+  return res;
+}
+
 int main(int argc, char **argv) {
 
   int res = 0;
@@ -460,6 +617,7 @@ int main(int argc, char **argv) {
 
   bool stream_source = false;
   bool incremental = false;
+  unsigned int gc_pause_budget = 0;
 
   pthread_t lispbm_thd;
   lbm_cons_t *heap_storage = NULL;
@@ -467,7 +625,7 @@ int main(int argc, char **argv) {
   int c;
   opterr = 1;
 
-  while (( c = getopt(argc, argv, "igsch:t:")) != -1) {
+  while (( c = getopt(argc, argv, "igsch:t:b:")) != -1) {
     switch (c) {
     case 't':
       timeout = (uint32_t)atoi((char *)optarg);
@@ -475,6 +633,9 @@ int main(int argc, char **argv) {
     case 'h':
       heap_size = (unsigned int)atoi((char *)optarg);
       break;
+    case 'b':
+      gc_pause_budget = (unsigned int)atoi((char *)optarg);
+      break;
     case 'i':
       incremental = true;
       break;
@@ -493,6 +654,7 @@ int main(int argc, char **argv) {
   printf("Heap size: %u\n", heap_size);
   printf("Streaming source: %s\n", stream_source ? "yes" : "no");
   printf("Incremental read: %s\n", incremental ? "yes" : "no");
+  printf("GC pause budget: %u\n", gc_pause_budget);
   printf("------------------------------------------------------------\n");
 
   if (argc - optind < 1) {
@@ -598,6 +760,8 @@ int main(int argc, char **argv) {
   lbm_random_extensions_init();
   lbm_mutex_extensions_init();
   lbm_set_extensions_init();
+  lbm_display_extensions_init();
+  lbm_display_extensions_set_callbacks(render_image, NULL, NULL);
   lbm_dyn_lib_init();
 
   lbm_add_extension("ext-even", ext_even);
@@ -607,6 +771,7 @@ int main(int argc, char **argv) {
   lbm_add_extension("event-float", ext_event_float);
   lbm_add_extension("event-list-of-float", ext_event_list_of_float);
   lbm_add_extension("event-array", ext_event_array);
+  lbm_add_extension("event-isr-threads", ext_event_isr_threads);
   lbm_add_extension("block", ext_block);
   lbm_add_extension("unblock", ext_unblock);
   lbm_add_extension("block-rmbr", ext_block_rmbr);
@@ -617,6 +782,11 @@ int main(int argc, char **argv) {
   lbm_add_extension("check", ext_check);
   lbm_add_extension("load-inc-i", ext_load_inc_i);
   lbm_add_extension("flatten-depth", ext_flatten_depth);
+  lbm_add_extension("render-log", ext_render_log);
+  lbm_add_extension("pending-apps", ext_pending_apps);
+  lbm_add_extension("prof-start", ext_prof_start);
+  lbm_add_extension("prof-sample", ext_prof_sample);
+  lbm_add_extension("prof-folded", ext_prof_folded);
 
   if (lbm_get_num_extensions() < lbm_get_max_extensions()) {
     printf("Extensions loaded successfully\n");
@@ -625,6 +795,11 @@ int main(int argc, char **argv) {
     return FAIL;
   }
 
+  if (gc_pause_budget && !lbm_set_gc_pause_budget(gc_pause_budget)) {
+    printf("Failed to set GC pause budget\n");
+    return FAIL;
+  }
+
   lbm_set_dynamic_load_callback(dyn_load);
   lbm_set_timestamp_us_callback(timestamp_callback);
   lbm_set_usleep_callback(sleep_callback);
@@ -0,0 +1,65 @@
+;; The keys are computed from their index rather than kept in a list, so
+;; that the test runs in a 512 cell heap.
+(define n 200)
+(define key (lambda (i) (- (mod (* i 73) 101) 50)))
+
+(define a (bufcreate (* 4 n)))
+(define idx (bufcreate (* 4 n)))
+
+(define fill-a (lambda (i)
+  (if (= i n) t
+    (progn
+      (bufset-i32 a (* 4 i) (key i) 'little-endian)
+      (fill-a (+ i 1))))))
+(fill-a 0)
+
+(vec-argsort 'i32 a idx)
+
+(define get (lambda (buf i) (bufget-i32 buf (* 4 i) 'little-endian)))
+
+;; The permutation sorts a and keeps equal keys in index order, so its
+;; entries are also distinct.
+(define argsorted (lambda (i)
+  (if (= i (- n 1)) t
+    (let ((x (get a (get idx i)))
+          (y (get a (get idx (+ i 1)))))
+      (if (or (< x y) (and (= x y) (< (get idx i) (get idx (+ i 1)))))
+          (argsorted (+ i 1))
+        nil)))))
+(define argsort-ok (argsorted 0))
+
+(vec-sort 'i32 a)
+
+(define sorted (lambda (i)
+  (if (= i (- n 1)) t
+    (if (<= (get a i) (get a (+ i 1))) (sorted (+ i 1)) nil))))
+
+;; Sorting gives the keys in the order of the permutation.
+(define same-as-argsort (lambda (i)
+  (if (= i n) t
+    (if (= (get a i) (key (get idx i))) (same-as-argsort (+ i 1)) nil))))
+
+(define lower (vec-search 'i32 a 0))
+
+;; Fractional keys search for the first element not less than the key.
+(define b (bufcreate 8))
+(bufset-i16 b 0 1 'little-endian)
+(bufset-i16 b 2 2 'little-endian)
+(bufset-i16 b 4 3 'little-endian)
+(bufset-i16 b 6 4 'little-endian)
+(define frac (list (vec-search 'i16 b 2.5) (vec-search 'i16 b 2.0)
+                   (vec-search 'i16 b -2.5) (vec-search 'i16 b 3.5f32)
+                   (vec-search 'i16 b 1.0e30) (vec-search 'i16 b -1.0e30)))
+
+(define arr (list-to-array (list '(b 3) '(a 1) '(d 4) '(c 2))))
+(array-sort > arr 1)
+
+(check (and argsort-ok
+            (sorted 0)
+            (same-as-argsort 0)
+            (= (get a lower) 0)
+            (< (get a (- lower 1)) 0)
+            (= (vec-search 'i32 a 1000) n)
+            (eq frac '(2 1 0 3 4 0))
+            (eq (array-to-list arr) '((d 4) (b 3) (c 2) (a 1)))
+            (eq (trap (array-sort < (list-to-array '(1 a)))) '(exit-error type_error))))
@@ -0,0 +1,13 @@
+; Compiled recursion gives the same results as the interpreter.
+
+(defun fib (n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))
+(define fibc (compile fib))
+
+(defun tak (x y z)
+  (if (not (< y x)) z
+    (tak (tak (- x 1) y z) (tak (- y 1) z x) (tak (- z 1) x y))))
+(define takc (compile tak))
+
+(check (and (eq (car (car (cdr (cdr fibc)))) 'bytecode)
+            (= (fibc 15) (fib 15))
+            (= (takc 12 8 4) (tak 12 8 4))))
@@ -0,0 +1,13 @@
+; Binding cells of globals are not part of the compiled closure, so a
+; recursive compiled closure can be flattened after it has run.
+
+(define fib (compile (lambda (n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))))
+(define r1 (fib 10))
+
+(define copy (unflatten (flatten fib)))
+(define r2 (copy 10))
+
+(define fib (lambda (n) 0))
+(define r3 (copy 10))
+
+(check (and (= r1 55) (= r2 55) (= r3 0)))
@@ -0,0 +1,9 @@
+; A compiled closure moved to flash looks up its globals at every use.
+
+(define fib (compile (lambda (n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))))
+(define r1 (fib 10))
+
+(move-to-flash fib)
+(define r2 (fib 10))
+
+(check (and (= r1 55) (= r2 55) (constant? fib)))
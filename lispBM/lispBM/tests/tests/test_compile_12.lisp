@@ -0,0 +1,16 @@
+; Compiled closures take extra arguments like interpreted ones do.
+
+(defun f (x) (+ x 1))
+(define g (compile f))
+(define h (compile (lambda () 5)))
+(define k (compile (lambda (x y) (list x y))))
+(define tail-extra (compile (lambda (x) (g x 10 20))))
+(define call-extra (compile (lambda (x) (+ (g x 10) (h x)))))
+
+(check (and (= (g 1 2) (f 1 2))
+            (= (apply g '(1 2 3)) 2)
+            (= (h 1 2) 5)
+            (eq (k 1 (h 2 3) 4) '(1 5))
+            (= (tail-extra 1) 2)
+            (= (call-extra 1) 7)
+            (eq (car (trap (k 1))) 'exit-error)))
@@ -0,0 +1,19 @@
+; Locals from let, var and loop live in frame slots.
+
+(defun sum-to (n)
+  (let ((s 0))
+    (progn
+      (loop ((i 0)) (<= i n)
+            (progn (setq s (+ s i))
+                   (setq i (+ i 1))))
+      s)))
+
+(defun squares (x)
+  (progn
+    (var y (* x x))
+    (var z (+ y 1))
+    (list y z)))
+
+(check (and (= ((compile sum-to) 100) (sum-to 100))
+            (eq ((compile squares) 3) '(9 10))
+            (eq ((compile (lambda (x) (let ((a x) (b (+ a 1))) (list a b)))) 1) '(1 2))))
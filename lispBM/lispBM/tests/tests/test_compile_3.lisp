@@ -0,0 +1,8 @@
+; cond, and and or keep their results.
+
+(define sign (compile (lambda (x) (cond ((< x 0) 'neg) ((= x 0) 'zero) (t 'pos)))))
+(define logic (compile (lambda (a b) (list (and a b) (or a b) (and) (or) (or nil b)))))
+
+(check (and (eq (list (sign -2) (sign 0) (sign 5)) '(neg zero pos))
+            (eq (logic 1 nil) '(nil 1 t nil nil))
+            (eq (logic 1 2) '(2 1 t nil 2))))
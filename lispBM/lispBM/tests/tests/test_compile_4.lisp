@@ -0,0 +1,24 @@
+; Global references follow define, setq and undefine.
+
+(define g 10)
+(define addg (compile (lambda (x) (+ x g))))
+(define r1 (addg 1))
+
+(define g 20)
+(define r2 (addg 1))
+
+(define setg (compile (lambda (x) (setq g x))))
+(setg 5)
+(define r3 g)
+
+(undefine 'g)
+(define r4 (trap (addg 1)))
+(define r5 (trap (setg 1)))
+
+(define g 100)
+(define r6 (addg 1))
+
+(check (and (= r1 11) (= r2 21) (= r3 5)
+            (eq r4 '(exit-error variable_not_bound))
+            (eq (car r5) 'exit-error)
+            (= r6 101)))
@@ -0,0 +1,12 @@
+; Captured variables are shared with the closure environment.
+
+(define make-acc
+  (lambda (a)
+    (list (compile (lambda (x) (setq a (+ a x))))
+          (lambda () a))))
+
+(define acc (make-acc 100))
+((car acc) 1)
+((car acc) 2)
+
+(check (= ((car (cdr acc))) 103))
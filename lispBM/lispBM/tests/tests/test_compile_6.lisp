@@ -0,0 +1,19 @@
+; Compiled closures work with apply, map, sort and spawn, and call
+; extensions and interpreted closures.
+
+(defun fib (n) (if (< n 2) n (+ (fib (- n 1)) (fib (- n 2)))))
+(define fibc (compile fib))
+(define double (lambda (x) (* 2 x)))
+(define f (compile (lambda (x) (str-join (list x (to-str (double 2)))))))
+(define cmp (compile (lambda (a b) (< a b))))
+
+(define res 0)
+(define id (self))
+(spawn (compile (lambda (n) (send id (fibc n)))) 10)
+(recv ((? x) (setq res x)))
+
+(check (and (= (apply fibc '(10)) 55)
+            (eq (map fibc '(1 2 3 4 5)) '(1 1 2 3 5))
+            (eq (sort cmp '(3 1 2)) '(1 2 3))
+            (eq (f "a") "a4")
+            (= res 55)))
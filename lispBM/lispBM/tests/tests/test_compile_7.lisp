@@ -0,0 +1,10 @@
+; Bodies that cannot be compiled leave the closure as it is.
+
+(define f (lambda (x) (eval x)))
+(define g (lambda (x) (map (lambda (y) (+ x y)) '(1 2))))
+(define h (lambda (x) (setvar 'x 1)))
+
+(check (and (eq (compile f) f)
+            (eq (compile g) g)
+            (eq (compile h) h)
+            (eq (trap (compile 1)) '(exit-error type_error))))
@@ -0,0 +1,8 @@
+; Errors in compiled code are reported and can be trapped.
+
+(define f (compile (lambda (x) (+ x 1))))
+(define g (compile (lambda (x y) (car x))))
+
+(check (and (eq (trap (f 'a)) '(exit-error type_error))
+            (eq (car (trap (g 1))) 'exit-error)
+            (= (f 1) 2)))
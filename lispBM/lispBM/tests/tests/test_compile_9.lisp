@@ -0,0 +1,8 @@
+; A compiled loop gives up its time slice so that other threads run.
+
+(define flag nil)
+(spawn (lambda () (setq flag t)))
+(define wait-flag (compile (lambda () (loop ((i 0)) (not flag) (setq i (+ i 1))))))
+(wait-flag)
+
+(check flag)
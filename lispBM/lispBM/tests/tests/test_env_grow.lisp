@@ -0,0 +1,43 @@
+; Many definitions grow the global environment. All bindings
+; must survive the growth and GC. Each binding takes two cons cells,
+; so the number of definitions is kept small enough for a 512 cell heap.
+; Symbol ids are handed out in order and pick the bucket, so three
+; unbound symbols are created before each definition. Only every fourth
+; bucket gets bindings and the chains grow long enough to trigger growth.
+
+(define roots0 (ix (env-stats) 0))
+
+(define gname (lambda (i) (str2sym (str-merge "glob-" (to-str i)))))
+
+(define filler (lambda (i k) (str2sym (str-merge "fill-" (to-str i) "-" (to-str k)))))
+
+(define defs (lambda (i n)
+  (if (= i n) t
+    (progn
+      (filler i 1)
+      (filler i 2)
+      (filler i 3)
+      (eval (list 'define (gname i) i))
+      (defs (+ i 1) n)))))
+
+(define n 64)
+
+(defs 0 n)
+(gc)
+
+(define sum-defs (lambda (i n acc)
+  (if (= i n) acc
+    (sum-defs (+ i 1) n (+ acc (eval (gname i)))))))
+
+(define stats (env-stats))
+
+(setq glob-7 1000)
+(undefine 'glob-8)
+
+(define r1 (> (ix stats 0) roots0))
+(define r2 (>= (ix stats 2) n))
+(define r3 (= (sum-defs 0 8 0) (+ 1000 (- 28 7))))
+(define r4 (eq (trap glob-8) '(exit-error variable_not_bound)))
+(define r5 (= (sum-defs 9 n 0) (- (/ (* n (- n 1)) 2) 36)))
+
+(check (and r1 r2 r3 r4 r5))
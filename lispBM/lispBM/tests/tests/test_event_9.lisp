@@ -0,0 +1,13 @@
+
+; Several C threads send events concurrently through the lock free
+; event queue. All of them arrive, none are dropped.
+(event-register-handler (self))
+(set-mailbox-size 400)
+
+(event-isr-threads 50)
+
+(defun collect (n acc)
+  (if (= n 0) acc
+    (recv ((? x) (collect (- n 1) (+ acc x))))))
+
+(check (= (collect 200 0) (* 4 1275)))
@@ -0,0 +1,20 @@
+
+; Floats of small, large and boundary magnitudes keep their type and value.
+(define fs (list 0.0 -0.0 0.0078125 -0.0078125 0.0078124 255.99998 256.0 -256.0 1.5 -3.25 1.0e-5 1.0e5 1.0e30))
+
+(define r1 (and (eq (map (lambda (x) (type-of x)) fs)
+                    (map (lambda (x) type-float) fs))
+                (eq (map (lambda (x) (- (+ x 1.0) 1.0)) '(1.5 -3.25 100.0))
+                    '(1.5 -3.25 100.0))
+                (= (* 0.5 0.5) 0.25)
+                (= (+ 200.0 100.0) 300.0)
+                (= (/ 1.0 256.0) 0.00390625)
+                (< 0.0078124 0.0078125)
+                (> 256.0 255.99998)
+                (= 0.0 -0.0)
+                (eq (to-i 255.5) 255)
+                (eq (to-i -0.0) 0)))
+
+(define r2 (eq (unflatten (flatten fs)) fs))
+
+(check (and r1 r2))
@@ -0,0 +1,67 @@
+; Incremental GC with a small pause budget. Lists, arrays and global
+; bindings are updated while collections are in progress. The budget
+; lets a cycle finish before the loop below has used up the free half
+; of a large heap.
+
+(set-gc-pause-budget 64)
+(gc-stats-reset)
+
+(define incremental-cycles (lambda () (ix (gc-histogram 'trigger) 3)))
+
+; Run at least 32 iterations and keep going until an incremental cycle
+; has completed. With LBM_ALWAYS_GC every allocation collects directly
+; and incremental cycles never complete.
+(define max-iter 10000)
+(define i 1)
+(define tail-list (list 0))
+(define last-cell tail-list)
+(define g nil)
+(define av (mkarray 2))
+
+; Old lists that are swapped between two arrays. Each list is only
+; reachable from one of the arrays at a time.
+(define sa (mkarray 8))
+(define sb (mkarray 8))
+(loopfor j 0 (< j 8) (+ j 1)
+         (progn
+           (setix sa j (list j))
+           (setix sb j (list (+ j 8)))))
+
+(defun swapped-sum (j acc)
+  (if (= j 8) acc
+    (swapped-sum (+ j 1) (+ acc (car (ix sa j)) (car (ix sb j))))))
+
+(loopwhile (and (< i max-iter)
+                (or (< i 32)
+                    (and (not (is-always-gc)) (= (incremental-cycles) 0))))
+         (progn
+           ; garbage
+           (range 0 16)
+           ; grow a list at the tail
+           (setcdr last-cell (list i))
+           (setq last-cell (cdr last-cell))
+           ; replace a global binding
+           (setq g (list i i i))
+           ; store into a lisp array
+           (setix av 0 (list i (+ i 1)))
+           (setix av 1 i)
+           ; move old lists between the arrays
+           (let ((k (mod i 8))
+                 (tmp (ix sa k)))
+             (progn
+               (setix sa k (ix sb k))
+               (setix sb k tmp)))
+           (setq i (+ i 1))))
+
+(define n i)
+(define r0 (or (is-always-gc) (> (incremental-cycles) 0)))
+
+(define r1 (= (length tail-list) n))
+(define r2 (= (foldl + 0 tail-list) (/ (* (- n 1) n) 2)))
+(define r3 (eq g (list (- n 1) (- n 1) (- n 1))))
+(define r4 (and (eq (ix av 0) (list (- n 1) n)) (= (ix av 1) (- n 1))))
+(define r5 (= (swapped-sum 0 0) 120))
+
+(set-gc-pause-budget 0)
+
+(check (and r0 r1 r2 r3 r4 r5))
@@ -0,0 +1,49 @@
+; Deeply nested lisp arrays, with shared and cyclic references, must
+; survive repeated garbage collection. Each level of nesting takes one
+; cons cell, so that the test runs in a 512 cell heap.
+
+; Marking with the GC stack takes one entry per level of nesting.
+(set-gc-stack-size 400)
+
+(define nest (lambda (n acc)
+               (if (= n 0)
+                   acc
+                 (nest (- n 1) (array n acc)))))
+
+(define depth 150)
+(define deep (nest depth 'bottom))
+
+; An array of arrays sharing a single lookup table.
+(define table (array 10 20 30 40))
+(define rows (mkarray 32))
+(looprange i 0 32 (setix rows i (array i table (list i))))
+
+; An array containing itself.
+(define cyc (mkarray 3))
+(setix cyc 0 cyc)
+(setix cyc 1 (list 1 2 3))
+(setix cyc 2 cyc)
+
+(define walk (lambda (a n)
+               (if (eq a 'bottom)
+                   n
+                 (if (= (ix a 0) (+ n 1))
+                     (walk (ix a 1) (+ n 1))
+                   -1))))
+
+(define check-all (lambda ()
+                    (and (= (walk deep 0) depth)
+                         (= (ix (ix (ix rows 31) 1) 3) 40)
+                         (eq (ix (ix rows 0) 1) (ix (ix rows 31) 1))
+                         (eq (ix (ix (ix cyc 0) 2) 1) (list 1 2 3))
+                         (eq (ix cyc 1) (list 1 2 3)))))
+
+(define stress (lambda (n)
+                 (if (= n 0)
+                     t
+                   (progn
+                     (gc)
+                     (range 50)
+                     (if (check-all) (stress (- n 1)) nil)))))
+
+(check (stress 20))
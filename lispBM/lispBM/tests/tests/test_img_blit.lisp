@@ -0,0 +1,36 @@
+; Unscaled blits between two buffers. Each destination pixel inside the
+; blitted area has to be the source pixel, or stay as it was where the
+; source has the transparent color.
+
+(define px565 (lambda (b w x y)
+  (bufget-u16 b (+ 5 (* 2 (+ (* y w) x))))))
+
+(define blit-ok (lambda (px dst dw dh src sw sh ox oy tc bg)
+  (let ((ok t))
+    (progn
+      (loopfor y 0 (< y dh) (+ y 1)
+        (loopfor x 0 (< x dw) (+ x 1)
+          (let ((sx (- x ox))
+                (sy (- y oy))
+                (s (if (and (>= sx 0) (< sx sw) (>= sy 0) (< sy sh)) (px src sw sx sy) tc))
+                (expected (if (= s tc) bg s)))
+            (if (not (= (px dst dw x y) expected))
+                (setq ok nil)))))
+      ok))))
+
+; rgb565, the source has black pixels on a diagonal.
+(define src (img-buffer 'rgb565 5 3))
+(loopfor y 0 (< y 3) (+ y 1)
+  (loopfor x 0 (< x 5) (+ x 1)
+    (if (not (= x y))
+        (img-setpix src x y (+ 0x100000 (* 0x10 x) (* 0x1000 y))))))
+
+(define dst (img-buffer 'rgb565 8 6))
+(img-blit dst src 2 1 -1)
+(define same-565 (blit-ok px565 dst 8 6 src 5 3 2 1 -1 0))
+
+(img-clear dst 0x00FF00)
+(img-blit dst src -1 4 0)
+(define transparent-565 (blit-ok px565 dst 8 6 src 5 3 -1 4 0 0x07E0))
+
+(check (and same-565 transparent-565))
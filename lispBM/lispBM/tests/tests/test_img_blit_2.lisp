@@ -0,0 +1,37 @@
+; Unscaled blits of indexed buffers, see test_img_blit.lisp.
+
+(define px4 (lambda (b w x y)
+  (let ((pos (+ (* y w) x)))
+    (bitwise-and (shr (bufget-u8 b (+ 5 (/ pos 4))) (* 2 (- 3 (mod pos 4)))) 3))))
+
+(define blit-ok (lambda (px dst dw dh src sw sh ox oy tc bg)
+  (let ((ok t))
+    (progn
+      (loopfor y 0 (< y dh) (+ y 1)
+        (loopfor x 0 (< x dw) (+ x 1)
+          (let ((sx (- x ox))
+                (sy (- y oy))
+                (s (if (and (>= sx 0) (< sx sw) (>= sy 0) (< sy sh)) (px src sw sx sy) tc))
+                (expected (if (= s tc) bg s)))
+            (if (not (= (px dst dw x y) expected))
+                (setq ok nil)))))
+      ok))))
+
+; indexed4, four pixels per byte. Offsets that do not match the
+; position of the source pixels in their bytes and ones that do.
+(define isrc (img-buffer 'indexed4 9 2))
+(loopfor y 0 (< y 2) (+ y 1)
+  (loopfor x 0 (< x 9) (+ x 1)
+    (img-setpix isrc x y (mod (+ x y 1) 4))))
+
+(define idst (img-buffer 'indexed4 16 3))
+(define indexed-ok (lambda (ox oy)
+  (progn
+    (img-clear idst 0)
+    (img-blit idst isrc ox oy -1)
+    (blit-ok px4 idst 16 3 isrc 9 2 ox oy -1 0))))
+
+(define unaligned (and (indexed-ok 3 0) (indexed-ok -1 1) (indexed-ok 10 1)))
+(define aligned (indexed-ok 4 1))
+
+(check (and unaligned aligned))
@@ -0,0 +1,42 @@
+; img-clear fills every pixel. rgb565 and rgb888 are filled with a
+; doubled pattern, an odd width puts the rows at odd offsets.
+(define w 7)
+(define h 5)
+
+(define px565 (lambda (b x y)
+  (bufget-u16 b (+ 5 (* 2 (+ (* y w) x))))))
+
+(define px888 (lambda (b x y)
+  (let ((i (+ 5 (* 3 (+ (* y w) x)))))
+    (+ (shl (bufget-u8 b i) 16) (shl (bufget-u8 b (+ i 1)) 8) (bufget-u8 b (+ i 2))))))
+
+; True when the pixels in the box x0,y0 - x1,y1 are in-box and the
+; others are out.
+(define all-pixels (lambda (b px in-box x0 y0 x1 y1 out)
+  (let ((ok t))
+    (progn
+      (loopfor y 0 (< y h) (+ y 1)
+        (loopfor x 0 (< x w) (+ x 1)
+          (let ((inside (and (>= x x0) (<= x x1) (>= y y0) (<= y y1))))
+            (if (not (= (px b x y) (if inside in-box out)))
+                (setq ok nil)))))
+      ok))))
+
+(define a (img-buffer 'rgb565 w h))
+(img-clear a 0xFF0000)
+(define clear-565 (all-pixels a px565 0xF800 0 0 (- w 1) (- h 1) 0))
+
+(define b (img-buffer 'rgb888 w h))
+(img-clear b 0x123456)
+(define clear-888 (all-pixels b px888 0x123456 0 0 (- w 1) (- h 1) 0))
+
+; Filled rectangles are drawn as horizontal lines, clipped to the image.
+(img-clear a 0)
+(img-rectangle a -2 1 5 3 0x00FF00 '(filled))
+(define hline-565 (all-pixels a px565 0x07E0 0 1 2 3 0))
+
+(img-clear b 0)
+(img-rectangle b 4 3 10 4 0x0000FF '(filled))
+(define hline-888 (all-pixels b px888 0x0000FF 4 3 6 4 0))
+
+(check (and clear-565 clear-888 hline-565 hline-888))
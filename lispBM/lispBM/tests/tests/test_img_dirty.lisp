@@ -0,0 +1,53 @@
+; Dirty region tracking. render-log returns the (x y w h first-pixel)
+; of every disp-render since the last call.
+
+(define img (img-buffer 'rgb332 32 32 'dirty-track))
+(define all-dirty (eq (img-dirty img) '((0 0 32 32))))
+
+(render-log)
+(disp-render-dirty img 10 20)
+(define full-render (eq (render-log) '((10 20 32 32 0))))
+(define cleared (eq (img-dirty img) nil))
+(disp-render-dirty img 10 20)
+(define clean-render (eq (render-log) nil))
+
+; Neighbours merge, distant rects are kept apart.
+(img-setpix img 5 6 0xFF0000)
+(img-setpix img 6 6 0x00FF00)
+(define merged (eq (img-dirty img) '((5 6 2 1))))
+(img-dirty-mark img 20 20 8 8)
+(define apart (eq (img-dirty img) '((5 6 2 1) (20 20 8 8))))
+
+(disp-render-dirty img 10 20)
+(define sub-renders (eq (render-log) '((15 26 2 1 0xFF0000) (30 40 8 8 0))))
+(define sub-cleared (eq (img-dirty img) nil))
+
+; Marks are clipped to the image and dropped when outside of it.
+(img-dirty-mark img -4 -4 8 8)
+(img-dirty-mark img 30 30 8 8)
+(img-dirty-mark img 40 40 4 4)
+(define clipped (eq (img-dirty img) '((0 0 4 4) (30 30 2 2))))
+(img-dirty-mark img)
+(define mark-all (eq (img-dirty img) '((0 0 32 32))))
+(disp-render img 0 0)
+(define render-clears (and (eq (img-dirty img) nil)
+                           (eq (render-log) '((0 0 32 32 0)))))
+
+; Running out of rects merges the new one into the cheapest, here
+; two 10x10 rects into a 22x22 one.
+(define big (img-buffer 'indexed2 112 112 'dirty-track))
+(disp-render big 0 0)
+(render-log)
+(define mark-diag (lambda (i)
+  (if (= i 9) t
+    (progn (img-dirty-mark big (* i 12) (* i 12) 10 10)
+           (mark-diag (+ i 1))))))
+(mark-diag 0)
+(define big-rects (img-dirty big))
+(define overflow (and (= (length big-rects) 8)
+                      (eq (ix big-rects 0) '(0 0 10 10))
+                      (eq (ix big-rects 7) '(84 84 22 22))))
+
+(check (and all-dirty full-render cleared clean-render
+            merged apart sub-renders sub-cleared
+            clipped mark-all render-clears overflow))
@@ -0,0 +1,44 @@
+; Dirty rects reported after each drawer, see test_img_dirty.lisp.
+
+(define img (img-buffer 'rgb332 32 32 'dirty-track))
+(define before (img-buffer 'rgb332 32 32))
+(define after (img-buffer 'rgb332 32 32))
+
+(define area (lambda (rs)
+  (if (eq rs nil) 0
+    (+ (* (ix (car rs) 2) (ix (car rs) 3)) (area (cdr rs))))))
+
+(define blank (lambda (b rs)
+  (loopforeach r rs
+    (img-rectangle b (ix r 0) (ix r 1) (ix r 2) (ix r 3) 0 '(filled)))))
+
+; Draws with f and checks that it changed the image, that the changes
+; are covered by the dirty rects and that those are at most max-area
+; pixels. The changes are covered when the images before and after are
+; the same with the rects blanked out.
+(define drawer-ok (lambda (f max-area)
+  (progn
+    (img-blit before img 0 0 -1)
+    (disp-render-dirty img 0 0)
+    (render-log)
+    (f)
+    (img-blit after img 0 0 -1)
+    (let ((rs (img-dirty img))
+          (changed (not (eq after before))))
+      (progn
+        (blank before rs)
+        (blank after rs)
+        (and changed
+             (<= (area rs) max-area)
+             (eq after before)))))))
+
+(define drawers-ok
+  (and (drawer-ok (lambda () (img-setpix img 31 31 0xFF0000)) 1)
+       (drawer-ok (lambda () (img-line img 2 3 12 7 0x00FF00 '(thickness 2))) 135)
+       (drawer-ok (lambda () (img-rectangle img 20 4 10 6 0x0000FF '(filled))) 77)
+       (drawer-ok (lambda () (img-circle img 16 16 5 0xFFFFFF)) 169)
+       (drawer-ok (lambda () (img-triangle img 1 20 9 28 1 28 0xFF0000 '(filled))) 81)
+       (drawer-ok (lambda () (img-arc img 16 16 8 0 90 0x00FF00)) 361)
+       (drawer-ok (lambda () (img-clear img 0xFFFFFF)) 1024)))
+
+(check drawers-ok)
@@ -0,0 +1,25 @@
+; Turning dirty region tracking off and on, see test_img_dirty.lisp.
+
+(define img (img-buffer 'rgb332 32 32 'dirty-track))
+(disp-render-dirty img 0 0)
+
+; Tracking can be turned off and on, which makes all of it dirty.
+(img-dirty-track img nil)
+(img-setpix img 1 1 0xFF0000)
+(define off (eq (img-dirty img) nil))
+(img-dirty-track img)
+(define on (eq (img-dirty img) '((0 0 32 32))))
+
+; The state belongs to the buffer. A buffer allocated without room for
+; it cannot be tracked, also not when it reuses the memory of a
+; tracked one.
+(define dm (dm-create 2048))
+(define a (img-buffer dm 'rgb332 16 16 'dirty-track))
+(define dm-tracked (eq (img-dirty a) '((0 0 16 16))))
+(setq a nil)
+(gc)
+(define b (img-buffer dm 'rgb332 16 16))
+(define untracked (and (eq (img-dirty b) nil)
+                       (eq (trap (img-dirty-track b)) '(exit-error eval_error))))
+
+(check (and off on dm-tracked untracked))
@@ -0,0 +1,37 @@
+
+; The mailbox is a ring buffer. Messages keep their order when the
+; buffer wraps, when messages are taken from the middle and when the
+; oldest message is dropped on a full mailbox.
+(set-mailbox-size 5)
+
+(defun take-any ()
+  (recv ((? x) x)))
+
+(defun send-range (from to)
+  (if (> from to) t
+    (progn (send (self) from)
+           (send-range (+ from 1) to))))
+
+(send-range 1 3)
+(define r1 (eq (take-any) 1))
+(define r2 (eq (take-any) 2))
+; Wraps around the end of the buffer.
+(send-range 4 7)
+(define r3 (eq (recv (5 5)) 5))
+(define r4 (eq (recv (6 6)) 6))
+(define r5 (eq (list (take-any) (take-any) (take-any)) '(3 4 7)))
+
+; Full mailbox drops the oldest messages.
+(send-range 10 16)
+(define r6 (eq (recv (13 13)) 13))
+(define r7 (eq (list (take-any) (take-any) (take-any) (take-any)) '(12 14 15 16)))
+
+; Resizing keeps the order.
+(send-range 20 23)
+(define r8 (eq (take-any) 20))
+(set-mailbox-size 10)
+(send-range 24 26)
+(define r9 (eq (list (take-any) (take-any) (take-any) (take-any) (take-any) (take-any))
+               '(21 22 23 24 25 26)))
+
+(check (and r1 r2 r3 r4 r5 r6 r7 r8 r9))
@@ -0,0 +1,17 @@
+;; Compiled closures that wait for a call show up in folded stacks.
+(define ctx (str-join (list "ctx-" (to-str (self)))))
+(define hc (compile (lambda (x) (list x))))
+(define fc (compile (lambda () (hc (prof-sample)))))
+(define deepc (compile (lambda (n) (if (= n 0) (prof-sample) (hc (deepc (- n 1)))))))
+
+(prof-start)
+(fc)
+(fc)
+(define two (prof-folded 128))
+
+(prof-start)
+(deepc 3)
+(define deep (prof-folded 128))
+
+(check (and (eq two (list (str-join (list ctx ";fc;prof-sample 2"))))
+            (eq deep (list (str-join (list ctx ";deepc;deepc;deepc;prof-sample 1"))))))
@@ -0,0 +1,19 @@
+;; Folded stacks of samples taken by hand with prof-sample.
+(define h (lambda (x) (list x)))
+(define ctx (str-join (list "ctx-" (to-str (self)))))
+
+(prof-start)
+(h (prof-sample))
+(h (prof-sample))
+(define two (prof-folded 128))
+;; A short line keeps the count.
+(define short (prof-folded (+ (str-len ctx) 5)))
+
+(prof-start)
+(define deep (lambda (n) (if (= n 0) (prof-sample) (h (deep (- n 1))))))
+(deep 10)
+(define truncated (prof-folded 128))
+
+(check (and (eq two (list (str-join (list ctx ";h;prof-sample 2"))))
+            (eq short (list (str-join (list ctx ";h 2"))))
+            (eq truncated (list (str-join (list ctx ";...;h;h;h;h;h;h;h;prof-sample 1"))))))
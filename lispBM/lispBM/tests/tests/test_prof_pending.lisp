@@ -0,0 +1,12 @@
+;; Pending applications are listed innermost first, closures by their
+;; body and extensions by their symbol.
+(define f (lambda (x) (list 'f x)))
+(define g (lambda (x) (list 'g x)))
+
+(define nested (f (g (pending-apps 8))))
+(define in-ext (to-str (pending-apps 8)))
+(define cut (f (f (f (pending-apps 2)))))
+
+(check (and (eq nested '(f (g (nil (list 'g x) (list 'f x)))))
+            (eq in-ext "(nil to-str)")
+            (eq cut '(f (f (f (t (list 'f x) (list 'f x))))))))
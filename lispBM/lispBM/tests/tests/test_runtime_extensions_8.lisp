@@ -0,0 +1,45 @@
+(define sum (lambda (ls) (foldl + 0 ls)))
+
+(gc-stats-reset)
+(gc)
+(gc)
+
+(define gclog (gc-log))
+
+;; Collections triggered by allocation can be logged between the
+;; explicit ones, as with LBM_ALWAYS_GC.
+(define explicit-recs
+  (lambda (ls)
+    (cond ((eq ls nil) nil)
+          ((eq (ix (car ls) 0) 'explicit) (cons (car ls) (explicit-recs (cdr ls))))
+          (t (explicit-recs (cdr ls))))))
+
+(define explicit (explicit-recs gclog))
+(define rec (first explicit))
+
+(define r1 (and (>= (length explicit) 2)
+                (= (length rec) 11)
+                (= (ix rec 4) (self))))
+
+;; Every collection is counted in both histograms. Collections can run
+;; between reading the two, so heap-use is read first.
+(define heap-use-hist (gc-histogram 'heap-use))
+(define pause-hist (gc-histogram 'pause))
+
+(define r2 (and (>= (ix (gc-histogram 'trigger) 2) 2)
+                (= (length pause-hist) 12)
+                (= (length heap-use-hist) 10)
+                (>= (sum pause-hist) (sum heap-use-hist))
+                (>= (sum heap-use-hist) 2)))
+
+(define r3 (= (length (gc-log 1)) 1))
+
+(define n0 (ctx-alloc-cells (self)))
+(define garbage (range 100))
+(yield 10)
+(define n1 (ctx-alloc-cells (self)))
+
+(define r4 (and (>= (- n1 n0) 100)
+                (> (assoc (ctx-alloc-cells) (self)) 0)))
+
+(check (and r1 r2 r3 r4))
@@ -0,0 +1,31 @@
+
+; Sleeping and timeout blocked threads wake up in deadline order.
+(define me (self))
+
+(defun sleeper (n dt)
+  (progn (sleep dt)
+         (send me n)))
+
+(defun waiter (n dt)
+  (progn (recv-to dt (_ nil))
+         (send me n)))
+
+(spawn sleeper 5 0.25)
+(spawn waiter 2 0.1)
+(spawn sleeper 4 0.2)
+(spawn sleeper 1 0.05)
+(spawn waiter 3 0.15)
+
+(defun collect (n acc)
+  (if (= n 0) (reverse acc)
+    (recv ((? x) (collect (- n 1) (cons x acc))))))
+
+(define order (collect 5 nil))
+
+; A waiter that gets a message before its timeout leaves the timers.
+(define w (spawn waiter 10 10.0))
+(send w 'hello)
+(define early (recv-to 1.0 (10 t) (timeout nil)))
+
+(check (and (eq order '(1 2 3 4 5))
+            early))
@@ -0,0 +1,41 @@
+;; Many runtime symbols, so that the symbol index has to grow a few times.
+;; The symbols are not kept in a list, so that the test runs in small heaps.
+(define n 600)
+
+(defun mk-name (i) (str-merge "sym-index-" (to-str i)))
+
+(defun mk-syms (i)
+  (if (= i n)
+      t
+    (progn (str2sym (mk-name i)) (mk-syms (+ i 1)))))
+
+(mk-syms 0)
+
+(define s17 (str2sym (mk-name 17)))
+(define s42 (str2sym (mk-name 42)))
+
+;; name -> symbol -> name, and all symbols are distinct
+(defun check-names (i)
+  (cond ((= i n) t)
+        ((let ((s (str2sym (mk-name i))))
+           (and (eq (sym2str s) (mk-name i))
+                (eq (= i 17) (eq s s17))))
+         (check-names (+ i 1)))
+        (t nil)))
+
+(define r1 (check-names 0))
+
+;; Special symbols, aliases and extensions resolve as before
+(define r3 (and (eq (str2sym "car") 'car)
+                (eq (str2sym "first") 'car)
+                (eq (sym2str 'car) "car")
+                (eq (str2sym "define") 'define)
+                (eq (str2sym "ext-even") 'ext-even)
+                (eq (sym2str 'ext-even) "ext-even")
+                (ext-even 2)))
+
+;; Reading source text creates and finds symbols through the same index
+(define r4 (eq (read "sym-index-42") s42))
+(define r5 (= (eval (read "(+ 1 2)")) 3))
+
+(check (and r1 r3 r4 r5))
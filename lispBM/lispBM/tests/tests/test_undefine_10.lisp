@@ -0,0 +1,15 @@
+; Looked up globals must not survive undefine.
+
+(define apa 1)
+(define bepa (+ apa 1))
+
+(undefine 'apa)
+
+(define r1 (trap apa))
+
+(define apa 10)
+(setq apa (+ apa 1))
+
+(check (and (eq r1 '(exit-error variable_not_bound))
+            (= bepa 2)
+            (= apa 11)))
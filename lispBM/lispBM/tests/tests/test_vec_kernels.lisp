@@ -0,0 +1,54 @@
+(define n 32)
+(define x (bufcreate (* 4 n)))
+(define y (bufcreate (* 4 n)))
+(define z (bufcreate (* 4 n)))
+
+(define fill-x (lambda (i)
+  (if (= i n) t
+    (progn
+      (bufset-f32 x (* 4 i) (to-float (mod (* i 7) 11)) 'little-endian)
+      (fill-x (+ i 1))))))
+(fill-x 0)
+
+;; Low pass biquad, filtered at once and in two blocks with state.
+(define coeffs (bufcreate 20))
+(bufset-f32 coeffs 0 0.2 'little-endian)
+(bufset-f32 coeffs 4 0.4 'little-endian)
+(bufset-f32 coeffs 8 0.2 'little-endian)
+(bufset-f32 coeffs 12 -0.3 'little-endian)
+(bufset-f32 coeffs 16 0.1 'little-endian)
+
+(vec-biquad 'f32 y x coeffs)
+
+(define st (bufcreate 8))
+(define half (bufcreate (* 2 n)))
+(define half2 (bufcreate (* 2 n)))
+(bufcpy half 0 x 0 (* 2 n))
+(bufcpy half2 0 x (* 2 n) (* 2 n))
+(vec-biquad 'f32 half half coeffs st)
+(vec-biquad 'f32 half2 half2 coeffs st)
+(bufcpy z 0 half 0 (* 2 n))
+(bufcpy z (* 2 n) half2 0 (* 2 n))
+
+(define same (lambda (i)
+  (if (= i n) t
+    (and (= (bufget-f32 y (* 4 i) 'little-endian) (bufget-f32 z (* 4 i) 'little-endian))
+         (same (+ i 1))))))
+(define blocks-ok (same 0))
+
+;; y = 2x + x, then the integer types saturate.
+(vec-scale 'f32 y x 2)
+(vec-axpy 'f32 y 1 x)
+(define scaled (= (vec-sum 'f32 y) (* 3 (vec-sum 'f32 x))))
+
+(define s (bufcreate 4))
+(bufset-i16 s 0 -20000 'little-endian)
+(bufset-i16 s 2 20000 'little-endian)
+(vec-mul 'i16 s s s)
+
+(check (and blocks-ok
+            scaled
+            (= (bufget-i16 s 0 'little-endian) 32767)
+            (= (vec-dot 'f32 x x) (vec-dot 'f32 x x))
+            (eq (vec-min 'i32 (bufcreate 0)) nil)
+            (eq (trap (vec-add 'u8 y x x)) '(exit-error type_error))))
@@ -0,0 +1,45 @@
+;; i32 elements above 2^24 go through the kernels unchanged.
+(define n 4)
+(define x (bufcreate (* 4 n)))
+(define y (bufcreate (* 4 n)))
+(define d (bufcreate (* 4 n)))
+
+(bufset-i32 y 0 16777217 'little-endian)
+(bufset-i32 y 4 2147483647 'little-endian)
+(bufset-i32 y 8 -2147483647 'little-endian)
+(bufset-i32 y 12 123456789 'little-endian)
+(bufset-i32 x 0 1 'little-endian)
+(bufset-i32 x 4 -1 'little-endian)
+(bufset-i32 x 8 2 'little-endian)
+(bufset-i32 x 12 -3 'little-endian)
+
+(define same-as-y (lambda (b i)
+  (if (= i n) t
+    (and (= (bufget-i32 b (* 4 i) 'little-endian) (bufget-i32 y (* 4 i) 'little-endian))
+         (same-as-y b (+ i 1))))))
+
+(define one (bufcreate 4))
+(bufset-f32 one 0 1.0 'little-endian)
+(define pass (bufcreate 20))
+(bufset-f32 pass 0 1.0 'little-endian)
+
+(vec-axpy 'i32 y 0 x)
+(define axpy-ok (same-as-y y 0))
+(vec-scale 'i32 d y 1)
+(define scale-ok (same-as-y d 0))
+(vec-fir 'i32 d y one)
+(define fir-ok (same-as-y d 0))
+(vec-biquad 'i32 d y pass)
+(define biquad-ok (same-as-y d 0))
+(vec-movavg 'i32 d y 1)
+(define movavg-ok (same-as-y d 0))
+(vec-resample 'i32 d y)
+(define resample-ok (same-as-y d 0))
+
+(vec-axpy 'i32 y 1 x)
+
+(check (and axpy-ok scale-ok fir-ok biquad-ok movavg-ok resample-ok
+            (= (bufget-i32 y 0 'little-endian) 16777218)
+            (= (bufget-i32 y 4 'little-endian) 2147483646)
+            (= (bufget-i32 y 8 'little-endian) -2147483645)
+            (= (bufget-i32 y 12 'little-endian) 123456786)))
@@ -0,0 +1,32 @@
+;; i16 results are rounded half away from zero.
+(define mk (lambda (xs)
+  (let ((b (bufcreate (* 2 (length xs)))))
+    (progn
+      (map (lambda (i) (bufset-i16 b (* 2 i) (ix xs i) 'little-endian)) (range (length xs)))
+      b))))
+
+(define elems (lambda (b)
+  (map (lambda (i) (bufget-i16 b (* 2 i) 'little-endian)) (range (/ (buflen b) 2)))))
+
+(define a (mk '(1 2 -1 -2)))
+(define d (bufcreate 8))
+(vec-movavg 'i16 d a 2)
+(define movavg-r (elems d))
+
+(define d3 (bufcreate 6))
+(vec-resample 'i16 d3 (mk '(0 1)))
+(define up-r (elems d3))
+(vec-resample 'i16 d3 (mk '(0 -1)))
+(define down-r (elems d3))
+
+(define s (mk '(3 -3 32767)))
+(vec-scale 'i16 d3 s 0.5)
+(define scale-r (elems d3))
+
+(define iv (vec-interp 'i16 (mk '(0 10)) (mk '(0 100)) 2.5))
+
+(check (and (eq movavg-r '(1 2 1 -2))
+            (eq up-r '(0 1 1))
+            (eq down-r '(0 -1 -1))
+            (eq scale-r '(2 -2 16384))
+            (= iv 25.0)))
@@ -14,6 +14,7 @@ LISPBMSRC = $(LISPBM)/src/env.c \
             $(LISPBM)/platform/chibios/src/platform_mutex.c \
             $(LISPBM)/src/lbm_channel.c \
             $(LISPBM)/src/lbm_c_interop.c \
+            $(LISPBM)/src/lbm_bytecode.c \
             $(LISPBM)/src/lbm_custom_type.c \
             $(LISPBM)/src/lbm_flags.c \
             $(LISPBM)/src/lbm_flat_value.c \
@@ -51,12 +51,14 @@
 #define PRINT_STACK_SIZE			128
 #define EXT_LOAD_CALLBACK_LEN		20
 #define PROF_DATA_NUM				30
+#define PROF_STACKS_NUM				32
 
 __attribute__((section(".ram4"))) static lbm_cons_t heap[HEAP_SIZE] __attribute__ ((aligned (8)));
 static uint32_t memory_array[LISP_MEM_SIZE];
 __attribute__((section(".ram4"))) static uint32_t bitmap_array[LISP_MEM_BITMAP_SIZE];
 __attribute__((section(".ram4"))) static lbm_extension_t extension_storage[EXTENSION_STORAGE_SIZE];
 __attribute__((section(".ram4"))) static lbm_prof_t prof_data[PROF_DATA_NUM];
+static lbm_prof_stack_t *prof_stacks = NULL;
 static volatile bool prof_running = false;
 
 static lbm_string_channel_state_t string_tok_state;
@@ -81,10 +83,12 @@ static char *repl_buffer = 0;
 static volatile systime_t repl_time = 0;
 static int restart_cnt = 0;
 static volatile bool const_write_error = false;
+static BSEMAPHORE_DECL(eval_wakeup_sem, true);
 
 // Private functions
 static uint32_t timestamp_callback(void);
 static void sleep_callback(uint32_t us);
+static void wakeup_callback(void);
 static bool image_write(uint32_t w, int32_t ix, bool const_heap);
 
 // Extension load callbacks
@@ -142,6 +146,58 @@ static void print_ctx_info(eval_context_t *ctx, void *arg1, void *arg2) {
 	commands_printf_lisp("Result%s: %s", print_ret ? "" : " (trunc)", output);
 }
 
+static void print_ctx_alloc(eval_context_t *ctx, void *arg1, void *arg2) {
+	(void) arg1;
+	(void) arg2;
+	commands_printf_lisp("  %d\t%u\t%s", ctx->id, ctx->alloc_cells, ctx->name ? ctx->name : "");
+}
+
+static void print_gc_stats(void) {
+	static const char *trigger_names[LBM_GC_NUM_TRIGGERS] = {"alloc", "request", "explicit", "incr"};
+	const lbm_gc_stats_t *stats = lbm_get_gc_stats();
+
+	commands_printf_lisp("--(GC)--");
+	commands_printf_lisp("Collections: %u, max pause: %u us", stats->num, stats->max_pause_us);
+	commands_printf_lisp("Triggers: alloc %u, request %u, explicit %u, incremental %u",
+			stats->triggers[LBM_GC_TRIGGER_ALLOC], stats->triggers[LBM_GC_TRIGGER_REQUEST],
+			stats->triggers[LBM_GC_TRIGGER_EXPLICIT], stats->triggers[LBM_GC_TRIGGER_INCREMENTAL]);
+
+	commands_printf_lisp("Pauses:");
+	for (int i = 0; i < LBM_GC_PAUSE_BUCKETS; i ++) {
+		if (stats->pause_hist[i] == 0) {
+			continue;
+		}
+		if (i == 0) {
+			commands_printf_lisp("  < 32 us: %u", stats->pause_hist[i]);
+		} else if (i == LBM_GC_PAUSE_BUCKETS - 1) {
+			commands_printf_lisp("  >= %u us: %u", 16u << i, stats->pause_hist[i]);
+		} else {
+			commands_printf_lisp("  %u - %u us: %u", 16u << i, (32u << i) - 1, stats->pause_hist[i]);
+		}
+	}
+
+	commands_printf_lisp("Heap use after GC:");
+	for (int i = 0; i < LBM_GC_USE_BUCKETS; i ++) {
+		if (stats->use_hist[i]) {
+			commands_printf_lisp("  %d - %d %%: %u", i * 10, i * 10 + 9, stats->use_hist[i]);
+		}
+	}
+
+	commands_printf_lisp("Recent collections, newest first:");
+	commands_printf_lisp("  Trigger\tMark us\tSweep us\tFreed\tFree\tMem free\tLongest\tCID");
+	lbm_gc_record_t rec;
+	for (lbm_uint i = 0; lbm_get_gc_record(i, &rec); i ++) {
+		commands_printf_lisp("  %s\t%u\t%u\t%u\t%u\t%u\t%u\t%d",
+				trigger_names[rec.trigger], rec.mark_us, rec.sweep_us, rec.recovered,
+				rec.free_after, rec.mem_free * 4, rec.mem_longest_free * 4, rec.cid);
+	}
+
+	commands_printf_lisp("Allocated cells per context:");
+	commands_printf_lisp("  CID\tCells\tName");
+	lbm_all_ctxs_iterator(print_ctx_alloc, NULL, NULL);
+	commands_printf_lisp(" ");
+}
+
 static void sym_it(const char *str) {
 	bool sym_name_flash = lbm_symbol_in_flash((char *)str);
 	bool sym_entry_flash = lbm_symbol_list_entry_in_flash((char *)str);
@@ -151,6 +207,25 @@ static void sym_it(const char *str) {
 							str);
 }
 
+// The stack samples are kept in LBM memory from ':prof start' until the
+// next start or restart, so that they can be exported after ':prof stop'.
+static void prof_init(void) {
+	lbm_prof_init(prof_data, PROF_DATA_NUM);
+	if (prof_stacks) {
+		lbm_free(prof_stacks);
+	}
+	prof_stacks = lbm_malloc_reserve(PROF_STACKS_NUM * sizeof(lbm_prof_stack_t));
+	if (prof_stacks) {
+		lbm_prof_init_stacks(prof_stacks, PROF_STACKS_NUM);
+	} else {
+		commands_printf_lisp("No memory for stack samples\n");
+	}
+}
+
+static void prof_emit_folded(const char *line) {
+	commands_printf_lisp("%s", line);
+}
+
 static void prof_thd_wrapper(void *v) {
 	(void)v;
 
@@ -252,7 +327,7 @@ void lispif_process_cmd(unsigned char *data, unsigned int len,
 
 		if (pause_eval(0, 2000)) {
 			lbm_value *glob_env = lbm_get_global_env();
-			for (int i = 0; i < GLOBAL_ENV_ROOTS; i ++) {
+			for (int i = 0; i < (int)lbm_get_global_env_roots(); i ++) {
 				if (ind > 300) {
 					break;
 				}
@@ -310,6 +385,12 @@ void lispif_process_cmd(unsigned char *data, unsigned int len,
 				commands_printf_lisp(
 						":info\n"
 						"  Print info about memory usage, allocated arrays and garbage collection");
+				commands_printf_lisp(
+						":gc\n"
+						"  Print garbage collection statistics and allocations per context");
+				commands_printf_lisp(
+						":gc reset\n"
+						"  Clear garbage collection statistics");
 				commands_printf_lisp(
 						":prof start\n"
 						"  Start profiler");
@@ -319,6 +400,9 @@ void lispif_process_cmd(unsigned char *data, unsigned int len,
 				commands_printf_lisp(
 						":prof report\n"
 						"  Print profiler report");
+				commands_printf_lisp(
+						":prof folded\n"
+						"  Print sampled stacks in folded format for flame graphs");
 				commands_printf_lisp(
 						":env\n"
 						"  Print current environment and variables");
@@ -357,6 +441,10 @@ void lispif_process_cmd(unsigned char *data, unsigned int len,
 				commands_printf_lisp("Marked: %d\n", lbm_heap_state.gc_marked);
 				commands_printf_lisp("GC SP max: %u (size %u)\n", lbm_get_max_stack(&lbm_heap_state.gc_stack), lbm_heap_state.gc_stack.size);
 				commands_printf_lisp("Global env cells: %u\n", lbm_get_global_env_size());
+				lbm_global_env_stats_t env_stats;
+				lbm_get_global_env_stats(&env_stats);
+				commands_printf_lisp("Global env buckets: %u (used %u, longest %u)\n",
+						env_stats.roots, env_stats.used_roots, env_stats.max_chain);
 				commands_printf_lisp("--(Symbol and Array memory)--\n");
 				commands_printf_lisp("Memory size: %u bytes\n", lbm_memory_num_words() * 4);
 				commands_printf_lisp("Memory free: %u bytes\n", lbm_memory_num_free() * 4);
@@ -374,12 +462,17 @@ void lispif_process_cmd(unsigned char *data, unsigned int len,
 				commands_printf_lisp("Image      : %d\n", image_size * 4);
 				commands_printf_lisp("Free       : %d\n", (lbm_image_get_size() - lbm_const_heap_state->next - image_size) * 4);
 				commands_printf_lisp("ImageVer   : %s\n", lbm_image_get_version());
+			} else if (strncmp(str, ":gc reset", 9) == 0) {
+				lbm_reset_gc_stats();
+				commands_printf_lisp("GC statistics cleared\n");
+			} else if (strncmp(str, ":gc", 3) == 0) {
+				print_gc_stats();
 			} else if (strncmp(str, ":prof start", 11) == 0) {
 				if (prof_running) {
-					lbm_prof_init(prof_data, PROF_DATA_NUM);
+					prof_init();
 					commands_printf_lisp("Profiler restarted\n");
 				} else {
-					lbm_prof_init(prof_data, PROF_DATA_NUM);
+					prof_init();
 					prof_running = true;
 					if (lispif_spawn(prof_thd_wrapper, 1024, "LBM Profiler", NULL)) {
 						commands_printf_lisp("Profiler started\n");
@@ -397,7 +490,7 @@ void lispif_process_cmd(unsigned char *data, unsigned int len,
 				lbm_uint tot_gc = 0;
 				commands_printf_lisp("CID\tName\tSamples\t%%Load\t%%GC");
 				for (int i = 0; i < PROF_DATA_NUM; i ++) {
-					if (prof_data[i].cid == -1) break;
+					if (prof_data[i].cid == -1) continue;
 					tot_gc += prof_data[i].gc_count;
 					commands_printf_lisp("%d\t%s\t%u\t%.3f\t%.3f",
 							prof_data[i].cid,
@@ -411,11 +504,18 @@ void lispif_process_cmd(unsigned char *data, unsigned int len,
 				commands_printf_lisp("System:\t%u\t%f%%\n", num_system, (double)(100.0 * ((float)num_system / (float)tot_samples)));
 				commands_printf_lisp("Sleep:\t%u\t%f%%\n", num_sleep, (double)(100.0 * ((float)num_sleep / (float)tot_samples)));
 				commands_printf_lisp("Total:\t%u samples\n", tot_samples);
+				commands_printf_lisp("Dropped:\t%u samples\n", lbm_prof_get_num_dropped_samples());
+			} else if (strncmp(str, ":prof folded", 12) == 0) {
+				if (pause_eval(0, 1000)) {
+					char line[128];
+					lbm_prof_export_folded(line, sizeof(line), prof_emit_folded);
+					lbm_continue_eval();
+				}
 			} else if (strncmp(str, ":env", 4) == 0) {
 				if (pause_eval(0, 1000)) {
 					lbm_value *glob_env = lbm_get_global_env();
 					char output[128];
-					for (int i = 0; i < GLOBAL_ENV_ROOTS; i ++) {
+					for (int i = 0; i < (int)lbm_get_global_env_roots(); i ++) {
 						lbm_value curr = glob_env[i];
 						while (lbm_type_of(curr) == LBM_TYPE_CONS) {
 							lbm_print_value(output, sizeof(output), lbm_car(curr));
@@ -696,6 +796,9 @@ bool lispif_restart(bool print, bool load_code, bool load_imports) {
 
 	restart_cnt++;
 	prof_running = false;
+	// LBM memory is initialized again below.
+	lbm_prof_init_stacks(NULL, 0);
+	prof_stacks = NULL;
 	string_tok_valid = false;
 
 	char *code_data = (char*)flash_helper_code_data(CODE_IND_LISP);
@@ -739,6 +842,7 @@ bool lispif_restart(bool print, bool load_code, bool load_imports) {
 
 		lbm_set_timestamp_us_callback(timestamp_callback);
 		lbm_set_usleep_callback(sleep_callback);
+		lbm_set_eval_wakeup_callback(wakeup_callback);
 		lbm_set_printf_callback(commands_printf_lisp);
 		lbm_set_ctx_done_callback(done_callback);
 
@@ -872,8 +976,20 @@ static uint32_t timestamp_callback(void) {
 	return (uint32_t) ((1000000 / CH_CFG_ST_FREQUENCY) * t);
 }
 
+// The eval thread sleeps on a semaphore so that events can wake it up.
 static void sleep_callback(uint32_t us) {
-	chThdSleepMicroseconds(us);
+	chBSemWaitTimeout(&eval_wakeup_sem, US2ST(us));
+}
+
+// Can be called from interrupt handlers through lbm_event_unboxed_isr.
+static void wakeup_callback(void) {
+	if (port_is_isr_context()) {
+		chSysLockFromISR();
+		chBSemSignalI(&eval_wakeup_sem);
+		chSysUnlockFromISR();
+	} else {
+		chBSemSignal(&eval_wakeup_sem);
+	}
 }
 
 static bool image_write(uint32_t w, int32_t ix, bool const_heap) {
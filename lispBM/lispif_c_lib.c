@@ -45,6 +45,7 @@
 #include "pwm_servo.h"
 #include "flash_helper.h"
 #include "mcpwm_foc.h"
+#include "digital_filter.h"
 
 // Function prototypes otherwise missing
 void packet_init(void (*s_func)(unsigned char *data, unsigned int len),
@@ -1038,6 +1039,20 @@ lbm_value ext_load_native_lib(lbm_value *args, lbm_uint argn) {
 		cif.cif.sem_wait_to = lib_sem_wait_to;
 		cif.cif.sem_reset = lib_sem_reset;
 
+		// Block filters
+		cif.cif.filter_fir_init = filter_fir_init;
+		cif.cif.filter_fir_reset = filter_fir_reset;
+		cif.cif.filter_fir_process_block = filter_fir_process_block;
+		cif.cif.biquad_config = biquad_config;
+		cif.cif.biquad_cascade_init = biquad_cascade_init;
+		cif.cif.biquad_cascade_reset = biquad_cascade_reset;
+		cif.cif.biquad_cascade_process_block = biquad_cascade_process_block;
+
+		// Real FFT
+		cif.cif.filter_rfft_init = filter_rfft_init;
+		cif.cif.filter_rfft = filter_rfft;
+		cif.cif.filter_rfft_magnitude = filter_rfft_magnitude;
+
 		lib_init_done = true;
 	}
 
@@ -104,6 +104,15 @@ static THD_FUNCTION(flash_integrity_check_thread, arg) {
 			NVIC_SystemReset();
 		}
 
+		// The code regions are not executed directly, so corruption there is
+		// reported rather than causing a reset.
+		if (flash_helper_verify_code_chunk() == FAULT_CODE_FLASH_CORRUPTION) {
+			fault_data f = {0};
+			f.fault = FAULT_CODE_FLASH_CORRUPTION;
+			f.info_str = "Code region corrupted";
+			terminal_add_fault_data(&f);
+		}
+
 		chThdSleepMilliseconds(6);
 	}
 }
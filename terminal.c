@@ -129,6 +129,15 @@ __attribute__((section(".text2"))) void terminal_process_string(char *str) {
 		} while (tp != NULL);
 		last_check_time = chVTGetSystemTimeX();
 		commands_printf(" ");
+	} else if (strcmp(argv[0], "flash_check") == 0) {
+		static const char *names[] = {"QML", "Lisp", "Lisp const"};
+		static const char *states[] = {"Unchecked", "OK", "Empty", "Corrupt"};
+		for (int i = 0;i < 3;i++) {
+			commands_printf("%-10s : %-9s (%u scans)", names[i],
+					states[flash_helper_code_region_status(i)],
+					(unsigned int)flash_helper_code_region_scan_cnt(i));
+		}
+		commands_printf(" ");
 	} else if (strcmp(argv[0], "fault") == 0) {
 		commands_printf("%s\n", mc_interface_fault_to_string(mc_interface_get_fault()));
 	} else if (strcmp(argv[0], "faults") == 0) {
@@ -1172,6 +1181,9 @@ __attribute__((section(".text2"))) void terminal_process_string(char *str) {
 		commands_printf("threads");
 		commands_printf("  List all threads");
 
+		commands_printf("flash_check");
+		commands_printf("  Prints the result of the background integrity check of the code regions");
+
 		commands_printf("fault");
 		commands_printf("  Prints the current fault code");
 
@@ -0,0 +1,345 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "digital_filter.h"
+
+#define FIR_BITS		6
+#define FIR_TAPS		(1 << FIR_BITS)
+#define BLOCK_LEN		32
+#define SECTIONS		4
+#define BENCH_SAMPLES	2000000
+#define FFT_BITS		10
+#define FFT_MAX_BITS	12
+#define FFT_BENCH_RUNS	2000
+
+static float rand_sample(void) {
+	return (float)rand() / (float)RAND_MAX * 2.0 - 1.0;
+}
+
+static bool close_enough(float a, float b) {
+	return fabsf(a - b) <= 1e-4 * (1.0 + fabsf(b));
+}
+
+static bool check_fir(int bits, int block_len, int samples) {
+	int taps = 1 << bits;
+	float coeffs[taps];
+	float ref_buffer[taps];
+	uint32_t ref_offset = 0;
+	float state[2 * taps];
+	float in[block_len];
+	float out[block_len];
+	FirFilter fir;
+
+	filter_create_fir_lowpass(coeffs, 0.1, bits, 1);
+	memset(ref_buffer, 0, sizeof(ref_buffer));
+	filter_fir_init(&fir, coeffs, state, taps);
+
+	for (int s = 0;s < samples;s += block_len) {
+		for (int i = 0;i < block_len;i++) {
+			in[i] = rand_sample();
+		}
+
+		filter_fir_process_block(&fir, in, out, block_len);
+
+		for (int i = 0;i < block_len;i++) {
+			filter_add_sample(ref_buffer, in[i], bits, &ref_offset);
+			float ref = filter_run_fir_iteration(ref_buffer, coeffs, bits, ref_offset);
+			if (!close_enough(out[i], ref)) {
+				printf("FIR mismatch: taps %d block %d sample %d: %f != %f\r\n",
+						taps, block_len, s + i, (double)out[i], (double)ref);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+static bool check_fir_odd_taps(int taps, int samples) {
+	float coeffs[taps];
+	float history[taps];
+	float state[2 * taps];
+	FirFilter fir;
+
+	for (int i = 0;i < taps;i++) {
+		coeffs[i] = rand_sample();
+		history[i] = 0.0;
+	}
+
+	filter_fir_init(&fir, coeffs, state, taps);
+
+	for (int s = 0;s < samples;s++) {
+		float x = rand_sample();
+		float y;
+		filter_fir_process_block(&fir, &x, &y, 1);
+
+		memmove(history, history + 1, (taps - 1) * sizeof(float));
+		history[taps - 1] = x;
+		float ref = 0.0;
+		for (int i = 0;i < taps;i++) {
+			ref += coeffs[i] * history[i];
+		}
+
+		if (!close_enough(y, ref)) {
+			printf("FIR mismatch: taps %d sample %d: %f != %f\r\n",
+					taps, s, (double)y, (double)ref);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool check_cascade(int num, int block_len, int samples) {
+	Biquad ref[num];
+	Biquad sections[num];
+	BiquadCascade cascade;
+	float buf[block_len];
+	float in[block_len];
+
+	for (int i = 0;i < num;i++) {
+		biquad_config(&ref[i], (i % 2) ? BQ_HIGHPASS : BQ_LOWPASS, 0.02 + 0.05 * i);
+		biquad_reset(&ref[i]);
+		sections[i] = ref[i];
+	}
+
+	biquad_cascade_init(&cascade, sections, num);
+
+	for (int s = 0;s < samples;s += block_len) {
+		for (int i = 0;i < block_len;i++) {
+			in[i] = rand_sample();
+		}
+
+		// In place
+		memcpy(buf, in, sizeof(buf));
+		biquad_cascade_process_block(&cascade, buf, buf, block_len);
+
+		for (int i = 0;i < block_len;i++) {
+			float y = in[i];
+			for (int j = 0;j < num;j++) {
+				y = biquad_process(&ref[j], y);
+			}
+
+			// Same operations in the same order, so the result should be exact
+			if (buf[i] != y) {
+				printf("Biquad mismatch: sections %d block %d sample %d: %f != %f\r\n",
+						num, block_len, s + i, (double)buf[i], (double)y);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+static bool check_rfft(int bits) {
+	int n = 1 << bits;
+	static float twiddle[FILTER_RFFT_TWIDDLE_LEN(FFT_MAX_BITS)];
+	static uint16_t bitrev[FILTER_RFFT_BITREV_LEN(FFT_MAX_BITS)];
+	static float input[1 << FFT_MAX_BITS];
+	static float data[1 << FFT_MAX_BITS];
+	static float mag[(1 << FFT_MAX_BITS) / 2 + 1];
+	FilterRfft fft;
+
+	if (!filter_rfft_init(&fft, bits, twiddle, bitrev)) {
+		printf("RFFT init failed: bits %d\r\n", bits);
+		return false;
+	}
+
+	for (int i = 0;i < n;i++) {
+		input[i] = rand_sample();
+		data[i] = input[i];
+	}
+
+	filter_rfft(&fft, data);
+
+	// Compare with a DFT in double precision
+	for (int k = 0;k <= n / 2;k++) {
+		double re = 0.0, im = 0.0;
+		for (int i = 0;i < n;i++) {
+			double arg = 2.0 * M_PI * (double)(((long)k * i) % n) / (double)n;
+			re += input[i] * cos(arg);
+			im -= input[i] * sin(arg);
+		}
+
+		double re_fft, im_fft;
+		if (k == 0) {
+			re_fft = data[0];
+			im_fft = 0.0;
+		} else if (k == n / 2) {
+			re_fft = data[1];
+			im_fft = 0.0;
+		} else {
+			re_fft = data[2 * k];
+			im_fft = data[2 * k + 1];
+		}
+
+		double tol = 1e-5 * n;
+		if (fabs(re - re_fft) > tol || fabs(im - im_fft) > tol) {
+			printf("RFFT mismatch: bits %d bin %d: %f %f != %f %f\r\n",
+					bits, k, re_fft, im_fft, re, im);
+			return false;
+		}
+	}
+
+	// A sine with amplitude 3 in bin 5 and an offset of 0.5
+	if (n >= 16) {
+		for (int i = 0;i < n;i++) {
+			data[i] = 0.5 + 3.0 * sinf(2.0 * M_PI * 5.0 * (float)i / (float)n + 0.3);
+		}
+
+		filter_rfft_magnitude(&fft, data, mag);
+
+		for (int k = 0;k <= n / 2;k++) {
+			float expected = k == 0 ? 0.5 : (k == 5 ? 3.0 : 0.0);
+			if (fabsf(mag[k] - expected) > 1e-3) {
+				printf("RFFT magnitude mismatch: bits %d bin %d: %f != %f\r\n",
+						bits, k, (double)mag[k], (double)expected);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+int main(void) {
+	int tests = 0;
+	srand(4);
+
+	const int block_lens[] = {1, 3, 16, 64};
+	for (int b = 0;b < 4;b++) {
+		for (int bits = 1;bits <= 8;bits++) {
+			if (!check_fir(bits, block_lens[b], 4096)) {
+				printf("Test failed\r\n");
+				return 1;
+			}
+			tests++;
+		}
+
+		for (int num = 0;num <= 6;num++) {
+			if (!check_cascade(num, block_lens[b], 4096)) {
+				printf("Test failed\r\n");
+				return 1;
+			}
+			tests++;
+		}
+	}
+
+	for (int taps = 1;taps <= 13;taps++) {
+		if (!check_fir_odd_taps(taps, 1000)) {
+			printf("Test failed\r\n");
+			return 1;
+		}
+		tests++;
+	}
+
+	for (int bits = 2;bits <= FFT_MAX_BITS;bits++) {
+		if (!check_rfft(bits)) {
+			printf("Test failed\r\n");
+			return 1;
+		}
+		tests++;
+	}
+
+	// Benchmark
+	static float input[BLOCK_LEN];
+	static float output[BLOCK_LEN];
+	volatile float sink = 0.0;
+	for (int i = 0;i < BLOCK_LEN;i++) {
+		input[i] = rand_sample();
+	}
+
+	float coeffs[FIR_TAPS];
+	float ref_buffer[FIR_TAPS] = {0};
+	uint32_t ref_offset = 0;
+	float state[2 * FIR_TAPS];
+	FirFilter fir;
+	filter_create_fir_lowpass(coeffs, 0.1, FIR_BITS, 1);
+	filter_fir_init(&fir, coeffs, state, FIR_TAPS);
+
+	clock_t t = clock();
+	for (int s = 0;s < BENCH_SAMPLES;s++) {
+		filter_add_sample(ref_buffer, input[s % BLOCK_LEN], FIR_BITS, &ref_offset);
+		sink += filter_run_fir_iteration(ref_buffer, coeffs, FIR_BITS, ref_offset);
+	}
+	double t_fir_ref = (double)(clock() - t) / CLOCKS_PER_SEC;
+
+	t = clock();
+	for (int s = 0;s < BENCH_SAMPLES;s += BLOCK_LEN) {
+		filter_fir_process_block(&fir, input, output, BLOCK_LEN);
+		sink += output[0];
+	}
+	double t_fir_block = (double)(clock() - t) / CLOCKS_PER_SEC;
+
+	Biquad ref[SECTIONS];
+	Biquad sections[SECTIONS];
+	BiquadCascade cascade;
+	for (int i = 0;i < SECTIONS;i++) {
+		biquad_config(&ref[i], BQ_LOWPASS, 0.05);
+		biquad_reset(&ref[i]);
+	}
+	memcpy(sections, ref, sizeof(ref));
+	biquad_cascade_init(&cascade, sections, SECTIONS);
+
+	t = clock();
+	for (int s = 0;s < BENCH_SAMPLES;s++) {
+		float y = input[s % BLOCK_LEN];
+		for (int j = 0;j < SECTIONS;j++) {
+			y = biquad_process(&ref[j], y);
+		}
+		sink += y;
+	}
+	double t_bq_ref = (double)(clock() - t) / CLOCKS_PER_SEC;
+
+	t = clock();
+	for (int s = 0;s < BENCH_SAMPLES;s += BLOCK_LEN) {
+		biquad_cascade_process_block(&cascade, input, output, BLOCK_LEN);
+		sink += output[0];
+	}
+	double t_bq_block = (double)(clock() - t) / CLOCKS_PER_SEC;
+
+	static float fft_real[1 << FFT_BITS];
+	static float fft_imag[1 << FFT_BITS];
+	static float fft_data[1 << FFT_BITS];
+	static float fft_twiddle[FILTER_RFFT_TWIDDLE_LEN(FFT_BITS)];
+	static uint16_t fft_bitrev[FILTER_RFFT_BITREV_LEN(FFT_BITS)];
+	FilterRfft fft;
+	filter_rfft_init(&fft, FFT_BITS, fft_twiddle, fft_bitrev);
+
+	t = clock();
+	for (int r = 0;r < FFT_BENCH_RUNS;r++) {
+		for (int i = 0;i < (1 << FFT_BITS);i++) {
+			fft_real[i] = input[i % BLOCK_LEN];
+			fft_imag[i] = 0.0;
+		}
+		filter_fft(0, FFT_BITS, fft_real, fft_imag);
+		sink += fft_real[1];
+	}
+	double t_fft_ref = (double)(clock() - t) / CLOCKS_PER_SEC;
+
+	t = clock();
+	for (int r = 0;r < FFT_BENCH_RUNS;r++) {
+		for (int i = 0;i < (1 << FFT_BITS);i++) {
+			fft_data[i] = input[i % BLOCK_LEN];
+		}
+		filter_rfft(&fft, fft_data);
+		sink += fft_data[2];
+	}
+	double t_fft_real = (double)(clock() - t) / CLOCKS_PER_SEC;
+	(void)sink;
+
+	printf("FIR %d taps, %d samples: per sample %.3f s, block %.3f s\r\n",
+			FIR_TAPS, BENCH_SAMPLES, t_fir_ref, t_fir_block);
+	printf("Biquad %d sections, %d samples: per sample %.3f s, block %.3f s\r\n",
+			SECTIONS, BENCH_SAMPLES, t_bq_ref, t_bq_block);
+	printf("FFT %d points, %d runs: filter_fft %.3f s, filter_rfft %.3f s\r\n",
+			1 << FFT_BITS, FFT_BENCH_RUNS, t_fft_ref, t_fft_real);
+	printf("All %d tests passed!\r\n", tests);
+
+	return 0;
+}
@@ -0,0 +1,27 @@
+/*
+ * Stand-in for the configuration types that set the number of emulated EEPROM
+ * variables.
+ */
+
+#ifndef DATATYPES_H_
+#define DATATYPES_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+	uint8_t data[700];
+} mc_configuration;
+
+typedef struct {
+	uint8_t data[400];
+} app_configuration;
+
+typedef struct {
+	uint8_t data[40];
+} backup_data;
+
+#define EEPROM_VARS_HW			32
+#define EEPROM_VARS_CUSTOM		256
+
+#endif /* DATATYPES_H_ */
@@ -0,0 +1,8 @@
+#ifndef FLASH_HELPER_H_
+#define FLASH_HELPER_H_
+
+#include <stdint.h>
+
+uint8_t* flash_helper_get_sector_address(uint32_t fsector);
+
+#endif /* FLASH_HELPER_H_ */
@@ -0,0 +1,502 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <sys/mman.h>
+
+#include "eeprom.h"
+#include "flash_helper.h"
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+#define FLASH_BASE		((uint32_t)0x08000000)
+#define FLASH_MAP_SIZE	((uint32_t)0x10000)
+
+uint16_t VirtAddVarTab[NB_OF_VAR];
+PWR_TypeDef pwr_stub = {0};
+
+static uint16_t ref_data[NB_OF_VAR];
+static bool ref_valid[NB_OF_VAR];
+static int var_num = 0;
+static int erase_fail_cnt = 0;
+static int power_left = -1; // Flash operations until power loss, -1 for no power loss
+static int program_cnt = 0;
+static int erase_cnt = 0;
+
+static bool use_power(void) {
+	if (power_left == 0) {
+		return false;
+	}
+
+	if (power_left > 0) {
+		power_left--;
+	}
+
+	return true;
+}
+
+FLASH_Status FLASH_ProgramHalfWord(uint32_t Address, uint16_t Data) {
+	if (!use_power()) {
+		return FLASH_ERROR_OPERATION;
+	}
+
+	// Programming can only clear bits
+	*(volatile uint16_t*)(uintptr_t)Address &= Data;
+	program_cnt++;
+	return FLASH_COMPLETE;
+}
+
+FLASH_Status FLASH_EraseSector(uint32_t FLASH_Sector, uint8_t VoltageRange) {
+	(void)VoltageRange;
+
+	if (erase_fail_cnt > 0) {
+		erase_fail_cnt--;
+		return FLASH_ERROR_OPERATION;
+	}
+
+	if (!use_power()) {
+		return FLASH_ERROR_OPERATION;
+	}
+
+	memset(flash_helper_get_sector_address(FLASH_Sector), 0xFF, PAGE_SIZE);
+	erase_cnt++;
+	return FLASH_COMPLETE;
+}
+
+uint8_t* flash_helper_get_sector_address(uint32_t fsector) {
+	if (fsector == FLASH_Sector_1) {
+		return (uint8_t*)(uintptr_t)PAGE0_BASE_ADDRESS;
+	} else {
+		return (uint8_t*)(uintptr_t)PAGE1_BASE_ADDRESS;
+	}
+}
+
+// Reference read that scans the valid page like EE_ReadVariable did before the index
+static uint16_t read_scan(uint16_t addr, uint16_t *data) {
+	uint32_t page;
+	if (*(volatile uint16_t*)(uintptr_t)PAGE0_BASE_ADDRESS == VALID_PAGE) {
+		page = PAGE0_BASE_ADDRESS;
+	} else if (*(volatile uint16_t*)(uintptr_t)PAGE1_BASE_ADDRESS == VALID_PAGE) {
+		page = PAGE1_BASE_ADDRESS;
+	} else {
+		return NO_VALID_PAGE;
+	}
+
+	for (uint32_t a = page + PAGE_SIZE - 2;a > page + 2;a -= 4) {
+		if (*(volatile uint16_t*)(uintptr_t)a == addr) {
+			*data = *(volatile uint16_t*)(uintptr_t)(a - 2);
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+static void init_var_tab(bool shuffle) {
+	memset(VirtAddVarTab, 0, sizeof(VirtAddVarTab));
+	var_num = 0;
+
+	// Same layout as conf_general_init, with a few unused entries at the end
+	for (unsigned int i = 0;i < (sizeof(mc_configuration) / 2);i++) {
+		VirtAddVarTab[var_num++] = 1000 + i;
+	}
+
+	for (unsigned int i = 0;i < (sizeof(app_configuration) / 2);i++) {
+		VirtAddVarTab[var_num++] = 2000 + i;
+	}
+
+	for (unsigned int i = 0;i < (EEPROM_VARS_HW * 2);i++) {
+		VirtAddVarTab[var_num++] = 3000 + i;
+	}
+
+	for (unsigned int i = 0;i < (EEPROM_VARS_CUSTOM * 2);i++) {
+		VirtAddVarTab[var_num++] = 4000 + i;
+	}
+
+	for (unsigned int i = 0;i < (sizeof(mc_configuration) / 2);i++) {
+		VirtAddVarTab[var_num++] = 5000 + i;
+	}
+
+	for (unsigned int i = 0;i < (sizeof(backup_data) / 2);i++) {
+		VirtAddVarTab[var_num++] = 6000 + i;
+	}
+
+	if (shuffle) {
+		for (int i = var_num - 1;i > 0;i--) {
+			int j = rand() % (i + 1);
+			uint16_t tmp = VirtAddVarTab[i];
+			VirtAddVarTab[i] = VirtAddVarTab[j];
+			VirtAddVarTab[j] = tmp;
+		}
+	}
+}
+
+static bool check_all(const char *step) {
+	for (int i = 0;i < var_num;i++) {
+		uint16_t addr = VirtAddVarTab[i];
+		uint16_t d1 = 0, d2 = 0;
+		uint16_t r1 = EE_ReadVariable(addr, &d1);
+		uint16_t r2 = read_scan(addr, &d2);
+
+		if (r1 != r2 || (r1 == 0 && d1 != d2)) {
+			printf("%s: index and scan differ for %d (%d %d, %d %d)\r\n", step, addr, r1, r2, d1, d2);
+			return false;
+		}
+
+		if ((r1 == 0) != ref_valid[i] || (r1 == 0 && d1 != ref_data[i])) {
+			printf("%s: wrong value for %d\r\n", step, addr);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool random_writes(int num) {
+	for (int i = 0;i < num;i++) {
+		// Favor a small set of variables so that pages fill with old copies
+		int ind = (rand() % 4) ? rand() % 50 : rand() % var_num;
+		uint16_t data = rand() % 8;
+
+		if (EE_WriteVariable(VirtAddVarTab[ind], data) != FLASH_COMPLETE) {
+			printf("Write failed\r\n");
+			return false;
+		}
+
+		ref_data[ind] = data;
+		ref_valid[ind] = true;
+
+		uint16_t d = 0;
+		if (EE_ReadVariable(VirtAddVarTab[ind], &d) != 0 || d != data) {
+			printf("Read back failed for %d\r\n", VirtAddVarTab[ind]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool run(bool shuffle) {
+	memset((void*)(uintptr_t)FLASH_BASE, 0xFF, FLASH_MAP_SIZE);
+	memset(ref_valid, 0, sizeof(ref_valid));
+	init_var_tab(shuffle);
+
+	if (EE_Init() != FLASH_COMPLETE) {
+		printf("Init failed\r\n");
+		return false;
+	}
+
+	if (!check_all("Empty")) {
+		return false;
+	}
+
+	if (!random_writes(50000) || !check_all("Writes")) {
+		return false;
+	}
+
+	// Reboot
+	if (EE_Init() != FLASH_COMPLETE || !check_all("Reboot")) {
+		return false;
+	}
+
+	// Interrupt a page transfer by failing the erase of the old page, then repair it
+	erase_fail_cnt = 1;
+	for (int i = 0;i < 100000;i++) {
+		int ind = rand() % var_num;
+		uint16_t data = rand();
+		uint16_t res = EE_WriteVariable(VirtAddVarTab[ind], data);
+
+		if (res == FLASH_COMPLETE) {
+			ref_data[ind] = data;
+			ref_valid[ind] = true;
+		} else {
+			// The new value is written to the receiving page before the erase
+			ref_data[ind] = data;
+			ref_valid[ind] = true;
+			break;
+		}
+	}
+
+	if (erase_fail_cnt != 0) {
+		printf("No page transfer happened\r\n");
+		return false;
+	}
+
+	if (EE_Init() != FLASH_COMPLETE || !check_all("Repair")) {
+		return false;
+	}
+
+	if (!random_writes(20000) || !check_all("After repair")) {
+		return false;
+	}
+
+	return true;
+}
+
+// Store a block of variables like conf_general does, optionally losing power after
+// power_ops flash operations. Returns true if the new values are expected.
+static bool store_block(int first, int num, const uint16_t *data, bool transaction, int power_ops) {
+	bool ok = true;
+	power_left = power_ops;
+
+	if (transaction) {
+		EE_TransactionBegin();
+		for (int i = 0;i < num;i++) {
+			EE_TransactionWrite(VirtAddVarTab[first + i], data[i]);
+		}
+		ok = EE_TransactionCommit() == FLASH_COMPLETE;
+	} else {
+		for (int i = 0;i < num && ok;i++) {
+			ok = EE_WriteVariable(VirtAddVarTab[first + i], data[i]) == FLASH_COMPLETE;
+		}
+	}
+
+	power_left = -1;
+	return ok;
+}
+
+// Check that either all or none of the values of a block were stored after a reboot.
+// Returns 1 if all were, 0 if none were and -1 if only some were.
+static int check_block(int first, int num, const uint16_t *data) {
+	bool all_new = true, all_old = true;
+
+	for (int i = 0;i < num;i++) {
+		uint16_t d = 0;
+		bool found = EE_ReadVariable(VirtAddVarTab[first + i], &d) == 0;
+
+		if (!found || d != data[i]) {
+			all_new = false;
+		}
+
+		if (found != ref_valid[first + i] || (found && d != ref_data[first + i])) {
+			all_old = false;
+		}
+	}
+
+	return all_new ? 1 : (all_old ? 0 : -1);
+}
+
+static void update_ref(int first, int num, const uint16_t *data) {
+	for (int i = 0;i < num;i++) {
+		ref_data[first + i] = data[i];
+		ref_valid[first + i] = true;
+	}
+}
+
+static bool run_transactions(void) {
+	memset((void*)(uintptr_t)FLASH_BASE, 0xFF, FLASH_MAP_SIZE);
+	memset(ref_valid, 0, sizeof(ref_valid));
+	init_var_tab(false);
+
+	if (EE_Init() != FLASH_COMPLETE) {
+		printf("Init failed\r\n");
+		return false;
+	}
+
+	const int num = sizeof(mc_configuration) / 2;
+	uint16_t data[sizeof(mc_configuration) / 2];
+	int rolled_back = 0;
+
+	for (int n = 0;n < 400;n++) {
+		// Change a random part of the block, or everything now and then
+		int first = (n % 2) ? 0 : var_num - num;
+		int changes = (n % 10) ? rand() % 20 : num;
+
+		for (int i = 0;i < num;i++) {
+			data[i] = ref_valid[first + i] ? ref_data[first + i] : 0;
+		}
+
+		for (int i = 0;i < changes;i++) {
+			data[rand() % num] = rand();
+		}
+
+		int power_ops = (n % 3) ? -1 : rand() % (2 * changes + 10);
+		bool completed = store_block(first, num, data, true, power_ops);
+
+		// Reboot
+		if (EE_Init() != FLASH_COMPLETE) {
+			printf("Init after transaction failed\r\n");
+			return false;
+		}
+
+		int stored = check_block(first, num, data);
+
+		if (stored < 0) {
+			printf("Transaction %d was partly stored\r\n", n);
+			return false;
+		}
+
+		if (completed && stored == 0) {
+			printf("Transaction %d was lost\r\n", n);
+			return false;
+		}
+
+		if (stored == 0) {
+			rolled_back++;
+		} else {
+			update_ref(first, num, data);
+		}
+
+		if (!check_all("Transactions")) {
+			return false;
+		}
+	}
+
+	printf("400 transactions, %d rolled back after power loss\r\n", rolled_back);
+
+	// Find a transaction that has to transfer the page and lose power at points
+	// spread over it, while copying the other variables, writing the transaction
+	// and erasing the old page
+	static uint8_t snapshot[FLASH_MAP_SIZE];
+	static uint16_t ref_data_before[NB_OF_VAR];
+	static bool ref_valid_before[NB_OF_VAR];
+	int ops = 0;
+
+	for (int n = 0;ops == 0;n++) {
+		int first = (n % 2) ? 0 : var_num - num;
+		for (int i = 0;i < num;i++) {
+			data[i] = ref_data[first + i];
+		}
+		for (int i = 0;i < 10;i++) {
+			data[rand() % num] = rand();
+		}
+
+		memcpy(snapshot, (void*)(uintptr_t)FLASH_BASE, FLASH_MAP_SIZE);
+		int cnt = program_cnt + erase_cnt;
+		int erases = erase_cnt;
+		store_block(first, num, data, true, -1);
+
+		if (erase_cnt == erases) {
+			update_ref(first, num, data);
+			continue;
+		}
+
+		ops = program_cnt + erase_cnt - cnt;
+		memcpy(ref_data_before, ref_data, sizeof(ref_data));
+		memcpy(ref_valid_before, ref_valid, sizeof(ref_valid));
+
+		for (int p = 0;p <= ops;p += (p < ops - 8) ? ops / 50 + 1 : 1) {
+			memcpy((void*)(uintptr_t)FLASH_BASE, snapshot, FLASH_MAP_SIZE);
+			EE_Init();
+			bool completed = store_block(first, num, data, true, p);
+
+			if (EE_Init() != FLASH_COMPLETE) {
+				printf("Init after transfer failed\r\n");
+				return false;
+			}
+
+			int stored = check_block(first, num, data);
+			if (stored < 0 || (completed && stored == 0)) {
+				printf("Transfer interrupted after %d of %d operations was %s\r\n",
+						p, ops, stored < 0 ? "partly stored" : "lost");
+				return false;
+			}
+
+			// The other variables must be intact either way
+			memcpy(ref_data, ref_data_before, sizeof(ref_data));
+			memcpy(ref_valid, ref_valid_before, sizeof(ref_valid));
+			if (stored) {
+				update_ref(first, num, data);
+			}
+
+			if (!check_all("Transfer")) {
+				return false;
+			}
+		}
+	}
+
+	printf("Power lost at points over a %d operation transfer\r\n", ops);
+
+	// Flash usage of transactions compared to one write per variable
+	int stats[2][2];
+	for (int t = 0;t < 2;t++) {
+		memset((void*)(uintptr_t)FLASH_BASE, 0xFF, FLASH_MAP_SIZE);
+		EE_Init();
+		program_cnt = 0;
+		erase_cnt = 0;
+
+		for (int n = 0;n < 1000;n++) {
+			int first = (n % 2) ? 0 : var_num - num;
+			for (int i = 0;i < num;i++) {
+				data[i] = (n < 2) ? rand() : data[i];
+			}
+			for (int i = 0;i < 10;i++) {
+				data[rand() % num] = rand();
+			}
+			store_block(first, num, data, t == 1, -1);
+		}
+
+		stats[t][0] = program_cnt;
+		stats[t][1] = erase_cnt;
+	}
+
+	printf("1000 config stores: single writes %d programs %d erases, transactions %d programs %d erases\r\n",
+			stats[0][0], stats[0][1], stats[1][0], stats[1][1]);
+
+	// A transaction takes as many slots as writing its variables one by one, so it
+	// must not erase more often
+	if (stats[1][1] > stats[0][1]) {
+		printf("Transactions erased more often than single writes\r\n");
+		return false;
+	}
+
+	return true;
+}
+
+int main(void) {
+	void *flash = mmap((void*)(uintptr_t)FLASH_BASE, FLASH_MAP_SIZE, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+	if (flash != (void*)(uintptr_t)FLASH_BASE) {
+		printf("Could not map flash stub at 0x%08X\r\n", FLASH_BASE);
+		return 1;
+	}
+
+	srand(1024);
+
+	if (!run(false)) {
+		printf("Indexed test failed\r\n");
+		return 1;
+	}
+
+	if (!run(true)) {
+		printf("Unsorted table test failed\r\n");
+		return 1;
+	}
+
+	if (!run_transactions()) {
+		printf("Transaction test failed\r\n");
+		return 1;
+	}
+
+	// Read performance of all variables from a well-used page
+	memset((void*)(uintptr_t)FLASH_BASE, 0xFF, FLASH_MAP_SIZE);
+	memset(ref_valid, 0, sizeof(ref_valid));
+	init_var_tab(false);
+	EE_Init();
+	random_writes(3000);
+
+	clock_t t = clock();
+	uint16_t d;
+	for (int n = 0;n < 100;n++) {
+		for (int i = 0;i < var_num;i++) {
+			EE_ReadVariable(VirtAddVarTab[i], &d);
+		}
+	}
+	double t_index = (double)(clock() - t) / CLOCKS_PER_SEC;
+
+	t = clock();
+	for (int n = 0;n < 100;n++) {
+		for (int i = 0;i < var_num;i++) {
+			read_scan(VirtAddVarTab[i], &d);
+		}
+	}
+	double t_scan = (double)(clock() - t) / CLOCKS_PER_SEC;
+
+	printf("Read all %d vars x100: index %.4f s, scan %.4f s\r\n", var_num, t_index, t_scan);
+	printf("All tests passed!\r\n");
+	return 0;
+}
@@ -0,0 +1,42 @@
+/*
+ * Minimal flash driver stub for running the EEPROM emulation on the host. The
+ * flash is emulated in RAM that main.c maps at the real flash address.
+ */
+
+#ifndef STM32F4XX_CONF_H_
+#define STM32F4XX_CONF_H_
+
+#include <stdint.h>
+
+#define __IO volatile
+
+typedef enum {
+	FLASH_BUSY = 1,
+	FLASH_ERROR_RD,
+	FLASH_ERROR_PGS,
+	FLASH_ERROR_PGP,
+	FLASH_ERROR_PGA,
+	FLASH_ERROR_WRP,
+	FLASH_ERROR_PROGRAM,
+	FLASH_ERROR_OPERATION,
+	FLASH_COMPLETE
+} FLASH_Status;
+
+#define FLASH_Sector_1		((uint16_t)0x0008)
+#define FLASH_Sector_2		((uint16_t)0x0010)
+
+#define VoltageRange_2		((uint8_t)0x01)
+#define VoltageRange_3		((uint8_t)0x02)
+
+typedef struct {
+	uint32_t CSR;
+} PWR_TypeDef;
+
+extern PWR_TypeDef pwr_stub;
+#define PWR					(&pwr_stub)
+#define PWR_CSR_PVDO		((uint32_t)0x00000004)
+
+FLASH_Status FLASH_ProgramHalfWord(uint32_t Address, uint16_t Data);
+FLASH_Status FLASH_EraseSector(uint32_t FLASH_Sector, uint8_t VoltageRange);
+
+#endif /* STM32F4XX_CONF_H_ */
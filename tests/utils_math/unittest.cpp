@@ -409,3 +409,107 @@ TEST_F(Saturate2dVector, ValsAreDegenerate) {
    EXPECT_FLOAT_EQ(10/sqrtf(2), inputVal_y);
    EXPECT_EQ(true, ret);
 }
+
+
+//----------------------------------------
+// Test fixture for utils_window_uint16
+//----------------------------------------
+class WindowUint16 : public MiscMath {
+protected:
+  virtual void SetUp() {
+     seed = 1;
+  }
+
+  virtual void TearDown() {
+  }
+
+  static const unsigned int max_len = 64;
+  static const int samples = 2000;
+  uint32_t seed;
+
+  // Fixed sequence, so that failures can be reproduced.
+  uint16_t next_sample(int mode) {
+     seed = seed * 1103515245u + 12345u;
+     uint32_t r = seed >> 8;
+     switch (mode) {
+     case 0: return r & 0xFFFF; // Full range
+     case 1: return r % 4; // Many duplicates
+     case 2: return 2000 + r % 50; // Noisy ADC value
+     default: return (r % 10) ? 1000 : 65535; // Spikes
+     }
+  }
+
+  // Runs the window, and one without the sorted buffer, next to a plain
+  // buffer that is sorted for every sample.
+  void check_window(unsigned int len, int mode) {
+     uint16_t ref_buffer[max_len];
+     unsigned int ref_index = 0;
+     uint16_t win_samples[max_len];
+     uint16_t win_sorted[max_len];
+     uint16_t plain_samples[max_len];
+     utils_window_uint16 win, plain;
+
+     uint16_t init = next_sample(mode);
+     for (unsigned int i = 0; i < len; i++) {
+        ref_buffer[i] = init;
+     }
+
+     utils_window_uint16_init(&win, win_samples, win_sorted, len, init);
+     utils_window_uint16_init(&plain, plain_samples, NULL, len, init);
+
+     for (int i = 0; i < samples; i++) {
+        uint16_t s = next_sample(mode);
+
+        uint16_t med_ref = utils_median_filter_uint16_run(ref_buffer, &ref_index, len, s);
+        utils_window_uint16_add(&win, s);
+        utils_window_uint16_add(&plain, s);
+
+        uint16_t min = 0xFFFF, max = 0;
+        double sum = 0.0, sum_sq = 0.0;
+        for (unsigned int j = 0; j < len; j++) {
+           min = ref_buffer[j] < min ? ref_buffer[j] : min;
+           max = ref_buffer[j] > max ? ref_buffer[j] : max;
+           sum += ref_buffer[j];
+        }
+        double mean = sum / len;
+        for (unsigned int j = 0; j < len; j++) {
+           sum_sq += (ref_buffer[j] - mean) * (ref_buffer[j] - mean);
+        }
+        double var = sum_sq / len;
+        double tol = 1e-6;
+
+        ASSERT_EQ(med_ref, utils_window_uint16_median(&win))
+           << "len " << len << " mode " << mode << " sample " << i;
+        ASSERT_EQ(min, utils_window_uint16_min(&win));
+        ASSERT_EQ(min, utils_window_uint16_min(&plain));
+        ASSERT_EQ(max, utils_window_uint16_max(&win));
+        ASSERT_EQ(max, utils_window_uint16_max(&plain));
+        ASSERT_NEAR(mean, (double)utils_window_uint16_mean(&win), tol * (mean + 1));
+        ASSERT_NEAR(var, (double)utils_window_uint16_variance(&win), tol * (var + 1));
+     }
+  }
+};
+
+TEST_F(WindowUint16, FullRange) {
+   for (unsigned int len = 1; len <= max_len; len++) {
+      check_window(len, 0);
+   }
+}
+
+TEST_F(WindowUint16, ManyDuplicates) {
+   for (unsigned int len = 1; len <= max_len; len++) {
+      check_window(len, 1);
+   }
+}
+
+TEST_F(WindowUint16, NoisyAdc) {
+   for (unsigned int len = 1; len <= max_len; len++) {
+      check_window(len, 2);
+   }
+}
+
+TEST_F(WindowUint16, Spikes) {
+   for (unsigned int len = 1; len <= max_len; len++) {
+      check_window(len, 3);
+   }
+}
@@ -263,3 +263,296 @@ void biquad_reset(Biquad *biquad) {
 	biquad->z1 = 0;
 	biquad->z2 = 0;
 }
+
+/**
+ * Initialize a FIR filter for block processing
+ * @param fir
+ * The filter
+ * @param coeffs
+ * The filter coefficients. As in filter_run_fir_iteration, coeffs[0] is applied
+ * to the oldest sample, so the output of filter_create_fir_lowpass can be used.
+ * @param state
+ * Buffer with room for 2 * taps samples
+ * @param taps
+ * The number of coefficients. Does not have to be a power of two.
+ */
+void filter_fir_init(FirFilter *fir, const float *coeffs, float *state, int taps) {
+	fir->coeffs = coeffs;
+	fir->state = state;
+	fir->taps = taps;
+	filter_fir_reset(fir);
+}
+
+void filter_fir_reset(FirFilter *fir) {
+	for (int i = 0;i < 2 * fir->taps;i++) {
+		fir->state[i] = 0.0;
+	}
+	fir->index = 0;
+}
+
+/**
+ * Filter a block of samples. The output is the same as running filter_add_sample
+ * and filter_run_fir_iteration for every sample, apart from rounding. in and out
+ * can be the same buffer.
+ */
+void filter_fir_process_block(FirFilter *fir, const float *in, float *out, int len) {
+	const float *c = fir->coeffs;
+	const int taps = fir->taps;
+	float *state = fir->state;
+	int index = fir->index;
+
+	for (int n = 0;n < len;n++) {
+		state[index] = in[n];
+		state[index + taps] = in[n];
+		index++;
+		if (index == taps) {
+			index = 0;
+		}
+
+		// The oldest sample is at index and the newest at index + taps - 1
+		const float *x = state + index;
+		float acc0 = 0.0, acc1 = 0.0, acc2 = 0.0, acc3 = 0.0;
+		int i = 0;
+
+		for (;i <= (taps - 4);i += 4) {
+			acc0 += c[i] * x[i];
+			acc1 += c[i + 1] * x[i + 1];
+			acc2 += c[i + 2] * x[i + 2];
+			acc3 += c[i + 3] * x[i + 3];
+		}
+
+		for (;i < taps;i++) {
+			acc0 += c[i] * x[i];
+		}
+
+		out[n] = (acc0 + acc1) + (acc2 + acc3);
+	}
+
+	fir->index = index;
+}
+
+/**
+ * Run a biquad over a block of samples. in and out can be the same buffer.
+ */
+void biquad_process_block(Biquad *biquad, const float *in, float *out, int len) {
+	const float a0 = biquad->a0, a1 = biquad->a1, a2 = biquad->a2;
+	const float b1 = biquad->b1, b2 = biquad->b2;
+	float z1 = biquad->z1, z2 = biquad->z2;
+
+	for (int n = 0;n < len;n++) {
+		float x = in[n];
+		float y = x * a0 + z1;
+		z1 = x * a1 + z2 - b1 * y;
+		z2 = x * a2 - b2 * y;
+		out[n] = y;
+	}
+
+	biquad->z1 = z1;
+	biquad->z2 = z2;
+}
+
+/**
+ * Initialize a cascade of biquad sections. The sections have to be configured
+ * with biquad_config or by setting the coefficients directly.
+ */
+void biquad_cascade_init(BiquadCascade *cascade, Biquad *sections, int num) {
+	cascade->sections = sections;
+	cascade->num = num;
+	biquad_cascade_reset(cascade);
+}
+
+void biquad_cascade_reset(BiquadCascade *cascade) {
+	for (int i = 0;i < cascade->num;i++) {
+		biquad_reset(&cascade->sections[i]);
+	}
+}
+
+/**
+ * Run a block of samples through all sections of a cascade. Each section
+ * processes the whole block before the next one, so that the coefficients and
+ * state of a section stay in registers. in and out can be the same buffer.
+ */
+void biquad_cascade_process_block(BiquadCascade *cascade, const float *in, float *out, int len) {
+	if (cascade->num == 0) {
+		for (int n = 0;n < len;n++) {
+			out[n] = in[n];
+		}
+		return;
+	}
+
+	biquad_process_block(&cascade->sections[0], in, out, len);
+	for (int i = 1;i < cascade->num;i++) {
+		biquad_process_block(&cascade->sections[i], out, out, len);
+	}
+}
+
+/**
+ * Initialize a real FFT. The twiddle factors and the bit reversal table are
+ * computed here, so that filter_rfft does not need any trigonometric functions.
+ * The same tables can be shared by several FilterRfft of the same size.
+ * @param fft
+ * The FFT to initialize
+ * @param bits
+ * The number of points as a power of two, 2 to 15
+ * @param twiddle
+ * Buffer with room for FILTER_RFFT_TWIDDLE_LEN(bits) floats
+ * @param bitrev
+ * Buffer with room for FILTER_RFFT_BITREV_LEN(bits) values
+ * @return
+ * false if bits is out of range
+ */
+bool filter_rfft_init(FilterRfft *fft, int bits, float *twiddle, uint16_t *bitrev) {
+	if (bits < 2 || bits > 15) {
+		return false;
+	}
+
+	int n = 1 << bits;
+	int m = n / 2;
+
+	fft->bits = bits;
+	fft->twiddle = twiddle;
+	fft->bitrev = bitrev;
+
+	for (int k = 0;k < m;k++) {
+		float arg = 2.0 * M_PI * (float)k / (float)n;
+		twiddle[2 * k] = cosf(arg);
+		twiddle[2 * k + 1] = sinf(arg);
+	}
+
+	for (int i = 0;i < m;i++) {
+		int rev = 0;
+		for (int b = 0;b < bits - 1;b++) {
+			if (i & (1 << b)) {
+				rev |= 1 << (bits - 2 - b);
+			}
+		}
+		bitrev[i] = rev;
+	}
+
+	return true;
+}
+
+/**
+ * Forward FFT of real data, in place. The N real samples are treated as N / 2
+ * complex samples, transformed with a complex FFT of half the size and then
+ * separated into the spectrum of the real signal.
+ * @param fft
+ * An FFT initialized with filter_rfft_init
+ * @param data
+ * N samples in, N / 2 + 1 frequency bins out. data[0] is the DC bin and
+ * data[1] the bin at half the sample rate, as they are both real. The other
+ * bins are stored as data[2 * k] (real) and data[2 * k + 1] (imaginary), which
+ * is the same layout as arm_rfft_fast_f32 in CMSIS-DSP.
+ */
+void filter_rfft(FilterRfft *fft, float *data) {
+	const int n = 1 << fft->bits;
+	const int m = n / 2;
+	const float *tw = fft->twiddle;
+	const uint16_t *bitrev = fft->bitrev;
+
+	// Bit reversal of the complex samples
+	for (int i = 0;i < m;i++) {
+		int j = bitrev[i];
+		if (i < j) {
+			float tr = data[2 * i];
+			float ti = data[2 * i + 1];
+			data[2 * i] = data[2 * j];
+			data[2 * i + 1] = data[2 * j + 1];
+			data[2 * j] = tr;
+			data[2 * j + 1] = ti;
+		}
+	}
+
+	// The first stage has no twiddles
+	for (int i = 0;i < m;i += 2) {
+		float *a = data + 2 * i;
+		float *b = a + 2;
+		float tr = b[0];
+		float ti = b[1];
+		b[0] = a[0] - tr;
+		b[1] = a[1] - ti;
+		a[0] += tr;
+		a[1] += ti;
+	}
+
+	// Remaining stages. The twiddle for butterfly j of a stage with length len
+	// is exp(-2 * pi * i * j / len), which is entry j * n / len in the table.
+	for (int len = 4;len <= m;len <<= 1) {
+		int half = len / 2;
+		int step = n / len;
+
+		for (int j = 0;j < half;j++) {
+			float c = tw[2 * j * step];
+			float s = tw[2 * j * step + 1];
+
+			for (int i = j;i < m;i += len) {
+				float *a = data + 2 * i;
+				float *b = data + 2 * (i + half);
+				float tr = c * b[0] + s * b[1];
+				float ti = c * b[1] - s * b[0];
+				b[0] = a[0] - tr;
+				b[1] = a[1] - ti;
+				a[0] += tr;
+				a[1] += ti;
+			}
+		}
+	}
+
+	// Separate the spectrum of the even and odd samples. Bins k and m - k
+	// are computed from the same two complex values, so this works in place.
+	float z0r = data[0];
+	float z0i = data[1];
+	data[0] = z0r + z0i;
+	data[1] = z0r - z0i;
+
+	for (int k = 1;k < m / 2;k++) {
+		float *a = data + 2 * k;
+		float *b = data + 2 * (m - k);
+
+		float er = 0.5 * (a[0] + b[0]);
+		float ei = 0.5 * (a[1] - b[1]);
+		float odr = 0.5 * (a[0] - b[0]);
+		float odi = 0.5 * (a[1] + b[1]);
+
+		float c = tw[2 * k];
+		float s = tw[2 * k + 1];
+		float tr = c * odr + s * odi;
+		float ti = c * odi - s * odr;
+
+		a[0] = er + ti;
+		a[1] = ei - tr;
+		b[0] = er - ti;
+		b[1] = -(ei + tr);
+	}
+
+	data[2 * (m / 2) + 1] = -data[2 * (m / 2) + 1];
+}
+
+/**
+ * Amplitude spectrum of real data, e.g. sampled phase currents or encoder
+ * positions. A sine wave with amplitude A at the frequency of a bin gives A in
+ * that bin and a constant offset C gives C in bin 0. The frequency of bin k is
+ * k * sample_rate / N.
+ * @param fft
+ * An FFT initialized with filter_rfft_init
+ * @param data
+ * N samples. Will be overwritten by the output of filter_rfft.
+ * @param mag
+ * Buffer with room for N / 2 + 1 values
+ */
+void filter_rfft_magnitude(FilterRfft *fft, float *data, float *mag) {
+	const int n = 1 << fft->bits;
+	const int m = n / 2;
+	const float scale = 2.0 / (float)n;
+
+	filter_rfft(fft, data);
+
+	mag[0] = fabsf(data[0]) / (float)n;
+	mag[m] = fabsf(data[1]) / (float)n;
+
+	for (int k = 1;k < m;k++) {
+		float re = data[2 * k];
+		float im = data[2 * k + 1];
+		mag[k] = sqrtf(re * re + im * im) * scale;
+	}
+}
@@ -21,7 +21,11 @@
 #define DIGITAL_FILTER_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 
+// Buffer sizes for a real FFT of 1 << bits points
+#define FILTER_RFFT_TWIDDLE_LEN(bits)	(1 << (bits))
+#define FILTER_RFFT_BITREV_LEN(bits)	(1 << ((bits) - 1))
 
 typedef struct{
 	float a0, a1, a2, b1, b2;
@@ -33,6 +37,27 @@ typedef enum {
 	BQ_HIGHPASS
 } BiquadType;
 
+// FIR filter for block processing. The state holds every sample twice, so that
+// the latest taps samples always are contiguous and no wrapping is needed.
+typedef struct {
+	const float *coeffs;
+	float *state; // 2 * taps floats
+	int taps;
+	int index;
+} FirFilter;
+
+typedef struct {
+	Biquad *sections;
+	int num;
+} BiquadCascade;
+
+// Real FFT with tables that are computed once for the size
+typedef struct {
+	int bits;
+	float *twiddle; // cos and sin interleaved, FILTER_RFFT_TWIDDLE_LEN floats
+	uint16_t *bitrev; // FILTER_RFFT_BITREV_LEN entries
+} FilterRfft;
+
 // Functions
 void filter_fft(int dir, int m, float *real, float *imag);
 void filter_dft(int dir, int len, float *real, float *imag);
@@ -45,5 +70,15 @@ void filter_add_sample(float *buffer, float sample, int bits, uint32_t *offset);
 float biquad_process(Biquad *biquad, float in);
 void biquad_config(Biquad *biquad, BiquadType type, float Fc);
 void biquad_reset(Biquad *biquad);
+void filter_fir_init(FirFilter *fir, const float *coeffs, float *state, int taps);
+void filter_fir_reset(FirFilter *fir);
+void filter_fir_process_block(FirFilter *fir, const float *in, float *out, int len);
+void biquad_process_block(Biquad *biquad, const float *in, float *out, int len);
+void biquad_cascade_init(BiquadCascade *cascade, Biquad *sections, int num);
+void biquad_cascade_reset(BiquadCascade *cascade);
+void biquad_cascade_process_block(BiquadCascade *cascade, const float *in, float *out, int len);
+bool filter_rfft_init(FilterRfft *fft, int bits, float *twiddle, uint16_t *bitrev);
+void filter_rfft(FilterRfft *fft, float *data);
+void filter_rfft_magnitude(FilterRfft *fft, float *data, float *mag);
 
 #endif /* DIGITAL_FILTER_H_ */
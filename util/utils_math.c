@@ -667,6 +667,136 @@ uint16_t utils_median_filter_uint16_run(uint16_t *buffer,
 	return buffer_sorted[filter_len / 2];
 }
 
+/**
+ * Initialize a sliding window filled with an initial value.
+ *
+ * @param w
+ * The window.
+ *
+ * @param samples
+ * Storage for len samples.
+ *
+ * @param sorted
+ * Storage for len sorted samples, needed for the median. Can be NULL, in which
+ * case the min and max are found by scanning the samples.
+ *
+ * @param len
+ * Window length, 1 to 65535.
+ *
+ * @param init_value
+ * Value to fill the window with.
+ */
+void utils_window_uint16_init(utils_window_uint16 *w, uint16_t *samples,
+		uint16_t *sorted, unsigned int len, uint16_t init_value) {
+	w->samples = samples;
+	w->sorted = sorted;
+	w->len = len;
+	w->index = 0;
+	w->sum = (uint32_t)init_value * len;
+	w->sum_sq = (uint64_t)init_value * init_value * len;
+
+	for (unsigned int i = 0;i < len;i++) {
+		samples[i] = init_value;
+		if (sorted) {
+			sorted[i] = init_value;
+		}
+	}
+}
+
+/**
+ * Add a sample to the window, replacing the oldest one.
+ */
+void utils_window_uint16_add(utils_window_uint16 *w, uint16_t sample) {
+	uint16_t old = w->samples[w->index];
+	w->samples[w->index++] = sample;
+	if (w->index >= w->len) {
+		w->index = 0;
+	}
+
+	w->sum = w->sum - old + sample;
+	w->sum_sq = w->sum_sq - (uint32_t)old * old + (uint32_t)sample * sample;
+
+	if (!w->sorted || old == sample) {
+		return;
+	}
+
+	// Find the old sample, then move it towards the position of the new one
+	uint16_t *s = w->sorted;
+	unsigned int lo = 0, hi = w->len - 1;
+	while (lo < hi) {
+		unsigned int mid = (lo + hi) / 2;
+		if (s[mid] < old) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	unsigned int pos = lo;
+	if (sample > old) {
+		while ((pos + 1) < w->len && s[pos + 1] < sample) {
+			s[pos] = s[pos + 1];
+			pos++;
+		}
+	} else {
+		while (pos > 0 && s[pos - 1] > sample) {
+			s[pos] = s[pos - 1];
+			pos--;
+		}
+	}
+	s[pos] = sample;
+}
+
+/**
+ * Median of the window. Requires the sorted storage. For even lengths the upper
+ * of the two middle samples is returned, like utils_median_filter_uint16_run.
+ */
+uint16_t utils_window_uint16_median(utils_window_uint16 *w) {
+	return w->sorted[w->len / 2];
+}
+
+uint16_t utils_window_uint16_min(utils_window_uint16 *w) {
+	if (w->sorted) {
+		return w->sorted[0];
+	}
+
+	uint16_t res = w->samples[0];
+	for (unsigned int i = 1;i < w->len;i++) {
+		if (w->samples[i] < res) {
+			res = w->samples[i];
+		}
+	}
+	return res;
+}
+
+uint16_t utils_window_uint16_max(utils_window_uint16 *w) {
+	if (w->sorted) {
+		return w->sorted[w->len - 1];
+	}
+
+	uint16_t res = w->samples[0];
+	for (unsigned int i = 1;i < w->len;i++) {
+		if (w->samples[i] > res) {
+			res = w->samples[i];
+		}
+	}
+	return res;
+}
+
+float utils_window_uint16_mean(utils_window_uint16 *w) {
+	return (float)w->sum / (float)w->len;
+}
+
+/**
+ * Population variance of the window. The sums are exact integers, so there is
+ * no drift or cancellation from running them for a long time.
+ */
+float utils_window_uint16_variance(utils_window_uint16 *w) {
+	uint64_t n = w->len;
+	uint64_t num = n * w->sum_sq - (uint64_t)w->sum * w->sum;
+	return (float)num / (float)(n * n);
+}
+
 void utils_rotate_vector3(float *input, float *rotation, float *output, bool reverse) {
 	float s1, c1, s2, c2, s3, c3;
 
@@ -24,6 +24,21 @@
 #include <stdint.h>
 #include <math.h>
 
+/*
+ * Sliding window over the latest len uint16 samples. The running sums give the
+ * mean and variance in constant time and the optional sorted copy gives the
+ * median, min and max with a binary search and a shift of the samples between
+ * the removed and the added value, without sorting the window for every sample.
+ */
+typedef struct {
+	uint16_t *samples;
+	uint16_t *sorted;
+	unsigned int len;
+	unsigned int index;
+	uint32_t sum;
+	uint64_t sum_sq;
+} utils_window_uint16;
+
 float utils_map_angle(float angle, float min, float max);
 void utils_deadband(float *value, float tres, float max);
 float utils_angle_difference(float angle1, float angle2);
@@ -55,6 +70,14 @@ float utils_batt_liion_norm_v_to_capacity(float norm_v);
 uint16_t utils_median_filter_uint16_run(uint16_t *buffer,
 		unsigned int *buffer_index, unsigned int filter_len, uint16_t sample);
 void utils_rotate_vector3(float *input, float *rotation, float *output, bool reverse);
+void utils_window_uint16_init(utils_window_uint16 *w, uint16_t *samples,
+		uint16_t *sorted, unsigned int len, uint16_t init_value);
+void utils_window_uint16_add(utils_window_uint16 *w, uint16_t sample);
+uint16_t utils_window_uint16_median(utils_window_uint16 *w);
+uint16_t utils_window_uint16_min(utils_window_uint16 *w);
+uint16_t utils_window_uint16_max(utils_window_uint16 *w);
+float utils_window_uint16_mean(utils_window_uint16 *w);
+float utils_window_uint16_variance(utils_window_uint16 *w);
 
 // Return the sign of the argument. -1.0 if negative, 1.0 if zero or positive.
 #define SIGN(x)				(((x) < 0.0) ? -1.0 : 1.0)